@@ -0,0 +1,24 @@
+// Counting replacement of the global operator new/delete. Not part of HomeAssistantLinkCore: add this file to a
+// binary to count its allocations (see AllocationTracker.h). In a DLL it only sees the DLL's own allocations.
+
+#include <cstdlib>
+#include <new>
+
+#include "AllocationTracker.h"
+
+namespace {
+    void* CountedAlloc(std::size_t size) {
+        CountAllocation(size);
+        if (void* p = std::malloc(size ? size : 1)) return p;
+        throw std::bad_alloc();
+    }
+
+    const bool g_Installed = (MarkAllocationHooksInstalled(), true);
+}
+
+void* operator new(std::size_t size) { return CountedAlloc(size); }
+void* operator new[](std::size_t size) { return CountedAlloc(size); }
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t) noexcept { std::free(p); }
@@ -0,0 +1,53 @@
+#include "AllocationTracker.h"
+
+#include <array>
+#include <atomic>
+#include <cstdio>
+
+namespace {
+    // Plain thread-local counters: the hook must not allocate, lock or touch shared cache lines
+    thread_local AllocationCounters t_Allocations;
+    std::atomic<bool> g_HooksInstalled{false};
+
+    constexpr const char* TABLE_NAMES[] = {"light defs", "smoother", "command cache", "flight recorder",
+                                           "trace buffer"};
+    static_assert(std::size(TABLE_NAMES) == static_cast<size_t>(ResidentTable::Count));
+    std::array<std::atomic<std::size_t>, static_cast<size_t>(ResidentTable::Count)> g_ResidentBytes{};
+}
+
+AllocationCounters GetThreadAllocations() noexcept { return t_Allocations; }
+
+void CountAllocation(std::size_t bytes) noexcept {
+    ++t_Allocations.count;
+    t_Allocations.bytes += bytes;
+}
+
+void MarkAllocationHooksInstalled() noexcept { g_HooksInstalled.store(true, std::memory_order_relaxed); }
+
+bool AllocationHooksInstalled() noexcept { return g_HooksInstalled.load(std::memory_order_relaxed); }
+
+const char* GetResidentTableName(ResidentTable table) { return TABLE_NAMES[static_cast<size_t>(table)]; }
+
+void SetResidentBytes(ResidentTable table, std::size_t bytes) noexcept {
+    g_ResidentBytes[static_cast<size_t>(table)].store(bytes, std::memory_order_relaxed);
+}
+
+std::size_t GetResidentBytes(ResidentTable table) noexcept {
+    return g_ResidentBytes[static_cast<size_t>(table)].load(std::memory_order_relaxed);
+}
+
+std::size_t StringHeapBytes(const std::string& s) noexcept {
+    static const std::size_t inlineCapacity = std::string().capacity();
+    return s.capacity() > inlineCapacity ? s.capacity() + 1 : 0;
+}
+
+std::string FormatResidentSizes() {
+    std::string out;
+    for (size_t i = 0; i < static_cast<size_t>(ResidentTable::Count); ++i) {
+        char buffer[64];
+        std::snprintf(buffer, sizeof(buffer), "%s%s %.1f", i ? ", " : "", TABLE_NAMES[i],
+                      static_cast<double>(g_ResidentBytes[i].load(std::memory_order_relaxed)) / 1024.0);
+        out += buffer;
+    }
+    return out;
+}
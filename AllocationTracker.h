@@ -0,0 +1,47 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Heap allocation accounting for the plugin's own code paths.
+// The counting operator new lives in AllocationHooks.cpp, which is compiled only into binaries that opt in
+// (CMake option HAL_TRACK_ALLOCATIONS for the plugin DLL; benchmarks always). Without it all counters stay zero.
+// Per-stage numbers are collected by ScopedStageTimer while profiling is enabled (see Profiler.h).
+
+struct AllocationCounters {
+    std::uint64_t count = 0;
+    std::uint64_t bytes = 0;
+
+    AllocationCounters operator-(const AllocationCounters& o) const { return {count - o.count, bytes - o.bytes}; }
+};
+
+// Allocations made by the calling thread since it started
+AllocationCounters GetThreadAllocations() noexcept;
+// Called from the operator new hook
+void CountAllocation(std::size_t bytes) noexcept;
+void MarkAllocationHooksInstalled() noexcept;
+bool AllocationHooksInstalled() noexcept;
+
+// --- Resident size of long-lived tables (estimates, updated by their owners) ---
+
+enum class ResidentTable : std::uint8_t {
+    LightDefinitions,  // g_SkyrimLightDefs
+    SmootherState,     // LightSmoother of the export thread
+    CommandCache,      // Last commanded state per lamp (dedup)
+    FlightRecorder,    // Flight recorder ring
+    TraceBuffer,       // Trace recorder ring
+    Count
+};
+
+const char* GetResidentTableName(ResidentTable table);
+void SetResidentBytes(ResidentTable table, std::size_t bytes) noexcept;
+std::size_t GetResidentBytes(ResidentTable table) noexcept;
+
+// Heap bytes owned by a string (0 while it fits the small-string buffer)
+std::size_t StringHeapBytes(const std::string& s) noexcept;
+// Per-node overhead of the standard node-based containers (pointers, color/hash), for estimates
+constexpr std::size_t MAP_NODE_OVERHEAD = 4 * sizeof(void*);
+constexpr std::size_t HASH_NODE_OVERHEAD = 2 * sizeof(void*);
+
+// "light defs 120.5, smoother 1.2, ..." in KiB
+std::string FormatResidentSizes();
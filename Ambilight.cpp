@@ -0,0 +1,274 @@
+#include "Ambilight.h"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #define HAL_AMBILIGHT_SSE2 1
+    #include <emmintrin.h>
+#endif
+
+namespace {
+    constexpr float DEG_TO_RAD = 3.14159265f / 180.0f;
+
+    // Grey pixels weigh 16, fully saturated ones 255: weight = 16 + chroma * 15/16. Keeps weight * channel within
+    // 16 bits for the SIMD path.
+    inline std::uint32_t SaturationWeight(std::uint32_t maxChannel, std::uint32_t minChannel) {
+        return 16 + (((maxChannel - minChannel) * 15) >> 4);
+    }
+
+#ifdef HAL_AMBILIGHT_SSE2
+    // Same 4-lane shuffle on both pixels of a 2-pixel, 16-bit-per-channel vector
+    template <int Imm>
+    inline __m128i ShufflePixels(__m128i v) {
+        return _mm_shufflehi_epi16(_mm_shufflelo_epi16(v, Imm), Imm);
+    }
+#endif
+}
+
+void AmbilightKernel::Configure(const std::vector<RealLamp>& lamps, const AmbilightConfig& config) {
+    auto sameLamp = [](const RealLamp& a, const RealLamp& b) {
+        return a.entity_id == b.entity_id && a.position.x == b.position.x && a.position.y == b.position.y &&
+               a.position.z == b.position.z;
+    };
+    bool sameLamps = std::equal(lamps.begin(), lamps.end(), configuredLamps.begin(), configuredLamps.end(), sameLamp);
+    if (sameLamps && config == configuredWith && !cells.empty()) return;
+    configuredLamps = lamps;
+    configuredWith = config;
+
+    columns = std::max(config.columns, 1);
+    rows = std::max(config.rows, 1);
+    cells.assign(static_cast<size_t>(columns * rows), AmbilightCell{});
+    columnOfPixel.clear();
+    entityIds.clear();
+    lampWeights.assign(lamps.size() * cells.size(), 0.0f);
+
+    // Room coordinates as in LampMapping: +y ahead (the screen), +x to the right, +z up
+    float twoSigmaSq = 2.0f * config.spread * config.spread;
+    for (size_t l = 0; l < lamps.size(); ++l) {
+        const Vec3& p = lamps[l].position;
+        entityIds.push_back(lamps[l].entity_id);
+        float azimuth = std::atan2(p.x, p.y);
+        float elevation = std::atan2(p.z, std::sqrt(p.x * p.x + p.y * p.y));
+        float u = std::clamp(0.5f + azimuth / (config.horizontal_fov * DEG_TO_RAD), 0.0f, 1.0f) * columns;
+        float v = std::clamp(0.5f - elevation / (config.vertical_fov * DEG_TO_RAD), 0.0f, 1.0f) * rows;
+
+        float* weights = &lampWeights[l * cells.size()];
+        float sum = 0.0f;
+        for (int cy = 0; cy < rows; ++cy) {
+            for (int cx = 0; cx < columns; ++cx) {
+                float du = u - (static_cast<float>(cx) + 0.5f);
+                float dv = v - (static_cast<float>(cy) + 0.5f);
+                float w = std::exp(-(du * du + dv * dv) / twoSigmaSq);
+                weights[cy * columns + cx] = w;
+                sum += w;
+            }
+        }
+        if (sum > 0.0f) {
+            for (size_t c = 0; c < cells.size(); ++c) weights[c] /= sum;
+        }
+    }
+}
+
+bool AmbilightKernel::PrepareGrid(const AmbilightImage& image) {
+    if (cells.empty() || !image.pixels || image.width <= 0 || image.height <= 0 ||
+        image.rowPitch < static_cast<size_t>(image.width) * 4) {
+        return false;
+    }
+    size_t cellWidth = (static_cast<size_t>(image.width) + columns - 1) / columns;
+    size_t cellHeight = (static_cast<size_t>(image.height) + rows - 1) / rows;
+    if (cellWidth * cellHeight > AMBILIGHT_MAX_PIXELS_PER_CELL) return false;
+
+    if (columnOfPixel.size() != static_cast<size_t>(image.width)) {
+        columnOfPixel.resize(static_cast<size_t>(image.width));
+        for (int x = 0; x < image.width; ++x) {
+            columnOfPixel[x] = static_cast<std::uint16_t>(x * columns / image.width);
+        }
+    }
+    std::fill(cells.begin(), cells.end(), AmbilightCell{});
+    format = image.format;
+    return true;
+}
+
+bool AmbilightKernel::AccumulateGridScalar(const AmbilightImage& image) {
+    if (!PrepareGrid(image)) return false;
+    for (int y = 0; y < image.height; ++y) {
+        const std::uint8_t* row = image.pixels + static_cast<size_t>(y) * image.rowPitch;
+        AmbilightCell* rowCells = &cells[static_cast<size_t>(y * rows / image.height) * columns];
+        for (int x = 0; x < image.width; ++x) {
+            const std::uint8_t* p = row + 4 * x;
+            std::uint32_t maxChannel = std::max({p[0], p[1], p[2]});
+            std::uint32_t minChannel = std::min({p[0], p[1], p[2]});
+            std::uint32_t w = SaturationWeight(maxChannel, minChannel);
+            AmbilightCell& cell = rowCells[columnOfPixel[x]];
+            cell.c0 += w * p[0];
+            cell.c1 += w * p[1];
+            cell.c2 += w * p[2];
+            cell.weight += w;
+        }
+    }
+    return true;
+}
+
+bool AmbilightKernel::AccumulateGrid(const AmbilightImage& image) {
+#ifdef HAL_AMBILIGHT_SSE2
+    if (!PrepareGrid(image)) return false;
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i colorMask = _mm_set_epi16(0, -1, -1, -1, 0, -1, -1, -1);
+    const __m128i alphaOne = _mm_set_epi16(1, 0, 0, 0, 1, 0, 0, 0);      // Alpha lane carries the weight sum
+    const __m128i alphaMax = _mm_set_epi16(255, 0, 0, 0, 255, 0, 0, 0);  // Keeps alpha out of the channel min
+    const __m128i fifteen = _mm_set1_epi16(15);
+    const __m128i sixteen = _mm_set1_epi16(16);
+
+    for (int y = 0; y < image.height; ++y) {
+        const std::uint8_t* row = image.pixels + static_cast<size_t>(y) * image.rowPitch;
+        AmbilightCell* rowCells = &cells[static_cast<size_t>(y * rows / image.height) * columns];
+        int x = 0;
+        // Two pixels per step, one 16-bit lane per channel: [c0 c1 c2 a | c0 c1 c2 a]
+        for (; x + 2 <= image.width; x += 2) {
+            __m128i px = _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(row + 4 * x)), zero);
+            __m128i color = _mm_and_si128(px, colorMask);
+            // Channel max/min of each pixel, broadcast to its four lanes
+            __m128i hi = _mm_max_epi16(color, ShufflePixels<_MM_SHUFFLE(3, 0, 2, 1)>(color));
+            hi = _mm_max_epi16(hi, ShufflePixels<_MM_SHUFFLE(3, 1, 0, 2)>(color));
+            hi = ShufflePixels<_MM_SHUFFLE(0, 0, 0, 0)>(hi);
+            __m128i forMin = _mm_or_si128(color, alphaMax);
+            __m128i lo = _mm_min_epi16(forMin, ShufflePixels<_MM_SHUFFLE(3, 0, 2, 1)>(forMin));
+            lo = _mm_min_epi16(lo, ShufflePixels<_MM_SHUFFLE(3, 1, 0, 2)>(forMin));
+            lo = ShufflePixels<_MM_SHUFFLE(0, 0, 0, 0)>(lo);
+            __m128i chroma = _mm_sub_epi16(hi, lo);
+            __m128i weight = _mm_add_epi16(_mm_srli_epi16(_mm_mullo_epi16(chroma, fifteen), 4), sixteen);
+            // weight * channel <= 255 * 255 fits the unsigned 16-bit product
+            __m128i product = _mm_mullo_epi16(_mm_or_si128(color, alphaOne), weight);
+
+            auto* first = reinterpret_cast<__m128i*>(&rowCells[columnOfPixel[x]]);
+            _mm_store_si128(first, _mm_add_epi32(_mm_load_si128(first), _mm_unpacklo_epi16(product, zero)));
+            auto* second = reinterpret_cast<__m128i*>(&rowCells[columnOfPixel[x + 1]]);
+            _mm_store_si128(second, _mm_add_epi32(_mm_load_si128(second), _mm_unpackhi_epi16(product, zero)));
+        }
+        for (; x < image.width; ++x) {
+            const std::uint8_t* p = row + 4 * x;
+            std::uint32_t w = SaturationWeight(std::max({p[0], p[1], p[2]}), std::min({p[0], p[1], p[2]}));
+            AmbilightCell& cell = rowCells[columnOfPixel[x]];
+            cell.c0 += w * p[0];
+            cell.c1 += w * p[1];
+            cell.c2 += w * p[2];
+            cell.weight += w;
+        }
+    }
+    return true;
+#else
+    return AccumulateGridScalar(image);
+#endif
+}
+
+std::vector<LightState> AmbilightKernel::ResolveLamps() const {
+    std::vector<LightState> result;
+    result.reserve(entityIds.size());
+    for (size_t l = 0; l < entityIds.size(); ++l) {
+        const float* weights = &lampWeights[l * cells.size()];
+        double sum0 = 0.0, sum1 = 0.0, sum2 = 0.0, sumWeight = 0.0;
+        for (size_t c = 0; c < cells.size(); ++c) {
+            double w = weights[c];
+            sum0 += w * cells[c].c0;
+            sum1 += w * cells[c].c1;
+            sum2 += w * cells[c].c2;
+            sumWeight += w * cells[c].weight;
+        }
+
+        LightState state;
+        state.entity_id = entityIds[l];
+        double r = 0.0, g = 0.0, b = 0.0;
+        if (sumWeight > 0.0) {
+            r = (format == AmbilightPixelFormat::BGRA8 ? sum2 : sum0) / sumWeight;
+            g = sum1 / sumWeight;
+            b = (format == AmbilightPixelFormat::BGRA8 ? sum0 : sum2) / sumWeight;
+        }
+        // Hue at full value; how bright the region is goes into the brightness
+        double peak = std::max({r, g, b});
+        double scale = peak > 0.0 ? 255.0 / peak : 0.0;
+        state.rgb_color = {static_cast<int>(r * scale + 0.5), static_cast<int>(g * scale + 0.5),
+                           static_cast<int>(b * scale + 0.5)};
+        double luma = (0.2126 * r + 0.7152 * g + 0.0722 * b) / 255.0;
+        state.brightness_pct = std::clamp(static_cast<int>(luma * 100.0 + 0.5), 10, 100);
+        result.push_back(std::move(state));
+    }
+    return result;
+}
+
+std::vector<LightState> AmbilightKernel::Process(const AmbilightImage& image) {
+    if (!AccumulateGrid(image)) return {};
+    return ResolveLamps();
+}
+
+void BlendAmbilightLayer(std::vector<LightState>& ambient, const std::vector<LightState>& screen, float mix) {
+    for (size_t i = 0; i < ambient.size() && i < screen.size(); ++i) {
+        LightState& a = ambient[i];
+        const LightState& s = screen[i];
+        if (a.inherit) {
+            // Interiors have no ambient: the screen is the only non-fire signal
+            a.rgb_color = s.rgb_color;
+            a.brightness_pct = s.brightness_pct;
+            a.inherit = false;
+            continue;
+        }
+        for (size_t c = 0; c < 3; ++c) {
+            a.rgb_color[c] = static_cast<int>(std::lround(a.rgb_color[c] + (s.rgb_color[c] - a.rgb_color[c]) * mix));
+        }
+        a.brightness_pct =
+            static_cast<int>(std::lround(a.brightness_pct + (s.brightness_pct - a.brightness_pct) * mix));
+    }
+}
+
+// --- PPM ---
+
+bool WriteAmbilightPpm(const std::filesystem::path& file, const AmbilightImage& image) {
+    if (!image.pixels || image.width <= 0 || image.height <= 0) return false;
+    std::ofstream out(file, std::ios::binary);
+    if (!out) return false;
+    out << "P6\n" << image.width << ' ' << image.height << "\n255\n";
+    bool bgra = image.format == AmbilightPixelFormat::BGRA8;
+    std::vector<char> row(static_cast<size_t>(image.width) * 3);
+    for (int y = 0; y < image.height; ++y) {
+        const std::uint8_t* src = image.pixels + static_cast<size_t>(y) * image.rowPitch;
+        for (int x = 0; x < image.width; ++x) {
+            row[3 * x + 0] = static_cast<char>(src[4 * x + (bgra ? 2 : 0)]);
+            row[3 * x + 1] = static_cast<char>(src[4 * x + 1]);
+            row[3 * x + 2] = static_cast<char>(src[4 * x + (bgra ? 0 : 2)]);
+        }
+        out.write(row.data(), static_cast<std::streamsize>(row.size()));
+    }
+    return static_cast<bool>(out);
+}
+
+bool LoadAmbilightPpm(const std::filesystem::path& file, std::vector<std::uint8_t>& pixels, AmbilightImage& image) {
+    std::ifstream in(file, std::ios::binary);
+    std::string magic;
+    in >> magic;
+    if (magic != "P6") return false;
+    int header[3] = {0, 0, 0};  // width, height, maxval
+    for (int& value : header) {
+        in >> std::ws;
+        while (in.peek() == '#') {  // Comment lines
+            std::string comment;
+            std::getline(in, comment);
+            in >> std::ws;
+        }
+        in >> value;
+    }
+    in.get();  // Single whitespace before the pixel data
+    if (!in || header[0] <= 0 || header[1] <= 0 || header[2] != 255) return false;
+
+    std::vector<char> rgb(static_cast<size_t>(header[0]) * header[1] * 3);
+    if (!in.read(rgb.data(), static_cast<std::streamsize>(rgb.size()))) return false;
+    pixels.resize(static_cast<size_t>(header[0]) * header[1] * 4);
+    for (size_t i = 0, n = rgb.size() / 3; i < n; ++i) {
+        pixels[4 * i + 0] = static_cast<std::uint8_t>(rgb[3 * i + 0]);
+        pixels[4 * i + 1] = static_cast<std::uint8_t>(rgb[3 * i + 1]);
+        pixels[4 * i + 2] = static_cast<std::uint8_t>(rgb[3 * i + 2]);
+        pixels[4 * i + 3] = 255;
+    }
+    image = {pixels.data(), header[0], header[1], static_cast<size_t>(header[0]) * 4, AmbilightPixelFormat::RGBA8};
+    return true;
+}
@@ -0,0 +1,85 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include "ConfigLoader.h"  // For AmbilightConfig, RealLamp, LightState
+
+// Screen-color layer: turns a small downscaled copy of the game's backbuffer into one color per lamp.
+// The image is split into a grid of regions; each region gets a saturation-weighted average color (vivid pixels
+// count up to 16x more than grey ones, so a fireball on a grey sky still tints the lamps). Each lamp then
+// blends the regions around the screen direction it sits in, as seen from the player's seat: lamps in front
+// take the matching part of the screen, lamps beside or behind the player take the nearest screen edge.
+// Capture (D3D11, plugin only) lives in AmbilightCapture.cpp; this part is portable and benchmarked on Linux.
+
+enum class AmbilightPixelFormat : std::uint8_t {
+    RGBA8,  // DXGI_FORMAT_R8G8B8A8_UNORM(_SRGB)
+    BGRA8,  // DXGI_FORMAT_B8G8R8A8_UNORM(_SRGB)
+};
+
+// A view of 8-bit, 4-channel pixels; rows may be padded (rowPitch >= 4 * width)
+struct AmbilightImage {
+    const std::uint8_t* pixels = nullptr;
+    int width = 0;
+    int height = 0;
+    size_t rowPitch = 0;
+    AmbilightPixelFormat format = AmbilightPixelFormat::RGBA8;
+};
+
+// Saturation-weighted channel sums of one grid region (in the image's channel order)
+struct alignas(16) AmbilightCell {
+    std::uint32_t c0 = 0, c1 = 0, c2 = 0;
+    std::uint32_t weight = 0;
+};
+
+// Images with more pixels per region than this would overflow the 32-bit region sums
+constexpr size_t AMBILIGHT_MAX_PIXELS_PER_CELL = 65536;
+
+class AmbilightKernel {
+public:
+    // Grid size and lamp directions; cheap to call every tick (only rebuilds the lamp weights on changes)
+    void Configure(const std::vector<RealLamp>& lamps, const AmbilightConfig& config);
+
+    // Region sums of an image. The SSE2 path (x86/x64) and the scalar reference produce identical sums.
+    // False if the image is empty or too large for the grid (see AMBILIGHT_MAX_PIXELS_PER_CELL).
+    bool AccumulateGrid(const AmbilightImage& image);
+    bool AccumulateGridScalar(const AmbilightImage& image);
+
+    // One state per configured lamp (same order): hue at full value plus brightness from the region luminance.
+    // Uses the sums of the last AccumulateGrid call.
+    std::vector<LightState> ResolveLamps() const;
+
+    // AccumulateGrid + ResolveLamps; empty if the image was rejected
+    std::vector<LightState> Process(const AmbilightImage& image);
+
+    const std::vector<AmbilightCell>& GetCells() const { return cells; }
+    int GetColumns() const { return columns; }
+    int GetRows() const { return rows; }
+
+private:
+    bool PrepareGrid(const AmbilightImage& image);
+
+    int columns = 0;
+    int rows = 0;
+    AmbilightPixelFormat format = AmbilightPixelFormat::RGBA8;
+    std::vector<AmbilightCell> cells;
+    std::vector<std::uint16_t> columnOfPixel;  // Grid column per image x, rebuilt when the width changes
+    std::vector<std::string> entityIds;
+    std::vector<float> lampWeights;  // lamps x cells, normalized per lamp
+
+    // Inputs of the current lamp weights, to skip rebuilding them
+    std::vector<RealLamp> configuredLamps;
+    AmbilightConfig configuredWith;
+};
+
+// Mixes the screen colors into the ambient (day/night) states: exteriors blend by config.mix, interiors (whose
+// ambient is "inherit") take the screen color outright. Both vectors are indexed like g_RealLamps.
+void BlendAmbilightLayer(std::vector<LightState>& ambient, const std::vector<LightState>& screen, float mix);
+
+// --- Captured frames on disk (binary PPM, P6), for offline benchmarks ---
+
+bool WriteAmbilightPpm(const std::filesystem::path& file, const AmbilightImage& image);
+// Loads a P6 file as RGBA8 into pixels; image points into pixels
+bool LoadAmbilightPpm(const std::filesystem::path& file, std::vector<std::uint8_t>& pixels, AmbilightImage& image);
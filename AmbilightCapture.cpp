@@ -0,0 +1,247 @@
+#include "AmbilightCapture.h"
+
+#include <d3d11.h>
+#include <dxgi.h>
+#include <wrl/client.h>
+
+#include <array>
+#include <atomic>
+#include <cstring>
+#include <mutex>
+#include <string>
+
+#include "ConfigLoader.h"
+#include "Logger.h"
+
+using Microsoft::WRL::ComPtr;
+
+namespace {
+    using PresentFn = HRESULT(STDMETHODCALLTYPE*)(IDXGISwapChain*, UINT, UINT);
+    constexpr size_t PRESENT_VTABLE_INDEX = 8;
+    constexpr size_t STAGING_COUNT = 3;  // Copies in flight; readback never waits on the GPU
+
+    PresentFn g_OriginalPresent = nullptr;
+    IDXGISwapChain* g_GameSwapChain = nullptr;
+    std::atomic<bool> g_CaptureDisabled = false;  // Unsupported backbuffer or D3D error: stop trying
+
+    // --- Render thread state ---
+    struct CaptureResources {
+        ComPtr<ID3D11Device> device;
+        ComPtr<ID3D11DeviceContext> context;
+        ComPtr<ID3D11Texture2D> mipChain;
+        ComPtr<ID3D11ShaderResourceView> mipView;
+        std::array<ComPtr<ID3D11Texture2D>, STAGING_COUNT> staging;
+        DXGI_FORMAT format = DXGI_FORMAT_UNKNOWN;
+        UINT sourceWidth = 0, sourceHeight = 0;
+        UINT mipLevel = 0, width = 0, height = 0;
+        AmbilightPixelFormat pixelFormat = AmbilightPixelFormat::RGBA8;
+        std::uint64_t issued = 0;  // Copies into the staging ring
+        std::uint64_t read = 0;    // Copies read back
+        std::chrono::steady_clock::time_point lastCopy;
+    };
+    CaptureResources g_Capture;
+
+    // --- Newest frame, shared with the export thread ---
+    std::mutex g_FrameMutex;
+    std::vector<std::uint8_t> g_FramePixels;
+    int g_FrameWidth = 0, g_FrameHeight = 0;
+    AmbilightPixelFormat g_FrameFormat = AmbilightPixelFormat::RGBA8;
+    std::chrono::steady_clock::time_point g_FrameTime;
+
+    bool ToPixelFormat(DXGI_FORMAT format, AmbilightPixelFormat& out) {
+        switch (format) {
+            case DXGI_FORMAT_R8G8B8A8_UNORM:
+            case DXGI_FORMAT_R8G8B8A8_UNORM_SRGB:
+                out = AmbilightPixelFormat::RGBA8;
+                return true;
+            case DXGI_FORMAT_B8G8R8A8_UNORM:
+            case DXGI_FORMAT_B8G8R8A8_UNORM_SRGB:
+            case DXGI_FORMAT_B8G8R8X8_UNORM:
+            case DXGI_FORMAT_B8G8R8X8_UNORM_SRGB:
+                out = AmbilightPixelFormat::BGRA8;
+                return true;
+            default:
+                return false;
+        }
+    }
+
+    void DisableCapture(const std::string& reason) {
+        g_CaptureDisabled.store(true);
+        LogToFile_Error("Ambilight capture disabled: " + reason);
+    }
+
+    // (Re)creates the mip chain and staging ring for the current backbuffer size and format
+    bool PrepareResources(const D3D11_TEXTURE2D_DESC& source) {
+        CaptureResources& c = g_Capture;
+        if (c.mipChain && c.format == source.Format && c.sourceWidth == source.Width &&
+            c.sourceHeight == source.Height) {
+            return true;
+        }
+        if (!ToPixelFormat(source.Format, c.pixelFormat)) {
+            DisableCapture("unsupported backbuffer format " + std::to_string(static_cast<int>(source.Format)));
+            return false;
+        }
+
+        D3D11_TEXTURE2D_DESC mipDesc = {};
+        mipDesc.Width = source.Width;
+        mipDesc.Height = source.Height;
+        mipDesc.MipLevels = 0;  // Full chain
+        mipDesc.ArraySize = 1;
+        mipDesc.Format = source.Format;
+        mipDesc.SampleDesc.Count = 1;
+        mipDesc.Usage = D3D11_USAGE_DEFAULT;
+        mipDesc.BindFlags = D3D11_BIND_SHADER_RESOURCE | D3D11_BIND_RENDER_TARGET;
+        mipDesc.MiscFlags = D3D11_RESOURCE_MISC_GENERATE_MIPS;
+        c.mipChain.Reset();
+        c.mipView.Reset();
+        if (FAILED(c.device->CreateTexture2D(&mipDesc, nullptr, &c.mipChain)) ||
+            FAILED(c.device->CreateShaderResourceView(c.mipChain.Get(), nullptr, &c.mipView))) {
+            DisableCapture("cannot create the mip chain texture");
+            return false;
+        }
+
+        c.mipLevel = 0;
+        c.width = source.Width;
+        c.height = source.Height;
+        while (c.width > static_cast<UINT>(g_Ambilight.capture_width) && c.width > 1 && c.height > 1) {
+            c.width = std::max(c.width / 2, 1u);
+            c.height = std::max(c.height / 2, 1u);
+            ++c.mipLevel;
+        }
+
+        D3D11_TEXTURE2D_DESC stagingDesc = {};
+        stagingDesc.Width = c.width;
+        stagingDesc.Height = c.height;
+        stagingDesc.MipLevels = 1;
+        stagingDesc.ArraySize = 1;
+        stagingDesc.Format = source.Format;
+        stagingDesc.SampleDesc.Count = 1;
+        stagingDesc.Usage = D3D11_USAGE_STAGING;
+        stagingDesc.CPUAccessFlags = D3D11_CPU_ACCESS_READ;
+        for (auto& texture : c.staging) {
+            texture.Reset();
+            if (FAILED(c.device->CreateTexture2D(&stagingDesc, nullptr, &texture))) {
+                DisableCapture("cannot create staging textures");
+                return false;
+            }
+        }
+        c.format = source.Format;
+        c.sourceWidth = source.Width;
+        c.sourceHeight = source.Height;
+        c.issued = c.read = 0;
+        LogToFile_Info("Ambilight capture: " + std::to_string(source.Width) + "x" + std::to_string(source.Height) +
+                       " backbuffer, reading mip " + std::to_string(c.mipLevel) + " (" + std::to_string(c.width) +
+                       "x" + std::to_string(c.height) + ").");
+        return true;
+    }
+
+    // Reads back finished copies, oldest first, without stalling on ones the GPU has not done yet
+    void ReadBackFinishedCopies() {
+        CaptureResources& c = g_Capture;
+        while (c.read < c.issued) {
+            ID3D11Texture2D* texture = c.staging[c.read % STAGING_COUNT].Get();
+            D3D11_MAPPED_SUBRESOURCE mapped;
+            HRESULT hr = c.context->Map(texture, 0, D3D11_MAP_READ, D3D11_MAP_FLAG_DO_NOT_WAIT, &mapped);
+            if (hr == DXGI_ERROR_WAS_STILL_DRAWING) return;
+            ++c.read;
+            if (FAILED(hr)) continue;
+            {
+                std::lock_guard lock(g_FrameMutex);
+                size_t rowBytes = static_cast<size_t>(c.width) * 4;
+                g_FramePixels.resize(rowBytes * c.height);
+                for (UINT y = 0; y < c.height; ++y) {
+                    std::memcpy(&g_FramePixels[y * rowBytes], static_cast<const std::uint8_t*>(mapped.pData) +
+                                                                  static_cast<size_t>(y) * mapped.RowPitch,
+                                rowBytes);
+                }
+                g_FrameWidth = static_cast<int>(c.width);
+                g_FrameHeight = static_cast<int>(c.height);
+                g_FrameFormat = c.pixelFormat;
+                g_FrameTime = std::chrono::steady_clock::now();
+            }
+            c.context->Unmap(texture, 0);
+        }
+    }
+
+    void CaptureBackbuffer(IDXGISwapChain* swapChain) {
+        CaptureResources& c = g_Capture;
+        if (!c.device) {
+            if (FAILED(swapChain->GetDevice(__uuidof(ID3D11Device), &c.device))) {
+                DisableCapture("swap chain has no D3D11 device");
+                return;
+            }
+            c.device->GetImmediateContext(&c.context);
+        }
+
+        ReadBackFinishedCopies();
+
+        auto now = std::chrono::steady_clock::now();
+        if (now - c.lastCopy < std::chrono::milliseconds(g_Ambilight.capture_interval_ms)) return;
+        if (c.issued - c.read >= STAGING_COUNT) return;  // GPU is behind; skip rather than wait
+
+        ComPtr<ID3D11Texture2D> backbuffer;
+        if (FAILED(swapChain->GetBuffer(0, __uuidof(ID3D11Texture2D), &backbuffer))) return;
+        D3D11_TEXTURE2D_DESC desc;
+        backbuffer->GetDesc(&desc);
+        if (!PrepareResources(desc)) return;
+
+        if (desc.SampleDesc.Count > 1) {
+            c.context->ResolveSubresource(c.mipChain.Get(), 0, backbuffer.Get(), 0, desc.Format);
+        } else {
+            c.context->CopySubresourceRegion(c.mipChain.Get(), 0, 0, 0, 0, backbuffer.Get(), 0, nullptr);
+        }
+        c.context->GenerateMips(c.mipView.Get());
+        c.context->CopySubresourceRegion(c.staging[c.issued % STAGING_COUNT].Get(), 0, 0, 0, 0, c.mipChain.Get(),
+                                         c.mipLevel, nullptr);
+        ++c.issued;
+        c.lastCopy = now;
+    }
+
+    HRESULT STDMETHODCALLTYPE PresentHook(IDXGISwapChain* swapChain, UINT syncInterval, UINT flags) {
+        // Other swap chains of the same class share the vtable (overlays, ENB); only capture the game's.
+        // DXGI_PRESENT_TEST presents nothing.
+        bool capture = swapChain == g_GameSwapChain && g_Ambilight.enabled && !(flags & DXGI_PRESENT_TEST) &&
+                       !g_CaptureDisabled.load(std::memory_order_relaxed);
+        if (capture) {
+            CaptureBackbuffer(swapChain);
+        }
+        return g_OriginalPresent(swapChain, syncInterval, flags);
+    }
+}
+
+bool InstallAmbilightCapture() {
+    if (g_OriginalPresent) return true;
+    auto renderer = RE::BSGraphics::Renderer::GetSingleton();
+    if (!renderer) {
+        LogToFile_Error("Ambilight capture: renderer not available.");
+        return false;
+    }
+    g_GameSwapChain = reinterpret_cast<IDXGISwapChain*>(renderer->GetRuntimeData().renderWindows[0].swapChain);
+    if (!g_GameSwapChain) {
+        LogToFile_Error("Ambilight capture: swap chain not available.");
+        return false;
+    }
+
+    auto vtable = *reinterpret_cast<std::uintptr_t**>(g_GameSwapChain);
+    g_OriginalPresent = reinterpret_cast<PresentFn>(vtable[PRESENT_VTABLE_INDEX]);
+    REL::safe_write(reinterpret_cast<std::uintptr_t>(&vtable[PRESENT_VTABLE_INDEX]),
+                    reinterpret_cast<std::uintptr_t>(&PresentHook));
+    LogToFile_Info("Ambilight capture installed (IDXGISwapChain::Present).");
+    return true;
+}
+
+bool GetLatestAmbilightCapture(std::vector<std::uint8_t>& pixels, AmbilightImage& image,
+                               std::chrono::milliseconds maxAge) {
+    std::lock_guard lock(g_FrameMutex);
+    if (g_FramePixels.empty() || std::chrono::steady_clock::now() - g_FrameTime > maxAge) return false;
+    pixels.assign(g_FramePixels.begin(), g_FramePixels.end());
+    image = {pixels.data(), g_FrameWidth, g_FrameHeight, static_cast<size_t>(g_FrameWidth) * 4, g_FrameFormat};
+    return true;
+}
+
+bool SaveAmbilightCapture(const std::filesystem::path& file) {
+    std::vector<std::uint8_t> pixels;
+    AmbilightImage image;
+    if (!GetLatestAmbilightCapture(pixels, image, std::chrono::hours(24))) return false;
+    return WriteAmbilightPpm(file, image);
+}
@@ -0,0 +1,23 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <vector>
+
+#include "Ambilight.h"
+
+// Backbuffer capture for the screen-color layer (D3D11, plugin only).
+// Hooks the game's IDXGISwapChain::Present. Every Ambilight.CaptureIntervalMs it resolves/copies the backbuffer
+// into a mipmapped texture, generates mips and copies the first mip at most Ambilight.CaptureWidth wide into a
+// ring of staging textures. Those are read back a frame or two later without waiting on the GPU. The export
+// thread picks up the newest copy.
+
+// Installs the Present hook. Call once after the renderer exists (kDataLoaded) and only if Ambilight is enabled.
+bool InstallAmbilightCapture();
+
+// Copies the newest capture into pixels (image points into it). False if there is none younger than maxAge.
+bool GetLatestAmbilightCapture(std::vector<std::uint8_t>& pixels, AmbilightImage& image,
+                               std::chrono::milliseconds maxAge);
+
+// Writes the newest capture as a PPM, e.g. to benchmark the kernel on real frames (bench/AmbilightBenchmarks.cpp)
+bool SaveAmbilightCapture(const std::filesystem::path& file);
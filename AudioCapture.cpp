@@ -0,0 +1,134 @@
+#include "AudioCapture.h"
+
+#include <Audioclient.h>
+#include <mmdeviceapi.h>
+#include <mmreg.h>
+#include <ksmedia.h>
+#include <wrl/client.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "AudioReactive.h"
+#include "ConfigLoader.h"
+#include "Logger.h"
+
+using Microsoft::WRL::ComPtr;
+
+namespace {
+    constexpr REFERENCE_TIME BUFFER_DURATION = 2'000'000;          // 200 ms, in 100 ns units
+    constexpr auto POLL_INTERVAL = std::chrono::milliseconds(10);  // Loopback clients cannot be event driven
+    constexpr auto RETRY_INTERVAL = std::chrono::seconds(5);       // After the device failed or went away
+
+    std::atomic<bool> g_CaptureStarted = false;
+
+    enum class SampleType { Float32, Int16, Unsupported };
+
+    SampleType GetSampleType(const WAVEFORMATEX* format) {
+        WORD tag = format->wFormatTag;
+        if (tag == WAVE_FORMAT_EXTENSIBLE) {
+            auto extensible = reinterpret_cast<const WAVEFORMATEXTENSIBLE*>(format);
+            if (extensible->SubFormat == KSDATAFORMAT_SUBTYPE_IEEE_FLOAT) {
+                tag = WAVE_FORMAT_IEEE_FLOAT;
+            } else if (extensible->SubFormat == KSDATAFORMAT_SUBTYPE_PCM) {
+                tag = WAVE_FORMAT_PCM;
+            }
+        }
+        if (tag == WAVE_FORMAT_IEEE_FLOAT && format->wBitsPerSample == 32) return SampleType::Float32;
+        if (tag == WAVE_FORMAT_PCM && format->wBitsPerSample == 16) return SampleType::Int16;
+        return SampleType::Unsupported;
+    }
+
+    // One loopback session on the current default output device. Returns when the device fails or goes away
+    // (e.g. the user switched outputs); the caller starts a new session on whatever is the default then.
+    void RunLoopbackSession(AudioBandAnalyzer& analyzer) {
+        ComPtr<IMMDeviceEnumerator> enumerator;
+        ComPtr<IMMDevice> device;
+        ComPtr<IAudioClient> client;
+        if (FAILED(CoCreateInstance(__uuidof(MMDeviceEnumerator), nullptr, CLSCTX_ALL, IID_PPV_ARGS(&enumerator))) ||
+            FAILED(enumerator->GetDefaultAudioEndpoint(eRender, eConsole, &device)) ||
+            FAILED(device->Activate(__uuidof(IAudioClient), CLSCTX_ALL, nullptr, &client))) {
+            HAL_LOG_WARN_LIMITED("Audio capture: no output device available.");
+            return;
+        }
+
+        WAVEFORMATEX* mixFormat = nullptr;
+        if (FAILED(client->GetMixFormat(&mixFormat))) return;
+        std::unique_ptr<WAVEFORMATEX, decltype(&CoTaskMemFree)> format(mixFormat, &CoTaskMemFree);
+        SampleType sampleType = GetSampleType(format.get());
+        if (sampleType == SampleType::Unsupported) {
+            HAL_LOG_WARN_LIMITED("Audio capture: unsupported mix format (tag {}, {} bits).", format->wFormatTag,
+                                 format->wBitsPerSample);
+            return;
+        }
+
+        ComPtr<IAudioCaptureClient> capture;
+        HRESULT hr = client->Initialize(AUDCLNT_SHAREMODE_SHARED, AUDCLNT_STREAMFLAGS_LOOPBACK, BUFFER_DURATION, 0,
+                                        format.get(), nullptr);
+        if (SUCCEEDED(hr)) hr = client->GetService(IID_PPV_ARGS(&capture));
+        if (SUCCEEDED(hr)) hr = client->Start();
+        if (FAILED(hr)) {
+            HAL_LOG_WARN_LIMITED("Audio capture: cannot open loopback stream (0x{:08X}).", static_cast<unsigned>(hr));
+            return;
+        }
+
+        int channels = format->nChannels;
+        analyzer.Configure(static_cast<int>(format->nSamplesPerSec), g_AudioReactive);
+        HAL_LOG_INFO("Audio capture: {} Hz, {} channels, {}-sample blocks.", format->nSamplesPerSec, channels,
+                     analyzer.GetBlockSize());
+
+        std::vector<float> samples;
+        while (SUCCEEDED(hr)) {
+            std::this_thread::sleep_for(POLL_INTERVAL);
+            UINT32 packetFrames = 0;
+            hr = capture->GetNextPacketSize(&packetFrames);
+            while (SUCCEEDED(hr) && packetFrames > 0) {
+                BYTE* data = nullptr;
+                UINT32 frames = 0;
+                DWORD flags = 0;
+                hr = capture->GetBuffer(&data, &frames, &flags, nullptr, nullptr);
+                if (FAILED(hr)) break;
+                size_t count = static_cast<size_t>(frames) * channels;
+                samples.resize(count);
+                if (flags & AUDCLNT_BUFFERFLAGS_SILENT) {
+                    std::fill(samples.begin(), samples.end(), 0.0f);
+                } else if (sampleType == SampleType::Float32) {
+                    std::memcpy(samples.data(), data, count * sizeof(float));
+                } else {
+                    const auto* pcm = reinterpret_cast<const std::int16_t*>(data);
+                    for (size_t i = 0; i < count; ++i) samples[i] = static_cast<float>(pcm[i]) / 32768.0f;
+                }
+                capture->ReleaseBuffer(frames);
+
+                if (analyzer.Push(samples.data(), frames, channels) > 0) g_AudioBands.Publish(analyzer.GetBands());
+                hr = capture->GetNextPacketSize(&packetFrames);
+            }
+        }
+        HAL_LOG_WARN_LIMITED("Audio capture: stream lost (0x{:08X}), reconnecting.", static_cast<unsigned>(hr));
+        client->Stop();
+    }
+
+    void AudioCaptureThread() {
+        if (FAILED(CoInitializeEx(nullptr, COINIT_MULTITHREADED))) {
+            LogToFile_Error("Audio capture: COM initialization failed.");
+            return;
+        }
+        AudioBandAnalyzer analyzer;
+        while (true) {
+            RunLoopbackSession(analyzer);
+            std::this_thread::sleep_for(RETRY_INTERVAL);
+        }
+    }
+}
+
+bool StartAudioCapture() {
+    if (g_CaptureStarted.exchange(true)) return true;
+    std::thread(AudioCaptureThread).detach();  // Runs for the lifetime of the game, like the export thread
+    LogToFile_Info("Audio capture thread started (WASAPI loopback of the default output device).");
+    return true;
+}
@@ -0,0 +1,9 @@
+#pragma once
+
+// Sound input for the audio-reactive layers (WASAPI, plugin only).
+// A dedicated thread captures the default output device in loopback mode (what the game plays, mixed with
+// anything else on that device), feeds it through an AudioBandAnalyzer and publishes every analyzed block to
+// g_AudioBands. The export thread only reads that snapshot, so a slow or missing audio device never delays a tick.
+
+// Starts the capture thread. Call once after the config is loaded and only if AudioReactive is enabled.
+bool StartAudioCapture();
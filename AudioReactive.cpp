@@ -0,0 +1,373 @@
+#include "AudioReactive.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+
+#include "Profiler.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #define HAL_AUDIO_SSE2 1
+    #include <emmintrin.h>
+#endif
+
+AudioBandsSnapshot g_AudioBands;
+
+namespace {
+    constexpr const char* BAND_NAMES[] = {"bass", "low_mid", "high_mid", "treble"};
+    static_assert(std::size(BAND_NAMES) == AUDIO_BAND_COUNT);
+    constexpr float BAND_EDGES_HZ[AUDIO_BAND_COUNT + 1] = {20.0f, 150.0f, 600.0f, 2500.0f, 10000.0f};
+    constexpr float PI = 3.14159265358979323846f;
+
+    // Per-block factor of an exponential smoother with the given time constant
+    float SmoothingCoefficient(float timeMs, float blockSeconds) {
+        if (timeMs <= 0.0f) return 0.0f;
+        return std::exp(-blockSeconds / (timeMs / 1000.0f));
+    }
+
+    std::int64_t SteadyNowNs() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                   std::chrono::steady_clock::now().time_since_epoch())
+            .count();
+    }
+}
+
+const char* GetAudioBandName(AudioBand band) {
+    size_t index = static_cast<size_t>(band);
+    return index < AUDIO_BAND_COUNT ? BAND_NAMES[index] : "?";
+}
+
+bool ParseAudioBand(std::string_view name, AudioBand& band) {
+    for (size_t i = 0; i < AUDIO_BAND_COUNT; ++i) {
+        if (name == BAND_NAMES[i]) {
+            band = static_cast<AudioBand>(i);
+            return true;
+        }
+    }
+    return false;
+}
+
+// --- FFT ---
+
+void AudioFft::Configure(size_t n) {
+    if (n == size) return;
+    size = n;
+    int bits = 0;
+    while ((size_t{1} << bits) < n) ++bits;
+    reversed.resize(n);
+    for (size_t i = 0; i < n; ++i) {
+        std::uint32_t r = 0;
+        for (int b = 0; b < bits; ++b) r |= static_cast<std::uint32_t>((i >> b) & 1) << (bits - 1 - b);
+        reversed[i] = r;
+    }
+    twiddleRe.assign(n, 0.0f);
+    twiddleIm.assign(n, 0.0f);
+    for (size_t h = 1; h < n; h <<= 1) {
+        for (size_t j = 0; j < h; ++j) {
+            double angle = -3.14159265358979323846 * static_cast<double>(j) / static_cast<double>(h);
+            twiddleRe[h + j] = static_cast<float>(std::cos(angle));
+            twiddleIm[h + j] = static_cast<float>(std::sin(angle));
+        }
+    }
+}
+
+void AudioFft::BitReverse(float* re, float* im) const {
+    for (size_t i = 0; i < size; ++i) {
+        size_t j = reversed[i];
+        if (i < j) {
+            std::swap(re[i], re[j]);
+            std::swap(im[i], im[j]);
+        }
+    }
+}
+
+void AudioFft::ForwardScalar(float* re, float* im) const {
+    BitReverse(re, im);
+    for (size_t h = 1; h < size; h <<= 1) {
+        for (size_t group = 0; group < size; group += 2 * h) {
+            for (size_t j = 0; j < h; ++j) {
+                size_t a = group + j, b = a + h;
+                float wr = twiddleRe[h + j], wi = twiddleIm[h + j];
+                float tr = re[b] * wr - im[b] * wi;
+                float ti = re[b] * wi + im[b] * wr;
+                re[b] = re[a] - tr;
+                im[b] = im[a] - ti;
+                re[a] = re[a] + tr;
+                im[a] = im[a] + ti;
+            }
+        }
+    }
+}
+
+void AudioFft::Forward(float* re, float* im) const {
+#ifdef HAL_AUDIO_SSE2
+    BitReverse(re, im);
+    // Spans 1 and 2 have fewer than four butterflies per group: scalar
+    for (size_t h = 1; h < size && h < 4; h <<= 1) {
+        for (size_t group = 0; group < size; group += 2 * h) {
+            for (size_t j = 0; j < h; ++j) {
+                size_t a = group + j, b = a + h;
+                float wr = twiddleRe[h + j], wi = twiddleIm[h + j];
+                float tr = re[b] * wr - im[b] * wi;
+                float ti = re[b] * wi + im[b] * wr;
+                re[b] = re[a] - tr;
+                im[b] = im[a] - ti;
+                re[a] = re[a] + tr;
+                im[a] = im[a] + ti;
+            }
+        }
+    }
+    // Four butterflies per step on the split arrays
+    for (size_t h = 4; h < size; h <<= 1) {
+        for (size_t group = 0; group < size; group += 2 * h) {
+            for (size_t j = 0; j < h; j += 4) {
+                float* ar = re + group + j;
+                float* ai = im + group + j;
+                float* br = ar + h;
+                float* bi = ai + h;
+                __m128 wr = _mm_loadu_ps(&twiddleRe[h + j]);
+                __m128 wi = _mm_loadu_ps(&twiddleIm[h + j]);
+                __m128 xr = _mm_loadu_ps(br);
+                __m128 xi = _mm_loadu_ps(bi);
+                __m128 tr = _mm_sub_ps(_mm_mul_ps(xr, wr), _mm_mul_ps(xi, wi));
+                __m128 ti = _mm_add_ps(_mm_mul_ps(xr, wi), _mm_mul_ps(xi, wr));
+                __m128 yr = _mm_loadu_ps(ar);
+                __m128 yi = _mm_loadu_ps(ai);
+                _mm_storeu_ps(br, _mm_sub_ps(yr, tr));
+                _mm_storeu_ps(bi, _mm_sub_ps(yi, ti));
+                _mm_storeu_ps(ar, _mm_add_ps(yr, tr));
+                _mm_storeu_ps(ai, _mm_add_ps(yi, ti));
+            }
+        }
+    }
+#else
+    ForwardScalar(re, im);
+#endif
+}
+
+// --- Band analysis ---
+
+void AudioBandAnalyzer::Configure(int rate, const AudioReactiveConfig& config) {
+    sampleRate = std::max(rate, 1);
+    size_t n = static_cast<size_t>(config.block_size);
+    fft.Configure(n);
+    window.resize(n);
+    for (size_t i = 0; i < n; ++i) {
+        window[i] = 0.5f - 0.5f * std::cos(2.0f * PI * static_cast<float>(i) / static_cast<float>(n));  // Hann
+    }
+    for (size_t b = 0; b <= AUDIO_BAND_COUNT; ++b) {
+        float bin = BAND_EDGES_HZ[b] * static_cast<float>(n) / static_cast<float>(sampleRate);
+        bandBins[b] = std::clamp<size_t>(static_cast<size_t>(std::lround(bin)), 1, n / 2);
+    }
+    floorDb = std::min(config.floor_db, -1.0f);
+    float blockSeconds = static_cast<float>(n / 2) / static_cast<float>(sampleRate);
+    attack = SmoothingCoefficient(config.attack_ms, blockSeconds);
+    release = SmoothingCoefficient(config.release_ms, blockSeconds);
+    average = SmoothingCoefficient(config.transient_window_ms, blockSeconds);
+    history.clear();
+    history.reserve(2 * n);
+    re.assign(n, 0.0f);
+    im.assign(n, 0.0f);
+    slowLevel = {};
+    primed = false;
+    bands = {};
+}
+
+std::array<float, AUDIO_BAND_COUNT> AudioBandAnalyzer::AnalyzeBlock(const float* mono, bool scalar) {
+    size_t n = fft.GetSize();
+    for (size_t i = 0; i < n; ++i) {
+        re[i] = mono[i] * window[i];
+        im[i] = 0.0f;
+    }
+    if (scalar) {
+        fft.ForwardScalar(re.data(), im.data());
+    } else {
+        fft.Forward(re.data(), im.data());
+    }
+
+    // A full-scale sine centered on a bin peaks at n/4 after the Hann window, and its main lobe holds 1.5x the
+    // peak power: that is 0 dB.
+    float quarter = static_cast<float>(n) / 4.0f;
+    float fullScale = 1.5f * quarter * quarter;
+    std::array<float, AUDIO_BAND_COUNT> levels{};
+    for (size_t b = 0; b < AUDIO_BAND_COUNT; ++b) {
+        float power = 0.0f;
+        for (size_t k = bandBins[b]; k < bandBins[b + 1]; ++k) power += re[k] * re[k] + im[k] * im[k];
+        float db = 10.0f * std::log10(std::max(power / fullScale, 1e-12f));
+        levels[b] = std::clamp((db - floorDb) / -floorDb, 0.0f, 1.0f);
+    }
+    return levels;
+}
+
+void AudioBandAnalyzer::UpdateEnvelopes(const std::array<float, AUDIO_BAND_COUNT>& levels) {
+    if (!primed) {
+        slowLevel = levels;  // The first block after (re)configuring is not a transient
+        primed = true;
+    }
+    for (size_t b = 0; b < AUDIO_BAND_COUNT; ++b) {
+        float level = levels[b];
+        float& envelope = bands.level[b];
+        envelope = level + (envelope - level) * (level > envelope ? attack : release);
+
+        // Transients rise instantly and fall with the release time
+        float rise = std::clamp(level - slowLevel[b], 0.0f, 1.0f);
+        float& transient = bands.transient[b];
+        transient = rise > transient ? rise : rise + (transient - rise) * release;
+        slowLevel[b] = level + (slowLevel[b] - level) * average;
+    }
+}
+
+int AudioBandAnalyzer::Push(const float* interleaved, size_t frames, int channels) {
+    size_t n = fft.GetSize();
+    if (n == 0 || channels <= 0) return 0;
+    float scale = 1.0f / static_cast<float>(channels);
+    for (size_t f = 0; f < frames; ++f) {
+        float sum = 0.0f;
+        for (int c = 0; c < channels; ++c) sum += interleaved[f * channels + c];
+        history.push_back(sum * scale);
+    }
+
+    int analyzed = 0;
+    size_t offset = 0;
+    while (history.size() - offset >= n) {
+        ScopedStageTimer dspTimer(PipelineStage::AudioDsp);
+        UpdateEnvelopes(AnalyzeBlock(history.data() + offset));
+        offset += n / 2;
+        ++analyzed;
+    }
+    history.erase(history.begin(), history.begin() + static_cast<std::ptrdiff_t>(offset));
+    return analyzed;
+}
+
+// --- Snapshot (seqlock: odd sequence = write in progress) ---
+
+void AudioBandsSnapshot::Publish(const AudioBands& bands) {
+    std::uint32_t seq = sequence.load(std::memory_order_relaxed);
+    sequence.store(seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    for (size_t b = 0; b < AUDIO_BAND_COUNT; ++b) {
+        values[b].store(bands.level[b], std::memory_order_relaxed);
+        values[AUDIO_BAND_COUNT + b].store(bands.transient[b], std::memory_order_relaxed);
+    }
+    publishedNs.store(SteadyNowNs(), std::memory_order_relaxed);
+    sequence.store(seq + 2, std::memory_order_release);
+}
+
+bool AudioBandsSnapshot::Read(AudioBands& out, std::chrono::milliseconds maxAge) const {
+    for (int attempt = 0; attempt < 4; ++attempt) {
+        std::uint32_t before = sequence.load(std::memory_order_acquire);
+        if (before & 1) continue;
+        for (size_t b = 0; b < AUDIO_BAND_COUNT; ++b) {
+            out.level[b] = values[b].load(std::memory_order_relaxed);
+            out.transient[b] = values[AUDIO_BAND_COUNT + b].load(std::memory_order_relaxed);
+        }
+        std::int64_t published = publishedNs.load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (sequence.load(std::memory_order_relaxed) != before) continue;
+        return published != 0 && SteadyNowNs() - published <=
+                                     std::chrono::duration_cast<std::chrono::nanoseconds>(maxAge).count();
+    }
+    return false;
+}
+
+// --- Modulation layers ---
+
+float EvaluateAudioCurve(const std::vector<AudioCurvePoint>& curve, float level) {
+    if (curve.empty()) return 0.0f;
+    if (level <= curve.front().level) return curve.front().value;
+    for (size_t i = 1; i < curve.size(); ++i) {
+        const AudioCurvePoint& a = curve[i - 1];
+        const AudioCurvePoint& b = curve[i];
+        if (level <= b.level) {
+            float t = (b.level > a.level) ? (level - a.level) / (b.level - a.level) : 1.0f;
+            return a.value + t * (b.value - a.value);
+        }
+    }
+    return curve.back().value;
+}
+
+void ApplyAudioModulation(std::vector<LightState>& states, const AudioBands& bands,
+                          const AudioReactiveConfig& config) {
+    auto bandIndex = [](int band) {
+        return static_cast<size_t>(std::clamp(band, 0, static_cast<int>(AUDIO_BAND_COUNT) - 1));
+    };
+    float intensity = EvaluateAudioCurve(config.intensity_curve, bands.level[bandIndex(config.intensity_band)]);
+    int amplitude = static_cast<int>(std::lround(
+        EvaluateAudioCurve(config.flicker_curve, bands.transient[bandIndex(config.flicker_band)])));
+    int added = static_cast<int>(std::lround(intensity));
+
+    for (auto& state : states) {
+        if (state.inherit || state.scene.has_value()) continue;
+        state.brightness_pct = std::clamp(state.brightness_pct + added, 10, 100);
+        if (amplitude < 1) continue;
+        if (!state.effect.has_value()) {
+            state.effect = "flicker";
+            state.flicker = FlickerConfig{amplitude / 2, amplitude / 2, amplitude / 2, amplitude};
+        } else if (state.effect.value() == "flicker") {
+            FlickerConfig flicker = state.flicker.value_or(FlickerConfig{});
+            flicker.brightness = std::max(flicker.brightness, amplitude);
+            state.flicker = flicker;
+        }
+    }
+}
+
+// --- WAV files ---
+
+bool LoadWavFile(const std::filesystem::path& file, std::vector<float>& samples, int& sampleRate, int& channels) {
+    std::string bytes;
+    if (!ReadTextFile(file, bytes) || bytes.size() < 12 || bytes.compare(0, 4, "RIFF") != 0 ||
+        bytes.compare(8, 4, "WAVE") != 0) {
+        return false;
+    }
+    auto u16 = [&](size_t at) {
+        return static_cast<std::uint32_t>(static_cast<std::uint8_t>(bytes[at])) |
+               static_cast<std::uint32_t>(static_cast<std::uint8_t>(bytes[at + 1])) << 8;
+    };
+    auto u32 = [&](size_t at) { return u16(at) | u16(at + 2) << 16; };
+
+    std::uint32_t format = 0, bits = 0;
+    channels = 0;
+    sampleRate = 0;
+    size_t pos = 12;
+    while (pos + 8 <= bytes.size()) {
+        std::string_view id(bytes.data() + pos, 4);
+        size_t length = u32(pos + 4);
+        size_t body = pos + 8;
+        if (body + length > bytes.size()) length = bytes.size() - body;  // Truncated file: take what is there
+        if (id == "fmt " && length >= 16) {
+            format = u16(body);
+            channels = static_cast<int>(u16(body + 2));
+            sampleRate = static_cast<int>(u32(body + 4));
+            bits = u16(body + 14);
+            if (format == 0xFFFE && length >= 26) format = u16(body + 24);  // WAVE_FORMAT_EXTENSIBLE sub-format
+        } else if (id == "data" && channels > 0) {
+            const char* data = bytes.data() + body;
+            samples.clear();
+            if (format == 1 && bits == 16) {
+                samples.resize(length / 2);
+                for (size_t i = 0; i < samples.size(); ++i) {
+                    std::int16_t v;
+                    std::memcpy(&v, data + 2 * i, 2);
+                    samples[i] = static_cast<float>(v) / 32768.0f;
+                }
+            } else if (format == 1 && bits == 24) {
+                samples.resize(length / 3);
+                for (size_t i = 0; i < samples.size(); ++i) {
+                    auto b = reinterpret_cast<const std::uint8_t*>(data + 3 * i);
+                    std::int32_t v = static_cast<std::int32_t>((b[0] << 8) | (b[1] << 16) | (b[2] << 24)) >> 8;
+                    samples[i] = static_cast<float>(v) / 8388608.0f;
+                }
+            } else if (format == 3 && bits == 32) {
+                samples.resize(length / 4);
+                std::memcpy(samples.data(), data, samples.size() * 4);
+            } else {
+                return false;
+            }
+            samples.resize(samples.size() - samples.size() % static_cast<size_t>(channels));
+            return sampleRate > 0;
+        }
+        pos = body + length + (length & 1);  // Chunks are word aligned
+    }
+    return false;
+}
@@ -0,0 +1,109 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <string_view>
+#include <vector>
+
+#include "ConfigLoader.h"  // For AudioReactiveConfig, AudioCurvePoint, LightState
+
+// Audio-reactive layers: the game's sound output is cut into half-overlapping blocks, each block goes through a
+// Hann window and an FFT, and the power in four bands is turned into a 0..1 level (dB between the configured floor
+// and full scale) with an attack/release envelope. A band's level drives the intensity layer (brightness added);
+// its transient (level above its recent average: hits, roars, explosions) drives the flicker layer.
+// Capture (WASAPI loopback, plugin only) lives in AudioCapture.cpp; this part is portable and benchmarked on Linux.
+
+enum class AudioBand : std::uint8_t {
+    Bass,     // 20-150 Hz
+    LowMid,   // 150-600 Hz
+    HighMid,  // 600-2500 Hz
+    Treble,   // 2500-10000 Hz
+    Count
+};
+constexpr size_t AUDIO_BAND_COUNT = static_cast<size_t>(AudioBand::Count);
+
+const char* GetAudioBandName(AudioBand band);
+bool ParseAudioBand(std::string_view name, AudioBand& band);  // "bass", "low_mid", "high_mid", "treble"
+
+struct AudioBands {
+    std::array<float, AUDIO_BAND_COUNT> level{};      // Envelope, 0..1
+    std::array<float, AUDIO_BAND_COUNT> transient{};  // Level above its recent average, 0..1
+};
+
+// In-place radix-2 FFT on split real/imaginary arrays. The SSE2 path (x86/x64) and the scalar reference run the
+// same butterflies in the same order and agree to float rounding.
+class AudioFft {
+public:
+    void Configure(size_t size);  // Power of two >= 4
+    void Forward(float* re, float* im) const;
+    void ForwardScalar(float* re, float* im) const;
+    size_t GetSize() const { return size; }
+
+private:
+    void BitReverse(float* re, float* im) const;
+
+    size_t size = 0;
+    std::vector<std::uint32_t> reversed;      // Bit-reversed index per index
+    std::vector<float> twiddleRe, twiddleIm;  // Stage with half-span h uses entries [h, 2h)
+};
+
+class AudioBandAnalyzer {
+public:
+    // Block size, band bins and envelope coefficients; resets the envelopes and the buffered samples
+    void Configure(int sampleRate, const AudioReactiveConfig& config);
+
+    // Interleaved float PCM (any channel count, downmixed). Analyzes every completed block (hop = half a block).
+    // Returns the number of blocks analyzed; GetBands() holds the result of the last one.
+    int Push(const float* interleaved, size_t frames, int channels);
+
+    // Band power of one block of mono samples (GetBlockSize() of them) as 0..1 levels, without envelopes
+    std::array<float, AUDIO_BAND_COUNT> AnalyzeBlock(const float* mono, bool scalar = false);
+
+    const AudioBands& GetBands() const { return bands; }
+    size_t GetBlockSize() const { return fft.GetSize(); }
+    int GetSampleRate() const { return sampleRate; }
+
+private:
+    void UpdateEnvelopes(const std::array<float, AUDIO_BAND_COUNT>& levels);
+
+    AudioFft fft;
+    int sampleRate = 0;
+    float floorDb = -60.0f;
+    float attack = 0.0f, release = 0.0f, average = 0.0f;  // Per-block smoothing coefficients
+    std::array<size_t, AUDIO_BAND_COUNT + 1> bandBins{};  // Band b covers bins [bandBins[b], bandBins[b + 1])
+    std::vector<float> window;
+    std::vector<float> history;  // Mono samples not yet analyzed
+    std::vector<float> re, im;   // FFT scratch
+    std::array<float, AUDIO_BAND_COUNT> slowLevel{};
+    bool primed = false;
+    AudioBands bands;
+};
+
+// Latest band state, written by the capture thread and read by the export thread without locks (seqlock)
+class AudioBandsSnapshot {
+public:
+    void Publish(const AudioBands& bands);  // Single writer
+    // False if nothing was published in the last maxAge, or the writer kept interfering
+    bool Read(AudioBands& out, std::chrono::milliseconds maxAge) const;
+
+private:
+    std::atomic<std::uint32_t> sequence{0};
+    std::array<std::atomic<float>, 2 * AUDIO_BAND_COUNT> values{};
+    std::atomic<std::int64_t> publishedNs{0};  // steady_clock, 0 = never
+};
+extern AudioBandsSnapshot g_AudioBands;
+
+// Piecewise linear; levels below the first / above the last point take that point's value
+float EvaluateAudioCurve(const std::vector<AudioCurvePoint>& curve, float level);
+
+// Intensity layer (brightness added from the intensity band's level) and flicker layer (the lamps flicker with
+// the flicker band's transient as amplitude) over the final lamp states. Scene and inherit states are left alone.
+void ApplyAudioModulation(std::vector<LightState>& states, const AudioBands& bands, const AudioReactiveConfig& config);
+
+// --- WAV files, for the analysis tool and benchmarks ---
+
+// 16/24-bit PCM or 32-bit float WAV as interleaved floats
+bool LoadWavFile(const std::filesystem::path& file, std::vector<float>& samples, int& sampleRate, int& channels);
@@ -1,30 +1,49 @@
 #include "ConfigLoader.h"
 
-#include <Windows.h>  // for MAX_PATH and HMODULE
+#ifdef _WIN32
+    #include <Windows.h>  // for MAX_PATH and HMODULE
+#endif
 
 #include <algorithm>
 #include <filesystem>
 #include <fstream>
+#include <mutex>
 #include <nlohmann/json.hpp>
 
+#include "AudioReactive.h"
+#include "EntityHealth.h"
 #include "Logger.h"
+#include "Metrics.h"
+#include "ModEventTriggers.h"
+#include "Profiler.h"
+#include "TraceRecorder.h"
 #include "SkyrimLightsDB.h"
+#include "StartupTiming.h"
 using json = nlohmann::json;
 
 const std::string CONFIG_FILE_NAME = "HomeAssistantLink.json";
-float g_DirectionSharpness = 2.0f;
 
 // Define globals
 std::string g_HA_URL;
 std::string g_HA_TOKEN;
+bool g_HA_HTTP2 = false;
 std::vector<std::string> g_LIGHT_ENTITY_IDS;
 std::vector<Scenario> g_SCENARIOS;
 std::vector<RealLamp> g_RealLamps;
 bool g_DebugMode = false;
 std::vector<DayNightKeyframe> g_DayNightCycle;  // New for day/night curve!
+TelemetryConfig g_Telemetry;
+DiagnosticsConfig g_Diagnostics;
+AmbilightConfig g_Ambilight;
+AudioReactiveConfig g_AudioReactive;
+TuyaConfig g_Tuya;
+LampHealthConfig g_LampHealth;
+SendConfig g_Send;
+LightingOptions g_LightingOptions;
 
 // Function to get the path of the current DLL (your plugin)
 std::filesystem::path GetCurrentModulePath() {
+#ifdef _WIN32
     char path[MAX_PATH];  // MAX_PATH is defined in Windows.h
     HMODULE hm = NULL;
 
@@ -45,6 +64,46 @@ std::filesystem::path GetCurrentModulePath() {
         return "";
     }
     return std::filesystem::path(path);
+#else
+    return {};  // Only the SKSE plugin has a module path; tools pass the config file explicitly
+#endif
+}
+
+// --- Live lighting options ---
+namespace {
+    std::mutex g_LiveOptionsMutex;
+    LiveLightingOptions g_LiveOptions;
+}
+
+LiveLightingOptions GetLiveLightingOptions() {
+    std::lock_guard lock(g_LiveOptionsMutex);
+    return g_LiveOptions;
+}
+
+LightingOptions SetLiveLightingOptions(const LightingOptions &options) {
+    LightingOptions clamped;
+    clamped.direction_sharpness = std::clamp(options.direction_sharpness, 0.1f, 16.0f);
+    clamped.light_radius = std::clamp(options.light_radius, 50.0f, 4000.0f);
+    clamped.fire_exponent = std::clamp(options.fire_exponent, 0.05f, 4.0f);
+    clamped.smoothing = std::clamp(options.smoothing, 0.01f, 1.0f);
+    std::lock_guard lock(g_LiveOptionsMutex);
+    g_LiveOptions.options = clamped;
+    ++g_LiveOptions.version;
+    return clamped;
+}
+
+// [[level, value], ...] with levels in 0..1, sorted by level. False (curve unchanged) if malformed.
+static bool ParseAudioCurve(const json &j, std::vector<AudioCurvePoint> &curve) {
+    if (!j.is_array() || j.empty()) return false;
+    std::vector<AudioCurvePoint> points;
+    for (const auto &p : j) {
+        if (!p.is_array() || p.size() != 2 || !p[0].is_number() || !p[1].is_number()) return false;
+        points.push_back({std::clamp(p[0].get<float>(), 0.0f, 1.0f), p[1].get<float>()});
+    }
+    std::stable_sort(points.begin(), points.end(),
+                     [](const AudioCurvePoint &a, const AudioCurvePoint &b) { return a.level < b.level; });
+    curve = std::move(points);
+    return true;
 }
 
 // Function to load configuration from JSON file
@@ -54,36 +113,57 @@ bool LoadConfiguration() {
         LogToConsole("ERROR: Could not determine plugin path. Cannot load configuration file.");
         return false;
     }
-    std::filesystem::path configFilePath = pluginPath.parent_path() / CONFIG_FILE_NAME;
+    return LoadConfigurationFromFile(pluginPath.parent_path() / CONFIG_FILE_NAME);
+}
 
+bool ReadTextFile(const std::filesystem::path &path, std::string &contents) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) return false;
+    file.seekg(0, std::ios::end);
+    auto size = file.tellg();
+    if (size < 0) return false;
+    contents.resize(static_cast<size_t>(size));
+    file.seekg(0, std::ios::beg);
+    return static_cast<bool>(file.read(contents.data(), static_cast<std::streamsize>(contents.size())));
+}
+
+bool LoadConfigurationFromFile(const std::filesystem::path &configFilePath) {
     LogToFile_Info("Attempting to load configuration from: " + configFilePath.string() + ".");
 
-    std::ifstream configFile(configFilePath);
-    if (!configFile.is_open()) {
+    std::string configText;
+    ScopedStartupTimer readTimer(StartupPhase::ConfigRead);
+    if (!ReadTextFile(configFilePath, configText)) {
         LogToFile_Error("Failed to open configuration file: " + configFilePath.string() +
                         ". Home Assistant Link will not function.");
-        LogToConsole("ERROR: Failed to open config: " + CONFIG_FILE_NAME);
+        LogToConsole("ERROR: Failed to open config: " + configFilePath.filename().string());
         return false;
     }
 
+    readTimer.Stop();
+
     try {
-        json config = json::parse(configFile);
+        ScopedStartupTimer parseTimer(StartupPhase::ConfigParse);
+        json config = json::parse(configText);
+        parseTimer.Stop();
+        ScopedStartupTimer buildTimer(StartupPhase::ConfigBuild);
 
         // --- Lighting Options (Direction Sharpness etc) ---
+        g_LightingOptions = LightingOptions{};
         if (config.contains("LightingOptions") && config["LightingOptions"].is_object()) {
             auto &lo = config["LightingOptions"];
-            if (lo.contains("directionSharpness") && lo["directionSharpness"].is_number()) {
-                g_DirectionSharpness = lo["directionSharpness"].get<float>();
-                LogToFile_Info("Loaded directionSharpness: " + std::to_string(g_DirectionSharpness));
-                NotifyIngame("Loaded directionSharpness: " + std::to_string(g_DirectionSharpness));
-            } else {
-                g_DirectionSharpness = 2.0f;
-                LogToFile_Info("directionSharpness not set, using default 2.0");
-            }
+            auto &o = g_LightingOptions;
+            o.direction_sharpness = lo.value("directionSharpness", o.direction_sharpness);
+            o.light_radius = lo.value("lightRadius", o.light_radius);
+            o.fire_exponent = lo.value("fireExponent", o.fire_exponent);
+            o.smoothing = lo.value("smoothing", o.smoothing);
         } else {
-            g_DirectionSharpness = 2.0f;
-            LogToFile_Info("No LightingOptions section, using default directionSharpness 2.0");
+            LogToFile_Info("No LightingOptions section, using the defaults");
         }
+        g_LightingOptions = SetLiveLightingOptions(g_LightingOptions);
+        LogToFile_Info("Lighting options: directionSharpness " + std::to_string(g_LightingOptions.direction_sharpness) +
+                       ", lightRadius " + std::to_string(g_LightingOptions.light_radius) + ", fireExponent " +
+                       std::to_string(g_LightingOptions.fire_exponent) + ", smoothing " +
+                       std::to_string(g_LightingOptions.smoothing));
 
         // --- NEW: Parse DayNightCycle for dynamic ambient ---
         g_DayNightCycle.clear();
@@ -118,6 +198,8 @@ bool LoadConfiguration() {
                     "'Token' not found or not a string in 'HomeAssistant' section of config. Using empty Token.");
                 g_HA_TOKEN = "";
             }
+            g_HA_HTTP2 = config["HomeAssistant"].value("Http2", false);
+            if (g_HA_HTTP2) LogToFile_Info("HTTP/2: Enabled (calls of a tick multiplexed over one connection).");
             // Read DebugMode
             if (config["HomeAssistant"].contains("DebugMode") && config["HomeAssistant"]["DebugMode"].is_boolean()) {
                 g_DebugMode = config["HomeAssistant"]["DebugMode"].get<bool>();
@@ -133,9 +215,189 @@ bool LoadConfiguration() {
             LogToFile_Warn("'HomeAssistant' section not found or not an object in config.");
             g_HA_URL = "";
             g_HA_TOKEN = "";
+            g_HA_HTTP2 = false;
             g_DebugMode = false;
         }
 
+        // --- Optional telemetry stream for external tools ---
+        g_Telemetry = TelemetryConfig{};
+        if (config.contains("Telemetry") && config["Telemetry"].is_object()) {
+            const auto &t = config["Telemetry"];
+            g_Telemetry.enabled = t.value("Enabled", false);
+            g_Telemetry.address = t.value("Address", g_Telemetry.address);
+            g_Telemetry.port = t.value("Port", g_Telemetry.port);
+            int interval_ms = t.value("IntervalMs", g_Telemetry.interval_ms);
+            g_Telemetry.interval_ms = std::max(EXPORT_TICK_MS, interval_ms);
+            if (g_Telemetry.enabled && interval_ms < EXPORT_TICK_MS) {
+                LogToFile_Warn("Telemetry.IntervalMs " + std::to_string(interval_ms) + " is shorter than the " +
+                               std::to_string(EXPORT_TICK_MS) + " ms export tick; publishing once per tick.");
+            }
+            g_Telemetry.max_lights = std::clamp(t.value("MaxLights", g_Telemetry.max_lights), 0, 32);
+            g_Telemetry.ttl = std::clamp(t.value("Ttl", g_Telemetry.ttl), 1, 255);
+            if (g_Telemetry.enabled) {
+                LogToFile_Info("Telemetry enabled: " + g_Telemetry.address + ":" + std::to_string(g_Telemetry.port) +
+                               " every " + std::to_string(g_Telemetry.interval_ms) + " ms.");
+            }
+        }
+
+        // --- Optional screen-color layer ---
+        g_Ambilight = AmbilightConfig{};
+        if (config.contains("Ambilight") && config["Ambilight"].is_object()) {
+            const auto &a = config["Ambilight"];
+            g_Ambilight.enabled = a.value("Enabled", false);
+            g_Ambilight.mix = std::clamp(a.value("Mix", g_Ambilight.mix), 0.0f, 1.0f);
+            g_Ambilight.columns = std::clamp(a.value("Columns", g_Ambilight.columns), 1, 64);
+            g_Ambilight.rows = std::clamp(a.value("Rows", g_Ambilight.rows), 1, 64);
+            g_Ambilight.horizontal_fov =
+                std::clamp(a.value("HorizontalFov", g_Ambilight.horizontal_fov), 10.0f, 170.0f);
+            g_Ambilight.vertical_fov = std::clamp(a.value("VerticalFov", g_Ambilight.vertical_fov), 10.0f, 170.0f);
+            g_Ambilight.spread = std::clamp(a.value("Spread", g_Ambilight.spread), 0.1f, 64.0f);
+            g_Ambilight.capture_width = std::clamp(a.value("CaptureWidth", g_Ambilight.capture_width), 8, 512);
+            g_Ambilight.capture_interval_ms =
+                std::max(0, a.value("CaptureIntervalMs", g_Ambilight.capture_interval_ms));
+            if (g_Ambilight.enabled) {
+                LogToFile_Info("Ambilight enabled: " + std::to_string(g_Ambilight.columns) + "x" +
+                               std::to_string(g_Ambilight.rows) + " regions, mix " + std::to_string(g_Ambilight.mix) +
+                               ".");
+            }
+        }
+
+        // --- Optional audio-reactive layers ---
+        g_AudioReactive = AudioReactiveConfig{};
+        if (config.contains("AudioReactive") && config["AudioReactive"].is_object()) {
+            const auto &a = config["AudioReactive"];
+            auto &cfg = g_AudioReactive;
+            cfg.enabled = a.value("Enabled", false);
+            int blockSize = std::clamp(a.value("BlockSize", cfg.block_size), 256, 8192);
+            cfg.block_size = 256;
+            while (cfg.block_size * 2 <= blockSize) cfg.block_size *= 2;  // Round down to a power of two
+            cfg.floor_db = std::clamp(a.value("FloorDb", cfg.floor_db), -120.0f, -6.0f);
+            cfg.attack_ms = std::clamp(a.value("AttackMs", cfg.attack_ms), 0.0f, 5000.0f);
+            cfg.release_ms = std::clamp(a.value("ReleaseMs", cfg.release_ms), 0.0f, 5000.0f);
+            cfg.transient_window_ms =
+                std::clamp(a.value("TransientWindowMs", cfg.transient_window_ms), 10.0f, 10000.0f);
+            for (auto [key, band] : {std::pair{"IntensityBand", &cfg.intensity_band},
+                                     std::pair{"FlickerBand", &cfg.flicker_band}}) {
+                AudioBand parsed;
+                if (!a.contains(key)) continue;
+                if (a[key].is_string() && ParseAudioBand(a[key].get<std::string>(), parsed)) {
+                    *band = static_cast<int>(parsed);
+                } else {
+                    LogToFile_Warn(std::string("AudioReactive.") + key +
+                                      " must be \"bass\", \"low_mid\", \"high_mid\" or \"treble\"; using the default.");
+                }
+            }
+            for (auto [key, curve] : {std::pair{"IntensityCurve", &cfg.intensity_curve},
+                                      std::pair{"FlickerCurve", &cfg.flicker_curve}}) {
+                if (a.contains(key) && !ParseAudioCurve(a[key], *curve)) {
+                    LogToFile_Warn(std::string("AudioReactive.") + key +
+                                      " must be a list of [level, value] pairs; using the default.");
+                }
+            }
+            if (cfg.enabled) {
+                LogToFile_Info(std::string("Audio-reactive layers enabled: intensity from ") +
+                               GetAudioBandName(static_cast<AudioBand>(cfg.intensity_band)) + ", flicker from " +
+                               GetAudioBandName(static_cast<AudioBand>(cfg.flicker_band)) + ", block " +
+                               std::to_string(cfg.block_size) + ".");
+            }
+        }
+
+        // --- Optional direct Tuya backend ---
+        g_Tuya = TuyaConfig{};
+        if (config.contains("Tuya") && config["Tuya"].is_object()) {
+            const auto &t = config["Tuya"];
+            g_Tuya.enabled = t.value("Enabled", false);
+            g_Tuya.timeout_ms = std::clamp(t.value("TimeoutMs", g_Tuya.timeout_ms), 20, 10000);
+            g_Tuya.reconnect_delay_ms = std::clamp(t.value("ReconnectDelayMs", g_Tuya.reconnect_delay_ms), 0, 600000);
+            for (const auto &d : t.value("Devices", json::array())) {
+                if (!d.is_object()) continue;
+                TuyaDeviceConfig device;
+                device.entity_id = d.value("EntityId", "");
+                device.address = d.value("Address", "");
+                device.port = std::clamp(d.value("Port", device.port), 1, 65535);
+                device.device_id = d.value("DeviceId", "");
+                device.local_key = d.value("LocalKey", "");
+                std::string version = d.value("Version", "3.3");
+                device.version = version == "3.5" ? 35 : version == "3.4" ? 34 : version == "3.3" ? 33 : 0;
+                device.power_dp = d.value("PowerDp", device.power_dp);
+                device.mode_dp = d.value("ModeDp", device.mode_dp);
+                device.colour_dp = d.value("ColourDp", device.colour_dp);
+                if (device.entity_id.empty() || device.address.empty() || device.device_id.empty() ||
+                    device.local_key.size() != 16 || device.version == 0) {
+                    LogToFile_Warn("Tuya device '" + device.entity_id +
+                                   "' skipped: needs EntityId, Address, DeviceId, a 16-character LocalKey and "
+                                   "Version 3.3, 3.4 or 3.5.");
+                    continue;
+                }
+                g_Tuya.devices.push_back(std::move(device));
+            }
+            if (g_Tuya.enabled) {
+                LogToFile_Info("Tuya local backend enabled for " + std::to_string(g_Tuya.devices.size()) +
+                               " devices.");
+            }
+        }
+
+        // --- Send pacing ---
+        g_Send = SendConfig{};
+        if (config.contains("Sending") && config["Sending"].is_object()) {
+            const auto &s = config["Sending"];
+            g_Send.coalesce_window_ms = std::clamp(s.value("CoalesceWindowMs", 0), 0, 5000);
+            if (g_Send.coalesce_window_ms > 0) {
+                LogToFile_Info("Sending: lamp changes coalesced over " + std::to_string(g_Send.coalesce_window_ms) +
+                               " ms windows.");
+            }
+            g_Send.stagger = s.value("Stagger", false);
+            g_Send.stagger_span = std::clamp(s.value("StaggerSpan", 0.75f), 0.0f, 1.0f);
+            if (s.contains("GroupPhases") && s["GroupPhases"].is_object()) {
+                for (const auto &[group, phase] : s["GroupPhases"].items()) {
+                    if (phase.is_number()) g_Send.group_phases[group] = std::clamp(phase.get<float>(), 0.0f, 1.0f);
+                }
+            }
+            if (g_Send.stagger) {
+                LogToFile_Info("Sending: lamp calls staggered over " +
+                               std::to_string(static_cast<int>(g_Send.stagger_span * 100.0f)) +
+                               "% of each tick, " + std::to_string(g_Send.group_phases.size()) + " group phase(s).");
+            }
+        }
+
+        // --- Quarantine of lamps whose calls keep failing ---
+        g_LampHealth = LampHealthConfig{};
+        if (config.contains("LampHealth") && config["LampHealth"].is_object()) {
+            const auto &h = config["LampHealth"];
+            g_LampHealth.failure_threshold = std::clamp(h.value("FailureThreshold", 3), 0, 1000);
+            g_LampHealth.initial_backoff_ms = std::clamp(h.value("InitialBackoffMs", 2000), 100, 3600000);
+            g_LampHealth.max_backoff_ms =
+                std::clamp(h.value("MaxBackoffMs", 60000), g_LampHealth.initial_backoff_ms, 3600000);
+        }
+
+        // --- Diagnostics (stage timings) ---
+        g_Diagnostics = DiagnosticsConfig{};
+        if (config.contains("Diagnostics") && config["Diagnostics"].is_object()) {
+            const auto &d = config["Diagnostics"];
+            g_Diagnostics.profiling = d.value("Profiling", false);
+            g_Diagnostics.profile_dump_seconds = std::max(0, d.value("ProfileDumpSeconds", 60));
+            g_Diagnostics.tracing = d.value("Tracing", false);
+            g_Diagnostics.trace_buffer_events = std::max(1024, d.value("TraceBufferEvents", 65536));
+            g_Diagnostics.metrics_port = std::clamp(d.value("MetricsPort", 0), 0, 65535);
+            g_Diagnostics.tuning_port = std::clamp(d.value("TuningPort", 0), 0, 65535);
+            g_Diagnostics.flight_recorder_frames = std::clamp(d.value("FlightRecorderFrames", 300), 0, 100000);
+            g_Diagnostics.flight_latency_threshold_ms = std::max(0, d.value("FlightLatencyThresholdMs", 2000));
+            g_Diagnostics.record_frames = d.value("RecordFrames", false);
+        }
+        // The metrics endpoint exports the stage histograms, so it needs them filled
+        g_ProfilingEnabled.store(g_Diagnostics.profiling || g_Diagnostics.metrics_port != 0);
+        if (g_Diagnostics.profiling) {
+            LogToFile_Info("Stage profiling enabled (dump every " + std::to_string(g_Diagnostics.profile_dump_seconds) +
+                           " s).");
+        }
+        g_TracingEnabled.store(false);
+        if (g_Diagnostics.tracing) {
+            ConfigureTraceRecorder(static_cast<size_t>(g_Diagnostics.trace_buffer_events));
+            g_TracingEnabled.store(true);
+            LogToFile_Info("Trace recorder enabled (" + std::to_string(g_Diagnostics.trace_buffer_events) +
+                           " events). Flush with HomeAssistantLink.DumpTrace().");
+        }
+
         // --- Parse real lamp positions for directional lighting ---
         g_RealLamps.clear();
         if (config.contains("Lights") && config["Lights"].is_array()) {
@@ -147,8 +409,17 @@ bool LoadConfiguration() {
                 lamp.position.x = pos.value("x", 0.0f);
                 lamp.position.y = pos.value("y", 0.0f);
                 lamp.position.z = pos.value("z", 0.0f);
+                if (lampJson.contains("coalesce_ms") && lampJson["coalesce_ms"].is_number_integer()) {
+                    lamp.coalesce_ms = std::clamp(lampJson["coalesce_ms"].get<int>(), 0, 5000);
+                }
+                if (lampJson.contains("send_phase") && lampJson["send_phase"].is_number()) {
+                    lamp.send_phase = std::clamp(lampJson["send_phase"].get<float>(), 0.0f, 1.0f);
+                }
+                lamp.send_group = lampJson.value("send_group", "");
                 g_RealLamps.push_back(lamp);
             }
+            RegisterMetricEntities(g_RealLamps);
+            RegisterEntityHealth(g_RealLamps);
             LogToFile_Info("Loaded " + std::to_string(g_RealLamps.size()) +
                            " lamp positions for directional lighting.");
             NotifyIngame("Loaded " + std::to_string(g_RealLamps.size()) + " lamp positions for directional lighting.");
@@ -177,6 +448,12 @@ bool LoadConfiguration() {
                 if (trigger_json.contains("max_hour")) {
                     scenario.trigger.max_hour = trigger_json.at("max_hour").get<int>();
                 }
+                if (trigger_json.contains("event") && trigger_json["event"].is_string()) {
+                    scenario.trigger.event = trigger_json["event"].get<std::string>();
+                }
+                if (trigger_json.contains("hold_seconds") && trigger_json["hold_seconds"].is_number()) {
+                    scenario.trigger.hold_seconds = trigger_json["hold_seconds"].get<float>();
+                }
 
                 // Parse outcome (array of LightState)
                 const auto &outcome_array_json = scenario_json.at("outcome");
@@ -251,6 +528,12 @@ bool LoadConfiguration() {
         }
 
         // --- END NEW SECTION ---
+        buildTimer.Stop();
+
+        // Derived tables: rebuilt on every load, also when the Scenarios section is gone
+        ScopedStartupTimer bakingTimer(StartupPhase::TableBaking);
+        BuildModEventTriggerTable(g_SCENARIOS);
+        bakingTimer.Stop();
 
         // Final config check
         if (g_HA_URL.empty() || g_HA_TOKEN.empty() || g_RealLamps.empty()) {
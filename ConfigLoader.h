@@ -1,5 +1,9 @@
 #pragma once
 #include <array>
+#include <cmath>
+#include <cstdint>
+#include <filesystem>
+#include <map>
 #include <nlohmann/json.hpp>
 #include <optional>
 #include <string>
@@ -38,6 +42,9 @@ struct ScenarioTrigger {
     std::optional<std::string> item;
     std::optional<std::string> object_type;
     std::optional<int> radius;
+    std::optional<std::string> event;        // "mod_event": ModEvent name to listen for
+    std::optional<float> hold_seconds;       // "mod_event": keep the scenario active this long after the event
+    int event_bit = -1;                      // Assigned by BuildModEventTriggerTable
 };
 
 struct Scenario {
@@ -60,7 +67,10 @@ struct Vec3 {
 
 struct RealLamp {
     std::string entity_id;
-    Vec3 position;  // in your room, e.g. centimeters from center
+    Vec3 position;             // in your room, e.g. centimeters from center
+    int coalesce_ms = -1;      // Own coalescing window ("coalesce_ms"), -1 = Sending.CoalesceWindowMs
+    float send_phase = -1.0f;  // Staggered send slot ("send_phase", 0..1 of the spread), -1 = group or automatic
+    std::string send_group{};  // "send_group": lamps of a group share Sending.GroupPhases[group]
 };
 
 
@@ -70,19 +80,152 @@ struct DayNightKeyframe {
     int brightness_pct;
 };
 
+// Lamp mapping, blend and smoothing tunables ("LightingOptions")
+struct LightingOptions {
+    float direction_sharpness = 2.0f;  // Exponent on the lamp/light direction match; higher = more spotlight-like
+    float light_radius = 400.0f;       // In-game lights further away are ignored (game units)
+    float fire_exponent = 0.4f;        // Fire influence = fire brightness ^ exponent; lower = fires take over sooner
+    float smoothing = 0.2f;            // LightSmoother factor per tick; higher = faster
+
+    bool operator==(const LightingOptions&) const = default;
+};
+
+// Live copy of the lighting options, read by the pipeline every tick. Every config load resets it to
+// g_LightingOptions; the tuning channel (TuningServer.h) changes it while the game runs.
+struct LiveLightingOptions {
+    LightingOptions options;
+    std::uint64_t version = 0;  // Increases with every change
+};
+
+constexpr int EXPORT_TICK_MS = 200;  // Period of the export thread loop (plugin.cpp)
+
+// Optional binary telemetry stream (see TelemetryFrame.h)
+struct TelemetryConfig {
+    bool enabled = false;
+    std::string address = "239.255.72.65";  // Multicast group or unicast address
+    uint16_t port = 47810;
+    int interval_ms = EXPORT_TICK_MS;  // Time between frames, rounded to whole export ticks (at least one)
+    int max_lights = 8;     // Nearest N in-game lights per frame
+    int ttl = 1;            // Multicast TTL, 1 = local network only
+};
+
+// Self-diagnostics (timings, ...)
+struct DiagnosticsConfig {
+    bool profiling = false;
+    int profile_dump_seconds = 60;  // 0 = only dump on demand
+    bool tracing = false;
+    int trace_buffer_events = 65536;  // Ring size; the oldest events are overwritten
+    int metrics_port = 0;             // Prometheus endpoint on 127.0.0.1, 0 = disabled
+    int tuning_port = 0;              // Live-tuning WebSocket on 127.0.0.1 (TuningServer.h), 0 = disabled
+    int flight_recorder_frames = 300;         // Ticks kept by the flight recorder, 0 = disabled
+    int flight_latency_threshold_ms = 2000;   // Auto-dump when a tick takes longer, 0 = never
+    bool record_frames = false;               // Record every tick's game state for offline replay
+};
+
+// Optional screen-color layer (see Ambilight.h): a downscaled copy of the backbuffer mapped onto the lamps
+struct AmbilightConfig {
+    bool enabled = false;
+    float mix = 0.5f;                // Share of the screen color in the ambient (day/night) color
+    int columns = 16;                // Region grid over the screen
+    int rows = 9;
+    float horizontal_fov = 85.0f;    // Degrees; lamps outside take the nearest screen edge
+    float vertical_fov = 55.0f;
+    float spread = 1.5f;             // Gaussian radius of a lamp's screen region, in grid cells
+    int capture_width = 64;          // Mip level used: the first one at most this wide
+    int capture_interval_ms = 100;   // Minimum time between backbuffer copies
+
+    bool operator==(const AmbilightConfig&) const = default;
+};
+
+// Point of an audio modulation curve: band level (0..1) -> layer output, linear in between
+struct AudioCurvePoint {
+    float level;
+    float value;
+
+    bool operator==(const AudioCurvePoint&) const = default;
+};
+
+// Optional audio-reactive layers (see AudioReactive.h): band energies of the game's sound modulate the lamps
+struct AudioReactiveConfig {
+    bool enabled = false;
+    int block_size = 1024;               // Samples per FFT block (power of two); blocks overlap by half
+    float floor_db = -60.0f;             // Band level 0 at this power, 1 at full scale
+    float attack_ms = 10.0f;             // Band level envelope
+    float release_ms = 250.0f;
+    float transient_window_ms = 400.0f;  // Recent average a transient is measured against
+    int intensity_band = 0;              // AudioBand index (bass)
+    std::vector<AudioCurvePoint> intensity_curve = {{0.3f, 0.0f}, {1.0f, 35.0f}};  // Level -> brightness added
+    int flicker_band = 0;
+    std::vector<AudioCurvePoint> flicker_curve = {{0.15f, 0.0f}, {0.6f, 30.0f}};  // Transient -> flicker amplitude
+};
+
+// A Tuya bulb driven over the LAN (Tuya local protocol, see TuyaTransport.h) instead of through Home Assistant
+struct TuyaDeviceConfig {
+    std::string entity_id;  // HA entity whose lamp states go to this bulb
+    std::string address;    // Bulb IP or host name
+    int port = 6668;
+    std::string device_id;  // Tuya device id (devId)
+    std::string local_key;  // 16-character local key
+    int version = 33;       // Protocol 3.3, 3.4 or 3.5 as 33/34/35
+    int power_dp = 20;      // DPS ids of a "colour_data_v2" bulb: switch_led, work_mode, colour_data_v2
+    int mode_dp = 21;
+    int colour_dp = 24;
+};
+
+struct TuyaConfig {
+    bool enabled = false;
+    int timeout_ms = 300;           // Connect and acknowledgement timeout per command
+    int reconnect_delay_ms = 5000;  // After a failed connect, calls fail fast for this long
+    std::vector<TuyaDeviceConfig> devices;
+};
+
+// Per-lamp backoff of failing HA calls (EntityHealth.h)
+struct LampHealthConfig {
+    int failure_threshold = 3;       // Consecutive failures before a lamp is quarantined, 0 = never
+    int initial_backoff_ms = 2000;   // Time until the first probe; doubles with every failed probe
+    int max_backoff_ms = 60000;
+};
+
+// How lamp commands leave the export loop ("Sending")
+struct SendConfig {
+    // After a command, further changes of the same lamp within this window are merged into one trailing update
+    // (sent on the first tick after the window). 0 = every change goes out on its own tick.
+    int coalesce_window_ms = 0;
+    // Spread each tick's lamp calls over the first stagger_span of the tick period instead of sending them back to
+    // back. Calls go out at their phase (0..1 of the spread): the lamp's send_phase, its group's phase, or evenly
+    // spaced among the remaining calls of the tick.
+    bool stagger = false;
+    float stagger_span = 0.75f;
+    std::map<std::string, float> group_phases;
+};
+
 // Config globals (extern!)
 extern std::string g_HA_URL;
 extern std::string g_HA_TOKEN;
+extern bool g_HA_HTTP2;  // Multiplex each tick's calls over one HTTP/2 connection (CurlTransport)
 extern std::vector<std::string> g_LIGHT_ENTITY_IDS;
 extern std::vector<Scenario> g_SCENARIOS;
 extern std::vector<RealLamp> g_RealLamps;
 extern bool g_DebugMode; 
 extern std::vector<DayNightKeyframe> g_DayNightCycle;
+extern TelemetryConfig g_Telemetry;
+extern DiagnosticsConfig g_Diagnostics;
+extern AmbilightConfig g_Ambilight;
+extern AudioReactiveConfig g_AudioReactive;
+extern TuyaConfig g_Tuya;
+extern LampHealthConfig g_LampHealth;
+extern SendConfig g_Send;
+extern LightingOptions g_LightingOptions;  // As loaded from the config
 
 float GetPlayerCameraYawRadians();
 
-extern float g_DirectionSharpness;  // Declaration only, NO initialization
+LiveLightingOptions GetLiveLightingOptions();
+// Clamps to sane ranges and returns what was applied
+LightingOptions SetLiveLightingOptions(const LightingOptions& options);
 
 // Config loader
-bool LoadConfiguration();
+bool LoadConfiguration();  // HomeAssistantLink.json next to the plugin DLL
+bool LoadConfigurationFromFile(const std::filesystem::path& configFilePath);
 std::filesystem::path GetCurrentModulePath();
+// Whole file in one read (binary, no newline conversion). False if it cannot be opened or read.
+bool ReadTextFile(const std::filesystem::path& path, std::string& contents);
@@ -0,0 +1,12 @@
+#include "CprTransport.h"
+
+CprTransport::CprTransport(std::string baseUrl, const std::string& token) : baseUrl(std::move(baseUrl)) {
+    headers["Authorization"] = "Bearer " + token;
+    headers["Content-Type"] = "application/json";
+}
+
+TransportResponse CprTransport::PostJson(const std::string& path, const std::string& body) {
+    cpr::Response r = cpr::Post(cpr::Url{baseUrl + path}, headers, cpr::Body{body});
+    // cpr::Post runs every call on a new session, so every call opens its own connection
+    return TransportResponse{r.status_code, std::move(r.text), std::move(r.error.message), r.elapsed, true};
+}
@@ -0,0 +1,18 @@
+#pragma once
+#include <cpr/cpr.h>
+
+#include <string>
+
+#include "Transport.h"
+
+// Home Assistant REST API over cpr (libcurl)
+class CprTransport final : public ILightTransport {
+public:
+    CprTransport(std::string baseUrl, const std::string& token);
+
+    TransportResponse PostJson(const std::string& path, const std::string& body) override;
+
+private:
+    std::string baseUrl;
+    cpr::Header headers;  // Built once: Authorization + Content-Type
+};
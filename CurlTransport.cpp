@@ -0,0 +1,152 @@
+#include "CurlTransport.h"
+
+#include <curl/curl.h>
+
+#include <mutex>
+
+#include "Logger.h"
+
+struct CurlTransport::Transfer {
+    CURL* easy = nullptr;
+    std::string url;
+    std::string body;
+    std::string responseText;
+    char errorBuffer[CURL_ERROR_SIZE] = {};
+    bool done = false;
+    CURLcode result = CURLE_OK;
+
+    ~Transfer() {
+        if (easy) curl_easy_cleanup(easy);
+    }
+
+    static size_t Write(char* data, size_t size, size_t count, void* user) {
+        static_cast<Transfer*>(user)->responseText.append(data, size * count);
+        return size * count;
+    }
+};
+
+namespace {
+    void InitCurlOnce() {
+        static std::once_flag once;
+        std::call_once(once, [] { curl_global_init(CURL_GLOBAL_DEFAULT); });
+    }
+
+    CURLM* AsMulti(void* multi) { return static_cast<CURLM*>(multi); }
+}
+
+CurlTransport::CurlTransport(std::string baseUrl, const std::string& token, bool http2, int timeoutMs)
+    : baseUrl(std::move(baseUrl)), http2(http2), timeoutMs(timeoutMs) {
+    while (!this->baseUrl.empty() && this->baseUrl.back() == '/') this->baseUrl.pop_back();
+    InitCurlOnce();
+    // Seen with 7.88: the second stream on a reused h2c connection fails with "Error in the HTTP2 framing layer"
+    if (http2 && !this->baseUrl.starts_with("https://") && curl_version_info(CURLVERSION_NOW)->version_num < 0x080000) {
+        HAL_LOG_WARN("libcurl {} may fail to reuse h2c (plain http HTTP/2) connections; use https or libcurl 8.",
+                     curl_version_info(CURLVERSION_NOW)->version);
+    }
+    multi = curl_multi_init();
+    // Multiplexing is libcurl's default for HTTP/2; said explicitly since the whole point depends on it
+    curl_multi_setopt(AsMulti(multi), CURLMOPT_PIPELINING, http2 ? CURLPIPE_MULTIPLEX : CURLPIPE_NOTHING);
+
+    curl_slist* list = curl_slist_append(nullptr, ("Authorization: Bearer " + token).c_str());
+    list = curl_slist_append(list, "Content-Type: application/json");
+    headers = list;
+}
+
+CurlTransport::~CurlTransport() {
+    transfers.clear();  // Easy handles go before the multi handle that cached their connections
+    if (multi) curl_multi_cleanup(AsMulti(multi));
+    curl_slist_free_all(static_cast<curl_slist*>(headers));
+}
+
+TransportResponse CurlTransport::PostJson(const std::string& path, const std::string& body) {
+    return std::move(PostJsonBatch({TransportRequest{path.c_str(), body}}).front());
+}
+
+std::vector<TransportResponse> CurlTransport::PostJsonBatch(const std::vector<TransportRequest>& requests) {
+    std::vector<TransportResponse> responses(requests.size());
+    if (requests.empty()) return responses;
+    std::lock_guard lock(mutex);
+
+    while (transfers.size() < requests.size()) {
+        auto transfer = std::make_unique<Transfer>();
+        CURL* easy = curl_easy_init();
+        transfer->easy = easy;
+        curl_easy_setopt(easy, CURLOPT_PRIVATE, transfer.get());
+        curl_easy_setopt(easy, CURLOPT_HTTPHEADER, static_cast<curl_slist*>(headers));
+        curl_easy_setopt(easy, CURLOPT_WRITEFUNCTION, &Transfer::Write);
+        curl_easy_setopt(easy, CURLOPT_WRITEDATA, transfer.get());
+        curl_easy_setopt(easy, CURLOPT_ERRORBUFFER, transfer->errorBuffer);
+        curl_easy_setopt(easy, CURLOPT_TIMEOUT_MS, static_cast<long>(timeoutMs));
+        curl_easy_setopt(easy, CURLOPT_NOSIGNAL, 1L);
+        if (http2) {
+            bool tls = baseUrl.starts_with("https://");
+            curl_easy_setopt(easy, CURLOPT_HTTP_VERSION,
+                             tls ? CURL_HTTP_VERSION_2TLS : CURL_HTTP_VERSION_2_PRIOR_KNOWLEDGE);
+            // Calls of a batch wait for the first connection and join it instead of opening their own
+            curl_easy_setopt(easy, CURLOPT_PIPEWAIT, 1L);
+        } else {
+            curl_easy_setopt(easy, CURLOPT_HTTP_VERSION, CURL_HTTP_VERSION_1_1);
+        }
+        transfers.push_back(std::move(transfer));
+        // Keep one idle connection per concurrent call (HTTP/1.1) instead of libcurl's default that shrinks
+        // with the handles attached between batches
+        curl_multi_setopt(AsMulti(multi), CURLMOPT_MAXCONNECTS, static_cast<long>(transfers.size()));
+    }
+
+    for (size_t i = 0; i < requests.size(); ++i) {
+        Transfer& transfer = *transfers[i];
+        transfer.url = baseUrl + requests[i].path;
+        transfer.body = requests[i].body;
+        transfer.responseText.clear();
+        transfer.errorBuffer[0] = '\0';
+        transfer.done = false;
+        transfer.result = CURLE_OK;
+        curl_easy_setopt(transfer.easy, CURLOPT_URL, transfer.url.c_str());
+        curl_easy_setopt(transfer.easy, CURLOPT_POSTFIELDS, transfer.body.data());
+        curl_easy_setopt(transfer.easy, CURLOPT_POSTFIELDSIZE, static_cast<long>(transfer.body.size()));
+        curl_multi_add_handle(AsMulti(multi), transfer.easy);
+    }
+
+    int running = 0;
+    do {
+        CURLMcode code = curl_multi_perform(AsMulti(multi), &running);
+        if (code == CURLM_OK && running > 0) code = curl_multi_poll(AsMulti(multi), nullptr, 0, 100, nullptr);
+        if (code != CURLM_OK) {
+            for (size_t i = 0; i < requests.size(); ++i) responses[i].error = curl_multi_strerror(code);
+            break;
+        }
+        int queued = 0;
+        while (CURLMsg* message = curl_multi_info_read(AsMulti(multi), &queued)) {
+            if (message->msg != CURLMSG_DONE) continue;
+            Transfer* transfer = nullptr;
+            curl_easy_getinfo(message->easy_handle, CURLINFO_PRIVATE, &transfer);
+            transfer->done = true;
+            transfer->result = message->data.result;
+        }
+    } while (running > 0);
+
+    for (size_t i = 0; i < requests.size(); ++i) {
+        Transfer& transfer = *transfers[i];
+        TransportResponse& response = responses[i];
+        curl_multi_remove_handle(AsMulti(multi), transfer.easy);
+        if (!transfer.done) {
+            if (response.error.empty()) response.error = "transfer did not complete";
+            continue;
+        }
+        long status = 0;
+        long connects = 0;
+        curl_off_t totalUs = 0;
+        curl_easy_getinfo(transfer.easy, CURLINFO_RESPONSE_CODE, &status);
+        curl_easy_getinfo(transfer.easy, CURLINFO_NUM_CONNECTS, &connects);
+        curl_easy_getinfo(transfer.easy, CURLINFO_TOTAL_TIME_T, &totalUs);
+        response.elapsed = static_cast<double>(totalUs) / 1e6;
+        response.new_connection = connects > 0;
+        if (transfer.result != CURLE_OK) {
+            response.error = transfer.errorBuffer[0] ? transfer.errorBuffer : curl_easy_strerror(transfer.result);
+            continue;
+        }
+        response.status_code = status;
+        response.text = std::move(transfer.responseText);
+    }
+    return responses;
+}
@@ -0,0 +1,33 @@
+#pragma once
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "Transport.h"
+
+// Home Assistant REST API over libcurl's multi interface, for HA behind a reverse proxy (nginx, Caddy) that speaks
+// HTTP/2. With http2 every call of a batch (one tick's lamp updates) is a stream on one shared connection: https
+// negotiates h2 through ALPN, plain http uses h2c with prior knowledge. The connection stays open between ticks and
+// the header list is built once, so after the first request HPACK sends the Authorization header as a table index.
+// Without http2 the batch runs over parallel HTTP/1.1 keep-alive connections, one per concurrent call.
+class CurlTransport final : public ILightTransport {
+public:
+    CurlTransport(std::string baseUrl, const std::string& token, bool http2, int timeoutMs = 5000);
+    ~CurlTransport() override;
+
+    TransportResponse PostJson(const std::string& path, const std::string& body) override;
+    std::vector<TransportResponse> PostJsonBatch(const std::vector<TransportRequest>& requests) override;
+
+private:
+    struct Transfer;  // One reusable easy handle
+
+    std::string baseUrl;
+    bool http2;
+    int timeoutMs;
+
+    std::mutex mutex;
+    void* multi = nullptr;    // CURLM, owns the connection cache
+    void* headers = nullptr;  // curl_slist: Authorization + Content-Type
+    std::vector<std::unique_ptr<Transfer>> transfers;  // Grows to the largest batch seen
+};
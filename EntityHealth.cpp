@@ -0,0 +1,96 @@
+#include "EntityHealth.h"
+
+#include <algorithm>
+#include <chrono>
+
+#include "Logger.h"
+
+namespace {
+    // Sized once at config load; elements hold atomics and never move afterwards
+    std::vector<EntityHealth> g_EntityHealth;
+
+    std::int64_t NowUs() {
+        return std::chrono::duration_cast<std::chrono::microseconds>(
+                   std::chrono::steady_clock::now().time_since_epoch())
+            .count();
+    }
+
+    EntityHealth* FindHealth(std::string_view entity_id) {
+        for (auto& h : g_EntityHealth) {
+            if (h.entity_id == entity_id) return &h;
+        }
+        return nullptr;
+    }
+
+    void ScheduleProbe(EntityHealth& h, std::uint32_t backoff_ms) {
+        h.backoff_ms.store(backoff_ms, std::memory_order_relaxed);
+        h.next_probe_us.store(NowUs() + static_cast<std::int64_t>(backoff_ms) * 1000, std::memory_order_relaxed);
+    }
+}
+
+void RegisterEntityHealth(const std::vector<RealLamp>& lamps) {
+    std::vector<EntityHealth> fresh(lamps.size());
+    for (size_t i = 0; i < lamps.size(); ++i) fresh[i].entity_id = lamps[i].entity_id;
+    g_EntityHealth.swap(fresh);
+}
+
+const std::vector<EntityHealth>& GetEntityHealth() { return g_EntityHealth; }
+
+bool IsEntitySendAllowed(std::string_view entity_id) {
+    EntityHealth* h = FindHealth(entity_id);
+    if (!h || !h->IsQuarantined()) return true;
+    std::int64_t now = NowUs();
+    if (now < h->next_probe_us.load(std::memory_order_relaxed)) {
+        h->skipped.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    // Claim the probe: until its outcome is recorded no further command slips through
+    h->next_probe_us.store(now + static_cast<std::int64_t>(h->backoff_ms.load(std::memory_order_relaxed)) * 1000,
+                           std::memory_order_relaxed);
+    return true;
+}
+
+bool IsEntityQuarantined(std::string_view entity_id) {
+    const EntityHealth* h = FindHealth(entity_id);
+    return h && h->IsQuarantined();
+}
+
+void RecordEntityOutcome(std::string_view entity_id, bool success) {
+    EntityHealth* h = FindHealth(entity_id);
+    if (!h) return;
+    if (success) {
+        if (h->IsQuarantined()) {
+            HAL_LOG_INFO("Lamp {} recovered after {} failed calls, back in service.", h->entity_id,
+                         h->consecutive_failures.load(std::memory_order_relaxed));
+            h->backoff_ms.store(0, std::memory_order_relaxed);
+        }
+        h->consecutive_failures.store(0, std::memory_order_relaxed);
+        return;
+    }
+
+    std::uint32_t failures = h->consecutive_failures.fetch_add(1, std::memory_order_relaxed) + 1;
+    const LampHealthConfig& config = g_LampHealth;
+    if (h->IsQuarantined()) {
+        // Failed probe
+        auto backoff = std::min<std::uint64_t>(std::uint64_t{h->backoff_ms.load(std::memory_order_relaxed)} * 2,
+                                               static_cast<std::uint64_t>(config.max_backoff_ms));
+        ScheduleProbe(*h, static_cast<std::uint32_t>(backoff));
+        HAL_LOG_DEBUG("Lamp {}: probe failed, next one in {} ms.", h->entity_id, backoff);
+        return;
+    }
+    if (config.failure_threshold <= 0 || failures < static_cast<std::uint32_t>(config.failure_threshold)) return;
+    ScheduleProbe(*h, static_cast<std::uint32_t>(config.initial_backoff_ms));
+    h->quarantines.fetch_add(1, std::memory_order_relaxed);
+    HAL_LOG_WARN("Lamp {} quarantined after {} consecutive failures; probing every {}-{} ms until it answers.",
+                 h->entity_id, failures, config.initial_backoff_ms, config.max_backoff_ms);
+}
+
+size_t GetQuarantinedEntityCount() {
+    return static_cast<size_t>(
+        std::count_if(g_EntityHealth.begin(), g_EntityHealth.end(), [](const auto& h) { return h.IsQuarantined(); }));
+}
+
+std::int64_t GetEntityProbeDelayMs(const EntityHealth& health) {
+    if (!health.IsQuarantined()) return 0;
+    return std::max<std::int64_t>(0, (health.next_probe_us.load(std::memory_order_relaxed) - NowUs()) / 1000);
+}
@@ -0,0 +1,40 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "ConfigLoader.h"
+
+// Per-lamp health, separate from the global HA link state. A lamp whose calls fail LampHealth.FailureThreshold
+// times in a row is quarantined: the pipeline stops sending to it, so a dead bulb no longer costs every tick a
+// timeout. Once the backoff has passed the next command goes out as a probe; a failed probe doubles the backoff
+// (up to MaxBackoffMs), the first success puts the lamp back into normal service.
+
+struct EntityHealth {
+    std::string entity_id;  // Immutable after RegisterEntityHealth
+    std::atomic<std::uint32_t> consecutive_failures{0};
+    std::atomic<std::uint32_t> backoff_ms{0};    // Current probe interval, 0 = healthy
+    std::atomic<std::int64_t> next_probe_us{0};  // steady_clock time of the next probe
+    std::atomic<std::uint64_t> skipped{0};       // Commands not sent while quarantined
+    std::atomic<std::uint64_t> quarantines{0};   // Times the lamp entered quarantine
+
+    bool IsQuarantined() const { return backoff_ms.load(std::memory_order_relaxed) != 0; }
+};
+
+// Creates one EntityHealth per configured lamp. Called at config load, before the export thread starts.
+void RegisterEntityHealth(const std::vector<RealLamp>& lamps);
+const std::vector<EntityHealth>& GetEntityHealth();
+
+// False while the lamp is quarantined and its next probe is not due. A true answer for a quarantined lamp claims
+// the probe, so it is asked once per command. Unknown entities are always allowed.
+bool IsEntitySendAllowed(std::string_view entity_id);
+// True while the lamp is quarantined, whether or not its probe is due. Does not claim anything.
+bool IsEntityQuarantined(std::string_view entity_id);
+// Records the result of one HA call for the lamp. Called by the export thread only.
+void RecordEntityOutcome(std::string_view entity_id, bool success);
+
+size_t GetQuarantinedEntityCount();
+// Milliseconds until the lamp's next probe (0 if due or healthy)
+std::int64_t GetEntityProbeDelayMs(const EntityHealth& health);
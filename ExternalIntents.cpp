@@ -0,0 +1,173 @@
+#include "ExternalIntents.h"
+
+#include <algorithm>
+#include <chrono>
+#include <optional>
+#include <string>
+
+#include "Logger.h"
+#include "MpscRingBuffer.h"
+#include "TraceRecorder.h"
+
+using HomeAssistantLinkAPI::LightIntent;
+using Clock = std::chrono::steady_clock;
+
+namespace {
+    MpscRingBuffer<LightIntent, 256> g_IntentQueue;
+
+    struct ActiveIntent {
+        LightIntent intent;
+        Clock::time_point start;
+        std::optional<Clock::time_point> releaseStart;
+        float releaseFrom = 1.0f;  // Envelope level at the moment the release began
+    };
+
+    // Only touched by the export thread
+    std::vector<ActiveIntent> g_ActiveIntents;
+
+    // Per lamp, index-aligned with the lamp states. An inherit lamp keeps showing the last state it was driven to;
+    // once an intent has faded in and out on it, that state is sent again (held while the lamp stays inherit, so
+    // dedup makes it one command and coalescing cannot drop it) instead of leaving the lamp at the faded level.
+    std::vector<std::optional<LightState>> g_LastDrivenStates;  // Last pipeline state that was not inherit
+    std::vector<std::optional<LightState>> g_InheritRestores;   // Pending restore per lamp
+    std::uint32_t g_IntentOnInherit = 0;                        // Lamps an intent drove from inherit last pass
+
+    // The inherited state as a static command: animations and scenes are not restarted, an unknown state is the
+    // dark the intent faded in from
+    LightState MakeInheritRestore(const LightState& inherit, const std::optional<LightState>& lastDriven) {
+        LightState restore = lastDriven.value_or(inherit);
+        restore.inherit = false;
+        if (!lastDriven) {
+            restore.rgb_color = {0, 0, 0};
+            restore.brightness_pct = 0;
+        }
+        if (restore.effect == "flicker" || restore.effect == "scene") restore.effect = std::nullopt;
+        restore.scene = std::nullopt;
+        restore.flicker = std::nullopt;
+        return restore;
+    }
+
+    float MillisecondsSince(Clock::time_point t, Clock::time_point now) {
+        return std::chrono::duration<float, std::milli>(now - t).count();
+    }
+
+    // Attack/hold/release envelope. Returns a negative value once the intent has fully faded out.
+    float EvaluateEnvelope(ActiveIntent& active, Clock::time_point now) {
+        const LightIntent& in = active.intent;
+        float elapsed = MillisecondsSince(active.start, now);
+        float attackLevel = in.attack_ms > 0 ? std::min(1.0f, elapsed / in.attack_ms) : 1.0f;
+
+        if (!active.releaseStart && in.hold_ms > 0 && elapsed >= static_cast<float>(in.attack_ms) + in.hold_ms) {
+            active.releaseStart = active.start + std::chrono::milliseconds(in.attack_ms + in.hold_ms);
+            active.releaseFrom = 1.0f;
+        }
+        if (!active.releaseStart) return attackLevel;
+
+        if (in.release_ms == 0) return -1.0f;
+        float r = MillisecondsSince(*active.releaseStart, now) / in.release_ms;
+        if (r >= 1.0f) return -1.0f;
+        return active.releaseFrom * (1.0f - r);
+    }
+
+    void AcceptIntent(const LightIntent& intent, Clock::time_point now) {
+        auto it = std::find_if(g_ActiveIntents.begin(), g_ActiveIntents.end(),
+                               [&](const ActiveIntent& a) { return a.intent.layer == intent.layer; });
+
+        if (intent.lampMask == 0) {
+            // Clear request: fade out from wherever the layer currently is
+            if (it != g_ActiveIntents.end() && !it->releaseStart) {
+                it->releaseFrom = std::max(0.0f, EvaluateEnvelope(*it, now));
+                it->releaseStart = now;
+            }
+            return;
+        }
+
+        ActiveIntent active{intent, now, std::nullopt, 1.0f};
+        if (it != g_ActiveIntents.end()) {
+            *it = active;
+        } else {
+            g_ActiveIntents.push_back(active);
+        }
+    }
+
+    int Lerp(int a, int b, float t) { return static_cast<int>(a + (b - a) * t); }
+}
+
+bool SubmitExternalIntent(const LightIntent& intent) { return g_IntentQueue.TryPush(intent); }
+
+size_t GetPendingIntentCount() { return g_IntentQueue.ApproxSize(); }
+
+size_t GetActiveIntentLayerCount() { return g_ActiveIntents.size(); }
+
+void ApplyExternalIntents(std::vector<LightState>& lampStates) {
+    auto now = Clock::now();
+
+    LightIntent incoming;
+    while (g_IntentQueue.TryPop(incoming)) {
+        if (g_TracingEnabled.load(std::memory_order_relaxed)) {
+            TraceInstant(incoming.lampMask ? "intent" : "intent_clear", "queue",
+                         "layer " + std::to_string(incoming.layer));
+        }
+        AcceptIntent(incoming, now);
+    }
+
+    g_LastDrivenStates.resize(lampStates.size());
+    g_InheritRestores.resize(lampStates.size());
+    for (size_t i = 0; i < lampStates.size(); ++i) {
+        if (lampStates[i].inherit) continue;
+        g_LastDrivenStates[i] = lampStates[i];
+        g_InheritRestores[i].reset();
+    }
+
+    std::uint32_t intentOnInherit = 0;
+    // Lowest priority first so the highest priority layer is blended last and wins
+    std::stable_sort(g_ActiveIntents.begin(), g_ActiveIntents.end(), [](const ActiveIntent& a, const ActiveIntent& b) {
+        return a.intent.priority < b.intent.priority;
+    });
+
+    for (auto it = g_ActiveIntents.begin(); it != g_ActiveIntents.end();) {
+        float level = EvaluateEnvelope(*it, now);
+        if (level < 0.0f) {
+            HAL_LOG_DEBUG("External intent layer {} finished.", it->intent.layer);
+            it = g_ActiveIntents.erase(it);
+            continue;
+        }
+
+        const LightIntent& in = it->intent;
+        float weight = std::clamp(in.strength, 0.0f, 1.0f) * level;
+        std::array<int, 3> rgb = {in.rgb[0], in.rgb[1], in.rgb[2]};
+        int brightness = std::clamp<int>(in.brightness_pct, 0, 100);
+
+        for (size_t i = 0; i < lampStates.size() && i < 32; ++i) {
+            if (weight <= 0.0f || !(in.lampMask & (1u << i))) continue;
+            LightState& state = lampStates[i];
+
+            // Scene lamps are driven by the bulb itself; leave them alone
+            if (state.effect.has_value() && state.effect.value() == "scene") continue;
+
+            if (state.inherit) {
+                // Nothing drives this lamp right now: fade the intent in from dark
+                intentOnInherit |= 1u << i;
+                state.inherit = false;
+                state.rgb_color = rgb;
+                state.brightness_pct = static_cast<int>(brightness * weight);
+                state.effect = std::nullopt;
+                state.flicker = std::nullopt;
+                continue;
+            }
+            for (int c = 0; c < 3; ++c) state.rgb_color[c] = Lerp(state.rgb_color[c], rgb[c], weight);
+            state.brightness_pct = Lerp(state.brightness_pct, brightness, weight);
+        }
+        ++it;
+    }
+
+    // Lamps back to inherit after an intent faded out on them get their inherited state
+    for (size_t i = 0; i < lampStates.size() && i < 32; ++i) {
+        if (!lampStates[i].inherit) continue;
+        if ((g_IntentOnInherit & (1u << i)) && !g_InheritRestores[i]) {
+            g_InheritRestores[i] = MakeInheritRestore(lampStates[i], g_LastDrivenStates[i]);
+        }
+        if (g_InheritRestores[i]) lampStates[i] = *g_InheritRestores[i];
+    }
+    g_IntentOnInherit = intentOnInherit;
+}
@@ -0,0 +1,16 @@
+#pragma once
+#include <cstddef>
+#include <vector>
+
+#include "ConfigLoader.h"
+#include "HomeAssistantLinkAPI.h"
+
+// Queues an intent submitted by another plugin. Lock-free, callable from any thread.
+bool SubmitExternalIntent(const HomeAssistantLinkAPI::LightIntent& intent);
+
+// Drains the intent queue and blends all active intent layers over the lamp states.
+// lampStates must be index-aligned with g_RealLamps. Called from the export thread only.
+void ApplyExternalIntents(std::vector<LightState>& lampStates);
+
+size_t GetPendingIntentCount();
+size_t GetActiveIntentLayerCount();
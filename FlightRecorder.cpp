@@ -0,0 +1,151 @@
+#include "FlightRecorder.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <fstream>
+#include <vector>
+
+#include "AllocationTracker.h"
+#include "ConfigLoader.h"
+#include "Logger.h"
+
+using namespace FlightRecorder;
+using Clock = std::chrono::steady_clock;
+
+namespace {
+    constexpr auto AUTO_DUMP_COOLDOWN = std::chrono::seconds(60);
+
+    std::vector<FlightFrame> g_FlightRing;
+    std::filesystem::path g_FlightDumpDirectory;
+    std::uint64_t g_FlightWritten = 0;  // Total frames committed
+    FlightFrame g_CurrentFlight{};
+    bool g_FlightInProgress = false;
+    Clock::time_point g_FlightTickStart;
+    Clock::time_point g_LastAutoDump;
+    bool g_HasAutoDumped = false;
+
+    std::atomic<const char*> g_RequestedDumpReason{nullptr};
+
+    std::uint64_t MicrosSinceEpoch(Clock::time_point t) {
+        return std::chrono::duration_cast<std::chrono::microseconds>(t.time_since_epoch()).count();
+    }
+
+    void WriteFlightDump(const char* reason) {
+        if (g_FlightWritten == 0) return;
+        // Millisecond stamp plus a suffix if taken: a manual dump and an error-triggered one can land close together
+        auto stamp = std::chrono::duration_cast<std::chrono::milliseconds>(
+                         std::chrono::system_clock::now().time_since_epoch())
+                         .count();
+        std::string base = "HomeAssistantLink_flight_" + std::to_string(stamp);
+        auto file = g_FlightDumpDirectory / (base + ".bin");
+        std::error_code ec;
+        for (int n = 1; std::filesystem::exists(file, ec); ++n) {
+            file = g_FlightDumpDirectory / (base + "_" + std::to_string(n) + ".bin");
+        }
+
+        std::ofstream out(file, std::ios::binary | std::ios::trunc);
+        if (!out.is_open()) {
+            LogToFile_Error("Flight recorder: cannot write " + file.string());
+            return;
+        }
+
+        size_t count = static_cast<size_t>(std::min<std::uint64_t>(g_FlightWritten, g_FlightRing.size()));
+        std::uint8_t lampCount = static_cast<std::uint8_t>(std::min<size_t>(g_RealLamps.size(), MAX_LAMPS));
+
+        FlightDumpHeader header{};
+        header.magic = DUMP_MAGIC;
+        header.version = DUMP_VERSION;
+        header.frameSize = sizeof(FlightFrame);
+        header.frameCount = static_cast<std::uint32_t>(count);
+        header.lampCount = lampCount;
+        header.dumpTimestamp_us = MicrosSinceEpoch(Clock::now());
+        std::strncpy(header.reason, reason, sizeof(header.reason) - 1);
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+        for (size_t i = 0; i < lampCount; ++i) {
+            char name[ENTITY_ID_SIZE] = {};
+            std::strncpy(name, g_RealLamps[i].entity_id.c_str(), sizeof(name) - 1);
+            out.write(name, sizeof(name));
+        }
+
+        // Oldest first
+        size_t first = static_cast<size_t>(g_FlightWritten % g_FlightRing.size());
+        if (g_FlightWritten < g_FlightRing.size()) first = 0;
+        for (size_t i = 0; i < count; ++i) {
+            const FlightFrame& f = g_FlightRing[(first + i) % g_FlightRing.size()];
+            out.write(reinterpret_cast<const char*>(&f), sizeof(f));
+        }
+
+        LogToFile_Warn("Flight recorder dumped " + std::to_string(count) + " frames (" + reason + ") to " +
+                       file.string());
+    }
+}
+
+void ConfigureFlightRecorder(size_t frames, std::filesystem::path dumpDirectory) {
+    g_FlightRing.assign(frames, FlightFrame{});
+    SetResidentBytes(ResidentTable::FlightRecorder, g_FlightRing.capacity() * sizeof(FlightFrame));
+    g_FlightDumpDirectory = std::move(dumpDirectory);
+    g_FlightWritten = 0;
+}
+
+FlightFrame* BeginFlightFrame() {
+    if (g_FlightRing.empty()) return nullptr;
+    g_FlightTickStart = Clock::now();
+    g_CurrentFlight = FlightFrame{};
+    g_CurrentFlight.timestamp_us = MicrosSinceEpoch(g_FlightTickStart);
+    g_CurrentFlight.sequence = static_cast<std::uint32_t>(g_FlightWritten);
+    g_CurrentFlight.scenarioIndex = -1;
+    g_FlightInProgress = true;
+    return &g_CurrentFlight;
+}
+
+void RecordFlightCommand(std::string_view entity_id, CommandOutcome outcome, long status, std::uint64_t latency_us) {
+    if (!g_FlightInProgress) return;
+    size_t lamps = std::min<size_t>(g_RealLamps.size(), MAX_LAMPS);
+    for (size_t i = 0; i < lamps; ++i) {
+        if (g_RealLamps[i].entity_id != entity_id) continue;
+        FlightLamp& lamp = g_CurrentFlight.lamps[i];
+        lamp.outcome = static_cast<std::uint8_t>(outcome);
+        lamp.status = static_cast<std::int16_t>(status);
+        lamp.latency_us = static_cast<std::uint32_t>(std::min<std::uint64_t>(latency_us, UINT32_MAX));
+        break;
+    }
+    if (outcome == CommandOutcome::Sent || outcome == CommandOutcome::Failed) ++g_CurrentFlight.requestCount;
+}
+
+void CommitFlightFrame() {
+    if (!g_FlightInProgress) return;
+    g_FlightInProgress = false;
+
+    auto now = Clock::now();
+    g_CurrentFlight.tickDuration_us = static_cast<std::uint32_t>(
+        std::chrono::duration_cast<std::chrono::microseconds>(now - g_FlightTickStart).count());
+    g_FlightRing[g_FlightWritten % g_FlightRing.size()] = g_CurrentFlight;
+    ++g_FlightWritten;
+
+    // Explicit requests always dump; automatic triggers are rate limited
+    if (const char* requested = g_RequestedDumpReason.exchange(nullptr)) {
+        WriteFlightDump(requested);
+        return;
+    }
+
+    const char* reason = nullptr;
+    bool failed =
+        std::any_of(std::begin(g_CurrentFlight.lamps), std::end(g_CurrentFlight.lamps), [](const FlightLamp& l) {
+            return l.outcome == static_cast<std::uint8_t>(CommandOutcome::Failed);
+        });
+    auto thresholdUs = static_cast<std::uint64_t>(g_Diagnostics.flight_latency_threshold_ms) * 1000;
+    if (failed) {
+        reason = "request error";
+    } else if (thresholdUs > 0 && g_CurrentFlight.tickDuration_us > thresholdUs) {
+        reason = "latency threshold";
+    }
+    if (reason && (!g_HasAutoDumped || now - g_LastAutoDump >= AUTO_DUMP_COOLDOWN)) {
+        g_HasAutoDumped = true;
+        g_LastAutoDump = now;
+        WriteFlightDump(reason);
+    }
+}
+
+void RequestFlightRecorderDump(const char* reason) { g_RequestedDumpReason.store(reason); }
@@ -0,0 +1,23 @@
+#pragma once
+#include <chrono>
+#include <filesystem>
+#include <string_view>
+
+#include "FlightRecorderFormat.h"
+
+// Fixed-size ring of per-tick records (inputs, decisions, outgoing commands) written by the export thread.
+// Dumped automatically on request errors and latency spikes, or on demand.
+
+// Allocates the ring (frames = 0 disables the recorder). Call before the export thread starts.
+void ConfigureFlightRecorder(size_t frames, std::filesystem::path dumpDirectory);
+
+// Starts a new record; returns nullptr if the recorder is disabled. Export thread only.
+FlightRecorder::FlightFrame* BeginFlightFrame();
+// Annotates the current record with the outcome of a command for the given lamp. Export thread only.
+void RecordFlightCommand(std::string_view entity_id, FlightRecorder::CommandOutcome outcome, long status,
+                         std::uint64_t latency_us);
+// Finishes the current record and performs any automatic or requested dump. Export thread only.
+void CommitFlightFrame();
+
+// Asks the export thread to dump at the end of its current tick. Callable from any thread.
+void RequestFlightRecorderDump(const char* reason);
@@ -0,0 +1,73 @@
+#pragma once
+#include <cstdint>
+
+// On-disk format of flight recorder dumps (little-endian):
+//   FlightDumpHeader | char[lampCount][FLIGHT_ENTITY_ID_SIZE] | FlightFrame[frameCount] (oldest first)
+
+namespace FlightRecorder {
+    constexpr std::uint32_t DUMP_MAGIC = 0x464C4148;  // "HALF"
+    constexpr std::uint16_t DUMP_VERSION = 1;
+    constexpr std::uint8_t MAX_LAMPS = 8;
+    constexpr size_t ENTITY_ID_SIZE = 64;
+
+    enum FrameFlags : std::uint32_t {
+        kInCombat = 1 << 0,
+        kInterior = 1 << 1,
+        kTorchEquipped = 1 << 2,
+        kIntentsActive = 1 << 3,
+    };
+
+    enum class CommandOutcome : std::uint8_t {
+        None = 0,         // Lamp not driven this frame (inherit)
+        Sent = 1,         // HA accepted the last request for this lamp
+        Deduped = 2,      // Skipped, lamp already in the target state
+        Failed = 3,       // HA request failed
+        Quarantined = 4,  // Skipped, lamp failing and waiting for its next probe (EntityHealth)
+        Coalesced = 5,    // Held, lamp changed again within its coalescing window
+    };
+
+    enum LampDecision : std::uint8_t {
+        kDecisionInherit = 1 << 0,
+        kDecisionFlicker = 1 << 1,
+        kDecisionScene = 1 << 2,
+    };
+
+#pragma pack(push, 1)
+    struct FlightDumpHeader {
+        std::uint32_t magic;
+        std::uint16_t version;
+        std::uint16_t frameSize;  // sizeof(FlightFrame)
+        std::uint32_t frameCount;
+        std::uint8_t lampCount;
+        std::uint8_t reserved[3];
+        std::uint64_t dumpTimestamp_us;
+        char reason[48];
+    };
+
+    struct FlightLamp {
+        std::uint8_t r, g, b;
+        std::uint8_t brightness_pct;
+        std::uint8_t decision;  // LampDecision
+        std::uint8_t outcome;   // CommandOutcome
+        std::int16_t status;    // Last HTTP status (0 = transport error / none)
+        std::uint32_t latency_us;
+    };
+
+    struct FlightFrame {
+        std::uint64_t timestamp_us;
+        std::uint32_t sequence;
+        std::uint32_t flags;  // FrameFlags
+        float gameHour;
+        float x, y, z, yaw;
+        std::uint16_t nearbyLights;
+        std::int16_t scenarioIndex;  // Index into Scenarios, -1 = ambient
+        std::uint32_t tickDuration_us;
+        std::uint32_t applyDuration_us;
+        std::uint32_t requestCount;
+        FlightLamp lamps[MAX_LAMPS];
+    };
+#pragma pack(pop)
+
+    static_assert(sizeof(FlightLamp) == 12);
+    static_assert(sizeof(FlightFrame) == 148);
+}
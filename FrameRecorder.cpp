@@ -0,0 +1,160 @@
+#include "FrameRecorder.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <mutex>
+
+#include "Logger.h"
+
+namespace {
+    std::atomic<bool> g_Recording{false};
+    std::mutex g_RecordingMutex;  // Guards the stream; only contended while starting or stopping
+    std::ofstream g_RecordingFile;
+    std::chrono::steady_clock::time_point g_RecordingStart;
+    std::uint64_t g_RecordedFrames = 0;
+    std::vector<char> g_FrameBuffer;  // Reused serialization buffer, one write per frame
+
+    template <typename T>
+    void Append(std::vector<char>& buffer, const T& value) {
+        size_t offset = buffer.size();
+        buffer.resize(offset + sizeof(T));
+        std::memcpy(buffer.data() + offset, &value, sizeof(T));
+    }
+
+    void CloseRecordingLocked() {
+        if (g_RecordingFile.is_open()) {
+            g_RecordingFile.close();
+            LogToFile_Info("Frame recording stopped after " + std::to_string(g_RecordedFrames) + " frames.");
+        }
+    }
+}
+
+std::filesystem::path MakeFrameRecordingPath(const std::filesystem::path& directory) {
+    auto stamp =
+        std::chrono::duration_cast<std::chrono::seconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+    return directory / ("HomeAssistantLink_frames_" + std::to_string(stamp) + ".halrec");
+}
+
+bool StartFrameRecording(const std::filesystem::path& file) {
+    std::lock_guard lock(g_RecordingMutex);
+    g_Recording.store(false, std::memory_order_relaxed);
+    CloseRecordingLocked();
+
+    g_RecordingFile.open(file, std::ios::binary | std::ios::trunc);
+    if (!g_RecordingFile) {
+        LogToFile_Error("Failed to open frame recording " + file.string());
+        return false;
+    }
+    FrameRecording::RecordingHeader header{};
+    header.magic = FrameRecording::FILE_MAGIC;
+    header.version = FrameRecording::FORMAT_VERSION;
+    header.frameHeaderSize = sizeof(FrameRecording::RecordedFrameHeader);
+    header.lightSize = sizeof(FrameRecording::RecordedLight);
+    header.lightRadius = GetLiveLightingOptions().options.light_radius;
+    header.startUnixTime_ms = static_cast<std::uint64_t>(
+        std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch())
+            .count());
+    g_RecordingFile.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+    g_RecordingStart = std::chrono::steady_clock::now();
+    g_RecordedFrames = 0;
+    g_Recording.store(true, std::memory_order_release);
+    LogToFile_Info("Frame recording started: " + file.string());
+    return true;
+}
+
+void StopFrameRecording() {
+    std::lock_guard lock(g_RecordingMutex);
+    g_Recording.store(false, std::memory_order_relaxed);
+    CloseRecordingLocked();
+}
+
+bool IsFrameRecording() { return g_Recording.load(std::memory_order_relaxed); }
+
+void RecordFrame(const FrameInput& frame) {
+    if (!g_Recording.load(std::memory_order_relaxed)) return;
+    std::lock_guard lock(g_RecordingMutex);
+    if (!g_RecordingFile.is_open()) return;
+
+    FrameRecording::RecordedFrameHeader header{};
+    header.time_us = static_cast<std::uint64_t>(
+        std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - g_RecordingStart)
+            .count());
+    header.gameHour = frame.gameHour;
+    header.yaw = frame.playerYaw;
+    header.x = frame.playerPos.x;
+    header.y = frame.playerPos.y;
+    header.z = frame.playerPos.z;
+    header.flags = (frame.inCombat ? std::uint32_t{FrameRecording::kInCombat} : 0u) |
+                   (frame.isInterior ? std::uint32_t{FrameRecording::kInterior} : 0u) |
+                   (frame.torchEquipped ? std::uint32_t{FrameRecording::kTorchEquipped} : 0u);
+    header.modEventFlags = frame.modEventFlags;
+    header.lightCount = static_cast<std::uint16_t>(std::min<size_t>(frame.lights.size(), UINT16_MAX));
+
+    g_FrameBuffer.clear();
+    Append(g_FrameBuffer, header);
+    for (size_t i = 0; i < header.lightCount; ++i) {
+        const InGameLight& l = frame.lights[i];
+        FrameRecording::RecordedLight light{};
+        light.x = l.skyrim_pos.x;
+        light.y = l.skyrim_pos.y;
+        light.z = l.skyrim_pos.z;
+        light.intensity = l.intensity;
+        light.r = static_cast<std::uint8_t>(std::clamp(l.color_r, 0, 255));
+        light.g = static_cast<std::uint8_t>(std::clamp(l.color_g, 0, 255));
+        light.b = static_cast<std::uint8_t>(std::clamp(l.color_b, 0, 255));
+        light.kind = l.type == "fire" ? FrameRecording::kFire : FrameRecording::kOther;
+        Append(g_FrameBuffer, light);
+    }
+    g_RecordingFile.write(g_FrameBuffer.data(), static_cast<std::streamsize>(g_FrameBuffer.size()));
+    ++g_RecordedFrames;
+}
+
+bool LoadFrameRecording(const std::filesystem::path& file, std::vector<RecordedFrame>& frames, std::string& error) {
+    std::ifstream in(file, std::ios::binary);
+    if (!in) {
+        error = "cannot open " + file.string();
+        return false;
+    }
+    FrameRecording::RecordingHeader header{};
+    if (!in.read(reinterpret_cast<char*>(&header), sizeof(header)) || header.magic != FrameRecording::FILE_MAGIC) {
+        error = "not a frame recording";
+        return false;
+    }
+    if (header.version != FrameRecording::FORMAT_VERSION ||
+        header.frameHeaderSize != sizeof(FrameRecording::RecordedFrameHeader) ||
+        header.lightSize != sizeof(FrameRecording::RecordedLight)) {
+        error = "unsupported recording version " + std::to_string(header.version);
+        return false;
+    }
+
+    frames.clear();
+    FrameRecording::RecordedFrameHeader frameHeader{};
+    std::vector<FrameRecording::RecordedLight> lights;
+    while (in.read(reinterpret_cast<char*>(&frameHeader), sizeof(frameHeader))) {
+        lights.resize(frameHeader.lightCount);
+        if (!in.read(reinterpret_cast<char*>(lights.data()),
+                     static_cast<std::streamsize>(lights.size() * sizeof(FrameRecording::RecordedLight)))) {
+            break;  // Truncated last frame
+        }
+        RecordedFrame& frame = frames.emplace_back();
+        frame.time_us = frameHeader.time_us;
+        frame.input.gameHour = frameHeader.gameHour;
+        frame.input.playerYaw = frameHeader.yaw;
+        frame.input.playerPos = Vec3{frameHeader.x, frameHeader.y, frameHeader.z};
+        frame.input.inCombat = (frameHeader.flags & FrameRecording::kInCombat) != 0;
+        frame.input.isInterior = (frameHeader.flags & FrameRecording::kInterior) != 0;
+        frame.input.torchEquipped = (frameHeader.flags & FrameRecording::kTorchEquipped) != 0;
+        frame.input.modEventFlags = frameHeader.modEventFlags;
+        frame.input.lights.reserve(lights.size());
+        for (const auto& l : lights) {
+            frame.input.lights.push_back(InGameLight{Vec3{l.x, l.y, l.z},
+                                                     l.kind == FrameRecording::kFire ? "fire" : "other", l.r, l.g,
+                                                     l.b, l.intensity});
+        }
+    }
+    return true;
+}
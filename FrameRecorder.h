@@ -0,0 +1,31 @@
+#pragma once
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include "FrameRecordingFormat.h"
+#include "Pipeline.h"
+
+// Records the per-tick game-state snapshot (the FrameInput of RunLightPipeline) to a compact binary file,
+// so mapping, blending and smoothing can be replayed and measured offline (tools/HomeAssistantLink_replay).
+
+// <directory>/HomeAssistantLink_frames_<unix time>.halrec
+std::filesystem::path MakeFrameRecordingPath(const std::filesystem::path& directory);
+
+// Starts a new recording, replacing any running one. Callable from any thread.
+bool StartFrameRecording(const std::filesystem::path& file);
+// Flushes and closes the running recording, if any. Callable from any thread.
+void StopFrameRecording();
+bool IsFrameRecording();
+
+// Appends one tick. Export thread; a single relaxed load when no recording is running.
+void RecordFrame(const FrameInput& frame);
+
+struct RecordedFrame {
+    std::uint64_t time_us = 0;  // Since the start of the recording
+    FrameInput input;
+};
+
+// Reads a whole recording. Returns false (with a reason in error) if the file is missing or not a recording.
+bool LoadFrameRecording(const std::filesystem::path& file, std::vector<RecordedFrame>& frames, std::string& error);
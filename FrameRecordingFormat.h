@@ -0,0 +1,57 @@
+#pragma once
+#include <cstdint>
+
+// On-disk format of frame recordings (little-endian):
+//   RecordingHeader | { RecordedFrameHeader | RecordedLight[lightCount] }...
+// One frame per export tick, appended until the recording is stopped. A truncated last frame (game crash) is
+// ignored by readers.
+
+namespace FrameRecording {
+    constexpr std::uint32_t FILE_MAGIC = 0x524C4148;  // "HALR"
+    constexpr std::uint16_t FORMAT_VERSION = 1;
+
+    enum FrameFlags : std::uint32_t {
+        kInCombat = 1 << 0,
+        kInterior = 1 << 1,
+        kTorchEquipped = 1 << 2,
+    };
+
+    enum LightKind : std::uint8_t {
+        kFire = 0,
+        kOther = 255,
+    };
+
+#pragma pack(push, 1)
+    struct RecordingHeader {
+        std::uint32_t magic;
+        std::uint16_t version;
+        std::uint16_t frameHeaderSize;  // sizeof(RecordedFrameHeader)
+        std::uint16_t lightSize;        // sizeof(RecordedLight)
+        std::uint16_t reserved;
+        float lightRadius;              // LIGHT_RADIUS at recording time
+        std::uint64_t startUnixTime_ms;
+    };
+
+    struct RecordedFrameHeader {
+        std::uint64_t time_us;  // Since the start of the recording
+        float gameHour;
+        float yaw;
+        float x, y, z;  // Player world position
+        std::uint32_t flags;  // FrameFlags
+        std::uint64_t modEventFlags;
+        std::uint16_t lightCount;
+        std::uint16_t reserved;
+    };
+
+    struct RecordedLight {
+        float x, y, z;  // Relative to the player
+        float intensity;
+        std::uint8_t r, g, b;
+        std::uint8_t kind;  // LightKind
+    };
+#pragma pack(pop)
+
+    static_assert(sizeof(RecordingHeader) == 24, "RecordingHeader layout is part of the file format");
+    static_assert(sizeof(RecordedFrameHeader) == 44, "RecordedFrameHeader layout is part of the file format");
+    static_assert(sizeof(RecordedLight) == 20, "RecordedLight layout is part of the file format");
+}
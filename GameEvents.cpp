@@ -0,0 +1,31 @@
+#include "GameEvents.h"
+
+#include "Logger.h"
+#include "ModEventTriggers.h"
+
+namespace {
+    // Forwards every ModEvent (SendModEvent from Papyrus) to the mod_event trigger latch
+    class ModEventSink : public RE::BSTEventSink<SKSE::ModCallbackEvent> {
+    public:
+        RE::BSEventNotifyControl ProcessEvent(const SKSE::ModCallbackEvent* a_event,
+                                              RE::BSTEventSource<SKSE::ModCallbackEvent>*) override {
+            if (a_event && LatchModEvent(a_event->eventName.c_str())) {
+                HAL_LOG_DEBUG("ModEvent trigger latched: {}", a_event->eventName.c_str());
+            }
+            return RE::BSEventNotifyControl::kContinue;
+        }
+    };
+
+    ModEventSink g_ModEventSink;
+}
+
+void RegisterGameEventSinks() {
+    if (GetModEventTriggerCount() > 0) {
+        if (auto source = SKSE::GetModCallbackEventSource()) {
+            source->AddEventSink(&g_ModEventSink);
+            LogToFile_Info("ModEvent sink registered.");
+        } else {
+            LogToFile_Warn("ModEvent source unavailable. 'mod_event' scenarios will never trigger.");
+        }
+    }
+}
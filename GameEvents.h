@@ -0,0 +1,4 @@
+#pragma once
+
+// Registers the game/SKSE event sinks the plugin reacts to (ModEvents, ...). Call once game data is loaded.
+void RegisterGameEventSinks();
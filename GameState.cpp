@@ -9,12 +9,27 @@
 #include <string>
 #include <vector>
 
+#include "AllocationTracker.h"
+#include "Ambilight.h"
+#include "AmbilightCapture.h"
+#include "AudioReactive.h"
 #include "ConfigLoader.h"
+#include "ExternalIntents.h"
+#include "FlightRecorder.h"
+#include "FrameRecorder.h"
 #include "LampMapping.h"
 #include "LightManager.h"
 #include "LightSmoother.h"
 #include "Logger.h"
+#include "Metrics.h"
+#include "ModEventTriggers.h"
+#include "Pipeline.h"
+#include "Profiler.h"
 #include "SkyrimLightsDB.h"
+#include "TelemetryFrame.h"
+#include "TelemetryPublisher.h"
+#include "TraceRecorder.h"
+#include "TuningServer.h"
 
 // --- Helper: Get player camera yaw in radians (true view direction, 0 = world X+), normalized [0, 2pi) ---
 float GetPlayerCameraYawRadians() {
@@ -85,6 +100,12 @@ std::vector<NearbyLightInfo> GetNearbyLights(float radius) {
 // --- File-scope smoother ---
 static LightSmoother g_smoother;
 
+// --- Screen-color layer ---
+static AmbilightKernel g_ambilightKernel;
+static std::vector<std::uint8_t> g_ambilightPixels;  // Reused capture buffer
+constexpr auto AMBILIGHT_MAX_AGE = std::chrono::seconds(1);  // Older captures (menus, loading) are ignored
+constexpr auto AUDIO_MAX_AGE = std::chrono::milliseconds(500);  // No newer block: silence or capture stopped
+
 // --- Torch detection ---
 bool IsTorchEquipped() {
     auto player = RE::PlayerCharacter::GetSingleton();
@@ -96,68 +117,47 @@ bool IsTorchEquipped() {
     return isTorch(right) || isTorch(left);
 }
 
-// --- Ambient (day/night) lighting from keyframes ---
-LightState GetAmbientStateForHour(float gameHour, const std::string& entity_id) {
-    if (g_DayNightCycle.size() < 2)
-        return LightState{entity_id, {128, 128, 128}, 50, std::nullopt, std::nullopt, false, std::nullopt};
-    float hour = std::fmod(gameHour, 24.0f);
-    if (hour < 0.0f) hour += 24.0f;
-    const DayNightKeyframe* kfA = nullptr;
-    const DayNightKeyframe* kfB = nullptr;
-    for (size_t i = 0; i < g_DayNightCycle.size(); ++i) {
-        size_t next = (i + 1) % g_DayNightCycle.size();
-        float hourA = static_cast<float>(g_DayNightCycle[i].hour);
-        float hourB = static_cast<float>(g_DayNightCycle[next].hour);
-        bool inSegment = false;
-        if (hourA < hourB)
-            inSegment = (hour >= hourA && hour < hourB);
-        else
-            inSegment = (hour >= hourA || hour < hourB);
-        if (inSegment) {
-            kfA = &g_DayNightCycle[i];
-            kfB = &g_DayNightCycle[next];
-            break;
-        }
-    }
-    if (!kfA || !kfB) {
-        kfA = &g_DayNightCycle[0];
-        kfB = &g_DayNightCycle[1];
-    }
-    float hourA = static_cast<float>(kfA->hour);
-    float hourB = static_cast<float>(kfB->hour);
-    float t;
-    if (hourA == hourB)
-        t = 0.0f;
-    else if (hourA < hourB)
-        t = (hour - hourA) / (hourB - hourA);
-    else {
-        float len = (24.0f - hourA) + hourB;
-        t = (hour >= hourA) ? (hour - hourA) / len : (hour + 24.0f - hourA) / len;
-    }
-    std::array<int, 3> rgb;
-    for (int c = 0; c < 3; ++c) rgb[c] = static_cast<int>((1.0f - t) * kfA->rgb_color[c] + t * kfB->rgb_color[c]);
-    int brightness = static_cast<int>((1.0f - t) * kfA->brightness_pct + t * kfB->brightness_pct);
-    return LightState{entity_id, rgb, brightness, std::nullopt, std::nullopt, false, std::nullopt};
-}
-
 // --- Main Export Function ---
 void ExportGameData() {
+    ScopedStageTimer tickTimer(PipelineStage::Tick);
+    RecordTick();
+    ScopedStageTimer gatherTimer(PipelineStage::GatherState);
+
     auto player = RE::PlayerCharacter::GetSingleton();
     if (!player) {
-        LogToFile_Debug("Player not found, skipping data export.");
+        HAL_LOG_DEBUG("Player not found, skipping data export.");
         return;
     }
 
     float gameHour = RE::Calendar::GetSingleton()->gameHour->value;
     bool inCombat = player->IsInCombat();
     bool isInterior = IsPlayerInInterior();
+    bool torchEquipped = IsTorchEquipped();
+    std::uint64_t modEventFlags = ConsumeModEventFlags();
+    FlightRecorder::FlightFrame* flight = BeginFlightFrame();
+    gatherTimer.Stop();
+
+    static bool s_wasInCombat = false;
+    if (inCombat != s_wasInCombat) {
+        TraceInstant(inCombat ? "combat_start" : "combat_end", "game");
+        s_wasInCombat = inCombat;
+    }
 
-    // STEP 1: Dynamic/Proximity Lighting
-    float radius = 400.0f;
-    auto fires = GetNearbyLights(radius);
-    std::vector<InGameLight> ingameLights;
+    // STEP 1: Snapshot of the nearby lights (positions relative to the player)
+    ScopedStageTimer nearbyTimer(PipelineStage::NearbyLights);
+    auto fires = GetNearbyLights(GetLiveLightingOptions().options.light_radius);
+    nearbyTimer.Stop();
     auto playerPos = player->GetPosition();
 
+    FrameInput frame;
+    frame.gameHour = gameHour;
+    frame.playerYaw = GetPlayerCameraYawRadians();
+    frame.playerPos = Vec3{playerPos.x, playerPos.y, playerPos.z};
+    frame.inCombat = inCombat;
+    frame.isInterior = isInterior;
+    frame.torchEquipped = torchEquipped;
+    frame.modEventFlags = modEventFlags;
+    frame.lights.reserve(fires.size());
     for (const auto& l : fires) {
         Vec3 relPos = {l.position.x - playerPos.x, l.position.y - playerPos.y, l.position.z - playerPos.z};
         int r = 255, g = 140, b = 0;
@@ -167,84 +167,83 @@ void ExportGameData() {
             b = std::get<2>(l.rgb);
         }
         float brightness = l.brightness;
-        ingameLights.push_back(InGameLight{relPos, "fire", r, g, b, brightness});
+        frame.lights.push_back(InGameLight{relPos, "fire", r, g, b, brightness});
     }
-
-    float playerYaw = GetPlayerCameraYawRadians();
-    auto dynamicLampStates = MapInGameLightsToRealLamps(g_RealLamps, ingameLights, playerYaw, radius);
-
-    // STEP 2: Get active scenario for torch/combat (no default/always/night/day scenarios anymore)
-    std::vector<LightState> scenarioLampStates;
-    const Scenario* activeScenario = nullptr;
-    int highestPriority = -1;
-    for (const auto& scenario : g_SCENARIOS) {
-        bool triggerMet = false;
-        if (scenario.trigger.type == "player_in_combat") {
-            if (inCombat) triggerMet = true;
-        } else if (scenario.trigger.type == "torch_equipped") {
-            if (IsTorchEquipped()) triggerMet = true;
-        }
-        if (triggerMet && scenario.priority > highestPriority) {
-            highestPriority = scenario.priority;
-            activeScenario = &scenario;
+    if (g_Ambilight.enabled) {
+        ScopedStageTimer ambilightTimer(PipelineStage::Ambilight);
+        AmbilightImage image;
+        if (GetLatestAmbilightCapture(g_ambilightPixels, image, AMBILIGHT_MAX_AGE)) {
+            g_ambilightKernel.Configure(g_RealLamps, g_Ambilight);
+            frame.ambilight = g_ambilightKernel.Process(image);
         }
     }
-    if (activeScenario) {
-        scenarioLampStates = activeScenario->outcome;
+    if (g_AudioReactive.enabled) {
+        AudioBands bands;
+        if (g_AudioBands.Read(bands, AUDIO_MAX_AGE)) frame.audio = bands;
     }
+    RecordFrame(frame);
 
-    // --- Use ambient (day/night) only if no high-prio scenario is active ---
-    if (!activeScenario) {
-        scenarioLampStates.clear();
-        for (const auto& lamp : g_RealLamps) {
-            if (!isInterior) {
-                scenarioLampStates.push_back(GetAmbientStateForHour(gameHour, lamp.entity_id));
-            } else {
-                // In interiors, only use dynamic/proximity (fire), ambient = inherit
-                LightState s;
-                s.entity_id = lamp.entity_id;
-                s.inherit = true;
-                scenarioLampStates.push_back(s);
-            }
-        }
-    }
-
-    // STEP 3: Blend dynamic and scenario/ambient per lamp, with fire dominance
-    std::vector<LightState> finalLampStates;
-    for (size_t i = 0; i < dynamicLampStates.size(); ++i) {
-        LightState dyn = dynamicLampStates[i];
-        LightState scen = (i < scenarioLampStates.size()) ? scenarioLampStates[i] : dyn;
+    // STEP 2-4: Mapping, scenario/ambient, blend, smoothing (Pipeline.cpp)
+    auto [smoothedStates, activeScenario, optionsVersion] = RunLightPipeline(frame, g_smoother);
+    SetResidentBytes(ResidentTable::SmootherState, g_smoother.ApproxResidentBytes());
 
-        float fire_influence = std::clamp(static_cast<float>(dyn.brightness_pct) / 100.0f, 0.0f, 1.0f);
-        fire_influence = std::pow(fire_influence, 0.4f);
-
-        if (fire_influence < 0.05f) fire_influence = 0.0f;
-        if (fire_influence > 0.95f) fire_influence = 1.0f;
+    static const Scenario* s_lastScenario = nullptr;
+    if (activeScenario != s_lastScenario) {
+        TraceInstant("scenario_change", "game", activeScenario ? std::string_view(activeScenario->name) : "ambient");
+        s_lastScenario = activeScenario;
+    }
 
-        float scenario_weight = 1.0f - fire_influence;
+    // STEP 5: Intents submitted by other plugins (own envelopes, so applied after smoothing)
+    ScopedStageTimer intentsTimer(PipelineStage::Intents);
+    ApplyExternalIntents(smoothedStates);
+    intentsTimer.Stop();
+    if (TuningClientConnected()) {
+        PublishTuningFrame(g_Metrics.ticks.load(std::memory_order_relaxed), optionsVersion,
+                           activeScenario ? std::string_view(activeScenario->name) : "ambient", smoothedStates);
+    }
 
-        LightState out = dyn;
-        for (int c = 0; c < 3; ++c) {
-            out.rgb_color[c] =
-                static_cast<int>(fire_influence * dyn.rgb_color[c] + scenario_weight * scen.rgb_color[c]);
+    // Publish before the (blocking) HA requests so external consumers are not delayed by HA latency
+    std::uint32_t telemetryFlags = (inCombat ? Telemetry::kInCombat : 0) | (isInterior ? Telemetry::kInterior : 0) |
+                                   (torchEquipped ? Telemetry::kTorchEquipped : 0) |
+                                   (activeScenario ? Telemetry::kScenarioActive : 0);
+    PublishTelemetry(
+        TelemetryInput{frame.playerPos, frame.playerYaw, gameHour, telemetryFlags, &frame.lights, &smoothedStates});
+
+    HAL_LOG_DEBUG("Blended dynamic+ambient/scenario mapping (per-lamp fire_influence): {} lamps.",
+                  smoothedStates.size());
+    if (flight) {
+        flight->flags = (inCombat ? FlightRecorder::kInCombat : 0) | (isInterior ? FlightRecorder::kInterior : 0) |
+                        (torchEquipped ? FlightRecorder::kTorchEquipped : 0) |
+                        (GetActiveIntentLayerCount() > 0 ? FlightRecorder::kIntentsActive : 0);
+        flight->gameHour = gameHour;
+        flight->x = playerPos.x;
+        flight->y = playerPos.y;
+        flight->z = playerPos.z;
+        flight->yaw = frame.playerYaw;
+        flight->nearbyLights = static_cast<std::uint16_t>(std::min<size_t>(frame.lights.size(), UINT16_MAX));
+        flight->scenarioIndex = activeScenario ? static_cast<std::int16_t>(activeScenario - g_SCENARIOS.data()) : -1;
+        for (size_t i = 0; i < smoothedStates.size() && i < FlightRecorder::MAX_LAMPS; ++i) {
+            const LightState& s = smoothedStates[i];
+            auto& lamp = flight->lamps[i];
+            lamp.r = static_cast<std::uint8_t>(std::clamp(s.rgb_color[0], 0, 255));
+            lamp.g = static_cast<std::uint8_t>(std::clamp(s.rgb_color[1], 0, 255));
+            lamp.b = static_cast<std::uint8_t>(std::clamp(s.rgb_color[2], 0, 255));
+            lamp.brightness_pct = static_cast<std::uint8_t>(std::clamp(s.brightness_pct, 0, 100));
+            std::string_view effect = s.effect.has_value() ? std::string_view(s.effect.value()) : "";
+            if (s.inherit) lamp.decision |= FlightRecorder::kDecisionInherit;
+            if (effect == "flicker") lamp.decision |= FlightRecorder::kDecisionFlicker;
+            if (effect == "scene") lamp.decision |= FlightRecorder::kDecisionScene;
         }
-        out.brightness_pct =
-            static_cast<int>(fire_influence * dyn.brightness_pct + scenario_weight * scen.brightness_pct);
-
-        out.rgb_color[0] = std::clamp(out.rgb_color[0], 0, 255);
-        out.rgb_color[1] = std::clamp(out.rgb_color[1], 0, 255);
-        out.rgb_color[2] = std::clamp(out.rgb_color[2], 0, 255);
-        out.brightness_pct = std::clamp(out.brightness_pct, 10, 100);
-
-        if (scen.inherit) out = dyn;
-
-        finalLampStates.push_back(out);
     }
 
-    // STEP 4: Smoothing
-    std::vector<LightState> smoothedStates = g_smoother.SmoothStates(finalLampStates, 0.2f);
-
-    LogToFile_Debug("Blended dynamic+ambient/scenario mapping (per-lamp fire_influence): " +
-                    std::to_string(smoothedStates.size()) + " lamps.");
+    auto applyStart = std::chrono::steady_clock::now();
+    ScopedStageTimer applyTimer(PipelineStage::Apply);
     ApplyLightStates(smoothedStates);
+    applyTimer.Stop();
+    if (flight) {
+        flight->applyDuration_us = static_cast<std::uint32_t>(
+            std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - applyStart)
+                .count());
+    }
+    CommitFlightFrame();
 }
@@ -0,0 +1,65 @@
+#pragma once
+#include <cstdint>
+
+// Public inter-plugin interface of HomeAssistantLink.
+//
+// Copy this header into your own SKSE plugin. To obtain the interface:
+//   1. Register a listener for messages sent by "HomeAssistantLink":
+//        SKSE::GetMessagingInterface()->RegisterListener(HomeAssistantLinkAPI::PluginName, OnHALMessage);
+//   2. Once all plugins are loaded (kPostLoad or later), send a request:
+//        HomeAssistantLinkAPI::InterfaceRequest req{HomeAssistantLinkAPI::kInterfaceVersion1};
+//        SKSE::GetMessagingInterface()->Dispatch(HomeAssistantLinkAPI::kRequestInterface, &req, sizeof(req),
+//                                                HomeAssistantLinkAPI::PluginName);
+//   3. OnHALMessage receives kInterfaceReply; keep the IVHAL1 pointer for the rest of the session.
+//
+// All IVHAL1 methods are thread-safe and never block: intents are copied into a lock-free queue and picked up
+// by the next pipeline pass of HomeAssistantLink (no Papyrus, no string parsing).
+namespace HomeAssistantLinkAPI {
+    constexpr const char* PluginName = "HomeAssistantLink";
+
+    constexpr std::uint32_t kInterfaceVersion1 = 1;
+
+    enum MessageType : std::uint32_t {
+        kRequestInterface = 0x48414C00,  // 'HAL\0', payload: InterfaceRequest
+        kInterfaceReply = 0x48414C01,    // payload: InterfaceReply
+    };
+
+    // A light intent is blended on top of the regular lamp output.
+    // Intents are grouped by layer: a new intent replaces whatever is active on the same layer.
+    struct LightIntent {
+        std::uint32_t layer;          // Caller-chosen id. Pick something unlikely to collide (e.g. a hash of your name)
+        std::uint32_t lampMask;       // Bit i = lamp i of the "Lights" array. 0 = fade out (clear) the layer
+        std::uint8_t rgb[3];          // Target color
+        std::uint8_t brightness_pct;  // Target brightness, 0..100
+        std::uint16_t attack_ms;      // Fade-in time
+        std::uint16_t release_ms;     // Fade-out time once the hold ends (or the layer is cleared)
+        std::uint32_t hold_ms;        // Time at full strength after the attack. 0 = hold until cleared
+        float strength;               // Peak blend weight over the regular output, 0..1
+        std::int32_t priority;        // Layers are blended in ascending priority, so the highest wins
+    };
+    static_assert(sizeof(LightIntent) == 28, "LightIntent layout is part of the ABI");
+
+    class IVHAL1 {
+    public:
+        // Returns false if the intent queue is full (the intent is dropped).
+        virtual bool SubmitIntent(const LightIntent& intent) noexcept = 0;
+        // Fades out the given layer using its release time.
+        virtual bool ClearLayer(std::uint32_t layer) noexcept = 0;
+        // Number of configured lamps (bits above this in lampMask are ignored).
+        virtual std::uint32_t GetLampCount() const noexcept = 0;
+        // Index of the lamp with the given entity id, or -1. Resolve once and cache the result.
+        virtual std::int32_t GetLampIndex(const char* entity_id) const noexcept = 0;
+
+    protected:
+        ~IVHAL1() = default;
+    };
+
+    struct InterfaceRequest {
+        std::uint32_t interfaceVersion;
+    };
+
+    struct InterfaceReply {
+        std::uint32_t interfaceVersion;  // 0 if the requested version is not supported
+        void* interfacePtr;              // IVHAL1* for kInterfaceVersion1
+    };
+}
@@ -0,0 +1,147 @@
+#include "HttpTransport.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <string_view>
+
+namespace {
+    bool EqualsIgnoreCase(std::string_view a, std::string_view b) {
+        if (a.size() != b.size()) return false;
+        for (size_t i = 0; i < a.size(); ++i) {
+            char ca = a[i] >= 'A' && a[i] <= 'Z' ? static_cast<char>(a[i] - 'A' + 'a') : a[i];
+            char cb = b[i] >= 'A' && b[i] <= 'Z' ? static_cast<char>(b[i] - 'A' + 'a') : b[i];
+            if (ca != cb) return false;
+        }
+        return true;
+    }
+}
+
+HttpTransport::HttpTransport(const std::string& baseUrl, const std::string& token, int timeoutMs)
+    : timeoutMs(timeoutMs) {
+    constexpr std::string_view scheme = "http://";
+    if (baseUrl.compare(0, scheme.size(), scheme) != 0) {
+        urlError = "HttpTransport only supports http:// URLs (got " + baseUrl + ")";
+        return;
+    }
+    std::string rest = baseUrl.substr(scheme.size());
+    size_t slash = rest.find('/');
+    std::string authority = rest.substr(0, slash);
+    if (slash != std::string::npos) pathPrefix = rest.substr(slash);
+    while (!pathPrefix.empty() && pathPrefix.back() == '/') pathPrefix.pop_back();
+
+    size_t colon = authority.rfind(':');
+    host = authority.substr(0, colon);
+    if (colon != std::string::npos) port = static_cast<std::uint16_t>(std::atoi(authority.c_str() + colon + 1));
+    if (host.empty() || port == 0) {
+        urlError = "Invalid Home Assistant URL " + baseUrl;
+        return;
+    }
+
+    headerBlock = "Host: " + authority + "\r\nAuthorization: Bearer " + token +
+                  "\r\nContent-Type: application/json\r\nConnection: keep-alive\r\n";
+}
+
+HttpTransport::~HttpTransport() { Disconnect(); }
+
+bool HttpTransport::EnsureConnected() {
+    if (connection != INVALID_SOCKET_HANDLE) return true;
+    buffer.clear();
+    connection = ConnectTcp(host, port);
+    return connection != INVALID_SOCKET_HANDLE;
+}
+
+void HttpTransport::Disconnect() {
+    CloseSocket(connection);
+    connection = INVALID_SOCKET_HANDLE;
+    buffer.clear();
+}
+
+bool HttpTransport::ReadResponse(TransportResponse& response, bool& keepAlive) {
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+    auto receiveMore = [&]() {
+        auto left = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now());
+        if (left.count() <= 0) return false;
+        char chunk[4096];
+        long received = ReceiveSome(connection, chunk, sizeof(chunk), static_cast<int>(left.count()));
+        if (received <= 0) return false;
+        buffer.append(chunk, static_cast<size_t>(received));
+        return true;
+    };
+
+    size_t headerEnd;
+    while ((headerEnd = buffer.find("\r\n\r\n")) == std::string::npos) {
+        if (!receiveMore()) return false;
+    }
+
+    // Status line: HTTP/1.1 200 OK
+    std::string_view head(buffer.data(), headerEnd);
+    size_t lineEnd = head.find("\r\n");
+    std::string_view statusLine = head.substr(0, lineEnd);
+    size_t space = statusLine.find(' ');
+    if (space == std::string_view::npos) return false;
+    response.status_code = std::atol(std::string(statusLine.substr(space + 1, 3)).c_str());
+
+    size_t contentLength = 0;
+    keepAlive = true;
+    while (lineEnd != std::string_view::npos && lineEnd < head.size()) {
+        size_t next = head.find("\r\n", lineEnd + 2);
+        std::string_view line = head.substr(lineEnd + 2, next == std::string_view::npos ? next : next - lineEnd - 2);
+        lineEnd = next;
+        size_t colon = line.find(':');
+        if (colon == std::string_view::npos) continue;
+        std::string_view name = line.substr(0, colon);
+        std::string_view value = line.substr(colon + 1);
+        while (!value.empty() && value.front() == ' ') value.remove_prefix(1);
+        if (EqualsIgnoreCase(name, "Content-Length")) {
+            contentLength = static_cast<size_t>(std::atoll(std::string(value).c_str()));
+        } else if (EqualsIgnoreCase(name, "Connection") && EqualsIgnoreCase(value, "close")) {
+            keepAlive = false;
+        } else if (EqualsIgnoreCase(name, "Transfer-Encoding")) {
+            return false;  // Chunked bodies are not supported
+        }
+    }
+
+    size_t bodyStart = headerEnd + 4;
+    while (buffer.size() < bodyStart + contentLength) {
+        if (!receiveMore()) return false;
+    }
+    response.text = buffer.substr(bodyStart, contentLength);
+    buffer.erase(0, bodyStart + contentLength);
+    return true;
+}
+
+TransportResponse HttpTransport::PostJson(const std::string& path, const std::string& body) {
+    TransportResponse response;
+    if (!urlError.empty()) {
+        response.error = urlError;
+        return response;
+    }
+
+    std::lock_guard lock(mutex);
+    auto start = std::chrono::steady_clock::now();
+    std::string request = "POST " + pathPrefix + path + " HTTP/1.1\r\n" + headerBlock +
+                          "Content-Length: " + std::to_string(body.size()) + "\r\n\r\n" + body;
+
+    // A kept-alive connection may have been closed by the server in the meantime: retry once on a fresh one
+    for (int attempt = 0; attempt < 2; ++attempt) {
+        bool reused = connection != INVALID_SOCKET_HANDLE;
+        response.new_connection = response.new_connection || !reused;
+        if (!EnsureConnected()) {
+            response.error = "Cannot connect to " + host + ":" + std::to_string(port) + " (" + LastSocketError() + ")";
+            break;
+        }
+        bool keepAlive = false;
+        if (SendAll(connection, request.data(), request.size()) && ReadResponse(response, keepAlive)) {
+            if (!keepAlive) Disconnect();
+            response.error.clear();
+            break;
+        }
+        Disconnect();
+        response.status_code = 0;
+        response.error = "Request to " + host + ":" + std::to_string(port) + path + " failed or timed out";
+        if (!reused) break;
+    }
+
+    response.elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return response;
+}
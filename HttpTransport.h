@@ -0,0 +1,35 @@
+#pragma once
+#include <cstdint>
+#include <mutex>
+#include <string>
+
+#include "NetSocket.h"
+#include "Transport.h"
+
+// Dependency-free Home Assistant transport: plain HTTP/1.1 over one keep-alive connection (no TLS, no chunked
+// responses). Used by the tools on platforms without cpr, e.g. the load driver against the mock HA server.
+class HttpTransport final : public ILightTransport {
+public:
+    // baseUrl: http://host[:port][/prefix]
+    HttpTransport(const std::string& baseUrl, const std::string& token, int timeoutMs = 5000);
+    ~HttpTransport() override;
+
+    TransportResponse PostJson(const std::string& path, const std::string& body) override;
+
+private:
+    bool EnsureConnected();
+    void Disconnect();
+    // Reads one response from the connection. False on timeout, close or a malformed response.
+    bool ReadResponse(TransportResponse& response, bool& keepAlive);
+
+    std::string host;
+    std::uint16_t port = 80;
+    std::string pathPrefix;
+    std::string headerBlock;  // Built once: Host, Authorization, Content-Type
+    std::string urlError;     // Non-empty if baseUrl could not be used
+    int timeoutMs;
+
+    std::mutex mutex;
+    SocketHandle connection = INVALID_SOCKET_HANDLE;
+    std::string buffer;  // Bytes received past the previous response
+};
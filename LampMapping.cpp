@@ -3,8 +3,6 @@
 #include <algorithm>
 #include <cmath>
 
-#include "GameState.h"
-
 // Helper: Calculate normalized dot product (direction similarity)
 static float DirDot(const Vec3& a, const Vec3& b) {
     float la = a.length(), lb = b.length();
@@ -17,14 +15,12 @@ static float DirDot(const Vec3& a, const Vec3& b) {
 // gameLights: Active in-game lights with world positions (in Skyrim units).
 // playerYawRadians: Player's current view direction (in radians).
 // maxDistance: Only lights within this distance influence the lamps.
+// directionSharpness: Exponent on the direction match, higher = more spotlight-like (LightingOptions, try 1.5-3.0).
 std::vector<LightState> MapInGameLightsToRealLamps(const std::vector<RealLamp>& realLamps,
                                                    const std::vector<InGameLight>& gameLights, float playerYawRadians,
-                                                   float maxDistance) {
+                                                   float maxDistance, float directionSharpness) {
     std::vector<LightState> result;
 
-    // You can tweak this sharpness value for stronger focus; higher = more spotlight-like
-    constexpr float DIRECTION_SHARPNESS = 2.0f;  // try 1.53.0 for your setup
-
     for (const auto& lamp : realLamps) {
         Vec3 lampDir = lamp.position.normalized();  // Direction from player to lamp
 
@@ -42,7 +38,8 @@ std::vector<LightState> MapInGameLightsToRealLamps(const std::vector<RealLamp>&
 
             Vec3 lightDir = relVec.normalized();
             float dirRaw = std::max(0.0f, lampDir.dot(lightDir));        // [0..1]
-            float dirAlignment = std::pow(dirRaw, DIRECTION_SHARPNESS);  // Sharper spotlight effect
+            // Sharper spotlight effect; the default exponent skips the pow call (hot with many lights)
+            float dirAlignment = directionSharpness == 2.0f ? dirRaw * dirRaw : std::pow(dirRaw, directionSharpness);
 
             float distanceFade = 1.0f - std::clamp(dist / maxDistance, 0.0f, 1.0f);
             float weight = dirAlignment * distanceFade * gameLight.intensity;
@@ -2,8 +2,7 @@
 #include <string>
 #include <vector>
 
-#include "GameState.h"     // For Vec3, RealLamp, etc.
-#include "LightManager.h"  // For LightState, FlickerConfig
+#include "ConfigLoader.h"  // For Vec3, RealLamp, LightState, FlickerConfig
 
 // Represents an in-game light source relevant to mapping
 struct InGameLight {
@@ -17,4 +16,4 @@ Vec3 RotateVectorByYaw(const Vec3& vec, float yawRadians);
 
 std::vector<LightState> MapInGameLightsToRealLamps(const std::vector<RealLamp>& realLamps,
                                                    const std::vector<InGameLight>& gameLights, float playerYawRadians,
-                                                   float maxDistance = 400.0f);
\ No newline at end of file
+                                                   float maxDistance = 400.0f, float directionSharpness = 2.0f);
\ No newline at end of file
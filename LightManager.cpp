@@ -1,9 +1,14 @@
 #include "LightManager.h"
+#include "AllocationTracker.h"
+#include "EntityHealth.h"
+#include "FlightRecorder.h"
 #include "Logger.h"
-#include <cpr/cpr.h>
+#include "Metrics.h"
+#include "Profiler.h"
 #include <nlohmann/json.hpp>
 using json = nlohmann::json;
 #include <map>
+#include <optional>
 #include <random>
 #include <algorithm>
 #include <thread>
@@ -11,6 +16,21 @@ using json = nlohmann::json;
 // ADDED: Global map to store the last commanded state for each light (for state tracking)
 std::map<std::string, LightState> g_LastCommandedLightStates;
 
+// When each lamp's last final command went out, for the coalescing window
+static std::map<std::string, std::chrono::steady_clock::time_point> g_LastSendTimes;
+
+// Failure log budget per entity, so one dead lamp cannot silence the errors of the others (LogRequestFailure)
+static std::map<std::string, LogRateLimiter> g_RequestFailureLimiters;
+
+static std::unique_ptr<ILightTransport> g_Transport;
+static std::chrono::steady_clock::duration g_SendTickPeriod = std::chrono::milliseconds(200);
+
+void SetLightTransport(std::unique_ptr<ILightTransport> transport) { g_Transport = std::move(transport); }
+
+void SetSendTickPeriod(std::chrono::steady_clock::duration period) { g_SendTickPeriod = period; }
+
+ILightTransport *GetLightTransport() { return g_Transport.get(); }
+
 // Helper for random flicker (call each update)
 // Improved flicker: stays close to base color/brightness!
 void ApplyFlicker(
@@ -18,7 +38,7 @@ void ApplyFlicker(
     int &brightness, 
     const std::array<int, 3> &base_rgb, 
     int base_brightness,
-    const FlickerConfig &config = FlickerConfig{}
+    const FlickerConfig &config
     ) {
     static std::random_device rd;
     static std::mt19937 rng(rd());
@@ -35,16 +55,175 @@ void ApplyFlicker(
     brightness = std::clamp(base_brightness + flicker, 10, 100);
 }
 
+std::string BuildTurnOnPayload(const std::string &entity_id, const std::array<int, 3> &rgb, int brightness_pct,
+                               const std::optional<std::string> &effect) {
+    json payload_json = {{"entity_id", entity_id}, {"rgb_color", rgb}, {"brightness_pct", brightness_pct}};
+    if (effect.has_value()) {
+        payload_json["effect"] = effect.value();
+    }
+    return payload_json.dump();
+}
+
+constexpr const char *LIGHT_TURN_ON_PATH = "/api/services/light/turn_on";
+constexpr const char *SELECT_OPTION_PATH = "/api/services/select/select_option";
+
+// Per-request bookkeeping. The lamp's health (RecordEntityOutcome) is not updated here: a lamp can take two calls
+// in a tick (scene PART 1/2, or a scene clear before FINAL), and ApplyLightStates records one outcome per lamp.
+static void RecordServiceResponse(const std::string &entity_id, const TransportResponse &r) {
+    auto latency_us = static_cast<std::uint64_t>(r.elapsed * 1e6);
+    RecordRequestMetrics(entity_id, r.status_code, latency_us);
+    if (r.new_connection) RecordConnectionOpened();
+    auto outcome = IsServiceCallSuccess(r.status_code) ? FlightRecorder::CommandOutcome::Sent
+                                                       : FlightRecorder::CommandOutcome::Failed;
+    RecordFlightCommand(entity_id, outcome, r.status_code, latency_us);
+}
+
+// Single HA service call, timed as one HttpRequest stage sample (traced with the target entity)
+static TransportResponse PostServiceCall(const char *service_path, const std::string &body,
+                                         const std::string &entity_id) {
+    ScopedStageTimer timer(PipelineStage::HttpRequest, entity_id);
+    TransportResponse r = g_Transport->PostJson(service_path, body);
+    timer.Stop();
+    RecordServiceResponse(entity_id, r);
+    return r;
+}
+
+// Independent calls of one pass, handed to the transport together so it can run them as concurrent streams.
+// Each call is still one HttpRequest sample of its own latency (traced from the start of the batch).
+static std::vector<TransportResponse> PostServiceCalls(const std::vector<TransportRequest> &requests,
+                                                       const std::vector<const std::string *> &entity_ids) {
+    if (requests.empty()) return {};
+    if (requests.size() == 1) return {PostServiceCall(requests[0].path, requests[0].body, *entity_ids[0])};
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<TransportResponse> responses = g_Transport->PostJsonBatch(requests);
+    for (size_t i = 0; i < responses.size(); ++i) {
+        auto duration = std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+            std::chrono::duration<double>(responses[i].elapsed));
+        if (g_ProfilingEnabled.load(std::memory_order_relaxed)) {
+            RecordStageDuration(PipelineStage::HttpRequest, duration);
+        }
+        TraceComplete(GetStageName(PipelineStage::HttpRequest), "pipeline", start, start + duration, *entity_ids[i]);
+        RecordServiceResponse(*entity_ids[i], responses[i]);
+    }
+    return responses;
+}
+
+// Configured send phase of a lamp (its own, then its group's), or -1 to be placed automatically
+static float ConfiguredSendPhase(const std::string &entity_id) {
+    for (const auto &lamp : g_RealLamps) {
+        if (lamp.entity_id != entity_id) continue;
+        if (lamp.send_phase >= 0.0f) return lamp.send_phase;
+        auto group = lamp.send_group.empty() ? g_Send.group_phases.end() : g_Send.group_phases.find(lamp.send_group);
+        return group != g_Send.group_phases.end() ? group->second : -1.0f;
+    }
+    return -1.0f;
+}
+
+// Staggered variant of PostServiceCalls: every call goes out at its phase of the spread instead of all at once.
+// Calls sharing a phase (a device group) still form one batch. Lamps without a configured phase fill the spread
+// evenly. The spread ends stagger_span into the tick, counted from pass_start (the start of the send pass), so
+// the scene steps and scene clears that ran before shrink it instead of pushing the tick past its period; with
+// nothing left the calls go out at once. Returns the responses in request order.
+static std::vector<TransportResponse> PostStaggeredServiceCalls(const std::vector<TransportRequest> &requests,
+                                                                const std::vector<const std::string *> &entity_ids,
+                                                                std::chrono::steady_clock::time_point pass_start) {
+    auto start = std::chrono::steady_clock::now();
+    std::chrono::duration<double> spread =
+        g_SendTickPeriod * static_cast<double>(g_Send.stagger_span) - (start - pass_start);
+    if (spread.count() <= 0.0) return PostServiceCalls(requests, entity_ids);
+    std::vector<std::pair<float, size_t>> slots;  // (phase, request index)
+    slots.reserve(requests.size());
+    std::vector<size_t> automatic;
+    for (size_t i = 0; i < requests.size(); ++i) {
+        float phase = ConfiguredSendPhase(*entity_ids[i]);
+        if (phase >= 0.0f) {
+            slots.emplace_back(phase, i);
+        } else {
+            automatic.push_back(i);
+        }
+    }
+    for (size_t k = 0; k < automatic.size(); ++k) {
+        slots.emplace_back(static_cast<float>(k) / static_cast<float>(automatic.size()), automatic[k]);
+    }
+    std::stable_sort(slots.begin(), slots.end(), [](const auto &a, const auto &b) { return a.first < b.first; });
+
+    std::vector<TransportResponse> responses(requests.size());
+    std::vector<TransportRequest> batch;
+    std::vector<const std::string *> batch_entities;
+    std::optional<std::pair<float, std::chrono::steady_clock::time_point>> previous;  // Phase and dispatch time
+    for (size_t first = 0; first < slots.size();) {
+        float phase = slots[first].first;
+        size_t last = first;
+        batch.clear();
+        batch_entities.clear();
+        for (; last < slots.size() && slots[last].first == phase; ++last) {
+            batch.push_back(requests[slots[last].second]);
+            batch_entities.push_back(entity_ids[slots[last].second]);
+        }
+        auto due = start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(spread * phase);
+        if (std::chrono::steady_clock::now() < due) {
+            ScopedTrace waitTrace("stagger_wait", "ha");
+            std::this_thread::sleep_until(due);
+        }
+        auto dispatched = std::chrono::steady_clock::now();
+        if (previous) {
+            auto micros = [](auto d) {
+                return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(d).count());
+            };
+            RecordSendGap(micros(dispatched - previous->second), micros(spread * (phase - previous->first)));
+        }
+        previous.emplace(phase, dispatched);
+        std::vector<TransportResponse> batch_responses = PostServiceCalls(batch, batch_entities);
+        for (size_t k = 0; k < batch_responses.size(); ++k) {
+            responses[slots[first + k].second] = std::move(batch_responses[k]);
+        }
+        first = last;
+    }
+    return responses;
+}
+
+// A lamp that keeps failing would otherwise log three lines per tick. Each entity's limiter lets a burst through
+// every 30 s and reports how many of its failures it swallowed in between.
+static void LogRequestFailure(const char *part, const std::string &entity_id, const TransportResponse &r) {
+    auto &limiter = g_RequestFailureLimiters.try_emplace(entity_id, 10, std::chrono::seconds(30)).first->second;
+    std::uint64_t suppressed = 0;
+    if (!limiter.Allow(suppressed)) return;
+    if (suppressed != 0) HAL_LOG_ERROR("({} similar request failures for {} suppressed)", suppressed, entity_id);
+    HAL_LOG_ERROR("Error {} for {}: Status Code {} - {}", part, entity_id, r.status_code, r.error);
+    HAL_LOG_ERROR("HA Response Text {} for {}: {}", part, entity_id, r.text);
+    LogToConsole("ERROR: HA " + std::string(part) + " for " + entity_id + ": Status Code " +
+                 std::to_string(r.status_code));
+}
+
+// Coalescing window of a lamp: its own "coalesce_ms" or Sending.CoalesceWindowMs
+static std::chrono::milliseconds CoalesceWindowFor(const std::string &entity_id) {
+    for (const auto &lamp : g_RealLamps) {
+        if (lamp.entity_id == entity_id && lamp.coalesce_ms >= 0) return std::chrono::milliseconds(lamp.coalesce_ms);
+    }
+    return std::chrono::milliseconds(g_Send.coalesce_window_ms);
+}
+
+// Resident size estimate of g_LastCommandedLightStates and g_LastSendTimes, for the stats report
+static size_t CommandCacheResidentBytes() {
+    size_t bytes = g_LastCommandedLightStates.size() * (sizeof(decltype(g_LastCommandedLightStates)::value_type) +
+                                                        MAP_NODE_OVERHEAD);
+    for (const auto &[entity_id, state] : g_LastCommandedLightStates) {
+        bytes += StringHeapBytes(entity_id) + StringHeapBytes(state.entity_id);
+        if (state.effect) bytes += StringHeapBytes(*state.effect);
+        if (state.scene) bytes += StringHeapBytes(*state.scene);
+    }
+    bytes += g_LastSendTimes.size() * (sizeof(decltype(g_LastSendTimes)::value_type) + MAP_NODE_OVERHEAD);
+    for (const auto &[entity_id, time] : g_LastSendTimes) bytes += StringHeapBytes(entity_id);
+    return bytes;
+}
+
 void ApplyLightStates(const std::vector<LightState> &light_states_to_apply) {
-    if (g_HA_URL.empty() || g_HA_TOKEN.empty()) {
-        LogToFile_Error("Cannot send light command. Home Assistant URL or Token not loaded.");
-        LogToConsole("ERROR: Cannot send light command. HA config incomplete.");
+    if (g_HA_URL.empty() || g_HA_TOKEN.empty() || !g_Transport) {
+        HAL_LOG_ERROR_LIMITED("Cannot send light command. Home Assistant URL or Token not loaded.");
         return;
     }
-
-    cpr::Header headers;
-    headers["Authorization"] = "Bearer " + g_HA_TOKEN;
-    headers["Content-Type"] = "application/json";
+    const auto pass_start = std::chrono::steady_clock::now();
 
     // Separate scene and non-scene lights, skip inherit lights here (handled in scenario resolution logic)
     std::vector<const LightState *> scene_lights;
@@ -56,6 +235,11 @@ void ApplyLightStates(const std::vector<LightState> &light_states_to_apply) {
             continue;
         }
         if (light_state.effect.has_value() && light_state.effect.value() == "scene" && light_state.scene.has_value()) {
+            // Scene calls are not deduped, so a claimed probe is always sent (normal lamps are gated further down)
+            if (!IsEntitySendAllowed(light_state.entity_id)) {
+                RecordFlightCommand(light_state.entity_id, FlightRecorder::CommandOutcome::Quarantined, 0, 0);
+                continue;
+            }
             scene_lights.push_back(&light_state);
         } else {
             normal_lights.push_back(&light_state);
@@ -66,35 +250,49 @@ void ApplyLightStates(const std::vector<LightState> &light_states_to_apply) {
 
     // PART 1: Send effect=scene for all at once
     std::map<std::string, bool> scene_part1_success;  // Track success for each entity
+    std::optional<ScopedTrace> part1Trace;
+    if (!scene_lights.empty()) part1Trace.emplace("scene_part1", "ha");
+    std::vector<TransportRequest> requests;
+    std::vector<const std::string *> request_entities;
     for (const auto *light_state : scene_lights) {
-        std::string service_url = g_HA_URL + "/api/services/light/turn_on";
         json payload_json = {{"entity_id", light_state->entity_id}, {"effect", light_state->effect.value()}};
 
-        LogToFile_Debug("Sending PART 1 (effect=scene) request to HA for " + light_state->entity_id + ": " +
-                        payload_json.dump());
-        cpr::Response r = cpr::Post(cpr::Url{service_url}, headers, cpr::Body{payload_json.dump()});
-        if (r.status_code == 200) {
-            LogToFile_Debug("Successfully sent PART 1 command for " + light_state->entity_id);
+        std::string body = payload_json.dump();
+        HAL_LOG_DEBUG("Sending PART 1 (effect=scene) request to HA for {}: {}", light_state->entity_id, body);
+        requests.push_back({LIGHT_TURN_ON_PATH, std::move(body)});
+        request_entities.push_back(&light_state->entity_id);
+    }
+    std::vector<TransportResponse> responses = PostServiceCalls(requests, request_entities);
+    for (size_t i = 0; i < responses.size(); ++i) {
+        const auto *light_state = scene_lights[i];
+        if (IsServiceCallSuccess(responses[i].status_code)) {
+            HAL_LOG_DEBUG("Successfully sent PART 1 command for {}", light_state->entity_id);
             scene_part1_success[light_state->entity_id] = true;
         } else {
-            LogToFile_Error("Error PART 1 (effect=scene) for " + light_state->entity_id + ": Status Code " +
-                            std::to_string(r.status_code) + " - " + r.error.message);
-            LogToFile_Error("HA Response Text PART 1 for " + light_state->entity_id + ": " + r.text);
-            LogToConsole("ERROR: HA PART 1 for " + light_state->entity_id + ": Status Code " +
-                         std::to_string(r.status_code));
+            LogRequestFailure("PART 1 (effect=scene)", light_state->entity_id, responses[i]);
+            RecordEntityOutcome(light_state->entity_id, false);  // No PART 2 this tick
             scene_part1_success[light_state->entity_id] = false;
         }
     }
 
+    part1Trace.reset();
+
     // Wait 200ms ONCE for all
     if (!scene_lights.empty()) {
+        ScopedTrace waitTrace("scene_wait", "ha");
         std::this_thread::sleep_for(std::chrono::milliseconds(200));
     }
 
     // PART 2: Send select_option for all at once
+    std::optional<ScopedTrace> part2Trace;
+    if (!scene_lights.empty()) part2Trace.emplace("scene_part2", "ha");
+    requests.clear();
+    request_entities.clear();
+    std::vector<const LightState *> part2_lights;
+    std::vector<std::string> select_entity_ids;
     for (const auto *light_state : scene_lights) {
         if (!scene_part1_success[light_state->entity_id]) {
-            LogToFile_Warn("Skipping PART 2 for " + light_state->entity_id + " due to failed PART 1.");
+            HAL_LOG_WARN_LIMITED("Skipping PART 2 for {} due to failed PART 1.", light_state->entity_id);
             continue;
         }
         std::string light_object_id = light_state->entity_id;
@@ -102,24 +300,35 @@ void ApplyLightStates(const std::vector<LightState> &light_states_to_apply) {
             light_object_id = light_object_id.substr(6);
         }
         std::string select_entity_id = "select." + light_object_id + "_scene";
-        std::string service_url = g_HA_URL + "/api/services/select/select_option";
         json payload_json = {{"entity_id", select_entity_id}, {"option", light_state->scene.value()}};
 
-        LogToFile_Debug("Sending PART 2 (select_option) request to HA for " + select_entity_id + ": " +
-                        payload_json.dump());
-        cpr::Response r = cpr::Post(cpr::Url{service_url}, headers, cpr::Body{payload_json.dump()});
-        if (r.status_code == 200) {
-            LogToFile_Debug("Successfully sent PART 2 command for " + select_entity_id);
-            g_LastCommandedLightStates[light_state->entity_id] = *light_state;
+        std::string body = payload_json.dump();
+        HAL_LOG_DEBUG("Sending PART 2 (select_option) request to HA for {}: {}", select_entity_id, body);
+        requests.push_back({SELECT_OPTION_PATH, std::move(body)});
+        // Metrics, lamp health, flight records and failure logs are per lamp, so the select call counts for its light
+        request_entities.push_back(&light_state->entity_id);
+        part2_lights.push_back(light_state);
+        select_entity_ids.push_back(std::move(select_entity_id));
+    }
+    responses = PostServiceCalls(requests, request_entities);
+    for (size_t i = 0; i < responses.size(); ++i) {
+        RecordEntityOutcome(part2_lights[i]->entity_id, IsServiceCallSuccess(responses[i].status_code));
+        if (IsServiceCallSuccess(responses[i].status_code)) {
+            HAL_LOG_DEBUG("Successfully sent PART 2 command for {}", select_entity_ids[i]);
+            g_LastCommandedLightStates[part2_lights[i]->entity_id] = *part2_lights[i];
         } else {
-            LogToFile_Error("Error PART 2 (select_option) for " + select_entity_id + ": Status Code " +
-                            std::to_string(r.status_code) + " - " + r.error.message);
-            LogToFile_Error("HA Response Text PART 2 for " + select_entity_id + ": " + r.text);
-            LogToConsole("ERROR: HA PART 2 for " + select_entity_id + ": Status Code " + std::to_string(r.status_code));
+            LogRequestFailure("PART 2 (select_option)", part2_lights[i]->entity_id, responses[i]);
         }
     }
 
+    part2Trace.reset();
+
     // --- NORMAL (non-scene) LIGHTS ---
+    // Scene clears go out one by one (each needs its wait); the final calls of all lamps are sent as one batch
+    requests.clear();
+    request_entities.clear();
+    std::vector<const LightState *> final_lights;
+    auto now = std::chrono::steady_clock::now();
     for (const auto *light_state : normal_lights) {
         // --- Check if previous state was a scene effect ---
         bool was_scene_effect = false;
@@ -129,26 +338,6 @@ void ApplyLightStates(const std::vector<LightState> &light_states_to_apply) {
                 was_scene_effect = true;
             }
         }
-        std::string service_url = g_HA_URL + "/api/services/light/turn_on";
-        bool success = false;
-
-        // --- Clear scene effect if needed ---
-        if (was_scene_effect) {
-            json part1_payload = {{"entity_id", light_state->entity_id}, {"effect", "off"}};
-            LogToFile_Debug("Sending PART 1 (clear scene, effect=\"off\") request to HA for " + light_state->entity_id +
-                            ": " + part1_payload.dump());
-            cpr::Response r = cpr::Post(cpr::Url{service_url}, headers, cpr::Body{part1_payload.dump()});
-            if (r.status_code == 200) {
-                LogToFile_Debug("Successfully sent PART 1 (clear scene) command for " + light_state->entity_id);
-                std::this_thread::sleep_for(std::chrono::milliseconds(200));
-            } else {
-                LogToFile_Error("Error PART 1 (clear scene) for " + light_state->entity_id + ": Status Code " +
-                                std::to_string(r.status_code) + " - " + r.error.message);
-                LogToFile_Error("HA Response Text PART 1 for " + light_state->entity_id + ": " + r.text);
-                LogToConsole("ERROR: HA PART 1 (clear scene) for " + light_state->entity_id + ": Status Code " +
-                             std::to_string(r.status_code));
-            }
-        }
 
         // --- Flicker/Animated effect (keeps color close to base) ---
         std::array<int, 3> rgb = light_state->rgb_color;
@@ -164,33 +353,73 @@ void ApplyLightStates(const std::vector<LightState> &light_states_to_apply) {
         }
 
         // --- Only skip for non-animated/static states ---
-        if (!isAnimated && g_LastCommandedLightStates.count(light_state->entity_id) &&
+        // A quarantined lamp's real state is unknown (it may have rebooted), so its probes are never deduped
+        bool quarantined = IsEntityQuarantined(light_state->entity_id);
+        if (!isAnimated && !quarantined && g_LastCommandedLightStates.count(light_state->entity_id) &&
             g_LastCommandedLightStates[light_state->entity_id] == *light_state) {
-            LogToFile_Debug("Light " + light_state->entity_id + " is already in the desired state. Skipping command.");
+            HAL_LOG_DEBUG("Light {} is already in the desired state. Skipping command.", light_state->entity_id);
+            RecordDedupSuppression();
+            RecordFlightCommand(light_state->entity_id, FlightRecorder::CommandOutcome::Deduped, 0, 0);
             continue;
         }
 
-        // PART 2 (standard call): Set the actual color/brightness/effect
-        json payload_json = {{"entity_id", light_state->entity_id}, {"rgb_color", rgb}, {"brightness_pct", brightness}};
-        if (light_state->effect.has_value() && !isAnimated) {
-            payload_json["effect"] = light_state->effect.value();
+        // --- Coalescing: the first change of a burst goes out now, later ones wait for the window to close ---
+        // Nothing is queued: a held lamp is compared again next tick, so the state that goes out when the window
+        // closes is the latest target, and a burst that ends where it started is deduped instead. Flickering lamps
+        // change every tick, so for them the window is simply the fastest update rate.
+        if (!was_scene_effect) {
+            auto last = g_LastSendTimes.find(light_state->entity_id);
+            if (last != g_LastSendTimes.end() && now - last->second < CoalesceWindowFor(light_state->entity_id)) {
+                RecordCoalescedUpdate();
+                RecordFlightCommand(light_state->entity_id, FlightRecorder::CommandOutcome::Coalesced, 0, 0);
+                continue;
+            }
         }
 
-        LogToFile_Debug("Sending FINAL request to HA for " + light_state->entity_id + ": " + payload_json.dump());
-        cpr::Response r = cpr::Post(cpr::Url{service_url}, headers, cpr::Body{payload_json.dump()});
-        if (r.status_code == 200) {
-            LogToFile_Debug("Successfully set FINAL state for " + light_state->entity_id);
-            success = true;
-        } else {
-            LogToFile_Error("Error FINAL setting state for " + light_state->entity_id + ": Status Code " +
-                            std::to_string(r.status_code) + " - " + r.error.message);
-            LogToFile_Error("HA Response Text FINAL for " + light_state->entity_id + ": " + r.text);
-            LogToConsole("ERROR: HA FINAL for " + light_state->entity_id + ": Status Code " +
-                         std::to_string(r.status_code));
+        // --- Quarantine: checked last, so a claimed probe always goes out ---
+        if (quarantined && !IsEntitySendAllowed(light_state->entity_id)) {
+            RecordFlightCommand(light_state->entity_id, FlightRecorder::CommandOutcome::Quarantined, 0, 0);
+            continue;
+        }
+        g_LastSendTimes[light_state->entity_id] = now;
+
+        // --- Clear scene effect if needed ---
+        if (was_scene_effect) {
+            json part1_payload = {{"entity_id", light_state->entity_id}, {"effect", "off"}};
+            std::string body = part1_payload.dump();
+            HAL_LOG_DEBUG("Sending PART 1 (clear scene, effect=\"off\") request to HA for {}: {}",
+                          light_state->entity_id, body);
+            TransportResponse r = PostServiceCall(LIGHT_TURN_ON_PATH, body, light_state->entity_id);
+            if (IsServiceCallSuccess(r.status_code)) {
+                HAL_LOG_DEBUG("Successfully sent PART 1 (clear scene) command for {}", light_state->entity_id);
+                ScopedTrace waitTrace("clear_scene_wait", "ha", light_state->entity_id);
+                std::this_thread::sleep_for(std::chrono::milliseconds(200));
+            } else {
+                LogRequestFailure("PART 1 (clear scene)", light_state->entity_id, r);
+            }
         }
 
-        if (success) {
+        // PART 2 (standard call): Set the actual color/brightness/effect
+        std::string body = BuildTurnOnPayload(light_state->entity_id, rgb, brightness,
+                                              isAnimated ? std::nullopt : light_state->effect);
+        HAL_LOG_DEBUG("Sending FINAL request to HA for {}: {}", light_state->entity_id, body);
+        requests.push_back({LIGHT_TURN_ON_PATH, std::move(body)});
+        request_entities.push_back(&light_state->entity_id);
+        final_lights.push_back(light_state);
+    }
+    responses = g_Send.stagger && requests.size() > 1
+                    ? PostStaggeredServiceCalls(requests, request_entities, pass_start)
+                    : PostServiceCalls(requests, request_entities);
+    for (size_t i = 0; i < responses.size(); ++i) {
+        const auto *light_state = final_lights[i];
+        // FINAL decides the lamp's health for the tick, also when a scene clear went out before it
+        RecordEntityOutcome(light_state->entity_id, IsServiceCallSuccess(responses[i].status_code));
+        if (IsServiceCallSuccess(responses[i].status_code)) {
+            HAL_LOG_DEBUG("Successfully set FINAL state for {}", light_state->entity_id);
             g_LastCommandedLightStates[light_state->entity_id] = *light_state;
+        } else {
+            LogRequestFailure("FINAL", light_state->entity_id, responses[i]);
         }
     }
+    SetResidentBytes(ResidentTable::CommandCache, CommandCacheResidentBytes());
 }
@@ -1,11 +1,26 @@
 #pragma once
 #include <array>
+#include <chrono>
+#include <memory>
+#include <optional>
 #include <string>
 #include <vector>
 
 #include "ConfigLoader.h"
+#include "Transport.h"
 
 // Optionally, include other headers if you use cpr/json directly here
 
 void ApplyLightStates(const std::vector<LightState>& light_states_to_apply);
-void ApplyFlicker(std::array<int, 3>& rgb, int& brightness, const std::array<int, 3>& base_rgb, int base_brightness);
+
+// JSON body of a light.turn_on call (effect omitted when empty)
+std::string BuildTurnOnPayload(const std::string& entity_id, const std::array<int, 3>& rgb, int brightness_pct,
+                               const std::optional<std::string>& effect);
+
+// Transport used by ApplyLightStates. Set once before the export thread starts.
+void SetLightTransport(std::unique_ptr<ILightTransport> transport);
+ILightTransport* GetLightTransport();
+// Length of one export tick (default 200 ms). Staggered calls (Sending.Stagger) are spread over it.
+void SetSendTickPeriod(std::chrono::steady_clock::duration period);
+void ApplyFlicker(std::array<int, 3>& rgb, int& brightness, const std::array<int, 3>& base_rgb, int base_brightness,
+                  const FlickerConfig& config = FlickerConfig{});
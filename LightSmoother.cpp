@@ -2,6 +2,8 @@
 
 #include <algorithm>
 
+#include "AllocationTracker.h"
+
 // Helper to linearly interpolate between a and b by t
 inline int lerp(int a, int b, float t) { return static_cast<int>(a + (b - a) * t); }
 
@@ -34,3 +36,12 @@ std::vector<LightState> LightSmoother::SmoothStates(const std::vector<LightState
     }
     return result;
 }
+
+size_t LightSmoother::ApproxResidentBytes() const {
+    size_t bytes = previousStates.bucket_count() * sizeof(void*) +
+                   previousStates.size() * (sizeof(decltype(previousStates)::value_type) + HASH_NODE_OVERHEAD);
+    for (const auto& [entityId, state] : previousStates) {
+        bytes += StringHeapBytes(entityId) + StringHeapBytes(state.effect);
+    }
+    return bytes;
+}
@@ -19,6 +19,9 @@ public:
     // Smoothly transitions from previous state to target state for all lamps
     std::vector<LightState> SmoothStates(const std::vector<LightState>& newStates, float smoothingFactor = 0.2f);
 
+    // Heap footprint estimate of the per-lamp state, for the stats report
+    size_t ApproxResidentBytes() const;
+
 private:
     std::unordered_map<std::string, SmoothLampState> previousStates;
 };
@@ -1,10 +1,38 @@
 #include "Logger.h"
 #include "ConfigLoader.h"
-#include <RE/Skyrim.h>
 #include <spdlog/spdlog.h>
 
 std::shared_ptr<spdlog::logger> g_plugin_logger;
 
+static GameOutputFn g_ConsoleOutput = nullptr;
+static GameOutputFn g_NotificationOutput = nullptr;
+
+void SetGameOutput(GameOutputFn console, GameOutputFn notification) {
+    g_ConsoleOutput = console;
+    g_NotificationOutput = notification;
+}
+
+void ApplyLogLevel() {
+    if (g_plugin_logger) {
+        g_plugin_logger->set_level(g_DebugMode ? spdlog::level::debug : spdlog::level::info);
+    }
+}
+
+bool LogRateLimiter::Allow(std::uint64_t& suppressed) noexcept {
+    const auto nowMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+                           std::chrono::steady_clock::now().time_since_epoch())
+                           .count();
+    auto start = windowStartMs.load(std::memory_order_relaxed);
+    if (nowMs - start >= windowMs && windowStartMs.compare_exchange_strong(start, nowMs, std::memory_order_relaxed)) {
+        inWindow.store(0, std::memory_order_relaxed);
+    }
+    if (inWindow.fetch_add(1, std::memory_order_relaxed) < burst) {
+        suppressed = dropped.exchange(0, std::memory_order_relaxed);
+        return true;
+    }
+    dropped.fetch_add(1, std::memory_order_relaxed);
+    return false;
+}
 
 void LogToFile_Info(const std::string& message) {
     if (g_plugin_logger) {
@@ -32,14 +60,16 @@ void LogToFile_Debug(const std::string& message) {
 
 void LogToConsole(const std::string& message) {
     if (g_DebugMode || message.find("ERROR:") != std::string::npos || message.find("WARNING:") != std::string::npos) {
-        if (auto console = RE::ConsoleLog::GetSingleton()) {
-            console->Print(message.c_str());
+        if (g_ConsoleOutput) {
+            g_ConsoleOutput(message.c_str());
         }
     }
 }
 
 void NotifyIngame(const std::string& msg, bool sound) {
-    // Use sound only if function accepts it; otherwise fallback
-    // Most safe: pass nullptr as 2nd arg for default sound
-    RE::DebugNotification(msg.c_str(), nullptr);
+    // The notification hook always uses the default sound
+    (void)sound;
+    if (g_NotificationOutput) {
+        g_NotificationOutput(msg.c_str());
+    }
 }
\ No newline at end of file
@@ -1,14 +1,76 @@
 #pragma once
 #include <spdlog/logger.h>
 
+#include <atomic>
+#include <chrono>
+#include <cstdint>
 #include <memory>
 #include <string>
 
 extern std::shared_ptr<spdlog::logger> g_plugin_logger;
+extern bool g_DebugMode;
 
 void LogToFile_Info(const std::string& message);
 void LogToFile_Warn(const std::string& message);
 void LogToFile_Error(const std::string& message);
 void LogToFile_Debug(const std::string& message);
 void LogToConsole(const std::string& message);
-void NotifyIngame(const std::string& msg, bool sound = false);
\ No newline at end of file
+void NotifyIngame(const std::string& msg, bool sound = false);
+
+// Where LogToConsole / NotifyIngame end up. The plugin installs the game console and HUD notifications at load;
+// without a hook (tools, benchmarks) those messages are dropped.
+using GameOutputFn = void (*)(const char* message);
+void SetGameOutput(GameOutputFn console, GameOutputFn notification);
+
+// Applies DebugMode to the logger level once the configuration is known.
+void ApplyLogLevel();
+
+// --- Lazily formatted logging ---
+// The arguments are neither evaluated nor formatted unless the level is enabled, so per-tick
+// HAL_LOG_DEBUG("... {}", payload.dump()) costs a single branch when DebugMode is off.
+#define HAL_LOG_AT(level, ...)                                                                                 \
+    do {                                                                                                       \
+        if (g_plugin_logger && g_plugin_logger->should_log(level)) {                                           \
+            g_plugin_logger->log(level, __VA_ARGS__);                                                          \
+        }                                                                                                      \
+    } while (0)
+
+#define HAL_LOG_DEBUG(fmt, ...)                                                                                \
+    do {                                                                                                       \
+        if (g_DebugMode) HAL_LOG_AT(spdlog::level::debug, "DEBUG: " fmt __VA_OPT__(, ) __VA_ARGS__);           \
+    } while (0)
+#define HAL_LOG_INFO(fmt, ...) HAL_LOG_AT(spdlog::level::info, "INFO: " fmt __VA_OPT__(, ) __VA_ARGS__)
+#define HAL_LOG_WARN(fmt, ...) HAL_LOG_AT(spdlog::level::warn, "WARN: " fmt __VA_OPT__(, ) __VA_ARGS__)
+#define HAL_LOG_ERROR(fmt, ...) HAL_LOG_AT(spdlog::level::err, "ERROR: " fmt __VA_OPT__(, ) __VA_ARGS__)
+
+// Lets a burst of messages through per window, then counts what it drops.
+// One limiter per call site keeps a failing lamp from flooding the log every tick.
+class LogRateLimiter {
+public:
+    explicit LogRateLimiter(std::uint32_t burst = 5, std::chrono::seconds window = std::chrono::seconds(30))
+        : burst(burst), windowMs(std::chrono::duration_cast<std::chrono::milliseconds>(window).count()) {}
+
+    // True if the caller may log. 'suppressed' receives the number of messages dropped since the last one let
+    // through, so the caller can mention them.
+    bool Allow(std::uint64_t& suppressed) noexcept;
+
+private:
+    std::uint32_t burst;
+    std::int64_t windowMs;
+    std::atomic<std::int64_t> windowStartMs{0};
+    std::atomic<std::uint32_t> inWindow{0};
+    std::atomic<std::uint64_t> dropped{0};
+};
+
+// Rate-limited HAL_LOG_ERROR / HAL_LOG_WARN: at most a few lines per call site every 30 s.
+#define HAL_LOG_RATE_LIMITED(LOG_MACRO, fmt, ...)                                                              \
+    do {                                                                                                       \
+        static LogRateLimiter hal_limiter_;                                                                    \
+        std::uint64_t hal_suppressed_ = 0;                                                                     \
+        if (hal_limiter_.Allow(hal_suppressed_)) {                                                             \
+            if (hal_suppressed_ != 0) LOG_MACRO("({} similar messages suppressed)", hal_suppressed_);          \
+            LOG_MACRO(fmt __VA_OPT__(, ) __VA_ARGS__);                                                         \
+        }                                                                                                      \
+    } while (0)
+#define HAL_LOG_ERROR_LIMITED(fmt, ...) HAL_LOG_RATE_LIMITED(HAL_LOG_ERROR, fmt __VA_OPT__(, ) __VA_ARGS__)
+#define HAL_LOG_WARN_LIMITED(fmt, ...) HAL_LOG_RATE_LIMITED(HAL_LOG_WARN, fmt __VA_OPT__(, ) __VA_ARGS__)
@@ -0,0 +1,211 @@
+#include "Metrics.h"
+
+#ifdef _WIN32
+    #include <Windows.h>
+#else
+    #include <ctime>
+#endif
+
+#include <cstdio>
+
+#include "EntityHealth.h"
+#include "ExternalIntents.h"
+#include "Profiler.h"
+
+PipelineMetrics g_Metrics;
+
+namespace {
+    // Sized once at config load; elements hold atomics and never move afterwards
+    std::vector<EntityMetrics> g_EntityMetrics;
+
+    constexpr const char* STATUS_CLASS_NAMES[] = {"transport_error", "1xx", "2xx", "3xx", "4xx", "5xx"};
+    static_assert(std::size(STATUS_CLASS_NAMES) == static_cast<size_t>(StatusClass::Count));
+
+    // Prometheus bucket bounds for the stage histograms, in microseconds
+    constexpr std::uint64_t HISTOGRAM_BOUNDS_US[] = {100,   250,    500,    1000,   2500,    5000,    10000,
+                                                     25000, 50000,  100000, 250000, 500000,  1000000, 2500000};
+
+    StatusClass ClassifyStatus(long status) {
+        if (status <= 0 || status >= 600) return StatusClass::TransportError;
+        return static_cast<StatusClass>(status / 100);
+    }
+
+    EntityMetrics* FindEntity(std::string_view entity_id) {
+        for (auto& e : g_EntityMetrics) {
+            if (e.entity_id == entity_id) return &e;
+        }
+        return nullptr;
+    }
+
+    void AppendHeader(std::string& out, const char* name, const char* type, const char* help) {
+        out += "# HELP ";
+        out += name;
+        out += ' ';
+        out += help;
+        out += "\n# TYPE ";
+        out += name;
+        out += ' ';
+        out += type;
+        out += '\n';
+    }
+
+    void AppendSample(std::string& out, std::string_view nameAndLabels, std::uint64_t value) {
+        out += nameAndLabels;
+        out += ' ';
+        out += std::to_string(value);
+        out += '\n';
+    }
+
+    std::string SecondsString(std::uint64_t us) {
+        char buffer[32];
+        std::snprintf(buffer, sizeof(buffer), "%.6f", static_cast<double>(us) / 1e6);
+        return buffer;
+    }
+}
+
+void RegisterMetricEntities(const std::vector<RealLamp>& lamps) {
+    std::vector<EntityMetrics> fresh(lamps.size());
+    for (size_t i = 0; i < lamps.size(); ++i) fresh[i].entity_id = lamps[i].entity_id;
+    g_EntityMetrics.swap(fresh);
+}
+
+const std::vector<EntityMetrics>& GetEntityMetrics() { return g_EntityMetrics; }
+
+const char* GetStatusClassName(StatusClass c) { return STATUS_CLASS_NAMES[static_cast<size_t>(c)]; }
+
+void RecordRequestMetrics(std::string_view entity_id, long status_code, std::uint64_t latency_us) {
+    g_Metrics.requests.fetch_add(1, std::memory_order_relaxed);
+    g_Metrics.status_counts[static_cast<size_t>(ClassifyStatus(status_code))].fetch_add(1, std::memory_order_relaxed);
+    bool success = IsServiceCallSuccess(status_code);
+    if (success) {
+        g_Metrics.consecutive_failures.store(0, std::memory_order_relaxed);
+    } else {
+        g_Metrics.failures.fetch_add(1, std::memory_order_relaxed);
+        g_Metrics.consecutive_failures.fetch_add(1, std::memory_order_relaxed);
+    }
+    if (auto* entity = FindEntity(entity_id)) {
+        entity->requests.fetch_add(1, std::memory_order_relaxed);
+        if (!success) entity->failures.fetch_add(1, std::memory_order_relaxed);
+        entity->last_latency_us.store(latency_us, std::memory_order_relaxed);
+        entity->last_status.store(static_cast<int>(status_code), std::memory_order_relaxed);
+    }
+}
+
+void RecordDedupSuppression() { g_Metrics.dedup_suppressed.fetch_add(1, std::memory_order_relaxed); }
+
+void RecordCoalescedUpdate() { g_Metrics.coalesced.fetch_add(1, std::memory_order_relaxed); }
+
+void RecordSendGap(std::uint64_t achieved_us, std::uint64_t planned_us) {
+    g_Metrics.send_gaps.fetch_add(1, std::memory_order_relaxed);
+    g_Metrics.send_gap_us.fetch_add(achieved_us, std::memory_order_relaxed);
+    g_Metrics.send_gap_planned_us.fetch_add(planned_us, std::memory_order_relaxed);
+}
+
+void RecordConnectionOpened() { g_Metrics.connections_opened.fetch_add(1, std::memory_order_relaxed); }
+
+void RecordTick() { g_Metrics.ticks.fetch_add(1, std::memory_order_relaxed); }
+
+void SampleWorkerCpuTime() {
+#ifdef _WIN32
+    FILETIME creation, exit, kernel, user;
+    if (!GetThreadTimes(GetCurrentThread(), &creation, &exit, &kernel, &user)) return;
+    auto toUs = [](const FILETIME& ft) {
+        return ((static_cast<std::uint64_t>(ft.dwHighDateTime) << 32) | ft.dwLowDateTime) / 10;  // 100 ns units
+    };
+    g_Metrics.worker_cpu_us.store(toUs(kernel) + toUs(user), std::memory_order_relaxed);
+#else
+    timespec ts{};
+    if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts) != 0) return;
+    g_Metrics.worker_cpu_us.store(static_cast<std::uint64_t>(ts.tv_sec) * 1000000 + ts.tv_nsec / 1000,
+                                  std::memory_order_relaxed);
+#endif
+}
+
+std::string FormatPrometheusMetrics() {
+    std::string out;
+    out.reserve(8192);
+
+    AppendHeader(out, "hal_ticks_total", "counter", "Export pipeline passes.");
+    AppendSample(out, "hal_ticks_total", g_Metrics.ticks.load(std::memory_order_relaxed));
+
+    AppendHeader(out, "hal_worker_cpu_seconds_total", "counter", "CPU time used by the export thread.");
+    out += "hal_worker_cpu_seconds_total " + SecondsString(g_Metrics.worker_cpu_us.load(std::memory_order_relaxed)) +
+           "\n";
+
+    AppendHeader(out, "hal_dedup_suppressed_total", "counter", "Lamp commands skipped because the state was unchanged.");
+    AppendSample(out, "hal_dedup_suppressed_total", g_Metrics.dedup_suppressed.load(std::memory_order_relaxed));
+
+    AppendHeader(out, "hal_coalesced_total", "counter", "Lamp changes held back by the coalescing window.");
+    AppendSample(out, "hal_coalesced_total", g_Metrics.coalesced.load(std::memory_order_relaxed));
+
+    AppendHeader(out, "hal_send_gaps_total", "counter", "Gaps between staggered send slots.");
+    AppendSample(out, "hal_send_gaps_total", g_Metrics.send_gaps.load(std::memory_order_relaxed));
+    AppendHeader(out, "hal_send_gap_seconds_total", "counter", "Achieved time between staggered send slots.");
+    out += "hal_send_gap_seconds_total " + SecondsString(g_Metrics.send_gap_us.load(std::memory_order_relaxed)) + "\n";
+    AppendHeader(out, "hal_send_gap_planned_seconds_total", "counter", "Planned time between staggered send slots.");
+    out += "hal_send_gap_planned_seconds_total " +
+           SecondsString(g_Metrics.send_gap_planned_us.load(std::memory_order_relaxed)) + "\n";
+
+    AppendHeader(out, "hal_http_connections_opened_total", "counter", "Connections opened to Home Assistant.");
+    AppendSample(out, "hal_http_connections_opened_total",
+                 g_Metrics.connections_opened.load(std::memory_order_relaxed));
+
+    AppendHeader(out, "hal_http_responses_total", "counter", "Home Assistant responses by status class.");
+    for (size_t i = 0; i < static_cast<size_t>(StatusClass::Count); ++i) {
+        AppendSample(out, std::string("hal_http_responses_total{class=\"") + STATUS_CLASS_NAMES[i] + "\"}",
+                     g_Metrics.status_counts[i].load(std::memory_order_relaxed));
+    }
+    AppendHeader(out, "hal_http_failures_total", "counter", "Failed Home Assistant calls (any status but 200).");
+    AppendSample(out, "hal_http_failures_total", g_Metrics.failures.load(std::memory_order_relaxed));
+
+    AppendHeader(out, "hal_entity_requests_total", "counter", "Home Assistant service calls per lamp.");
+    for (const auto& e : g_EntityMetrics) {
+        AppendSample(out, "hal_entity_requests_total{entity=\"" + e.entity_id + "\"}",
+                     e.requests.load(std::memory_order_relaxed));
+    }
+    AppendHeader(out, "hal_entity_failures_total", "counter", "Failed Home Assistant service calls per lamp.");
+    for (const auto& e : g_EntityMetrics) {
+        AppendSample(out, "hal_entity_failures_total{entity=\"" + e.entity_id + "\"}",
+                     e.failures.load(std::memory_order_relaxed));
+    }
+    AppendHeader(out, "hal_entity_last_latency_seconds", "gauge", "Latency of the last service call per lamp.");
+    for (const auto& e : g_EntityMetrics) {
+        out += "hal_entity_last_latency_seconds{entity=\"" + e.entity_id + "\"} " +
+               SecondsString(e.last_latency_us.load(std::memory_order_relaxed)) + "\n";
+    }
+
+    AppendHeader(out, "hal_entity_quarantined", "gauge", "1 while the lamp is quarantined after repeated failures.");
+    for (const auto& h : GetEntityHealth()) {
+        AppendSample(out, "hal_entity_quarantined{entity=\"" + h.entity_id + "\"}", h.IsQuarantined() ? 1 : 0);
+    }
+    AppendHeader(out, "hal_entity_skipped_total", "counter", "Lamp commands not sent while quarantined.");
+    for (const auto& h : GetEntityHealth()) {
+        AppendSample(out, "hal_entity_skipped_total{entity=\"" + h.entity_id + "\"}",
+                     h.skipped.load(std::memory_order_relaxed));
+    }
+
+    AppendHeader(out, "hal_intent_queue_depth", "gauge", "Plugin API intents waiting for the next tick.");
+    AppendSample(out, "hal_intent_queue_depth", GetPendingIntentCount());
+
+    AppendHeader(out, "hal_stage_duration_seconds", "histogram", "Duration of each pipeline stage.");
+    for (size_t s = 0; s < static_cast<size_t>(PipelineStage::Count); ++s) {
+        auto stage = static_cast<PipelineStage>(s);
+        auto snap = GetStageHistogram(stage).TakeSnapshot();
+        std::string labels = std::string("stage=\"") + GetStageName(stage) + "\"";
+
+        // Cumulative counts of all fine buckets whose upper bound fits under each coarse bound
+        std::uint64_t cumulative = 0;
+        size_t fine = 0;
+        for (std::uint64_t bound : HISTOGRAM_BOUNDS_US) {
+            while (fine < LatencyHistogram::BUCKET_COUNT && LatencyHistogram::BucketUpperBound(fine) <= bound) {
+                cumulative += snap.buckets[fine++];
+            }
+            AppendSample(out, "hal_stage_duration_seconds_bucket{" + labels + ",le=\"" + SecondsString(bound) + "\"}",
+                         cumulative);
+        }
+        AppendSample(out, "hal_stage_duration_seconds_bucket{" + labels + ",le=\"+Inf\"}", snap.count);
+        out += "hal_stage_duration_seconds_sum{" + labels + "} " + SecondsString(snap.sum_us) + "\n";
+        AppendSample(out, "hal_stage_duration_seconds_count{" + labels + "}", snap.count);
+    }
+    return out;
+}
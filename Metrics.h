@@ -0,0 +1,61 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "ConfigLoader.h"
+
+// Pre-aggregated pipeline counters. Writers use relaxed atomics; readers (metrics endpoint, stats) only load,
+// so reading never contends with the export thread.
+
+struct EntityMetrics {
+    std::string entity_id;  // Immutable after RegisterMetricEntities
+    std::atomic<std::uint64_t> requests{0};
+    std::atomic<std::uint64_t> failures{0};
+    std::atomic<std::uint64_t> last_latency_us{0};
+    std::atomic<int> last_status{0};
+};
+
+// The one definition of a failed Home Assistant call, shared by the stats report, the metrics endpoint, lamp health
+// and the flight recorder: HA answers service calls with 200, anything else (other 2xx included) is a failure
+inline bool IsServiceCallSuccess(long status_code) { return status_code == 200; }
+
+enum class StatusClass : std::uint8_t { TransportError, Informational, Success, Redirect, ClientError, ServerError, Count };
+
+struct PipelineMetrics {
+    std::atomic<std::uint64_t> ticks{0};
+    std::atomic<std::uint64_t> requests{0};
+    std::atomic<std::uint64_t> failures{0};  // Requests that fail IsServiceCallSuccess
+    std::atomic<std::uint64_t> dedup_suppressed{0};
+    std::atomic<std::uint64_t> coalesced{0};  // Lamp changes held back by the coalescing window
+    std::atomic<std::uint64_t> send_gaps{0};  // Gaps between consecutive staggered send slots of a tick
+    std::atomic<std::uint64_t> send_gap_us{0};  // Sum of the achieved gaps
+    std::atomic<std::uint64_t> send_gap_planned_us{0};  // Sum of the gaps the phases asked for
+    std::atomic<std::uint64_t> connections_opened{0};  // New HA connections (per call with cpr, rare with keep-alive)
+    std::atomic<std::uint64_t> worker_cpu_us{0};  // CPU time consumed by the export thread
+    std::atomic<std::uint32_t> consecutive_failures{0};  // Failed HA calls since the last success (any lamp)
+    std::atomic<std::uint64_t> status_counts[static_cast<size_t>(StatusClass::Count)]{};
+};
+
+extern PipelineMetrics g_Metrics;
+
+// Creates one EntityMetrics per configured lamp. Called at config load, before the export thread starts.
+void RegisterMetricEntities(const std::vector<RealLamp>& lamps);
+const std::vector<EntityMetrics>& GetEntityMetrics();
+
+// Records one HA response (status 0 = transport error).
+void RecordRequestMetrics(std::string_view entity_id, long status_code, std::uint64_t latency_us);
+void RecordDedupSuppression();
+void RecordCoalescedUpdate();
+void RecordSendGap(std::uint64_t achieved_us, std::uint64_t planned_us);
+void RecordConnectionOpened();
+void RecordTick();
+// Samples the calling thread's CPU time. Called by the export thread once per tick.
+void SampleWorkerCpuTime();
+
+const char* GetStatusClassName(StatusClass c);
+
+// Prometheus text exposition format (version 0.0.4) of all counters and stage histograms.
+std::string FormatPrometheusMetrics();
@@ -0,0 +1,62 @@
+#include "MetricsServer.h"
+
+#include <chrono>
+#include <string>
+#include <thread>
+
+#include "Logger.h"
+#include "Metrics.h"
+#include "NetSocket.h"
+
+namespace {
+    void HandleClient(SocketHandle client) {
+        char request[2048];
+        long received = ReceiveSome(client, request, sizeof(request) - 1, 1000);
+        if (received <= 0) return;
+        request[received] = '\0';
+
+        std::string_view line(request, static_cast<size_t>(received));
+        line = line.substr(0, line.find('\r'));
+
+        std::string status;
+        std::string body;
+        if (line.starts_with("GET /metrics ") || line.starts_with("GET /metrics?")) {
+            status = "200 OK";
+            body = FormatPrometheusMetrics();
+        } else {
+            status = "404 Not Found";
+            body = "Only /metrics is served here.\n";
+        }
+
+        std::string response = "HTTP/1.1 " + status +
+                               "\r\nContent-Type: text/plain; version=0.0.4; charset=utf-8\r\nContent-Length: " +
+                               std::to_string(body.size()) + "\r\nConnection: close\r\n\r\n" + body;
+        SendAll(client, response.data(), response.size());
+    }
+
+    void MetricsServerThread(std::uint16_t port) {
+        TcpListener listener;
+        // Localhost only: the endpoint is unauthenticated
+        if (!listener.Listen("127.0.0.1", port)) {
+            LogToFile_Error("Metrics endpoint: cannot listen on 127.0.0.1:" + std::to_string(port) + " (" +
+                            LastSocketError() + ").");
+            return;
+        }
+        LogToFile_Info("Metrics endpoint listening on http://127.0.0.1:" + std::to_string(port) + "/metrics");
+
+        while (listener.IsOpen()) {
+            SocketHandle client = listener.Accept();
+            if (client == INVALID_SOCKET_HANDLE) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(100));
+                continue;
+            }
+            HandleClient(client);
+            CloseSocket(client);
+        }
+    }
+}
+
+void StartMetricsServer(std::uint16_t port) {
+    if (port == 0) return;
+    std::thread(MetricsServerThread, port).detach();
+}
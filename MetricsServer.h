@@ -0,0 +1,5 @@
+#pragma once
+#include <cstdint>
+
+// Serves FormatPrometheusMetrics() at http://127.0.0.1:<port>/metrics from its own thread. No-op if port is 0.
+void StartMetricsServer(std::uint16_t port);
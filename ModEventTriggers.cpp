@@ -0,0 +1,100 @@
+#include "ModEventTriggers.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <unordered_map>
+
+#include "Logger.h"
+#include "TraceRecorder.h"
+
+namespace {
+    constexpr size_t MAX_MOD_EVENTS = 64;
+
+    struct ModEventSlot {
+        std::string name;
+        std::int64_t hold_ms = 0;  // Longest hold of all scenarios listening for this event
+    };
+
+    // Written at config load only; read by the sink afterwards
+    std::vector<ModEventSlot> g_ModEventSlots;
+    std::unordered_map<std::string, int> g_ModEventBits;
+
+    std::atomic<std::uint64_t> g_LatchedFlags{0};
+    std::array<std::atomic<std::int64_t>, MAX_MOD_EVENTS> g_HoldUntilMs{};
+
+    std::int64_t NowMs() {
+        return std::chrono::duration_cast<std::chrono::milliseconds>(
+                   std::chrono::steady_clock::now().time_since_epoch())
+            .count();
+    }
+}
+
+void BuildModEventTriggerTable(std::vector<Scenario>& scenarios) {
+    g_ModEventSlots.clear();
+    g_ModEventBits.clear();
+    g_LatchedFlags.store(0);
+    for (auto& hold : g_HoldUntilMs) hold.store(0);
+
+    for (auto& scenario : scenarios) {
+        if (scenario.trigger.type != "mod_event") continue;
+        if (!scenario.trigger.event.has_value() || scenario.trigger.event->empty()) {
+            LogToFile_Warn("Scenario '" + scenario.name + "' uses trigger 'mod_event' without an 'event' name. Ignored.");
+            continue;
+        }
+
+        const std::string& name = scenario.trigger.event.value();
+        auto hold_ms = static_cast<std::int64_t>(scenario.trigger.hold_seconds.value_or(0.0f) * 1000.0f);
+
+        auto it = g_ModEventBits.find(name);
+        if (it == g_ModEventBits.end()) {
+            if (g_ModEventSlots.size() >= MAX_MOD_EVENTS) {
+                LogToFile_Warn("Too many distinct mod_event triggers (max " + std::to_string(MAX_MOD_EVENTS) +
+                               "). Scenario '" + scenario.name + "' ignored.");
+                continue;
+            }
+            it = g_ModEventBits.emplace(name, static_cast<int>(g_ModEventSlots.size())).first;
+            g_ModEventSlots.push_back(ModEventSlot{name, 0});
+        }
+        auto& slot = g_ModEventSlots[it->second];
+        slot.hold_ms = std::max(slot.hold_ms, hold_ms);
+        scenario.trigger.event_bit = it->second;
+    }
+
+    if (!g_ModEventSlots.empty()) {
+        LogToFile_Info("Listening for " + std::to_string(g_ModEventSlots.size()) + " ModEvent trigger(s).");
+    }
+}
+
+bool LatchModEvent(std::string_view eventName) {
+    auto it = g_ModEventBits.find(std::string(eventName));
+    if (it == g_ModEventBits.end()) return false;
+
+    int bit = it->second;
+    std::int64_t hold_ms = g_ModEventSlots[bit].hold_ms;
+    if (hold_ms > 0) {
+        std::int64_t until = NowMs() + hold_ms;
+        std::int64_t current = g_HoldUntilMs[bit].load(std::memory_order_relaxed);
+        while (current < until &&
+               !g_HoldUntilMs[bit].compare_exchange_weak(current, until, std::memory_order_relaxed)) {
+        }
+    }
+    g_LatchedFlags.fetch_or(std::uint64_t{1} << bit, std::memory_order_release);
+    TraceInstant("mod_event", "game", eventName);
+    return true;
+}
+
+std::uint64_t ConsumeModEventFlags() {
+    std::uint64_t flags = g_LatchedFlags.exchange(0, std::memory_order_acquire);
+    if (g_ModEventSlots.empty()) return flags;
+
+    std::int64_t now = NowMs();
+    for (size_t bit = 0; bit < g_ModEventSlots.size(); ++bit) {
+        if (g_HoldUntilMs[bit].load(std::memory_order_relaxed) > now) flags |= std::uint64_t{1} << bit;
+    }
+    return flags;
+}
+
+size_t GetModEventTriggerCount() { return g_ModEventSlots.size(); }
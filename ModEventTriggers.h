@@ -0,0 +1,21 @@
+#pragma once
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+#include "ConfigLoader.h"
+
+// Lock-free latch for "mod_event" scenario triggers.
+// Every distinct event name used by a scenario gets one bit (max 64). The ModEvent sink sets the bit from the
+// Papyrus thread, the export thread consumes it on its next tick.
+
+// Assigns event bits to all "mod_event" triggers. Called at config load, before the sink is registered.
+void BuildModEventTriggerTable(std::vector<Scenario>& scenarios);
+
+// Latches the named event if a scenario listens for it. Callable from any thread.
+bool LatchModEvent(std::string_view eventName);
+
+// Returns the bits of all events that fired since the last call, plus events still inside their hold duration.
+std::uint64_t ConsumeModEventFlags();
+
+size_t GetModEventTriggerCount();
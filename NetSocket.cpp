@@ -0,0 +1,246 @@
+#include "NetSocket.h"
+
+#include <algorithm>
+#include <cstring>
+#include <mutex>
+
+#ifdef _WIN32
+    #include <winsock2.h>
+    #include <ws2tcpip.h>
+const SocketHandle INVALID_SOCKET_HANDLE = static_cast<SocketHandle>(INVALID_SOCKET);
+#else
+    #include <arpa/inet.h>
+    #include <cerrno>
+    #include <fcntl.h>
+    #include <netdb.h>
+    #include <netinet/in.h>
+    #include <netinet/tcp.h>
+    #include <poll.h>
+    #include <sys/socket.h>
+    #include <unistd.h>
+const SocketHandle INVALID_SOCKET_HANDLE = -1;
+#endif
+
+bool InitializeSockets() {
+#ifdef _WIN32
+    static std::once_flag once;
+    static bool ok = false;
+    std::call_once(once, [] {
+        WSADATA wsaData;
+        ok = WSAStartup(MAKEWORD(2, 2), &wsaData) == 0;
+    });
+    return ok;
+#else
+    return true;
+#endif
+}
+
+void CloseSocket(SocketHandle socket) {
+    if (socket == INVALID_SOCKET_HANDLE) return;
+#ifdef _WIN32
+    closesocket(static_cast<SOCKET>(socket));
+#else
+    close(socket);
+#endif
+}
+
+std::string LastSocketError() {
+#ifdef _WIN32
+    return "WSA error " + std::to_string(WSAGetLastError());
+#else
+    return std::strerror(errno);
+#endif
+}
+
+bool SendAll(SocketHandle socket, const void* data, size_t size) {
+    const char* cursor = static_cast<const char*>(data);
+    while (size > 0) {
+#ifdef _WIN32
+        int sent = send(static_cast<SOCKET>(socket), cursor, static_cast<int>(std::min<size_t>(size, 1 << 30)), 0);
+#else
+        auto sent = send(socket, cursor, size, MSG_NOSIGNAL);
+#endif
+        if (sent <= 0) return false;
+        cursor += sent;
+        size -= static_cast<size_t>(sent);
+    }
+    return true;
+}
+
+long ReceiveSome(SocketHandle socket, void* data, size_t size, int timeoutMs) {
+#ifdef _WIN32
+    WSAPOLLFD pfd{static_cast<SOCKET>(socket), POLLRDNORM, 0};
+    int ready = WSAPoll(&pfd, 1, timeoutMs);
+    if (ready <= 0) return ready < 0 ? -1 : 0;
+    int received = recv(static_cast<SOCKET>(socket), static_cast<char*>(data), static_cast<int>(size), 0);
+#else
+    pollfd pfd{socket, POLLIN, 0};
+    int ready = poll(&pfd, 1, timeoutMs);
+    if (ready <= 0) return ready < 0 ? -1 : 0;
+    auto received = recv(socket, data, size, 0);
+#endif
+    return received < 0 ? -1 : static_cast<long>(received);
+}
+
+int PollReadable(SocketHandle socket, int timeoutMs) {
+#ifdef _WIN32
+    WSAPOLLFD pfd{static_cast<SOCKET>(socket), POLLRDNORM, 0};
+    int ready = WSAPoll(&pfd, 1, timeoutMs);
+#else
+    pollfd pfd{socket, POLLIN, 0};
+    int ready = poll(&pfd, 1, timeoutMs);
+#endif
+    return ready < 0 ? -1 : (ready > 0 ? 1 : 0);
+}
+
+// Non-blocking connect plus poll, so an unreachable host costs at most timeoutMs
+static bool ConnectSocket(SocketHandle s, const sockaddr* addr, int addrLen, int timeoutMs) {
+#ifdef _WIN32
+    auto handle = static_cast<SOCKET>(s);
+    if (timeoutMs < 0) return connect(handle, addr, addrLen) == 0;
+    u_long nonBlocking = 1;
+    ioctlsocket(handle, FIONBIO, &nonBlocking);
+    bool connected = connect(handle, addr, addrLen) == 0;
+    if (!connected && WSAGetLastError() == WSAEWOULDBLOCK) {
+        WSAPOLLFD pfd{handle, POLLWRNORM, 0};
+        connected = WSAPoll(&pfd, 1, timeoutMs) == 1;
+    }
+    nonBlocking = 0;
+    ioctlsocket(handle, FIONBIO, &nonBlocking);
+#else
+    if (timeoutMs < 0) return connect(s, addr, static_cast<socklen_t>(addrLen)) == 0;
+    int flags = fcntl(s, F_GETFL, 0);
+    fcntl(s, F_SETFL, flags | O_NONBLOCK);
+    bool connected = connect(s, addr, static_cast<socklen_t>(addrLen)) == 0;
+    if (!connected && errno == EINPROGRESS) {
+        pollfd pfd{s, POLLOUT, 0};
+        connected = poll(&pfd, 1, timeoutMs) == 1;
+    }
+    fcntl(s, F_SETFL, flags);
+#endif
+    if (!connected) return false;
+    // Writable also signals a failed connect; the pending error tells them apart
+    int error = 0;
+#ifdef _WIN32
+    int length = sizeof(error);
+#else
+    socklen_t length = sizeof(error);
+#endif
+    getsockopt(s, SOL_SOCKET, SO_ERROR, reinterpret_cast<char*>(&error), &length);
+    return error == 0;
+}
+
+SocketHandle ConnectTcp(const std::string& host, std::uint16_t port, int timeoutMs) {
+    if (!InitializeSockets()) return INVALID_SOCKET_HANDLE;
+
+    addrinfo hints{};
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_STREAM;
+    hints.ai_protocol = IPPROTO_TCP;
+    addrinfo* result = nullptr;
+    if (getaddrinfo(host.c_str(), std::to_string(port).c_str(), &hints, &result) != 0) return INVALID_SOCKET_HANDLE;
+
+    SocketHandle connected = INVALID_SOCKET_HANDLE;
+    for (addrinfo* ai = result; ai && connected == INVALID_SOCKET_HANDLE; ai = ai->ai_next) {
+        auto s = ::socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol);
+        if (static_cast<SocketHandle>(s) == INVALID_SOCKET_HANDLE) continue;
+        auto addrLen = static_cast<int>(ai->ai_addrlen);
+        if (!ConnectSocket(static_cast<SocketHandle>(s), ai->ai_addr, addrLen, timeoutMs)) {
+            CloseSocket(static_cast<SocketHandle>(s));
+            continue;
+        }
+        // Requests are small and latency-bound
+        int noDelay = 1;
+        setsockopt(s, IPPROTO_TCP, TCP_NODELAY, reinterpret_cast<const char*>(&noDelay), sizeof(noDelay));
+        connected = static_cast<SocketHandle>(s);
+    }
+    freeaddrinfo(result);
+    return connected;
+}
+
+// --- TcpListener ---
+
+TcpListener::~TcpListener() { Close(); }
+
+bool TcpListener::Listen(const std::string& address, std::uint16_t port, int backlog) {
+    Close();
+    if (!InitializeSockets()) return false;
+
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    if (inet_pton(AF_INET, address.c_str(), &addr.sin_addr) != 1) return false;
+
+    auto s = ::socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    if (static_cast<SocketHandle>(s) == INVALID_SOCKET_HANDLE) return false;
+    socket = static_cast<SocketHandle>(s);
+
+    int reuse = 1;
+    setsockopt(s, SOL_SOCKET, SO_REUSEADDR, reinterpret_cast<const char*>(&reuse), sizeof(reuse));
+    if (bind(s, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr)) != 0 || listen(s, backlog) != 0) {
+        Close();
+        return false;
+    }
+    return true;
+}
+
+SocketHandle TcpListener::Accept() {
+    if (socket == INVALID_SOCKET_HANDLE) return INVALID_SOCKET_HANDLE;
+#ifdef _WIN32
+    auto client = accept(static_cast<SOCKET>(socket), nullptr, nullptr);
+#else
+    auto client = accept(socket, nullptr, nullptr);
+#endif
+    return static_cast<SocketHandle>(client);
+}
+
+void TcpListener::Close() {
+    CloseSocket(socket);
+    socket = INVALID_SOCKET_HANDLE;
+}
+
+// --- UdpSender ---
+
+UdpSender::~UdpSender() { Close(); }
+
+bool UdpSender::Open(const std::string& address, std::uint16_t port, int ttl) {
+    Close();
+    if (!InitializeSockets()) return false;
+
+    sockaddr_in dest{};
+    dest.sin_family = AF_INET;
+    dest.sin_port = htons(port);
+    if (inet_pton(AF_INET, address.c_str(), &dest.sin_addr) != 1) return false;
+
+    auto s = ::socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    if (static_cast<SocketHandle>(s) == INVALID_SOCKET_HANDLE) return false;
+    socket = static_cast<SocketHandle>(s);
+
+    // Multicast range is 224.0.0.0/4
+    if ((ntohl(dest.sin_addr.s_addr) >> 28) == 0xE) {
+        int hops = ttl;
+        setsockopt(s, IPPROTO_IP, IP_MULTICAST_TTL, reinterpret_cast<const char*>(&hops), sizeof(hops));
+    }
+
+    static_assert(sizeof(dest) <= sizeof(destination));
+    std::memcpy(destination, &dest, sizeof(dest));
+    destinationSize = sizeof(dest);
+    return true;
+}
+
+bool UdpSender::Send(const void* data, size_t size) {
+    if (socket == INVALID_SOCKET_HANDLE) return false;
+#ifdef _WIN32
+    auto sent = sendto(static_cast<SOCKET>(socket), static_cast<const char*>(data), static_cast<int>(size), 0,
+                       reinterpret_cast<const sockaddr*>(destination), destinationSize);
+#else
+    auto sent = sendto(socket, data, size, 0, reinterpret_cast<const sockaddr*>(destination),
+                       static_cast<socklen_t>(destinationSize));
+#endif
+    return sent == static_cast<decltype(sent)>(size);
+}
+
+void UdpSender::Close() {
+    CloseSocket(socket);
+    socket = INVALID_SOCKET_HANDLE;
+}
@@ -0,0 +1,63 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Minimal portable socket helpers (Winsock on Windows, BSD sockets elsewhere).
+
+#ifdef _WIN32
+using SocketHandle = std::uintptr_t;
+#else
+using SocketHandle = int;
+#endif
+
+extern const SocketHandle INVALID_SOCKET_HANDLE;
+
+// Initializes the socket library once per process. Safe to call repeatedly.
+bool InitializeSockets();
+void CloseSocket(SocketHandle socket);
+std::string LastSocketError();
+
+// Sends the whole buffer on a connected TCP socket.
+bool SendAll(SocketHandle socket, const void* data, size_t size);
+// Receives up to size bytes; waits at most timeoutMs. Returns bytes read, 0 on close/timeout, -1 on error.
+long ReceiveSome(SocketHandle socket, void* data, size_t size, int timeoutMs);
+// Waits at most timeoutMs for data (or a close) to read. Returns 1 when readable, 0 on timeout, -1 on error.
+// Tells a timeout from a closed peer when paired with ReceiveSome.
+int PollReadable(SocketHandle socket, int timeoutMs);
+
+// Opens a TCP connection (IPv4, host name or dotted address) with Nagle disabled. INVALID_SOCKET_HANDLE on failure.
+// timeoutMs bounds the connect itself (< 0 = the OS default, which can be 20 s and more for an unreachable host).
+SocketHandle ConnectTcp(const std::string& host, std::uint16_t port, int timeoutMs = -1);
+
+// Blocking TCP listener for small local endpoints (metrics, control channels).
+class TcpListener {
+public:
+    ~TcpListener();
+
+    bool Listen(const std::string& address, std::uint16_t port, int backlog = 8);
+    // Blocks until a client connects. Returns INVALID_SOCKET_HANDLE once the listener is closed.
+    SocketHandle Accept();
+    void Close();
+    bool IsOpen() const { return socket != INVALID_SOCKET_HANDLE; }
+
+private:
+    SocketHandle socket = INVALID_SOCKET_HANDLE;
+};
+
+// Fire-and-forget UDP sender (unicast or multicast).
+class UdpSender {
+public:
+    ~UdpSender();
+
+    // ttl only matters for multicast addresses
+    bool Open(const std::string& address, std::uint16_t port, int ttl = 1);
+    bool Send(const void* data, size_t size);
+    void Close();
+    bool IsOpen() const { return socket != INVALID_SOCKET_HANDLE; }
+
+private:
+    SocketHandle socket = INVALID_SOCKET_HANDLE;
+    unsigned char destination[32] = {};  // sockaddr_in storage
+    int destinationSize = 0;
+};
@@ -0,0 +1,123 @@
+#include "PapyrusInterface.h"
+
+#include <chrono>
+#include <filesystem>
+
+#include "AmbilightCapture.h"
+#include "FlightRecorder.h"
+#include "FrameRecorder.h"
+#include "Logger.h"
+#include "Stats.h"
+#include "TraceRecorder.h"
+
+namespace {
+    constexpr auto SCRIPT_NAME = "HomeAssistantLink"sv;
+
+    // Writes the trace ring buffer to <SKSE log dir>/HomeAssistantLink_trace_<unix time>.json
+    bool DumpTrace(RE::StaticFunctionTag*) {
+        if (!g_TracingEnabled.load()) {
+            LogToConsole("HomeAssistantLink: WARNING: Tracing is disabled (Diagnostics.Tracing in config).");
+            return false;
+        }
+        auto logsFolder = SKSE::log::log_directory();
+        if (!logsFolder) {
+            LogToFile_Error("DumpTrace: SKSE log directory unavailable.");
+            return false;
+        }
+        auto stamp = std::chrono::duration_cast<std::chrono::seconds>(
+                         std::chrono::system_clock::now().time_since_epoch())
+                         .count();
+        std::filesystem::path file = *logsFolder / ("HomeAssistantLink_trace_" + std::to_string(stamp) + ".json");
+        bool ok = FlushTrace(file);
+        if (ok) {
+            LogToFile_Info("Trace written to " + file.string());
+            if (auto console = RE::ConsoleLog::GetSingleton()) {
+                console->Print(("Trace written to " + file.string()).c_str());
+            }
+        } else {
+            LogToFile_Error("Failed to write trace to " + file.string());
+        }
+        return ok;
+    }
+
+    // Dumps the flight recorder ring at the end of the current export tick
+    void DumpFlightRecorder(RE::StaticFunctionTag*) {
+        RequestFlightRecorderDump("console");
+        if (auto console = RE::ConsoleLog::GetSingleton()) {
+            console->Print("Flight recorder dump requested (written to the SKSE log folder on the next tick).");
+        }
+    }
+
+    // Starts recording every tick's game state to the SKSE log folder (replay with tools/HomeAssistantLink_replay)
+    bool StartFrameRecording(RE::StaticFunctionTag*) {
+        auto logsFolder = SKSE::log::log_directory();
+        if (!logsFolder) {
+            LogToFile_Error("StartFrameRecording: SKSE log directory unavailable.");
+            return false;
+        }
+        std::filesystem::path file = MakeFrameRecordingPath(*logsFolder);
+        bool ok = ::StartFrameRecording(file);
+        if (auto console = RE::ConsoleLog::GetSingleton()) {
+            console->Print((ok ? "Recording frames to " + file.string() : "Failed to start frame recording").c_str());
+        }
+        return ok;
+    }
+
+    void StopFrameRecording(RE::StaticFunctionTag*) {
+        ::StopFrameRecording();
+        if (auto console = RE::ConsoleLog::GetSingleton()) {
+            console->Print("Frame recording stopped.");
+        }
+    }
+
+    // Writes the newest ambilight capture as <SKSE log dir>/HomeAssistantLink_ambilight_<unix time>.ppm
+    bool SaveAmbilightFrame(RE::StaticFunctionTag*) {
+        auto logsFolder = SKSE::log::log_directory();
+        if (!logsFolder) {
+            LogToFile_Error("SaveAmbilightFrame: SKSE log directory unavailable.");
+            return false;
+        }
+        auto stamp = std::chrono::duration_cast<std::chrono::seconds>(
+                         std::chrono::system_clock::now().time_since_epoch())
+                         .count();
+        std::filesystem::path file = *logsFolder / ("HomeAssistantLink_ambilight_" + std::to_string(stamp) + ".ppm");
+        bool ok = SaveAmbilightCapture(file);
+        if (auto console = RE::ConsoleLog::GetSingleton()) {
+            console->Print((ok ? "Ambilight frame written to " + file.string()
+                               : std::string("No ambilight capture available (Ambilight.Enabled in config)"))
+                               .c_str());
+        }
+        return ok;
+    }
+
+    // Pipeline health report built from the pre-aggregated counters (see Stats.h)
+    RE::BSFixedString GetStats(RE::StaticFunctionTag*) { return FormatStatsReport(); }
+
+    // Prints the stats report to the console, one line per Print (the console truncates long lines)
+    void PrintStats(RE::StaticFunctionTag*) {
+        auto console = RE::ConsoleLog::GetSingleton();
+        if (!console) return;
+        std::string report = FormatStatsReport();
+        size_t start = 0;
+        while (start < report.size()) {
+            size_t end = report.find('\n', start);
+            if (end == std::string::npos) end = report.size();
+            console->Print(report.substr(start, end - start).c_str());
+            start = end + 1;
+        }
+    }
+}
+
+namespace HALPapyrus {
+    bool Register(RE::BSScript::IVirtualMachine* vm) {
+        vm->RegisterFunction("DumpTrace"sv, SCRIPT_NAME, DumpTrace);
+        vm->RegisterFunction("DumpFlightRecorder"sv, SCRIPT_NAME, DumpFlightRecorder);
+        vm->RegisterFunction("StartFrameRecording"sv, SCRIPT_NAME, StartFrameRecording);
+        vm->RegisterFunction("StopFrameRecording"sv, SCRIPT_NAME, StopFrameRecording);
+        vm->RegisterFunction("SaveAmbilightFrame"sv, SCRIPT_NAME, SaveAmbilightFrame);
+        vm->RegisterFunction("GetStats"sv, SCRIPT_NAME, GetStats);
+        vm->RegisterFunction("PrintStats"sv, SCRIPT_NAME, PrintStats);
+        LogToFile_Info("Papyrus functions registered.");
+        return true;
+    }
+}
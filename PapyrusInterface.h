@@ -0,0 +1,6 @@
+#pragma once
+
+// Native functions of the HomeAssistantLink Papyrus script (callable from scripts or the console via cgf).
+namespace HALPapyrus {
+    bool Register(RE::BSScript::IVirtualMachine* vm);
+}
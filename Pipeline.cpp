@@ -0,0 +1,162 @@
+#include "Pipeline.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+
+#include "Ambilight.h"
+#include "Profiler.h"
+
+// --- Ambient (day/night) lighting from keyframes ---
+LightState GetAmbientStateForHour(float gameHour, const std::string& entity_id) {
+    if (g_DayNightCycle.size() < 2)
+        return LightState{entity_id, {128, 128, 128}, 50, std::nullopt, std::nullopt, false, std::nullopt};
+    float hour = std::fmod(gameHour, 24.0f);
+    if (hour < 0.0f) hour += 24.0f;
+    const DayNightKeyframe* kfA = nullptr;
+    const DayNightKeyframe* kfB = nullptr;
+    for (size_t i = 0; i < g_DayNightCycle.size(); ++i) {
+        size_t next = (i + 1) % g_DayNightCycle.size();
+        float hourA = static_cast<float>(g_DayNightCycle[i].hour);
+        float hourB = static_cast<float>(g_DayNightCycle[next].hour);
+        bool inSegment = false;
+        if (hourA < hourB)
+            inSegment = (hour >= hourA && hour < hourB);
+        else
+            inSegment = (hour >= hourA || hour < hourB);
+        if (inSegment) {
+            kfA = &g_DayNightCycle[i];
+            kfB = &g_DayNightCycle[next];
+            break;
+        }
+    }
+    if (!kfA || !kfB) {
+        kfA = &g_DayNightCycle[0];
+        kfB = &g_DayNightCycle[1];
+    }
+    float hourA = static_cast<float>(kfA->hour);
+    float hourB = static_cast<float>(kfB->hour);
+    float t;
+    if (hourA == hourB)
+        t = 0.0f;
+    else if (hourA < hourB)
+        t = (hour - hourA) / (hourB - hourA);
+    else {
+        float len = (24.0f - hourA) + hourB;
+        t = (hour >= hourA) ? (hour - hourA) / len : (hour + 24.0f - hourA) / len;
+    }
+    std::array<int, 3> rgb;
+    for (int c = 0; c < 3; ++c) rgb[c] = static_cast<int>((1.0f - t) * kfA->rgb_color[c] + t * kfB->rgb_color[c]);
+    int brightness = static_cast<int>((1.0f - t) * kfA->brightness_pct + t * kfB->brightness_pct);
+    return LightState{entity_id, rgb, brightness, std::nullopt, std::nullopt, false, std::nullopt};
+}
+
+// --- Scenario selection (torch/combat/mod events; no default/always/night/day scenarios anymore) ---
+const Scenario* SelectActiveScenario(const FrameInput& frame) {
+    const Scenario* activeScenario = nullptr;
+    int highestPriority = -1;
+    for (const auto& scenario : g_SCENARIOS) {
+        bool triggerMet = false;
+        if (scenario.trigger.type == "player_in_combat") {
+            if (frame.inCombat) triggerMet = true;
+        } else if (scenario.trigger.type == "torch_equipped") {
+            if (frame.torchEquipped) triggerMet = true;
+        } else if (scenario.trigger.type == "mod_event") {
+            int bit = scenario.trigger.event_bit;
+            if (bit >= 0 && (frame.modEventFlags >> bit) & 1) triggerMet = true;
+        }
+        if (triggerMet && scenario.priority > highestPriority) {
+            highestPriority = scenario.priority;
+            activeScenario = &scenario;
+        }
+    }
+    return activeScenario;
+}
+
+// --- Fire-dominant blend of proximity and scenario/ambient states ---
+std::vector<LightState> BlendLampStates(const std::vector<LightState>& dynamic,
+                                        const std::vector<LightState>& scenario, float fireExponent) {
+    std::vector<LightState> finalLampStates;
+    finalLampStates.reserve(dynamic.size());
+    for (size_t i = 0; i < dynamic.size(); ++i) {
+        const LightState& dyn = dynamic[i];
+        const LightState& scen = (i < scenario.size()) ? scenario[i] : dyn;
+
+        float fire_influence = std::clamp(static_cast<float>(dyn.brightness_pct) / 100.0f, 0.0f, 1.0f);
+        fire_influence = std::pow(fire_influence, fireExponent);
+
+        if (fire_influence < 0.05f) fire_influence = 0.0f;
+        if (fire_influence > 0.95f) fire_influence = 1.0f;
+
+        float scenario_weight = 1.0f - fire_influence;
+
+        LightState out = dyn;
+        for (int c = 0; c < 3; ++c) {
+            out.rgb_color[c] =
+                static_cast<int>(fire_influence * dyn.rgb_color[c] + scenario_weight * scen.rgb_color[c]);
+        }
+        out.brightness_pct =
+            static_cast<int>(fire_influence * dyn.brightness_pct + scenario_weight * scen.brightness_pct);
+
+        out.rgb_color[0] = std::clamp(out.rgb_color[0], 0, 255);
+        out.rgb_color[1] = std::clamp(out.rgb_color[1], 0, 255);
+        out.rgb_color[2] = std::clamp(out.rgb_color[2], 0, 255);
+        out.brightness_pct = std::clamp(out.brightness_pct, 10, 100);
+
+        if (scen.inherit) out = dyn;
+
+        finalLampStates.push_back(out);
+    }
+    return finalLampStates;
+}
+
+FrameResult RunLightPipeline(const FrameInput& frame, LightSmoother& smoother) {
+    FrameResult result;
+    auto [options, optionsVersion] = GetLiveLightingOptions();
+    result.optionsVersion = optionsVersion;
+
+    // STEP 1: Dynamic/Proximity Lighting
+    ScopedStageTimer mappingTimer(PipelineStage::Mapping);
+    auto dynamicLampStates = MapInGameLightsToRealLamps(g_RealLamps, frame.lights, frame.playerYaw,
+                                                        options.light_radius, options.direction_sharpness);
+    mappingTimer.Stop();
+
+    // STEP 2: Get active scenario for torch/combat
+    ScopedStageTimer scenarioTimer(PipelineStage::Scenario);
+    std::vector<LightState> scenarioLampStates;
+    result.activeScenario = SelectActiveScenario(frame);
+    if (result.activeScenario) {
+        scenarioLampStates = result.activeScenario->outcome;
+    } else {
+        // --- Use ambient (day/night) only if no high-prio scenario is active ---
+        for (const auto& lamp : g_RealLamps) {
+            if (!frame.isInterior) {
+                scenarioLampStates.push_back(GetAmbientStateForHour(frame.gameHour, lamp.entity_id));
+            } else {
+                // In interiors, only use dynamic/proximity (fire), ambient = inherit
+                LightState s;
+                s.entity_id = lamp.entity_id;
+                s.inherit = true;
+                scenarioLampStates.push_back(s);
+            }
+        }
+        if (!frame.ambilight.empty()) BlendAmbilightLayer(scenarioLampStates, frame.ambilight, g_Ambilight.mix);
+    }
+    scenarioTimer.Stop();
+
+    // STEP 3: Blend dynamic and scenario/ambient per lamp, with fire dominance
+    ScopedStageTimer blendTimer(PipelineStage::Blend);
+    std::vector<LightState> finalLampStates =
+        BlendLampStates(dynamicLampStates, scenarioLampStates, options.fire_exponent);
+    blendTimer.Stop();
+
+    // STEP 4: Smoothing
+    ScopedStageTimer smoothTimer(PipelineStage::Smooth);
+    result.lampStates = smoother.SmoothStates(finalLampStates, options.smoothing);
+    smoothTimer.Stop();
+
+    // STEP 5: Audio-reactive intensity/flicker (after smoothing, so hits are not smoothed away)
+    if (frame.audio) ApplyAudioModulation(result.lampStates, *frame.audio, g_AudioReactive);
+
+    return result;
+}
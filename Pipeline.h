@@ -0,0 +1,52 @@
+#pragma once
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "AudioReactive.h"
+#include "ConfigLoader.h"
+#include "LampMapping.h"
+#include "LightSmoother.h"
+
+// The game-independent part of ExportGameData: everything between "what the game looks like this tick" and
+// "what each lamp should show". No game calls, so the same code runs in the plugin, the replay tool and
+// benchmarks.
+
+constexpr float LIGHT_RADIUS = 400.0f;  // Default LightingOptions.lightRadius (scene generators, benchmarks)
+
+// Game state snapshot of one tick
+struct FrameInput {
+    float gameHour = 12.0f;
+    float playerYaw = 0.0f;  // Camera yaw, radians
+    Vec3 playerPos{0.0f, 0.0f, 0.0f};
+    bool inCombat = false;
+    bool isInterior = false;
+    bool torchEquipped = false;
+    std::uint64_t modEventFlags = 0;  // ConsumeModEventFlags() of this tick
+    std::vector<InGameLight> lights;  // Nearby lights, positions relative to the player
+    std::vector<LightState> ambilight;  // Screen colors per g_RealLamps entry (Ambilight.h), empty = layer off
+    std::optional<AudioBands> audio;    // Latest audio band state (AudioReactive.h), none = layers off
+};
+
+struct FrameResult {
+    std::vector<LightState> lampStates;  // Smoothed, one per g_RealLamps entry
+    const Scenario* activeScenario = nullptr;
+    std::uint64_t optionsVersion = 0;  // LiveLightingOptions::version this tick ran with
+};
+
+// Day/night ambient for one lamp from the g_DayNightCycle keyframes
+LightState GetAmbientStateForHour(float gameHour, const std::string& entity_id);
+
+// Highest-priority scenario of g_SCENARIOS whose trigger holds, or nullptr (ambient)
+const Scenario* SelectActiveScenario(const FrameInput& frame);
+
+// Per lamp: fire (dynamic) brightness ^ fireExponent decides how much it overrides the scenario/ambient color;
+// inherit keeps the dynamic state. Scenario entries beyond dynamic.size() are ignored.
+std::vector<LightState> BlendLampStates(const std::vector<LightState>& dynamic,
+                                        const std::vector<LightState>& scenario, float fireExponent = 0.4f);
+
+// Proximity mapping, scenario/ambient selection (screen colors mixed into the ambient), fire-dominant blend,
+// smoothing and the audio layers for one tick, with the live lighting options. The smoother carries state between
+// ticks; use one per independent run.
+FrameResult RunLightPipeline(const FrameInput& frame, LightSmoother& smoother);
@@ -0,0 +1,66 @@
+#include "PluginAPI.h"
+
+#include <cstring>
+
+#include "ConfigLoader.h"
+#include "ExternalIntents.h"
+#include "HomeAssistantLinkAPI.h"
+#include "Logger.h"
+
+namespace {
+    class HALInterface final : public HomeAssistantLinkAPI::IVHAL1 {
+    public:
+        bool SubmitIntent(const HomeAssistantLinkAPI::LightIntent& intent) noexcept override {
+            return SubmitExternalIntent(intent);
+        }
+
+        bool ClearLayer(std::uint32_t layer) noexcept override {
+            HomeAssistantLinkAPI::LightIntent clear{};
+            clear.layer = layer;
+            clear.lampMask = 0;
+            return SubmitExternalIntent(clear);
+        }
+
+        std::uint32_t GetLampCount() const noexcept override { return static_cast<std::uint32_t>(g_RealLamps.size()); }
+
+        std::int32_t GetLampIndex(const char* entity_id) const noexcept override {
+            if (!entity_id) return -1;
+            for (size_t i = 0; i < g_RealLamps.size(); ++i) {
+                if (std::strcmp(g_RealLamps[i].entity_id.c_str(), entity_id) == 0) return static_cast<std::int32_t>(i);
+            }
+            return -1;
+        }
+    };
+
+    HALInterface g_HALInterface;
+
+    void OnPluginMessage(SKSE::MessagingInterface::Message* message) {
+        if (!message || message->type != HomeAssistantLinkAPI::kRequestInterface) return;
+
+        HomeAssistantLinkAPI::InterfaceReply reply{0, nullptr};
+        std::uint32_t requested = 0;
+        if (message->data && message->dataLen >= sizeof(HomeAssistantLinkAPI::InterfaceRequest)) {
+            requested = static_cast<HomeAssistantLinkAPI::InterfaceRequest*>(message->data)->interfaceVersion;
+        }
+        if (requested == HomeAssistantLinkAPI::kInterfaceVersion1) {
+            reply.interfaceVersion = HomeAssistantLinkAPI::kInterfaceVersion1;
+            reply.interfacePtr = static_cast<HomeAssistantLinkAPI::IVHAL1*>(&g_HALInterface);
+        }
+
+        const char* sender = message->sender ? message->sender : "<unknown>";
+        LogToFile_Info("Plugin API: interface v" + std::to_string(requested) + " requested by " + sender +
+                       (reply.interfacePtr ? " (granted)." : " (unsupported version)."));
+        SKSE::GetMessagingInterface()->Dispatch(HomeAssistantLinkAPI::kInterfaceReply, &reply, sizeof(reply),
+                                                message->sender);
+    }
+}
+
+void RegisterPluginAPI() {
+    // nullptr sender = accept interface requests from any plugin
+    if (SKSE::GetMessagingInterface()->RegisterListener(nullptr, OnPluginMessage)) {
+        LogToFile_Info("Plugin API listener registered (interface v" +
+                       std::to_string(HomeAssistantLinkAPI::kInterfaceVersion1) + ").");
+    } else {
+        LogToFile_Warn("Failed to register plugin API listener. Other plugins cannot submit light intents.");
+    }
+}
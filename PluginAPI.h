@@ -0,0 +1,4 @@
+#pragma once
+
+// Registers the SKSE messaging listener that hands out the HomeAssistantLinkAPI interface to other plugins.
+void RegisterPluginAPI();
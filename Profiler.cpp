@@ -0,0 +1,158 @@
+#include "Profiler.h"
+
+#include <algorithm>
+#include <bit>
+#include <cstdio>
+
+#include "ConfigLoader.h"
+#include "Logger.h"
+
+std::atomic<bool> g_ProfilingEnabled = false;
+
+namespace {
+    std::array<LatencyHistogram, static_cast<size_t>(PipelineStage::Count)> g_StageHistograms;
+
+    struct StageAllocationTotals {
+        std::atomic<std::uint64_t> samples{0};
+        std::atomic<std::uint64_t> count{0};
+        std::atomic<std::uint64_t> bytes{0};
+    };
+    std::array<StageAllocationTotals, static_cast<size_t>(PipelineStage::Count)> g_StageAllocations;
+
+    constexpr const char* STAGE_NAMES[] = {"tick",    "gather_state", "nearby_lights", "ambilight",
+                                           "audio_dsp", "mapping",    "scenario",      "blend",
+                                           "smooth",  "intents",      "apply",         "http_request"};
+    static_assert(std::size(STAGE_NAMES) == static_cast<size_t>(PipelineStage::Count));
+
+    std::chrono::steady_clock::time_point g_LastTimingDump = std::chrono::steady_clock::now();
+}
+
+const char* GetStageName(PipelineStage stage) { return STAGE_NAMES[static_cast<size_t>(stage)]; }
+
+// --- LatencyHistogram ---
+// Values below 2^(SUB_BUCKET_BITS+1) get exact buckets. Above, each power of two [2^e, 2^(e+1)) is split into
+// 2^SUB_BUCKET_BITS equal sub-buckets, addressed by the top SUB_BUCKET_BITS+1 bits of the value.
+
+size_t LatencyHistogram::BucketIndex(std::uint64_t us) noexcept {
+    constexpr std::uint64_t SUB = std::uint64_t{1} << SUB_BUCKET_BITS;
+    if (us < 2 * SUB) return static_cast<size_t>(us);
+    int e = static_cast<int>(std::bit_width(us)) - 1;  // msb position, >= SUB_BUCKET_BITS + 1
+    int shift = e - SUB_BUCKET_BITS;
+    size_t index = static_cast<size_t>(shift) * SUB + static_cast<size_t>(us >> shift);
+    return std::min(index, BUCKET_COUNT - 1);
+}
+
+std::uint64_t LatencyHistogram::BucketLowerBound(size_t index) noexcept {
+    constexpr size_t SUB = size_t{1} << SUB_BUCKET_BITS;
+    if (index < 2 * SUB) return index;
+    size_t shift = index / SUB - 1;
+    std::uint64_t mantissa = index % SUB + SUB;
+    return mantissa << shift;
+}
+
+std::uint64_t LatencyHistogram::BucketUpperBound(size_t index) noexcept {
+    if (index + 1 >= BUCKET_COUNT) return BucketLowerBound(index) * 2;
+    return BucketLowerBound(index + 1) - 1;
+}
+
+void LatencyHistogram::Record(std::uint64_t us) noexcept {
+    buckets[BucketIndex(us)].fetch_add(1, std::memory_order_relaxed);
+    count.fetch_add(1, std::memory_order_relaxed);
+    sum_us.fetch_add(us, std::memory_order_relaxed);
+    std::uint64_t prevMax = max_us.load(std::memory_order_relaxed);
+    while (us > prevMax && !max_us.compare_exchange_weak(prevMax, us, std::memory_order_relaxed)) {
+    }
+}
+
+LatencyHistogram::Snapshot LatencyHistogram::TakeSnapshot() const {
+    Snapshot snap;
+    for (size_t i = 0; i < BUCKET_COUNT; ++i) {
+        snap.buckets[i] = buckets[i].load(std::memory_order_relaxed);
+        snap.count += snap.buckets[i];  // Consistent with the buckets even while writers are active
+    }
+    snap.sum_us = sum_us.load(std::memory_order_relaxed);
+    snap.max_us = max_us.load(std::memory_order_relaxed);
+    return snap;
+}
+
+std::uint64_t LatencyHistogram::Snapshot::Percentile(double p) const {
+    if (count == 0) return 0;
+    auto rank = static_cast<std::uint64_t>(std::clamp(p, 0.0, 100.0) / 100.0 * static_cast<double>(count - 1)) + 1;
+    std::uint64_t seen = 0;
+    for (size_t i = 0; i < BUCKET_COUNT; ++i) {
+        seen += buckets[i];
+        if (seen >= rank) {
+            std::uint64_t mid = (BucketLowerBound(i) + BucketUpperBound(i)) / 2;
+            return std::min(mid, max_us);
+        }
+    }
+    return max_us;
+}
+
+// --- Stage registry ---
+
+LatencyHistogram& GetStageHistogram(PipelineStage stage) { return g_StageHistograms[static_cast<size_t>(stage)]; }
+
+void RecordStageDuration(PipelineStage stage, std::chrono::steady_clock::duration duration) {
+    auto us = std::chrono::duration_cast<std::chrono::microseconds>(duration).count();
+    GetStageHistogram(stage).Record(static_cast<std::uint64_t>(std::max<long long>(us, 0)));
+}
+
+void RecordStageAllocations(PipelineStage stage, const AllocationCounters& delta) noexcept {
+    auto& totals = g_StageAllocations[static_cast<size_t>(stage)];
+    totals.samples.fetch_add(1, std::memory_order_relaxed);
+    totals.count.fetch_add(delta.count, std::memory_order_relaxed);
+    totals.bytes.fetch_add(delta.bytes, std::memory_order_relaxed);
+}
+
+StageAllocations GetStageAllocations(PipelineStage stage) noexcept {
+    const auto& totals = g_StageAllocations[static_cast<size_t>(stage)];
+    return {totals.samples.load(std::memory_order_relaxed), totals.count.load(std::memory_order_relaxed),
+            totals.bytes.load(std::memory_order_relaxed)};
+}
+
+std::string FormatStageTimings() {
+    std::string out = "Stage timings (us, since start):";
+    for (size_t i = 0; i < static_cast<size_t>(PipelineStage::Count); ++i) {
+        auto snap = g_StageHistograms[i].TakeSnapshot();
+        if (snap.count == 0) continue;
+        out += "\n  " + std::string(STAGE_NAMES[i]) + ": n=" + std::to_string(snap.count) +
+               " p50=" + std::to_string(snap.Percentile(50.0)) + " p99=" + std::to_string(snap.Percentile(99.0)) +
+               " max=" + std::to_string(snap.max_us);
+    }
+    return out;
+}
+
+std::string FormatStageAllocations() {
+    if (!AllocationHooksInstalled()) return "Allocations: not counted (build with HAL_TRACK_ALLOCATIONS)";
+    auto average = [](const StageAllocations& a, char* buffer, size_t size) {
+        double n = static_cast<double>(a.samples);
+        std::snprintf(buffer, size, "%.1f (%.1f KiB)", static_cast<double>(a.count) / n,
+                      static_cast<double>(a.bytes) / n / 1024.0);
+    };
+    char buffer[64];
+    StageAllocations tick = GetStageAllocations(PipelineStage::Tick);
+    if (tick.samples == 0) return "Allocations: no ticks profiled (enable Diagnostics.Profiling)";
+    average(tick, buffer, sizeof(buffer));
+    std::string out = "Allocations: " + std::string(buffer) + "/tick;";
+    const char* separator = " ";
+    for (size_t i = 0; i < static_cast<size_t>(PipelineStage::Count); ++i) {
+        if (static_cast<PipelineStage>(i) == PipelineStage::Tick) continue;
+        StageAllocations stage = GetStageAllocations(static_cast<PipelineStage>(i));
+        if (stage.samples == 0) continue;
+        average(stage, buffer, sizeof(buffer));
+        out += separator + std::string(STAGE_NAMES[i]) + " " + buffer;
+        separator = ", ";
+    }
+    return out;
+}
+
+void DumpStageTimings() { LogToFile_Info(FormatStageTimings()); }
+
+void MaybeDumpStageTimings() {
+    if (!g_ProfilingEnabled.load(std::memory_order_relaxed) || g_Diagnostics.profile_dump_seconds <= 0) return;
+    auto now = std::chrono::steady_clock::now();
+    if (now - g_LastTimingDump < std::chrono::seconds(g_Diagnostics.profile_dump_seconds)) return;
+    g_LastTimingDump = now;
+    DumpStageTimings();
+}
@@ -0,0 +1,124 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+#include "AllocationTracker.h"
+#include "TraceRecorder.h"
+
+// Low-overhead per-stage timing for the export pipeline.
+// Timers record into lock-free log-linear (HDR-style) histograms; readers take snapshots without locking.
+// When profiling and tracing are disabled a timer costs a single branch.
+
+enum class PipelineStage : std::uint8_t {
+    Tick,          // Whole ExportGameData pass
+    GatherState,   // Player/calendar/cell queries
+    NearbyLights,  // GetNearbyLights
+    Ambilight,     // Screen-color kernel (AmbilightKernel::Process)
+    AudioDsp,      // One audio analysis block (capture thread)
+    Mapping,       // MapInGameLightsToRealLamps
+    Scenario,      // Scenario selection + ambient
+    Blend,         // Dynamic/ambient blend
+    Smooth,        // LightSmoother::SmoothStates
+    Intents,       // External plugin intents
+    Apply,         // ApplyLightStates (all HA requests of one tick)
+    HttpRequest,   // A single HA service call
+    Count
+};
+
+const char* GetStageName(PipelineStage stage);
+
+extern std::atomic<bool> g_ProfilingEnabled;
+
+// Histogram of microsecond durations with ~6% relative bucket width, covering 0 us .. ~134 s (2^27 us); longer
+// durations are counted in the top bucket.
+class LatencyHistogram {
+public:
+    static constexpr int SUB_BUCKET_BITS = 4;  // 16 sub-buckets per power of two
+    static constexpr size_t BUCKET_COUNT = 384;
+
+    struct Snapshot {
+        std::array<std::uint64_t, BUCKET_COUNT> buckets{};
+        std::uint64_t count = 0;
+        std::uint64_t sum_us = 0;
+        std::uint64_t max_us = 0;
+
+        // p in [0, 100]; returns the midpoint of the bucket holding the percentile
+        std::uint64_t Percentile(double p) const;
+    };
+
+    void Record(std::uint64_t us) noexcept;
+    Snapshot TakeSnapshot() const;
+
+    static size_t BucketIndex(std::uint64_t us) noexcept;
+    static std::uint64_t BucketLowerBound(size_t index) noexcept;
+    static std::uint64_t BucketUpperBound(size_t index) noexcept;
+
+private:
+    std::array<std::atomic<std::uint64_t>, BUCKET_COUNT> buckets{};
+    std::atomic<std::uint64_t> count{0};
+    std::atomic<std::uint64_t> sum_us{0};
+    std::atomic<std::uint64_t> max_us{0};
+};
+
+LatencyHistogram& GetStageHistogram(PipelineStage stage);
+void RecordStageDuration(PipelineStage stage, std::chrono::steady_clock::duration duration);
+
+// Heap allocations made inside a stage (all zero unless AllocationHooks.cpp is linked in)
+struct StageAllocations {
+    std::uint64_t samples = 0;
+    std::uint64_t count = 0;
+    std::uint64_t bytes = 0;
+};
+void RecordStageAllocations(PipelineStage stage, const AllocationCounters& delta) noexcept;
+StageAllocations GetStageAllocations(PipelineStage stage) noexcept;
+
+// Times the enclosing scope (or until Stop) into the stage histogram, and into the trace timeline when tracing
+// is enabled. While profiling it also records the calling thread's heap allocations in the scope.
+// detail (e.g. an entity id) is only used by the trace and must outlive the timer.
+class ScopedStageTimer {
+public:
+    explicit ScopedStageTimer(PipelineStage stage, std::string_view detail = {}) noexcept
+        : stage(stage), detail(detail) {
+        if (g_ProfilingEnabled.load(std::memory_order_relaxed) | g_TracingEnabled.load(std::memory_order_relaxed)) {
+            start = std::chrono::steady_clock::now();
+            startAllocations = GetThreadAllocations();
+            active = true;
+        }
+    }
+    ~ScopedStageTimer() { Stop(); }
+
+    void Stop() noexcept {
+        if (active) {
+            active = false;
+            auto end = std::chrono::steady_clock::now();
+            if (g_ProfilingEnabled.load(std::memory_order_relaxed)) {
+                RecordStageDuration(stage, end - start);
+                RecordStageAllocations(stage, GetThreadAllocations() - startAllocations);
+            }
+            TraceComplete(GetStageName(stage), "pipeline", start, end, detail);
+        }
+    }
+
+    ScopedStageTimer(const ScopedStageTimer&) = delete;
+    ScopedStageTimer& operator=(const ScopedStageTimer&) = delete;
+
+private:
+    PipelineStage stage;
+    std::string_view detail;
+    bool active = false;
+    std::chrono::steady_clock::time_point start;
+    AllocationCounters startAllocations;
+};
+
+// One line per stage with samples: count, p50, p99, max (microseconds, since start).
+std::string FormatStageTimings();
+// "Allocations: 10.2/tick (1.3 KiB); mapping 4.0 (0.4 KiB), ..." (per-sample averages, since start).
+std::string FormatStageAllocations();
+// Writes FormatStageTimings() to the log now.
+void DumpStageTimings();
+// Called once per tick by the export thread; dumps every Diagnostics.ProfileDumpSeconds.
+void MaybeDumpStageTimings();
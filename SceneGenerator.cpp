@@ -0,0 +1,175 @@
+#include "SceneGenerator.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+
+namespace {
+    constexpr float TWO_PI = 6.2831853f;
+
+    // Light colors as lights.json has them: mostly fire/candle tones, some magic light
+    constexpr int WARM_PALETTE[][3] = {{255, 140, 0}, {255, 170, 80}, {255, 200, 120}, {230, 110, 40}};
+    constexpr int COOL_PALETTE[][3] = {{120, 160, 255}, {90, 220, 255}, {170, 120, 255}};
+
+    // The std:: distributions are implementation-defined, so a seed would give other scenes with another standard
+    // library (and the regress goldens would not match). These rely only on std::mt19937, whose output is fixed.
+    float Uniform(std::mt19937& rng, float low, float high) {
+        return low + (high - low) * static_cast<float>(rng() >> 8) * (1.0f / 16777216.0f);
+    }
+
+    // Box-Muller
+    float Normal(std::mt19937& rng, float mean, float stddev) {
+        float u1 = 1.0f - Uniform(rng, 0.0f, 1.0f);  // (0, 1], for the log
+        float u2 = Uniform(rng, 0.0f, 1.0f);
+        return mean + stddev * std::sqrt(-2.0f * std::log(u1)) * std::cos(TWO_PI * u2);
+    }
+
+    float Heading(const Vec3& from, const Vec3& to) {
+        // Skyrim yaw: 0 = north (+y), clockwise
+        return std::atan2(to.x - from.x, to.y - from.y);
+    }
+}
+
+SceneGenerator::SceneGenerator(const SceneConfig& config) : config(config), rng(config.seed) {
+    std::vector<Vec3> centers;
+    for (int i = 0; i < config.clusters; ++i) centers.push_back(RandomPointInArea());
+
+    staticField.reserve(static_cast<size_t>(std::max(config.staticLights, 0)));
+    for (int i = 0; i < config.staticLights; ++i) {
+        Vec3 position;
+        if (centers.empty()) {
+            position = RandomPointInArea();
+        } else {
+            const Vec3& center = centers[static_cast<size_t>(i) % centers.size()];
+            float dx = Normal(rng, 0.0f, config.clusterSpread);
+            float dy = Normal(rng, 0.0f, config.clusterSpread);
+            position = {center.x + dx, center.y + dy, 0.0f};
+        }
+        position.z = Uniform(rng, 0.0f, 300.0f);
+        staticField.push_back(MakeLight(position, false));
+    }
+
+    for (int i = 0; i < config.torchBearers; ++i) {
+        torchBearers.push_back({RandomPointInArea(), RandomPointInArea()});
+        torchLights.push_back(MakeLight({0.0f, 0.0f, 0.0f}, true));
+        torchLights.back().intensity = 256.0f;  // Torch light radius
+    }
+
+    switch (config.playerPath) {
+        case PlayerPath::RandomWalk:
+            player = {{0.0f, 0.0f, 0.0f}, RandomPointInArea()};
+            break;
+        default:  // Static, Line and Circle are computed from the frame index
+            player = {{0.0f, 0.0f, 0.0f}, {0.0f, 0.0f, 0.0f}};
+            break;
+    }
+}
+
+Vec3 SceneGenerator::RandomPointInArea() {
+    float r = config.areaRadius * std::sqrt(Uniform(rng, 0.0f, 1.0f));
+    float angle = TWO_PI * Uniform(rng, 0.0f, 1.0f);
+    return {r * std::cos(angle), r * std::sin(angle), 0.0f};
+}
+
+// Moves towards the target; picks a new random target on arrival
+void SceneGenerator::Advance(Mover& mover, float distance) {
+    Vec3 delta = mover.target - mover.position;
+    delta.z = 0.0f;
+    float length = delta.length();
+    if (length <= distance) {
+        mover.position = {mover.target.x, mover.target.y, mover.position.z};
+        mover.target = RandomPointInArea();
+        return;
+    }
+    float step = distance / length;
+    mover.position.x += delta.x * step;
+    mover.position.y += delta.y * step;
+}
+
+InGameLight SceneGenerator::MakeLight(const Vec3& position, bool forceWarm) {
+    auto jitter = [this]() { return Normal(rng, 0.0f, config.colorJitter); };
+    bool warm = forceWarm || Uniform(rng, 0.0f, 1.0f) < config.warmFraction;
+    const int* base = warm ? WARM_PALETTE[rng() % std::size(WARM_PALETTE)]
+                           : COOL_PALETTE[rng() % std::size(COOL_PALETTE)];
+
+    InGameLight light;
+    light.skyrim_pos = position;
+    light.type = "fire";  // GetNearbyLights reports every light as "fire"
+    light.color_r = std::clamp(static_cast<int>(static_cast<float>(base[0]) + jitter()), 0, 255);
+    light.color_g = std::clamp(static_cast<int>(static_cast<float>(base[1]) + jitter()), 0, 255);
+    light.color_b = std::clamp(static_cast<int>(static_cast<float>(base[2]) + jitter()), 0, 255);
+    light.intensity = Uniform(rng, 150.0f, 600.0f);  // Light radius, as the plugin passes it
+    return light;
+}
+
+FrameInput SceneGenerator::NextFrame() {
+    float t = static_cast<float>(frameIndex) * config.tickSeconds;
+    float step = config.playerSpeed * config.tickSeconds;
+    float yaw = 0.0f;
+
+    switch (config.playerPath) {
+        case PlayerPath::Static:
+            yaw = 0.25f * t;
+            break;
+        case PlayerPath::Line: {
+            // East to west and back along the x axis
+            float half = config.areaRadius * 0.8f;
+            if (half <= 0.0f) break;
+            float travel = std::fmod(step * static_cast<float>(frameIndex), 4.0f * half);
+            bool outbound = travel < 2.0f * half;
+            player.position = {outbound ? travel - half : 3.0f * half - travel, 0.0f, 0.0f};
+            yaw = outbound ? TWO_PI / 4.0f : -TWO_PI / 4.0f;
+            break;
+        }
+        case PlayerPath::Circle: {
+            float radius = config.areaRadius * 0.5f;
+            float angle = radius > 0.0f ? step * static_cast<float>(frameIndex) / radius : 0.0f;
+            player.position = {radius * std::cos(angle), radius * std::sin(angle), 0.0f};
+            yaw = -angle;  // Facing along the counter-clockwise tangent
+            break;
+        }
+        case PlayerPath::RandomWalk:
+            Advance(player, step);
+            yaw = Heading(player.position, player.target);
+            break;
+    }
+
+    FrameInput frame;
+    frame.gameHour = std::fmod(config.startHour + t * config.timeScale / 3600.0f, 24.0f);
+    frame.playerYaw = yaw;
+    frame.playerPos = player.position;
+
+    auto addIfNear = [&](const InGameLight& light, const Vec3& world) {
+        Vec3 rel = world - player.position;
+        if (rel.length() > config.cullRadius) return;
+        InGameLight copy = light;
+        copy.skyrim_pos = rel;
+        frame.lights.push_back(std::move(copy));
+    };
+    for (const InGameLight& light : staticField) addIfNear(light, light.skyrim_pos);
+    for (size_t i = 0; i < torchBearers.size(); ++i) {
+        Advance(torchBearers[i], config.torchBearerSpeed * config.tickSeconds);
+        Vec3 torch = torchBearers[i].position;
+        torch.z = 110.0f;  // Held at shoulder height
+        addIfNear(torchLights[i], torch);
+    }
+
+    ++frameIndex;
+    return frame;
+}
+
+std::vector<RealLamp> MakeLampRing(int count, const std::string& prefix) {
+    std::vector<RealLamp> lamps;
+    for (int i = 0; i < count; ++i) {
+        float angle = TWO_PI * static_cast<float>(i) / static_cast<float>(count);
+        lamps.push_back({prefix + std::to_string(i), {300.0f * std::cos(angle), 300.0f * std::sin(angle), 100.0f}});
+    }
+    return lamps;
+}
+
+void UseSyntheticConfig(int lampCount, const std::string& prefix) {
+    g_RealLamps = MakeLampRing(lampCount, prefix);
+    g_SCENARIOS.clear();
+    g_DayNightCycle = {{0, {40, 40, 90}, 15}, {7, {255, 180, 120}, 60}, {12, {255, 255, 240}, 90},
+                       {19, {255, 140, 80}, 55}};
+}
@@ -0,0 +1,74 @@
+#pragma once
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "Pipeline.h"
+
+// Synthetic game state for stress tests: a field of static lights (uniform or clustered), NPCs carrying torches
+// through it and a player walking a path. Produces the same FrameInput the export thread builds, including the
+// LIGHT_RADIUS cull of GetNearbyLights, so scenes far beyond what real saves reach can be fed to the pipeline.
+// Deterministic for a given config and seed, with any standard library.
+
+enum class PlayerPath : std::uint8_t {
+    Static,      // Stands at the center, slowly looking around
+    Line,        // Walks back and forth through the center
+    Circle,      // Circles the center at half the area radius
+    RandomWalk,  // Wanders between random waypoints
+};
+
+struct SceneConfig {
+    int staticLights = 200;           // Braziers, candles, lanterns
+    float areaRadius = 2000.0f;       // Static lights and torch bearers stay inside this disc (game units)
+    int clusters = 0;                 // 0 = uniform spread, otherwise lights gather around this many centers
+    float clusterSpread = 250.0f;     // Standard deviation of a cluster
+    int torchBearers = 0;             // NPCs walking between random waypoints with a torch
+    float torchBearerSpeed = 120.0f;  // Game units per second
+    float warmFraction = 0.8f;        // Share of fire-colored lights; the rest are cool (magic) lights
+    float colorJitter = 30.0f;        // Per-light color deviation from the palette
+    PlayerPath playerPath = PlayerPath::Circle;
+    float playerSpeed = 200.0f;       // Game units per second
+    float cullRadius = LIGHT_RADIUS;  // Like GetNearbyLights: only lights this close reach the pipeline
+    float tickSeconds = 0.2f;         // Time step per frame (the export thread ticks every 200 ms)
+    float startHour = 20.0f;
+    float timeScale = 20.0f;          // Game seconds per real second (Skyrim default)
+    std::uint32_t seed = 1;
+};
+
+class SceneGenerator {
+public:
+    explicit SceneGenerator(const SceneConfig& config);
+
+    // Advances the scene by one tick and returns what the export thread would see
+    FrameInput NextFrame();
+
+    const SceneConfig& GetConfig() const { return config; }
+    std::uint64_t GetFrameIndex() const { return frameIndex; }
+
+private:
+    struct Mover {
+        Vec3 position;
+        Vec3 target;
+    };
+
+    Vec3 RandomPointInArea();
+    void Advance(Mover& mover, float distance);
+    InGameLight MakeLight(const Vec3& position, bool forceWarm);
+
+    SceneConfig config;
+    std::mt19937 rng;
+    std::uint64_t frameIndex = 0;
+    std::vector<InGameLight> staticField;  // World positions
+    std::vector<Mover> torchBearers;
+    std::vector<InGameLight> torchLights;  // Color/intensity per torch bearer
+    Mover player;
+};
+
+// The lamp setup shared by the tools and benchmarks: count lamps evenly on a ring of radius 300, 100 units above
+// the player, named <prefix>0 .. <prefix>count-1
+std::vector<RealLamp> MakeLampRing(int count, const std::string& prefix = "light.synthetic_");
+
+// Replaces the loaded config with a lamp ring, no scenarios and a fixed day/night cycle (dim night, warm morning,
+// bright noon, orange evening)
+void UseSyntheticConfig(int lampCount, const std::string& prefix = "light.synthetic_");
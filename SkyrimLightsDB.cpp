@@ -1,6 +1,9 @@
 // SkyrimLightsDB.cpp
 #include "SkyrimLightsDB.h"
+#include "AllocationTracker.h"
+#include "ConfigLoader.h"
 #include "Logger.h"
+#include "StartupTiming.h"
 #include <fstream>
 #include <nlohmann/json.hpp>
 using json = nlohmann::json;
@@ -9,7 +12,6 @@ using json = nlohmann::json;
 #include <filesystem>
 
 std::unordered_map<uint32_t, SkyrimLightDefinition> g_SkyrimLightDefs;
-extern std::filesystem::path GetCurrentModulePath();
 
 bool LoadSkyrimLightsDatabase() {
     // Resolve the path to the plugin DLL and look for lights.json next to it
@@ -18,24 +20,32 @@ bool LoadSkyrimLightsDatabase() {
         LogToFile_Error("Could not determine plugin DLL path for loading lights.json");
         return false;
     }
-    std::filesystem::path lightsJsonPath = pluginPath.parent_path() / "lights.json";
+    return LoadSkyrimLightsDatabaseFromFile(pluginPath.parent_path() / "lights.json");
+}
+
+bool LoadSkyrimLightsDatabaseFromFile(const std::filesystem::path& lightsJsonPath) {
     LogToFile_Info("Attempting to load Skyrim lights database from: " + lightsJsonPath.string());
 
-    std::ifstream file(lightsJsonPath);
-    if (!file.is_open()) {
+    std::string text;
+    ScopedStartupTimer readTimer(StartupPhase::LightsRead);
+    if (!ReadTextFile(lightsJsonPath, text)) {
         LogToFile_Error("Failed to open lights.json at " + lightsJsonPath.string());
         return false;
     }
+    readTimer.Stop();
 
     nlohmann::json j;
     try {
-        file >> j;
+        ScopedStartupTimer parseTimer(StartupPhase::LightsParse);
+        j = nlohmann::json::parse(text);
     } catch (std::exception& e) {
         LogToFile_Error("Failed to parse lights.json: " + std::string(e.what()));
         return false;
     }
 
+    ScopedStartupTimer buildTimer(StartupPhase::LightsBuild);
     g_SkyrimLightDefs.clear();
+    g_SkyrimLightDefs.reserve(j.size());
     for (const auto& entry : j) {
         SkyrimLightDefinition def;
         // Read formID as string, parse as hex
@@ -64,6 +74,15 @@ bool LoadSkyrimLightsDatabase() {
         g_SkyrimLightDefs[def.form_id] = def;
     }
 
+    buildTimer.Stop();
+
+    size_t resident = g_SkyrimLightDefs.bucket_count() * sizeof(void*) +
+                      g_SkyrimLightDefs.size() * (sizeof(decltype(g_SkyrimLightDefs)::value_type) + HASH_NODE_OVERHEAD);
+    for (const auto& [formId, def] : g_SkyrimLightDefs) {
+        resident += StringHeapBytes(def.editor_id) + StringHeapBytes(def.name);
+    }
+    SetResidentBytes(ResidentTable::LightDefinitions, resident);
+
     LogToFile_Info("Successfully loaded " + std::to_string(g_SkyrimLightDefs.size()) +
                    " Skyrim lights from lights.json");
     return true;
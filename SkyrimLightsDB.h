@@ -1,4 +1,5 @@
 #pragma once
+#include <filesystem>
 #include <nlohmann/json.hpp>
 #include <string>
 #include <unordered_map>
@@ -16,5 +17,6 @@ struct SkyrimLightDefinition {
 
 extern std::unordered_map<uint32_t, SkyrimLightDefinition> g_SkyrimLightDefs;
 
-bool LoadSkyrimLightsDatabase();
+bool LoadSkyrimLightsDatabase();  // lights.json next to the plugin DLL
+bool LoadSkyrimLightsDatabaseFromFile(const std::filesystem::path& lightsJsonPath);
 const SkyrimLightDefinition* GetLightDefinitionByFormID(uint32_t formID);
@@ -0,0 +1,46 @@
+#include "StartupTiming.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdio>
+
+namespace {
+    constexpr const char* PHASE_NAMES[] = {"logger",       "config read", "config parse", "config build",
+                                           "table baking", "lights read", "lights parse", "lights build"};
+    static_assert(std::size(PHASE_NAMES) == static_cast<size_t>(StartupPhase::Count));
+
+    // Nanoseconds, 0 = not run. Written by the loading thread, read by stats callers.
+    std::array<std::atomic<std::int64_t>, static_cast<size_t>(StartupPhase::Count)> g_PhaseNanos{};
+}
+
+const char* GetStartupPhaseName(StartupPhase phase) { return PHASE_NAMES[static_cast<size_t>(phase)]; }
+
+void RecordStartupPhase(StartupPhase phase, std::chrono::steady_clock::duration duration) {
+    auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count();
+    g_PhaseNanos[static_cast<size_t>(phase)].store(std::max<std::int64_t>(ns, 1), std::memory_order_relaxed);
+}
+
+std::chrono::nanoseconds GetStartupPhaseDuration(StartupPhase phase) {
+    return std::chrono::nanoseconds(g_PhaseNanos[static_cast<size_t>(phase)].load(std::memory_order_relaxed));
+}
+
+std::string FormatStartupTimings() {
+    std::string out = "Startup (ms):";
+    double totalMs = 0.0;
+    bool first = true;
+    for (size_t i = 0; i < static_cast<size_t>(StartupPhase::Count); ++i) {
+        auto ns = g_PhaseNanos[i].load(std::memory_order_relaxed);
+        if (ns == 0) continue;
+        double ms = static_cast<double>(ns) / 1e6;
+        totalMs += ms;
+        char buffer[64];
+        std::snprintf(buffer, sizeof(buffer), "%s %s %.2f", first ? "" : ",", PHASE_NAMES[i], ms);
+        out += buffer;
+        first = false;
+    }
+    if (first) return out + " not recorded";
+    char buffer[32];
+    std::snprintf(buffer, sizeof(buffer), ", total %.2f", totalMs);
+    return out + buffer;
+}
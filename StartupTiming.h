@@ -0,0 +1,52 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+// Phase timings of plugin initialization. The loaders record their phases on every call (the startup benchmark
+// calls them repeatedly, a phase recorded again overwrites its value); the plugin logs FormatStartupTimings()
+// once loading is done and the stats report repeats it.
+
+enum class StartupPhase : std::uint8_t {
+    LoggerSetup,  // spdlog file sink and async thread pool
+    ConfigRead,   // HomeAssistantLink.json from disk
+    ConfigParse,  // JSON text to tree
+    ConfigBuild,  // Config globals from the tree
+    TableBaking,  // Derived lookup tables (mod event trigger bits)
+    LightsRead,   // lights.json from disk
+    LightsParse,  // JSON text to tree
+    LightsBuild,  // g_SkyrimLightDefs
+    Count
+};
+
+const char* GetStartupPhaseName(StartupPhase phase);
+
+void RecordStartupPhase(StartupPhase phase, std::chrono::steady_clock::duration duration);
+// Last recorded duration, zero if the phase has not run
+std::chrono::nanoseconds GetStartupPhaseDuration(StartupPhase phase);
+
+// Records the time until Stop() or the end of the scope. Always on: each phase runs once per load.
+class ScopedStartupTimer {
+public:
+    explicit ScopedStartupTimer(StartupPhase phase) noexcept
+        : phase(phase), start(std::chrono::steady_clock::now()) {}
+    ~ScopedStartupTimer() { Stop(); }
+
+    void Stop() noexcept {
+        if (active) {
+            active = false;
+            RecordStartupPhase(phase, std::chrono::steady_clock::now() - start);
+        }
+    }
+
+    ScopedStartupTimer(const ScopedStartupTimer&) = delete;
+    ScopedStartupTimer& operator=(const ScopedStartupTimer&) = delete;
+
+private:
+    StartupPhase phase;
+    bool active = true;
+    std::chrono::steady_clock::time_point start;
+};
+
+// "Startup (ms): logger 1.20, config read 0.05, ... total 9.80"; phases that did not run are left out
+std::string FormatStartupTimings();
@@ -0,0 +1,155 @@
+#include "Stats.h"
+
+#include <spdlog/async.h>
+
+#include <chrono>
+#include <algorithm>
+#include <cstdio>
+#include <mutex>
+
+#include "AllocationTracker.h"
+#include "EntityHealth.h"
+#include "ExternalIntents.h"
+#include "Metrics.h"
+#include "Profiler.h"
+#include "StartupTiming.h"
+
+namespace {
+    // Consecutive failures (any lamp) after which the HA link is reported as down
+    constexpr std::uint32_t LINK_DOWN_FAILURES = 5;
+
+    struct Baseline {
+        std::chrono::steady_clock::time_point time = std::chrono::steady_clock::now();
+        std::uint64_t ticks = 0;
+        std::uint64_t requests = 0;
+        std::uint64_t failures = 0;
+        std::uint64_t dedup = 0;
+        std::uint64_t coalesced = 0;
+        std::uint64_t send_gaps = 0;
+        std::uint64_t send_gap_us = 0;
+        std::uint64_t send_gap_planned_us = 0;
+        std::uint64_t connections = 0;
+        std::uint64_t cpu_us = 0;
+    };
+
+    std::mutex g_BaselineMutex;  // Only taken by report callers, never by the pipeline
+    Baseline g_Baseline;
+
+    void AppendLine(std::string& out, const char* format, auto... args) {
+        char buffer[256];
+        int n = std::snprintf(buffer, sizeof(buffer), format, args...);
+        if (n > 0) out.append(buffer, std::min<size_t>(static_cast<size_t>(n), sizeof(buffer) - 1));
+        out += '\n';
+    }
+}
+
+std::string FormatStatsReport() {
+    Baseline now;
+    now.ticks = g_Metrics.ticks.load(std::memory_order_relaxed);
+    now.requests = g_Metrics.requests.load(std::memory_order_relaxed);
+    now.failures = g_Metrics.failures.load(std::memory_order_relaxed);
+    now.dedup = g_Metrics.dedup_suppressed.load(std::memory_order_relaxed);
+    now.coalesced = g_Metrics.coalesced.load(std::memory_order_relaxed);
+    now.send_gaps = g_Metrics.send_gaps.load(std::memory_order_relaxed);
+    now.send_gap_us = g_Metrics.send_gap_us.load(std::memory_order_relaxed);
+    now.send_gap_planned_us = g_Metrics.send_gap_planned_us.load(std::memory_order_relaxed);
+    now.connections = g_Metrics.connections_opened.load(std::memory_order_relaxed);
+    now.cpu_us = g_Metrics.worker_cpu_us.load(std::memory_order_relaxed);
+
+    Baseline prev;
+    {
+        std::lock_guard lock(g_BaselineMutex);
+        prev = g_Baseline;
+        g_Baseline = now;
+    }
+
+    double seconds = std::chrono::duration<double>(now.time - prev.time).count();
+    if (seconds <= 0.0) seconds = 1e-3;
+    auto rate = [seconds](std::uint64_t a, std::uint64_t b) { return static_cast<double>(a - b) / seconds; };
+
+    std::string out;
+    out.reserve(2048);
+    AppendLine(out, "HomeAssistantLink stats (last %.1f s)", seconds);
+    AppendLine(out, "Ticks: %.2f/s (total %llu), export thread CPU %.1f%%", rate(now.ticks, prev.ticks),
+               static_cast<unsigned long long>(now.ticks), rate(now.cpu_us, prev.cpu_us) / 1e4);
+
+    std::uint64_t sent = now.requests - prev.requests;
+    std::uint64_t deduped = now.dedup - prev.dedup;
+    std::uint64_t coalesced = now.coalesced - prev.coalesced;
+    std::uint64_t updates = sent + deduped + coalesced;
+    auto share = [updates](std::uint64_t n) {
+        return updates ? 100.0 * static_cast<double>(n) / static_cast<double>(updates) : 0.0;
+    };
+    AppendLine(out, "Sends: %.2f/s, failures %.2f/s, dedup %.0f%% / coalesced %.0f%% of %llu lamp updates",
+               rate(now.requests, prev.requests), rate(now.failures, prev.failures), share(deduped), share(coalesced),
+               static_cast<unsigned long long>(updates));
+    if (std::uint64_t gaps = now.send_gaps - prev.send_gaps; gaps != 0) {
+        auto mean_ms = [gaps](std::uint64_t a, std::uint64_t b) { return static_cast<double>(a - b) / gaps / 1000.0; };
+        AppendLine(out, "Staggered sends: %.1f ms between slots (planned %.1f ms), %llu gaps",
+                   mean_ms(now.send_gap_us, prev.send_gap_us),
+                   mean_ms(now.send_gap_planned_us, prev.send_gap_planned_us), static_cast<unsigned long long>(gaps));
+    }
+
+    std::uint32_t streak = g_Metrics.consecutive_failures.load(std::memory_order_relaxed);
+    const char* link = streak == 0 ? "up" : (streak < LINK_DOWN_FAILURES ? "degraded" : "down");
+    auto responses = [](StatusClass c) {
+        return static_cast<unsigned long long>(g_Metrics.status_counts[static_cast<size_t>(c)].load());
+    };
+    AppendLine(out, "HA link: %s (%u consecutive failures), responses 2xx=%llu 4xx=%llu 5xx=%llu transport=%llu", link,
+               streak, responses(StatusClass::Success), responses(StatusClass::ClientError),
+               responses(StatusClass::ServerError), responses(StatusClass::TransportError));
+    AppendLine(out, "HA connections: %.2f/s opened (total %llu)", rate(now.connections, prev.connections),
+               static_cast<unsigned long long>(now.connections));
+    AppendLine(out, "Lamps: %zu of %zu quarantined", GetQuarantinedEntityCount(), GetEntityHealth().size());
+
+    size_t logQueued = 0, logDropped = 0;
+    if (auto pool = spdlog::thread_pool()) {
+        logQueued = pool->queue_size();
+        logDropped = pool->overrun_counter();
+    }
+    AppendLine(out, "Queues: intents %zu pending / %zu active layers, log %zu queued (%zu dropped)",
+               GetPendingIntentCount(), GetActiveIntentLayerCount(), logQueued, logDropped);
+
+    if (g_ProfilingEnabled.load(std::memory_order_relaxed)) {
+        out += "Stages p50/p99 (ms):";
+        for (size_t s = 0; s < static_cast<size_t>(PipelineStage::Count); ++s) {
+            auto stage = static_cast<PipelineStage>(s);
+            auto snap = GetStageHistogram(stage).TakeSnapshot();
+            if (snap.count == 0) continue;
+            char buffer[64];
+            std::snprintf(buffer, sizeof(buffer), " %s %.2f/%.2f", GetStageName(stage),
+                          static_cast<double>(snap.Percentile(50.0)) / 1000.0,
+                          static_cast<double>(snap.Percentile(99.0)) / 1000.0);
+            out += buffer;
+        }
+        out += '\n';
+        out += FormatStageAllocations();
+        out += '\n';
+    } else {
+        out += "Stages: profiling disabled (Diagnostics.Profiling)\n";
+    }
+    out += "Resident (KiB): " + FormatResidentSizes() + '\n';
+
+    out += FormatStartupTimings();
+    out += '\n';
+
+    // Both lists are built from the lamp list at config load, so they share the index
+    const auto& metrics = GetEntityMetrics();
+    const auto& health = GetEntityHealth();
+    for (size_t i = 0; i < metrics.size(); ++i) {
+        const EntityMetrics& e = metrics[i];
+        char state[96] = "";
+        if (i < health.size() && health[i].IsQuarantined()) {
+            std::snprintf(state, sizeof(state), ", QUARANTINED (backoff %u ms, probe in %lld ms, %llu skipped)",
+                          health[i].backoff_ms.load(std::memory_order_relaxed),
+                          static_cast<long long>(GetEntityProbeDelayMs(health[i])),
+                          static_cast<unsigned long long>(health[i].skipped.load(std::memory_order_relaxed)));
+        }
+        AppendLine(out, "  %s: last %.1f ms (status %d), %llu requests, %llu failures%s", e.entity_id.c_str(),
+                   static_cast<double>(e.last_latency_us.load(std::memory_order_relaxed)) / 1000.0,
+                   e.last_status.load(std::memory_order_relaxed),
+                   static_cast<unsigned long long>(e.requests.load(std::memory_order_relaxed)),
+                   static_cast<unsigned long long>(e.failures.load(std::memory_order_relaxed)), state);
+    }
+    return out;
+}
@@ -0,0 +1,8 @@
+#pragma once
+#include <string>
+
+// Human-readable pipeline health report for the console (Papyrus GetStats / PrintStats).
+// Built only from the pre-aggregated counters of Metrics/Profiler, so nothing is collected for it in the
+// pipeline and a report costs a few microseconds. Rates cover the time since the previous report
+// (or since the plugin loaded, for the first one).
+std::string FormatStatsReport();
@@ -0,0 +1,71 @@
+#pragma once
+#include <cstdint>
+
+// Wire format of the binary game-telemetry stream (one UDP datagram per frame, little-endian).
+// Consumers should check magic and version, then read using the sizes in the header so that fields appended in
+// later versions are skipped gracefully.
+//
+// Layout: TelemetryFrameHeader | TelemetryPlayer | TelemetryLight[lightCount] | TelemetryLamp[lampCount]
+
+namespace Telemetry {
+    constexpr std::uint32_t FRAME_MAGIC = 0x544C4148;  // "HALT"
+    constexpr std::uint16_t FRAME_VERSION = 1;
+    constexpr std::uint8_t MAX_LIGHTS = 32;
+    constexpr std::uint8_t MAX_LAMPS = 32;
+
+    enum PlayerFlags : std::uint32_t {
+        kInCombat = 1 << 0,
+        kInterior = 1 << 1,
+        kTorchEquipped = 1 << 2,
+        kScenarioActive = 1 << 3,
+    };
+
+    enum LampFlags : std::uint8_t {
+        kLampInherit = 1 << 0,  // Lamp is not driven this frame (keeps its previous state)
+        kLampFlicker = 1 << 1,
+        kLampScene = 1 << 2,
+    };
+
+#pragma pack(push, 1)
+    struct TelemetryFrameHeader {
+        std::uint32_t magic;
+        std::uint16_t version;
+        std::uint16_t headerSize;  // sizeof(TelemetryFrameHeader)
+        std::uint32_t sequence;    // Increments per frame; gaps mean dropped datagrams
+        std::uint64_t timestamp_us;
+        std::uint8_t lightCount;
+        std::uint8_t lampCount;
+        std::uint8_t lightSize;  // sizeof(TelemetryLight)
+        std::uint8_t lampSize;   // sizeof(TelemetryLamp)
+    };
+
+    struct TelemetryPlayer {
+        float x, y, z;  // World position (Skyrim units)
+        float yaw;      // Camera yaw, radians [0, 2pi)
+        float gameHour;
+        std::uint32_t flags;  // PlayerFlags
+    };
+
+    // Nearby in-game light, nearest first
+    struct TelemetryLight {
+        float rel_x, rel_y, rel_z;  // Relative to the player (world axes)
+        float distance;
+        float intensity;
+        std::uint8_t r, g, b;
+        std::uint8_t reserved;
+    };
+
+    // Final lamp output in the order of the "Lights" config array
+    struct TelemetryLamp {
+        std::uint8_t r, g, b;
+        std::uint8_t brightness_pct;
+        std::uint8_t flags;  // LampFlags
+        std::uint8_t reserved[3];
+    };
+#pragma pack(pop)
+
+    static_assert(sizeof(TelemetryFrameHeader) == 24);
+    static_assert(sizeof(TelemetryPlayer) == 24);
+    static_assert(sizeof(TelemetryLight) == 24);
+    static_assert(sizeof(TelemetryLamp) == 8);
+}
@@ -0,0 +1,117 @@
+#include "TelemetryPublisher.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <numeric>
+
+#include "LampMapping.h"
+#include "Logger.h"
+#include "NetSocket.h"
+#include "TelemetryFrame.h"
+
+using namespace Telemetry;
+using Clock = std::chrono::steady_clock;
+
+namespace {
+    UdpSender g_TelemetrySender;
+    bool g_TelemetryOpenFailed = false;
+    std::uint32_t g_TelemetrySequence = 0;
+    int g_TicksSinceTelemetryFrame = 0;
+
+    std::uint8_t ToByte(int v) { return static_cast<std::uint8_t>(std::clamp(v, 0, 255)); }
+}
+
+void PublishTelemetry(const TelemetryInput& input) {
+    if (!g_Telemetry.enabled || g_TelemetryOpenFailed) return;
+
+    // Every n-th tick, with IntervalMs rounded to whole ticks. Comparing wall time against a one-tick interval
+    // would drop every other frame whenever a tick starts a little early.
+    int everyTicks = std::max(1, (g_Telemetry.interval_ms + EXPORT_TICK_MS / 2) / EXPORT_TICK_MS);
+    if (++g_TicksSinceTelemetryFrame < everyTicks) return;
+    g_TicksSinceTelemetryFrame = 0;
+    auto now = Clock::now();
+
+    if (!g_TelemetrySender.IsOpen()) {
+        if (!g_TelemetrySender.Open(g_Telemetry.address, g_Telemetry.port, g_Telemetry.ttl)) {
+            LogToFile_Error("Telemetry: failed to open UDP socket for " + g_Telemetry.address + ":" +
+                            std::to_string(g_Telemetry.port) + " (" + LastSocketError() + "). Telemetry disabled.");
+            g_TelemetryOpenFailed = true;
+            return;
+        }
+        LogToFile_Info("Telemetry: publishing to " + g_Telemetry.address + ":" + std::to_string(g_Telemetry.port));
+    }
+
+    const auto& lights = *input.lights;
+    const auto& lamps = *input.lamps;
+
+    // Top-N nearest lights
+    size_t maxLights = std::min<size_t>(g_Telemetry.max_lights, MAX_LIGHTS);
+    std::vector<size_t> order(lights.size());
+    std::iota(order.begin(), order.end(), size_t{0});
+    size_t lightCount = std::min(maxLights, lights.size());
+    std::partial_sort(order.begin(), order.begin() + lightCount, order.end(), [&](size_t a, size_t b) {
+        return lights[a].skyrim_pos.length() < lights[b].skyrim_pos.length();
+    });
+    size_t lampCount = std::min<size_t>(lamps.size(), MAX_LAMPS);
+
+    // Fixed-size scratch: the largest frame still fits a single Ethernet MTU
+    unsigned char buffer[sizeof(TelemetryFrameHeader) + sizeof(TelemetryPlayer) + MAX_LIGHTS * sizeof(TelemetryLight) +
+                         MAX_LAMPS * sizeof(TelemetryLamp)];
+    unsigned char* cursor = buffer;
+
+    TelemetryFrameHeader header{};
+    header.magic = FRAME_MAGIC;
+    header.version = FRAME_VERSION;
+    header.headerSize = sizeof(TelemetryFrameHeader);
+    header.sequence = g_TelemetrySequence++;
+    header.timestamp_us =
+        std::chrono::duration_cast<std::chrono::microseconds>(now.time_since_epoch()).count();
+    header.lightCount = static_cast<std::uint8_t>(lightCount);
+    header.lampCount = static_cast<std::uint8_t>(lampCount);
+    header.lightSize = sizeof(TelemetryLight);
+    header.lampSize = sizeof(TelemetryLamp);
+    std::memcpy(cursor, &header, sizeof(header));
+    cursor += sizeof(header);
+
+    TelemetryPlayer player{input.playerPos.x, input.playerPos.y, input.playerPos.z,
+                           input.yaw,         input.gameHour,    input.flags};
+    std::memcpy(cursor, &player, sizeof(player));
+    cursor += sizeof(player);
+
+    for (size_t i = 0; i < lightCount; ++i) {
+        const InGameLight& l = lights[order[i]];
+        TelemetryLight out{};
+        out.rel_x = l.skyrim_pos.x;
+        out.rel_y = l.skyrim_pos.y;
+        out.rel_z = l.skyrim_pos.z;
+        out.distance = l.skyrim_pos.length();
+        out.intensity = l.intensity;
+        out.r = ToByte(l.color_r);
+        out.g = ToByte(l.color_g);
+        out.b = ToByte(l.color_b);
+        std::memcpy(cursor, &out, sizeof(out));
+        cursor += sizeof(out);
+    }
+
+    for (size_t i = 0; i < lampCount; ++i) {
+        const LightState& s = lamps[i];
+        TelemetryLamp out{};
+        if (s.inherit) {
+            out.flags |= kLampInherit;
+        } else {
+            out.r = ToByte(s.rgb_color[0]);
+            out.g = ToByte(s.rgb_color[1]);
+            out.b = ToByte(s.rgb_color[2]);
+            out.brightness_pct = ToByte(s.brightness_pct);
+        }
+        if (s.effect.has_value() && s.effect.value() == "flicker") out.flags |= kLampFlicker;
+        if (s.effect.has_value() && s.effect.value() == "scene") out.flags |= kLampScene;
+        std::memcpy(cursor, &out, sizeof(out));
+        cursor += sizeof(out);
+    }
+
+    if (!g_TelemetrySender.Send(buffer, static_cast<size_t>(cursor - buffer))) {
+        HAL_LOG_WARN_LIMITED("Telemetry: send failed ({})", LastSocketError());
+    }
+}
@@ -0,0 +1,20 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+#include "ConfigLoader.h"
+
+struct InGameLight;
+
+// Everything one telemetry frame is built from. Pointers must stay valid for the duration of the call.
+struct TelemetryInput {
+    Vec3 playerPos;
+    float yaw;
+    float gameHour;
+    std::uint32_t flags;  // Telemetry::PlayerFlags
+    const std::vector<InGameLight>* lights;
+    const std::vector<LightState>* lamps;
+};
+
+// Sends a frame if telemetry is enabled and the configured interval has elapsed. Export thread only.
+void PublishTelemetry(const TelemetryInput& input);
@@ -0,0 +1,170 @@
+#include "TraceRecorder.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "AllocationTracker.h"
+
+std::atomic<bool> g_TracingEnabled = false;
+
+namespace {
+    struct TraceEvent {
+        std::int64_t ts_us;
+        std::int64_t dur_us;
+        std::int64_t value;  // Counter events
+        const char* name;
+        const char* category;
+        std::uint32_t tid;
+        char phase;  // 'X' complete, 'i' instant, 'C' counter
+        char detail[48];
+    };
+
+    // Seqlock per slot: seq is 0 while a writer owns the slot, otherwise the 1-based global index of the event
+    struct TraceSlot {
+        std::atomic<std::uint64_t> seq{0};
+        TraceEvent event;
+    };
+
+    std::unique_ptr<TraceSlot[]> g_TraceSlots;
+    size_t g_TraceCapacity = 0;
+    std::atomic<std::uint64_t> g_TraceWriteIndex{0};
+
+    const auto g_TraceEpoch = std::chrono::steady_clock::now();
+
+    std::atomic<std::uint32_t> g_NextTraceThreadId{1};
+    thread_local std::uint32_t t_TraceThreadId = 0;
+
+    std::mutex g_ThreadNamesLock;
+    std::vector<std::pair<std::uint32_t, std::string>> g_ThreadNames;
+
+    std::uint32_t CurrentTraceThreadId() {
+        if (t_TraceThreadId == 0) t_TraceThreadId = g_NextTraceThreadId.fetch_add(1, std::memory_order_relaxed);
+        return t_TraceThreadId;
+    }
+
+    std::int64_t ToTraceMicros(std::chrono::steady_clock::time_point t) {
+        return std::chrono::duration_cast<std::chrono::microseconds>(t - g_TraceEpoch).count();
+    }
+
+    void PushEvent(TraceEvent& event, std::string_view detail) {
+        if (g_TraceCapacity == 0) return;
+        event.tid = CurrentTraceThreadId();
+        size_t n = std::min(detail.size(), sizeof(event.detail) - 1);
+        std::memcpy(event.detail, detail.data(), n);
+        event.detail[n] = '\0';
+
+        std::uint64_t index = g_TraceWriteIndex.fetch_add(1, std::memory_order_relaxed);
+        TraceSlot& slot = g_TraceSlots[index % g_TraceCapacity];
+        slot.seq.store(0, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        slot.event = event;
+        slot.seq.store(index + 1, std::memory_order_release);
+    }
+
+    void WriteEscaped(std::ofstream& out, const char* text) {
+        for (const char* c = text; *c; ++c) {
+            if (*c == '"' || *c == '\\') out << '\\';
+            if (static_cast<unsigned char>(*c) < 0x20) continue;
+            out << *c;
+        }
+    }
+}
+
+void ConfigureTraceRecorder(size_t capacity) {
+    g_TraceSlots = capacity > 0 ? std::make_unique<TraceSlot[]>(capacity) : nullptr;
+    g_TraceCapacity = capacity;
+    SetResidentBytes(ResidentTable::TraceBuffer, capacity * sizeof(TraceSlot));
+    g_TraceWriteIndex.store(0);
+}
+
+void SetTraceThreadName(const char* name) {
+    std::lock_guard lock(g_ThreadNamesLock);
+    g_ThreadNames.emplace_back(CurrentTraceThreadId(), name);
+}
+
+void TraceComplete(const char* name, const char* category, std::chrono::steady_clock::time_point start,
+                   std::chrono::steady_clock::time_point end, std::string_view detail) {
+    if (!g_TracingEnabled.load(std::memory_order_relaxed)) return;
+    TraceEvent event{};
+    event.ts_us = ToTraceMicros(start);
+    event.dur_us = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
+    event.name = name;
+    event.category = category;
+    event.phase = 'X';
+    PushEvent(event, detail);
+}
+
+void TraceInstant(const char* name, const char* category, std::string_view detail) {
+    if (!g_TracingEnabled.load(std::memory_order_relaxed)) return;
+    TraceEvent event{};
+    event.ts_us = ToTraceMicros(std::chrono::steady_clock::now());
+    event.name = name;
+    event.category = category;
+    event.phase = 'i';
+    PushEvent(event, detail);
+}
+
+void TraceCounter(const char* name, std::int64_t value) {
+    if (!g_TracingEnabled.load(std::memory_order_relaxed)) return;
+    TraceEvent event{};
+    event.ts_us = ToTraceMicros(std::chrono::steady_clock::now());
+    event.value = value;
+    event.name = name;
+    event.category = "counter";
+    event.phase = 'C';
+    PushEvent(event, {});
+}
+
+bool FlushTrace(const std::filesystem::path& file) {
+    if (g_TraceCapacity == 0) return false;
+
+    // Copy out every slot that is fully written and still within the window
+    std::vector<TraceEvent> events;
+    events.reserve(g_TraceCapacity);
+    std::uint64_t end = g_TraceWriteIndex.load(std::memory_order_acquire);
+    std::uint64_t begin = end > g_TraceCapacity ? end - g_TraceCapacity : 0;
+    for (std::uint64_t i = begin; i < end; ++i) {
+        TraceSlot& slot = g_TraceSlots[i % g_TraceCapacity];
+        std::uint64_t before = slot.seq.load(std::memory_order_acquire);
+        TraceEvent copy = slot.event;
+        std::atomic_thread_fence(std::memory_order_acquire);
+        std::uint64_t after = slot.seq.load(std::memory_order_relaxed);
+        if (before == i + 1 && after == before) events.push_back(copy);
+    }
+
+    std::ofstream out(file, std::ios::trunc);
+    if (!out.is_open()) return false;
+
+    out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    bool first = true;
+    {
+        std::lock_guard lock(g_ThreadNamesLock);
+        for (const auto& [tid, name] : g_ThreadNames) {
+            out << (first ? "" : ",\n") << R"({"ph":"M","name":"thread_name","pid":1,"tid":)" << tid
+                << R"(,"args":{"name":")" << name << "\"}}";
+            first = false;
+        }
+    }
+    for (const auto& e : events) {
+        out << (first ? "" : ",\n") << "{\"ph\":\"" << e.phase << "\",\"name\":\"" << e.name << "\",\"cat\":\""
+            << e.category << "\",\"pid\":1,\"tid\":" << e.tid << ",\"ts\":" << e.ts_us;
+        if (e.phase == 'X') out << ",\"dur\":" << e.dur_us;
+        if (e.phase == 'i') out << ",\"s\":\"t\"";
+        if (e.phase == 'C') {
+            out << ",\"args\":{\"value\":" << e.value << "}";
+        } else if (e.detail[0] != '\0') {
+            out << ",\"args\":{\"detail\":\"";
+            WriteEscaped(out, e.detail);
+            out << "\"}";
+        }
+        out << "}";
+        first = false;
+    }
+    out << "\n]}\n";
+    return out.good();
+}
@@ -0,0 +1,51 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <string_view>
+
+// Timeline recorder producing Chrome trace-event JSON (open in chrome://tracing or ui.perfetto.dev).
+// Events go into a preallocated ring buffer (oldest events are overwritten) and are only formatted on flush.
+
+extern std::atomic<bool> g_TracingEnabled;
+
+// Allocates the ring buffer. Call before enabling tracing; not thread-safe against concurrent writers.
+void ConfigureTraceRecorder(size_t capacity);
+
+// Names the calling thread in the trace ("export", "papyrus", ...).
+void SetTraceThreadName(const char* name);
+
+// name/category must be string literals (only the pointer is stored). detail is copied (truncated to 47 chars).
+void TraceComplete(const char* name, const char* category, std::chrono::steady_clock::time_point start,
+                   std::chrono::steady_clock::time_point end, std::string_view detail = {});
+void TraceInstant(const char* name, const char* category, std::string_view detail = {});
+void TraceCounter(const char* name, std::int64_t value);
+
+// Writes the buffered events as trace-event JSON. Safe to call while events are being recorded.
+bool FlushTrace(const std::filesystem::path& file);
+
+// Records the enclosing scope as a complete event when tracing is enabled.
+class ScopedTrace {
+public:
+    ScopedTrace(const char* name, const char* category, std::string_view detail = {}) noexcept
+        : name(name), category(category), detail(detail) {
+        if (g_TracingEnabled.load(std::memory_order_relaxed)) {
+            start = std::chrono::steady_clock::now();
+            active = true;
+        }
+    }
+    ~ScopedTrace() {
+        if (active) TraceComplete(name, category, start, std::chrono::steady_clock::now(), detail);
+    }
+
+    ScopedTrace(const ScopedTrace&) = delete;
+    ScopedTrace& operator=(const ScopedTrace&) = delete;
+
+private:
+    const char* name;
+    const char* category;
+    std::string_view detail;
+    bool active = false;
+    std::chrono::steady_clock::time_point start;
+};
@@ -0,0 +1,37 @@
+#pragma once
+#include <string>
+#include <vector>
+
+// Result of one Home Assistant service call
+struct TransportResponse {
+    long status_code = 0;         // HTTP status, 0 = transport error (see error)
+    std::string text;             // Response body
+    std::string error;            // Transport error message
+    double elapsed = 0.0;         // Seconds
+    bool new_connection = false;  // The call had to open a connection (TCP and, for https, TLS handshake)
+};
+
+// One call of a batch
+struct TransportRequest {
+    const char* path;  // e.g. "/api/services/light/turn_on"
+    std::string body;
+};
+
+// How LightManager reaches Home Assistant. The plugin installs CprTransport or CurlTransport; tools and benchmarks
+// install their own.
+class ILightTransport {
+public:
+    virtual ~ILightTransport() = default;
+
+    // POSTs a JSON body to <Home Assistant URL><path>, e.g. "/api/services/light/turn_on". Blocking.
+    virtual TransportResponse PostJson(const std::string& path, const std::string& body) = 0;
+
+    // POSTs independent calls (one tick's lamp updates) and returns their responses in request order. Transports
+    // that can run them concurrently (HTTP/2 streams) override this; the default sends them one after another.
+    virtual std::vector<TransportResponse> PostJsonBatch(const std::vector<TransportRequest>& requests) {
+        std::vector<TransportResponse> responses;
+        responses.reserve(requests.size());
+        for (const TransportRequest& request : requests) responses.push_back(PostJson(request.path, request.body));
+        return responses;
+    }
+};
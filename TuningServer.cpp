@@ -0,0 +1,430 @@
+#include "TuningServer.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <cmath>
+#include <mutex>
+#include <nlohmann/json.hpp>
+#include <optional>
+#include <string>
+#include <thread>
+
+#include "Logger.h"
+#include "NetSocket.h"
+#include "Profiler.h"
+
+using json = nlohmann::json;
+
+namespace {
+    constexpr int POLL_MS = 20;                     // Outgoing frames wait at most this long
+    constexpr int HANDSHAKE_TIMEOUT_MS = 2000;
+    constexpr size_t MAX_HANDSHAKE_BYTES = 8192;
+    constexpr size_t MAX_MESSAGE_BYTES = 64 * 1024;  // Commands are tiny; anything bigger is a broken client
+
+    std::atomic<bool> g_ClientConnected = false;
+
+    struct PendingFrame {
+        std::uint64_t tick = 0;
+        std::uint64_t paramsVersion = 0;
+        std::string scenario;
+        std::vector<LightState> lamps;
+    };
+    std::mutex g_PendingMutex;
+    std::optional<PendingFrame> g_Pending;  // Latest frame not yet sent
+
+    // --- WebSocket handshake (RFC 6455: SHA-1 and base64 of the client key) ---
+
+    std::array<std::uint8_t, 20> Sha1(std::string_view data) {
+        std::uint32_t h[5] = {0x67452301, 0xEFCDAB89, 0x98BADCFE, 0x10325476, 0xC3D2E1F0};
+        auto rotl = [](std::uint32_t v, int n) { return (v << n) | (v >> (32 - n)); };
+
+        std::string message(data);
+        std::uint64_t bitLength = static_cast<std::uint64_t>(data.size()) * 8;
+        message += static_cast<char>(0x80);
+        while (message.size() % 64 != 56) message += '\0';
+        for (int i = 7; i >= 0; --i) message += static_cast<char>((bitLength >> (i * 8)) & 0xFF);
+
+        for (size_t chunk = 0; chunk < message.size(); chunk += 64) {
+            std::uint32_t w[80];
+            for (int i = 0; i < 16; ++i) {
+                const auto* p = reinterpret_cast<const std::uint8_t*>(message.data() + chunk + 4 * i);
+                w[i] = (std::uint32_t(p[0]) << 24) | (std::uint32_t(p[1]) << 16) | (std::uint32_t(p[2]) << 8) | p[3];
+            }
+            for (int i = 16; i < 80; ++i) w[i] = rotl(w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16], 1);
+
+            std::uint32_t a = h[0], b = h[1], c = h[2], d = h[3], e = h[4];
+            for (int i = 0; i < 80; ++i) {
+                std::uint32_t f, k;
+                if (i < 20) {
+                    f = (b & c) | (~b & d);
+                    k = 0x5A827999;
+                } else if (i < 40) {
+                    f = b ^ c ^ d;
+                    k = 0x6ED9EBA1;
+                } else if (i < 60) {
+                    f = (b & c) | (b & d) | (c & d);
+                    k = 0x8F1BBCDC;
+                } else {
+                    f = b ^ c ^ d;
+                    k = 0xCA62C1D6;
+                }
+                std::uint32_t temp = rotl(a, 5) + f + e + k + w[i];
+                e = d;
+                d = c;
+                c = rotl(b, 30);
+                b = a;
+                a = temp;
+            }
+            h[0] += a;
+            h[1] += b;
+            h[2] += c;
+            h[3] += d;
+            h[4] += e;
+        }
+
+        std::array<std::uint8_t, 20> digest;
+        for (int i = 0; i < 20; ++i) digest[i] = static_cast<std::uint8_t>(h[i / 4] >> (24 - 8 * (i % 4)));
+        return digest;
+    }
+
+    std::string Base64(const std::uint8_t* data, size_t size) {
+        static constexpr char ALPHABET[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+        std::string out;
+        for (size_t i = 0; i < size; i += 3) {
+            std::uint32_t v = std::uint32_t(data[i]) << 16;
+            if (i + 1 < size) v |= std::uint32_t(data[i + 1]) << 8;
+            if (i + 2 < size) v |= data[i + 2];
+            out += ALPHABET[(v >> 18) & 63];
+            out += ALPHABET[(v >> 12) & 63];
+            out += i + 1 < size ? ALPHABET[(v >> 6) & 63] : '=';
+            out += i + 2 < size ? ALPHABET[v & 63] : '=';
+        }
+        return out;
+    }
+
+    // Value of a request header (case-insensitive name), empty if missing
+    std::string_view FindHeader(std::string_view request, std::string_view name) {
+        size_t pos = request.find("\r\n");
+        while (pos != std::string_view::npos && pos + 2 < request.size()) {
+            size_t start = pos + 2;
+            size_t end = request.find("\r\n", start);
+            std::string_view line = request.substr(start, end == std::string_view::npos ? end : end - start);
+            if (line.size() > name.size() && line[name.size()] == ':' &&
+                std::equal(name.begin(), name.end(), line.begin(),
+                           [](char a, char b) { return std::tolower(a) == std::tolower(b); })) {
+                std::string_view value = line.substr(name.size() + 1);
+                while (!value.empty() && value.front() == ' ') value.remove_prefix(1);
+                while (!value.empty() && value.back() == ' ') value.remove_suffix(1);
+                return value;
+            }
+            pos = end;
+        }
+        return {};
+    }
+
+    bool Handshake(SocketHandle client) {
+        std::string request;
+        char buffer[1024];
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(HANDSHAKE_TIMEOUT_MS);
+        while (request.find("\r\n\r\n") == std::string::npos) {
+            if (request.size() > MAX_HANDSHAKE_BYTES || std::chrono::steady_clock::now() > deadline) return false;
+            if (PollReadable(client, 100) <= 0) continue;
+            long received = ReceiveSome(client, buffer, sizeof(buffer), 0);
+            if (received <= 0) return false;
+            request.append(buffer, static_cast<size_t>(received));
+        }
+
+        std::string_view key = FindHeader(request, "Sec-WebSocket-Key");
+        if (!request.starts_with("GET ") || key.empty()) {
+            std::string body = "Live-tuning endpoint: connect with a WebSocket client.\n";
+            std::string response = "HTTP/1.1 400 Bad Request\r\nContent-Type: text/plain\r\nContent-Length: " +
+                                   std::to_string(body.size()) + "\r\nConnection: close\r\n\r\n" + body;
+            SendAll(client, response.data(), response.size());
+            return false;
+        }
+
+        auto digest = Sha1(std::string(key) + "258EAFA5-E914-47DA-95CA-C5AB0DC85B11");
+        std::string response =
+            "HTTP/1.1 101 Switching Protocols\r\nUpgrade: websocket\r\nConnection: Upgrade\r\nSec-WebSocket-Accept: " +
+            Base64(digest.data(), digest.size()) + "\r\n\r\n";
+        return SendAll(client, response.data(), response.size());
+    }
+
+    // --- Frames ---
+
+    enum Opcode : std::uint8_t { kContinuation = 0, kText = 1, kBinary = 2, kClose = 8, kPing = 9, kPong = 10 };
+
+    // Server frames are never masked
+    bool SendFrame(SocketHandle client, Opcode opcode, std::string_view payload) {
+        std::string frame;
+        frame += static_cast<char>(0x80 | opcode);
+        if (payload.size() < 126) {
+            frame += static_cast<char>(payload.size());
+        } else if (payload.size() <= 0xFFFF) {
+            frame += static_cast<char>(126);
+            frame += static_cast<char>(payload.size() >> 8);
+            frame += static_cast<char>(payload.size() & 0xFF);
+        } else {
+            frame += static_cast<char>(127);
+            for (int i = 7; i >= 0; --i) frame += static_cast<char>((std::uint64_t(payload.size()) >> (8 * i)) & 0xFF);
+        }
+        frame.append(payload);
+        return SendAll(client, frame.data(), frame.size());
+    }
+
+    bool SendJson(SocketHandle client, const json& message) { return SendFrame(client, kText, message.dump()); }
+
+    json ParamsToJson(const LightingOptions& o) {
+        // Floats widened to double print as 0.4000000059604645; 4 decimals is all a tuner needs
+        auto round = [](float v) { return std::round(static_cast<double>(v) * 1e4) / 1e4; };
+        return {{"directionSharpness", round(o.direction_sharpness)},
+                {"lightRadius", round(o.light_radius)},
+                {"fireExponent", round(o.fire_exponent)},
+                {"smoothing", round(o.smoothing)}};
+    }
+
+    json ParamsMessage() {
+        LiveLightingOptions live = GetLiveLightingOptions();
+        return {{"type", "params"}, {"version", live.version}, {"params", ParamsToJson(live.options)}};
+    }
+
+    json ErrorMessage(const std::string& message) { return {{"type", "error"}, {"message", message}}; }
+
+    json HandleCommand(std::string_view text) {
+        json command = json::parse(text, nullptr, false);
+        if (!command.is_object()) return ErrorMessage("expected a JSON object");
+
+        if (command.contains("set")) {
+            const json& set = command["set"];
+            if (!set.is_object()) return ErrorMessage("\"set\" must be an object");
+            LightingOptions options = GetLiveLightingOptions().options;
+            for (const auto& [name, value] : set.items()) {
+                if (!value.is_number()) return ErrorMessage("\"" + name + "\" must be a number");
+                float v = value.get<float>();
+                if (name == "directionSharpness") {
+                    options.direction_sharpness = v;
+                } else if (name == "lightRadius") {
+                    options.light_radius = v;
+                } else if (name == "fireExponent") {
+                    options.fire_exponent = v;
+                } else if (name == "smoothing") {
+                    options.smoothing = v;
+                } else {
+                    return ErrorMessage("unknown parameter \"" + name + "\"");
+                }
+            }
+            SetLiveLightingOptions(options);
+            LogToFile_Info("Live tuning: " + ParamsToJson(GetLiveLightingOptions().options).dump());
+        } else if (command.contains("reset")) {
+            SetLiveLightingOptions(g_LightingOptions);
+            LogToFile_Info("Live tuning: reset to the configured lighting options.");
+        } else if (!command.contains("get")) {
+            return ErrorMessage("expected \"set\", \"get\" or \"reset\"");
+        }
+        return ParamsMessage();
+    }
+
+    std::string LampMode(const LightState& lamp) {
+        if (lamp.inherit) return "inherit";
+        if (lamp.scene) return "scene";
+        return lamp.effect.value_or("");
+    }
+
+    // Stage timings since the previous frame
+    class StageWindow {
+    public:
+        StageWindow() { Reset(); }
+
+        void Reset() {
+            for (size_t s = 0; s < STAGE_COUNT; ++s) {
+                previous[s] = GetStageHistogram(static_cast<PipelineStage>(s)).TakeSnapshot();
+            }
+        }
+
+        json Advance() {
+            json stages = json::object();
+            for (size_t s = 0; s < STAGE_COUNT; ++s) {
+                auto now = GetStageHistogram(static_cast<PipelineStage>(s)).TakeSnapshot();
+                std::uint64_t count = now.count - previous[s].count;
+                if (count > 0) {
+                    // Per-window max: upper bound of the highest bucket that gained samples
+                    std::uint64_t max = 0;
+                    for (size_t i = now.buckets.size(); i-- > 0;) {
+                        if (now.buckets[i] != previous[s].buckets[i]) {
+                            max = std::min(LatencyHistogram::BucketUpperBound(i), now.max_us);
+                            break;
+                        }
+                    }
+                    stages[GetStageName(static_cast<PipelineStage>(s))] = {
+                        {"n", count}, {"mean_us", (now.sum_us - previous[s].sum_us) / count}, {"max_us", max}};
+                }
+                previous[s] = now;
+            }
+            return stages;
+        }
+
+    private:
+        static constexpr size_t STAGE_COUNT = static_cast<size_t>(PipelineStage::Count);
+        std::array<LatencyHistogram::Snapshot, STAGE_COUNT> previous;
+    };
+
+    json FrameMessage(const PendingFrame& frame, StageWindow& stages) {
+        json lamps = json::array();
+        for (const LightState& lamp : frame.lamps) {
+            lamps.push_back({{"entity_id", lamp.entity_id},
+                             {"rgb", lamp.rgb_color},
+                             {"brightness", lamp.brightness_pct},
+                             {"mode", LampMode(lamp)}});
+        }
+        return {{"type", "frame"},
+                {"tick", frame.tick},
+                {"paramsVersion", frame.paramsVersion},
+                {"scenario", frame.scenario},
+                {"lamps", std::move(lamps)},
+                {"stages", stages.Advance()}};
+    }
+
+    // Incoming bytes -> complete messages. Returns false when the connection should end.
+    class FrameReader {
+    public:
+        bool Feed(SocketHandle client, const char* data, size_t size) {
+            buffer.append(data, size);
+            while (true) {
+                if (buffer.size() < 2) return true;
+                auto b0 = static_cast<std::uint8_t>(buffer[0]);
+                auto b1 = static_cast<std::uint8_t>(buffer[1]);
+                bool fin = b0 & 0x80;
+                auto opcode = static_cast<Opcode>(b0 & 0x0F);
+                if (!(b1 & 0x80)) return Close(client, 1002);  // Client frames must be masked
+                size_t header = 2;
+                std::uint64_t length = b1 & 0x7F;
+                if (length >= 126) {
+                    size_t extra = length == 126 ? 2 : 8;
+                    if (buffer.size() < header + extra) return true;
+                    length = 0;
+                    for (size_t i = 0; i < extra; ++i) {
+                        length = (length << 8) | static_cast<std::uint8_t>(buffer[2 + i]);
+                    }
+                    header += extra;
+                }
+                if (length > MAX_MESSAGE_BYTES) return Close(client, 1009);
+                if (buffer.size() < header + 4 + length) return true;
+
+                const char* mask = buffer.data() + header;
+                std::string payload = buffer.substr(header + 4, static_cast<size_t>(length));
+                for (size_t i = 0; i < payload.size(); ++i) payload[i] ^= mask[i % 4];
+                buffer.erase(0, header + 4 + static_cast<size_t>(length));
+
+                switch (opcode) {
+                    case kPing:
+                        SendFrame(client, kPong, payload);
+                        break;
+                    case kPong:
+                        break;
+                    case kClose:
+                        SendFrame(client, kClose, payload.substr(0, 2));
+                        return false;
+                    case kBinary:
+                        return Close(client, 1003);
+                    case kText:
+                    case kContinuation:
+                        message += payload;
+                        if (message.size() > MAX_MESSAGE_BYTES) return Close(client, 1009);
+                        if (fin) {
+                            if (!SendJson(client, HandleCommand(message))) return false;
+                            message.clear();
+                        }
+                        break;
+                    default:
+                        return Close(client, 1002);
+                }
+            }
+        }
+
+    private:
+        static bool Close(SocketHandle client, std::uint16_t code) {
+            char status[2] = {static_cast<char>(code >> 8), static_cast<char>(code & 0xFF)};
+            SendFrame(client, kClose, std::string_view(status, 2));
+            return false;
+        }
+
+        std::string buffer;
+        std::string message;  // Fragments of a text message so far
+    };
+
+    void ServeClient(SocketHandle client) {
+        FrameReader reader;
+        StageWindow stages;
+        {
+            std::lock_guard lock(g_PendingMutex);
+            g_Pending.reset();
+        }
+        if (!SendJson(client, ParamsMessage())) return;
+
+        char buffer[4096];
+        while (true) {
+            int readable = PollReadable(client, POLL_MS);
+            if (readable < 0) return;
+            if (readable > 0) {
+                long received = ReceiveSome(client, buffer, sizeof(buffer), 0);
+                if (received <= 0 || !reader.Feed(client, buffer, static_cast<size_t>(received))) return;
+            }
+
+            std::optional<PendingFrame> frame;
+            {
+                std::lock_guard lock(g_PendingMutex);
+                frame.swap(g_Pending);
+            }
+            if (frame && !SendJson(client, FrameMessage(*frame, stages))) return;
+        }
+    }
+
+    void TuningServerThread(std::uint16_t port) {
+        TcpListener listener;
+        // Localhost only: the endpoint is unauthenticated
+        if (!listener.Listen("127.0.0.1", port)) {
+            LogToFile_Error("Tuning endpoint: cannot listen on 127.0.0.1:" + std::to_string(port) + " (" +
+                            LastSocketError() + ").");
+            return;
+        }
+        LogToFile_Info("Tuning endpoint listening on ws://127.0.0.1:" + std::to_string(port) + "/");
+
+        while (listener.IsOpen()) {
+            SocketHandle client = listener.Accept();
+            if (client == INVALID_SOCKET_HANDLE) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(100));
+                continue;
+            }
+            if (Handshake(client)) {
+                LogToFile_Info("Tuning client connected.");
+                g_ProfilingEnabled.store(true);  // Frames report stage timings
+                g_ClientConnected.store(true);
+                ServeClient(client);
+                g_ClientConnected.store(false);
+                g_ProfilingEnabled.store(g_Diagnostics.profiling || g_Diagnostics.metrics_port != 0);
+                LogToFile_Info("Tuning client disconnected.");
+            }
+            CloseSocket(client);
+        }
+    }
+}
+
+void StartTuningServer(std::uint16_t port) {
+    if (port == 0) return;
+    std::thread(TuningServerThread, port).detach();
+}
+
+bool TuningClientConnected() { return g_ClientConnected.load(std::memory_order_relaxed); }
+
+void PublishTuningFrame(std::uint64_t tick, std::uint64_t paramsVersion, std::string_view scenario,
+                        const std::vector<LightState>& lamps) {
+    std::lock_guard lock(g_PendingMutex);
+    if (!g_Pending) g_Pending.emplace();
+    g_Pending->tick = tick;
+    g_Pending->paramsVersion = paramsVersion;
+    g_Pending->scenario.assign(scenario);
+    g_Pending->lamps = lamps;
+}
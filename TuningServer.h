@@ -0,0 +1,31 @@
+#pragma once
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+#include "ConfigLoader.h"  // For LightState
+
+// Live-tuning channel: a WebSocket on ws://127.0.0.1:<port>/ (one client at a time) to change the lighting options
+// while the game runs and watch what they do.
+//
+// Client -> plugin (text frames, JSON):
+//   {"set": {"directionSharpness": 3.0, "lightRadius": 600, "fireExponent": 0.5, "smoothing": 0.3}}  (any subset)
+//   {"get": "params"}
+//   {"reset": true}  (back to the values from HomeAssistantLink.json)
+// Plugin -> client:
+//   {"type": "params", "version": N, "params": {...}}  after every command, with the values actually applied
+//   {"type": "frame", "tick": T, "paramsVersion": N, "scenario": "...", "lamps": [...], "stages": {...}}  per tick
+//   {"type": "error", "message": "..."}
+// A change applies from the next tick on; frames carry the params version they were computed with. "stages" holds
+// the per-stage timings (n, mean_us, max_us) since the previous frame. Profiling stays on while a client is connected.
+
+// Starts the server thread. No-op if port is 0.
+void StartTuningServer(std::uint16_t port);
+
+// Cheap check for the export thread, to skip building frames nobody reads
+bool TuningClientConnected();
+
+// Hands the tick's final lamp states to the server thread, which sends them. Only the latest frame is kept, so a
+// slow client never delays the export thread.
+void PublishTuningFrame(std::uint64_t tick, std::uint64_t paramsVersion, std::string_view scenario,
+                        const std::vector<LightState>& lamps);
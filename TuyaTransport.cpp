@@ -0,0 +1,273 @@
+#include "TuyaTransport.h"
+
+#include <chrono>
+#include <cstring>
+#include <mutex>
+#include <nlohmann/json.hpp>
+
+#include "Logger.h"
+#include "NetSocket.h"
+#include "TuyaProtocol.h"
+
+using json = nlohmann::json;
+
+namespace {
+    constexpr const char* LIGHT_TURN_ON_PATH = "/api/services/light/turn_on";
+    using Clock = std::chrono::steady_clock;
+}
+
+struct TuyaTransport::Device {
+    TuyaDeviceConfig config;
+    TuyaVersion version = TuyaVersion::V33;
+    TuyaKey localKey{};
+    std::string payloadPrefix;  // Control JSON around the timestamp and the dps object, built once
+    std::string payloadMiddle;
+    std::string payloadSuffix;
+
+    std::mutex mutex;  // One command at a time per bulb
+    SocketHandle socket = INVALID_SOCKET_HANDLE;
+    TuyaCodec codec;
+    std::uint32_t seq = 0;
+    std::string buffer;  // Received bytes not decoded yet
+    Clock::time_point retryAfter{};
+
+    explicit Device(const TuyaDeviceConfig& deviceConfig) : config(deviceConfig) {
+        version = static_cast<TuyaVersion>(config.version);
+        std::memcpy(localKey.data(), config.local_key.data(), localKey.size());
+        std::string id = json(config.device_id).dump();
+        if (version == TuyaVersion::V33) {
+            payloadPrefix = "{\"devId\":" + id + ",\"uid\":" + id + ",\"t\":\"";
+            payloadMiddle = "\",\"dps\":";
+            payloadSuffix = "}";
+        } else {
+            payloadPrefix = "{\"protocol\":5,\"t\":";
+            payloadMiddle = ",\"data\":{\"dps\":";
+            payloadSuffix = "}}";
+        }
+    }
+
+    ~Device() { CloseSocket(socket); }
+
+    void Disconnect() {
+        CloseSocket(socket);
+        socket = INVALID_SOCKET_HANDLE;
+        buffer.clear();
+    }
+
+    bool Send(std::uint32_t cmd, std::string_view payload) {
+        std::string frame = codec.Encode(++seq, cmd, payload);
+        return !frame.empty() && SendAll(socket, frame.data(), frame.size());
+    }
+
+    // Next message with the given command; anything else the bulb sends meanwhile (status reports) is dropped
+    bool Receive(std::uint32_t cmd, Clock::time_point deadline, TuyaMessage& message, std::string& error) {
+        char chunk[1024];
+        while (true) {
+            long used = codec.Decode(buffer, message, true);
+            if (used < 0) {
+                error = "undecodable frame (wrong local key or protocol version?)";
+                return false;
+            }
+            if (used > 0) {
+                buffer.erase(0, static_cast<size_t>(used));
+                if (message.cmd == cmd) return true;
+                continue;
+            }
+            auto left = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - Clock::now()).count();
+            if (left <= 0) {
+                error = "no answer within the timeout";
+                return false;
+            }
+            int ready = PollReadable(socket, static_cast<int>(left));
+            if (ready < 0) {
+                error = LastSocketError();
+                return false;
+            }
+            if (ready == 0) continue;
+            long received = ReceiveSome(socket, chunk, sizeof(chunk), 0);
+            if (received <= 0) {
+                error = "connection closed by the bulb";
+                return false;
+            }
+            buffer.append(chunk, static_cast<size_t>(received));
+        }
+    }
+
+    // Reads whatever arrived while idle. False if the bulb closed the connection in the meantime.
+    bool DrainIdle() {
+        char chunk[1024];
+        while (PollReadable(socket, 0) > 0) {
+            long received = ReceiveSome(socket, chunk, sizeof(chunk), 0);
+            if (received <= 0) return false;
+            buffer.append(chunk, static_cast<size_t>(received));
+        }
+        TuyaMessage message;
+        long used = 0;
+        while ((used = codec.Decode(buffer, message, true)) > 0) buffer.erase(0, static_cast<size_t>(used));
+        return used == 0;
+    }
+
+    // TCP connect plus, for 3.4/3.5, the session key negotiation
+    bool Connect(int timeoutMs, std::string& error) {
+        auto deadline = Clock::now() + std::chrono::milliseconds(timeoutMs);
+        socket = ConnectTcp(config.address, static_cast<std::uint16_t>(config.port), timeoutMs);
+        if (socket == INVALID_SOCKET_HANDLE) {
+            error = "cannot connect to " + config.address + ":" + std::to_string(config.port);
+            return false;
+        }
+        codec.Configure(version, localKey);
+        if (version == TuyaVersion::V33) return true;
+
+        TuyaNonce clientNonce;
+        RandomTuyaBytes(clientNonce.data(), clientNonce.size());
+        TuyaMessage reply;
+        if (!Send(TuyaCommand::kSessKeyNegStart,
+                  std::string_view(reinterpret_cast<const char*>(clientNonce.data()), clientNonce.size())) ||
+            !Receive(TuyaCommand::kSessKeyNegResp, deadline, reply, error)) {
+            if (error.empty()) error = "session key negotiation: send failed";
+            return false;
+        }
+        // Device nonce followed by the HMAC of ours, which proves the bulb has the same local key
+        constexpr size_t RESPONSE_SIZE = TUYA_NONCE_SIZE + sizeof(TuyaHmacDigest);
+        if (reply.payload.size() < RESPONSE_SIZE) {
+            error = "session key negotiation: short response";
+            return false;
+        }
+        const char* response = reply.payload.data() + reply.payload.size() - RESPONSE_SIZE;
+        TuyaNonce deviceNonce;
+        std::memcpy(deviceNonce.data(), response, deviceNonce.size());
+        TuyaHmacDigest expected = TuyaHmac(localKey, clientNonce.data(), clientNonce.size());
+        if (std::memcmp(expected.data(), response + TUYA_NONCE_SIZE, expected.size()) != 0) {
+            error = "session key negotiation: HMAC mismatch (wrong local key?)";
+            return false;
+        }
+        TuyaHmacDigest finish = TuyaHmac(localKey, deviceNonce.data(), deviceNonce.size());
+        if (!Send(TuyaCommand::kSessKeyNegFinish,
+                  std::string_view(reinterpret_cast<const char*>(finish.data()), finish.size()))) {
+            error = "session key negotiation: send failed";
+            return false;
+        }
+        codec.SetKey(DeriveTuyaSessionKey(version, localKey, clientNonce, deviceNonce));
+        return true;
+    }
+
+    bool SetDps(const std::string& dps, int timeoutMs, int reconnectDelayMs, std::string& error, bool& connected) {
+        std::lock_guard lock(mutex);
+        if (socket != INVALID_SOCKET_HANDLE && !DrainIdle()) Disconnect();
+
+        // A kept-alive connection may have gone stale (bulb rebooted or timed us out): one retry on a new one
+        for (int attempt = 0; attempt < 2; ++attempt) {
+            bool fresh = socket == INVALID_SOCKET_HANDLE;
+            if (fresh) {
+                if (Clock::now() < retryAfter) {
+                    error = "unreachable, waiting before the next connect attempt";
+                    return false;
+                }
+                if (!Connect(timeoutMs, error)) {
+                    Disconnect();
+                    retryAfter = Clock::now() + std::chrono::milliseconds(reconnectDelayMs);
+                    return false;
+                }
+                connected = true;
+                HAL_LOG_DEBUG("Tuya {}: connected to {}:{} (protocol {}).", config.entity_id, config.address,
+                              config.port, GetTuyaVersionName(version));
+            }
+
+            std::uint32_t cmd = version == TuyaVersion::V33 ? TuyaCommand::kControl : TuyaCommand::kControlNew;
+            auto now = std::chrono::duration_cast<std::chrono::seconds>(
+                           std::chrono::system_clock::now().time_since_epoch())
+                           .count();
+            std::string payload = payloadPrefix + std::to_string(now) + payloadMiddle + dps + payloadSuffix;
+            TuyaMessage ack;
+            error.clear();
+            if (Send(cmd, payload) && Receive(cmd, Clock::now() + std::chrono::milliseconds(timeoutMs), ack, error)) {
+                if (ack.retcode == 0) return true;
+                error = "bulb rejected the command (code " + std::to_string(ack.retcode) + ")";
+                return false;
+            }
+            if (error.empty()) error = "send failed: " + LastSocketError();
+            Disconnect();
+            if (fresh) {
+                retryAfter = Clock::now() + std::chrono::milliseconds(reconnectDelayMs);
+                return false;
+            }
+        }
+        return false;
+    }
+};
+
+TuyaTransport::TuyaTransport(std::unique_ptr<ILightTransport> fallback, const TuyaConfig& config)
+    : fallback(std::move(fallback)), timeoutMs(config.timeout_ms), reconnectDelayMs(config.reconnect_delay_ms) {
+    for (const TuyaDeviceConfig& device : config.devices) {
+        devices[device.entity_id] = std::make_unique<Device>(device);
+        LogToFile_Info("Tuya: " + device.entity_id + " -> " + device.address + ":" + std::to_string(device.port) +
+                       " (protocol " + GetTuyaVersionName(static_cast<TuyaVersion>(device.version)) + ").");
+    }
+}
+
+TuyaTransport::~TuyaTransport() = default;
+
+bool TuyaTransport::SendDirect(const std::string& path, const std::string& body, TransportResponse& response) {
+    if (path != LIGHT_TURN_ON_PATH) return false;
+    json request = json::parse(body, nullptr, false);
+    auto it = request.is_object() ? devices.find(request.value("entity_id", "")) : devices.end();
+    // Effects and scenes need HA's integration; plain color + brightness is what the bulb takes directly
+    if (it == devices.end() || !request.contains("rgb_color") || request["rgb_color"].size() != 3 ||
+        request.contains("effect")) {
+        return false;
+    }
+    auto start = Clock::now();
+    Device& device = *it->second;
+    std::array<int, 3> rgb = request["rgb_color"].get<std::array<int, 3>>();
+    int brightness = request.value("brightness_pct", 100);
+
+    std::string power = "\"" + std::to_string(device.config.power_dp) + "\":";
+    std::string dps;
+    if (brightness <= 0) {
+        dps = "{" + power + "false}";
+    } else {
+        dps = "{" + power + "true,\"" + std::to_string(device.config.mode_dp) + "\":\"colour\",\"" +
+              std::to_string(device.config.colour_dp) + "\":\"" + EncodeTuyaColour(rgb, brightness) + "\"}";
+    }
+
+    std::string error;
+    if (device.SetDps(dps, timeoutMs, reconnectDelayMs, error, response.new_connection)) {
+        response.status_code = 200;
+    } else {
+        response.error = "Tuya " + device.config.address + ": " + error;
+    }
+    response.elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+    return true;
+}
+
+TransportResponse TuyaTransport::PostJson(const std::string& path, const std::string& body) {
+    TransportResponse response;
+    if (SendDirect(path, body, response)) return response;
+    if (!fallback) {
+        response.error = "no Home Assistant transport for " + path;
+        return response;
+    }
+    return fallback->PostJson(path, body);
+}
+
+std::vector<TransportResponse> TuyaTransport::PostJsonBatch(const std::vector<TransportRequest>& requests) {
+    std::vector<TransportResponse> responses(requests.size());
+    std::vector<TransportRequest> forwarded;
+    std::vector<size_t> forwardedIndex;
+    for (size_t i = 0; i < requests.size(); ++i) {
+        if (SendDirect(requests[i].path, requests[i].body, responses[i])) continue;
+        forwarded.push_back(requests[i]);
+        forwardedIndex.push_back(i);
+    }
+    if (forwarded.empty()) return responses;
+    if (!fallback) {
+        for (size_t i : forwardedIndex) {
+            responses[i].error = std::string("no Home Assistant transport for ") + requests[i].path;
+        }
+        return responses;
+    }
+    // The rest still goes to Home Assistant as one batch, so an HTTP/2 fallback keeps multiplexing it
+    std::vector<TransportResponse> fallbackResponses = fallback->PostJsonBatch(forwarded);
+    for (size_t k = 0; k < forwardedIndex.size(); ++k) responses[forwardedIndex[k]] = std::move(fallbackResponses[k]);
+    return responses;
+}
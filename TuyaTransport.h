@@ -0,0 +1,38 @@
+#pragma once
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "ConfigLoader.h"  // For TuyaConfig
+#include "Transport.h"
+
+// Direct LAN backend for Tuya bulbs (Tuya local protocol 3.3/3.4/3.5, see TuyaProtocol.h).
+// Wraps the Home Assistant transport: light.turn_on calls with rgb_color for a configured Tuya entity are turned into
+// DPS (power, colour mode, colour_data_v2 with the brightness as value) and sent straight to the bulb; everything
+// else (other entities, effects and scenes, select_option) goes on to Home Assistant.
+// Each bulb keeps one TCP connection open, with its session key negotiated once per connection, so a command is one
+// encrypted frame and the bulb's acknowledgement. A dropped connection is reopened on the next command; after a
+// failed connect the bulb's calls fail fast for ReconnectDelayMs so an unplugged bulb cannot stall every tick.
+// Responses look like HA's: 200 when the bulb acknowledged, 0 with an error otherwise.
+class TuyaTransport final : public ILightTransport {
+public:
+    TuyaTransport(std::unique_ptr<ILightTransport> fallback, const TuyaConfig& config);
+    ~TuyaTransport() override;
+
+    TransportResponse PostJson(const std::string& path, const std::string& body) override;
+    std::vector<TransportResponse> PostJsonBatch(const std::vector<TransportRequest>& requests) override;
+
+    size_t GetDeviceCount() const { return devices.size(); }
+
+private:
+    struct Device;
+
+    // Sends a call straight to its bulb if it is one this backend handles; false leaves it to the fallback
+    bool SendDirect(const std::string& path, const std::string& body, TransportResponse& response);
+
+    std::unique_ptr<ILightTransport> fallback;  // May be null (tools): non-Tuya calls then fail
+    std::unordered_map<std::string, std::unique_ptr<Device>> devices;  // By entity id
+    int timeoutMs;
+    int reconnectDelayMs;
+};
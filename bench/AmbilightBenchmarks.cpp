@@ -0,0 +1,164 @@
+// Screen-color kernel (Ambilight.h), separately from the D3D11 capture: region accumulation (SSE2 and scalar
+// reference) by capture width, and the per-lamp resolve by lamp count.
+// Recorded frames: set HAL_AMBILIGHT_FRAMES to a folder of PPMs saved in game with
+// cgf "HomeAssistantLink.SaveAmbilightFrame"; each file becomes a BM_AmbilightRecorded/<name> benchmark.
+//
+//   HomeAssistantLink_bench --benchmark_filter=Ambilight
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include "Ambilight.h"
+#include "BenchAllocations.h"
+#include "SceneGenerator.h"
+
+namespace {
+    // 16:9 test frame: sky gradient over dark ground, an orange fire and a blue spell, plus pixel noise
+    struct SyntheticFrame {
+        std::vector<std::uint8_t> pixels;
+        AmbilightImage image;
+    };
+
+    SyntheticFrame MakeFrame(int width) {
+        SyntheticFrame frame;
+        int height = std::max(width * 9 / 16, 1);
+        frame.pixels.resize(static_cast<size_t>(width) * height * 4);
+        std::uint32_t seed = 777;
+        for (int y = 0; y < height; ++y) {
+            for (int x = 0; x < width; ++x) {
+                float u = static_cast<float>(x) / static_cast<float>(width);
+                float v = static_cast<float>(y) / static_cast<float>(height);
+                float r, g, b;
+                if (v < 0.55f) {
+                    r = 60.0f + 80.0f * v;
+                    g = 90.0f + 60.0f * v;
+                    b = 150.0f - 40.0f * v;
+                } else {
+                    r = 45.0f;
+                    g = 40.0f;
+                    b = 35.0f;
+                }
+                float fire = std::exp(-((u - 0.25f) * (u - 0.25f) + (v - 0.7f) * (v - 0.7f)) / 0.01f);
+                float spell = std::exp(-((u - 0.8f) * (u - 0.8f) + (v - 0.5f) * (v - 0.5f)) / 0.005f);
+                r += 210.0f * fire + 40.0f * spell;
+                g += 110.0f * fire + 120.0f * spell;
+                b += 10.0f * fire + 230.0f * spell;
+                seed = seed * 1664525u + 1013904223u;
+                float noise = static_cast<float>(seed >> 27) - 16.0f;
+                std::uint8_t* p = &frame.pixels[(static_cast<size_t>(y) * width + x) * 4];
+                p[0] = static_cast<std::uint8_t>(std::clamp(r + noise, 0.0f, 255.0f));
+                p[1] = static_cast<std::uint8_t>(std::clamp(g + noise, 0.0f, 255.0f));
+                p[2] = static_cast<std::uint8_t>(std::clamp(b + noise, 0.0f, 255.0f));
+                p[3] = 255;
+            }
+        }
+        frame.image = {frame.pixels.data(), width, height, static_cast<size_t>(width) * 4,
+                       AmbilightPixelFormat::RGBA8};
+        return frame;
+    }
+
+    // Lamps around the seat: front left/right, sides, behind
+    bool SameCells(const std::vector<AmbilightCell>& a, const std::vector<AmbilightCell>& b) {
+        if (a.size() != b.size()) return false;
+        for (size_t i = 0; i < a.size(); ++i) {
+            if (a[i].c0 != b[i].c0 || a[i].c1 != b[i].c1 || a[i].c2 != b[i].c2 || a[i].weight != b[i].weight) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    void RunGrid(benchmark::State& state, const AmbilightImage& image, bool scalar) {
+        AmbilightKernel kernel;
+        kernel.Configure(MakeLampRing(4, "light.ambilight_"), AmbilightConfig{});
+
+        // The SIMD path must match the scalar reference exactly
+        AmbilightKernel reference;
+        reference.Configure(MakeLampRing(4, "light.ambilight_"), AmbilightConfig{});
+        if (!kernel.AccumulateGrid(image) || !reference.AccumulateGridScalar(image) ||
+            !SameCells(kernel.GetCells(), reference.GetCells())) {
+            state.SkipWithError("AccumulateGrid differs from AccumulateGridScalar");
+            return;
+        }
+
+        AllocationScope allocs;
+        for (auto _ : state) {
+            bool ok = scalar ? kernel.AccumulateGridScalar(image) : kernel.AccumulateGrid(image);
+            benchmark::DoNotOptimize(ok);
+            benchmark::ClobberMemory();
+        }
+        allocs.Report(state);
+        state.counters["pixels"] = static_cast<double>(image.width) * image.height;
+        state.SetItemsProcessed(state.iterations() * static_cast<std::int64_t>(image.width) * image.height);
+    }
+}
+
+// Arg: capture width (16:9). The plugin reads the first mip at most Ambilight.CaptureWidth (default 64) wide.
+static void BM_AmbilightGrid(benchmark::State& state) {
+    SyntheticFrame frame = MakeFrame(static_cast<int>(state.range(0)));
+    RunGrid(state, frame.image, false);
+}
+BENCHMARK(BM_AmbilightGrid)->ArgName("width")->Arg(32)->Arg(64)->Arg(128)->Arg(256);
+
+static void BM_AmbilightGridScalar(benchmark::State& state) {
+    SyntheticFrame frame = MakeFrame(static_cast<int>(state.range(0)));
+    RunGrid(state, frame.image, true);
+}
+BENCHMARK(BM_AmbilightGridScalar)->ArgName("width")->Arg(32)->Arg(64)->Arg(128)->Arg(256);
+
+// Arg: lamps. Weighted sum over the 16x9 regions per lamp.
+static void BM_AmbilightResolve(benchmark::State& state) {
+    SyntheticFrame frame = MakeFrame(64);
+    AmbilightKernel kernel;
+    kernel.Configure(MakeLampRing(static_cast<int>(state.range(0)), "light.ambilight_"), AmbilightConfig{});
+    kernel.AccumulateGrid(frame.image);
+    AllocationScope allocs;
+    for (auto _ : state) {
+        std::vector<LightState> lamps = kernel.ResolveLamps();
+        benchmark::DoNotOptimize(lamps.data());
+    }
+    allocs.Report(state);
+}
+BENCHMARK(BM_AmbilightResolve)->ArgName("lamps")->Arg(4)->Arg(16);
+
+// --- Recorded frames (HAL_AMBILIGHT_FRAMES) ---
+
+namespace {
+    void RunRecorded(benchmark::State& state, const std::filesystem::path& file) {
+        std::vector<std::uint8_t> pixels;
+        AmbilightImage image;
+        if (!LoadAmbilightPpm(file, pixels, image)) {
+            state.SkipWithError("not a binary PPM (P6, maxval 255)");
+            return;
+        }
+        AmbilightKernel kernel;
+        kernel.Configure(MakeLampRing(4, "light.ambilight_"), AmbilightConfig{});
+        AllocationScope allocs;
+        for (auto _ : state) {
+            std::vector<LightState> lamps = kernel.Process(image);
+            benchmark::DoNotOptimize(lamps.data());
+        }
+        allocs.Report(state);
+        state.counters["pixels"] = static_cast<double>(image.width) * image.height;
+    }
+
+    const bool g_RecordedFramesRegistered = [] {
+        const char* folder = std::getenv("HAL_AMBILIGHT_FRAMES");
+        std::error_code ec;
+        if (!folder || !std::filesystem::is_directory(folder, ec)) return false;
+        for (const auto& entry : std::filesystem::directory_iterator(folder, ec)) {
+            if (entry.path().extension() != ".ppm") continue;
+            std::filesystem::path file = entry.path();
+            benchmark::RegisterBenchmark(("BM_AmbilightRecorded/" + file.stem().string()).c_str(),
+                                         [file](benchmark::State& state) { RunRecorded(state, file); });
+        }
+        return true;
+    }();
+}
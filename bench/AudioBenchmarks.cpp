@@ -0,0 +1,182 @@
+// Audio-reactive DSP (AudioReactive.h), separately from the WASAPI capture: the FFT (SSE2 and scalar reference)
+// by block size, the whole analyzer on a synthetic mix, and the modulation layers over the lamp states.
+// WAV files: set HAL_AUDIO_WAVS to a folder of .wav files (e.g. recorded game audio); each file becomes a
+// BM_AudioWav/<name> benchmark that analyzes the whole file per iteration.
+//
+//   HomeAssistantLink_bench --benchmark_filter=Audio
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include "AudioReactive.h"
+#include "BenchAllocations.h"
+
+namespace {
+    constexpr int SAMPLE_RATE = 48000;
+
+    // Stereo test mix: a kick drum every half second, a low drone, a mid melody and hiss
+    std::vector<float> MakeMix(float seconds) {
+        size_t frames = static_cast<size_t>(seconds * SAMPLE_RATE);
+        std::vector<float> samples(frames * 2);
+        std::uint32_t seed = 99;
+        for (size_t i = 0; i < frames; ++i) {
+            float t = static_cast<float>(i) / SAMPLE_RATE;
+            float beat = std::fmod(t, 0.5f);
+            float kickPitch = 50.0f + 80.0f * std::exp(-beat * 30.0f);
+            float kick = std::exp(-beat * 18.0f) * std::sin(6.2831853f * kickPitch * beat);
+            float drone = 0.2f * std::sin(6.2831853f * 82.0f * t);
+            float note = 440.0f + 220.0f * std::floor(std::fmod(t * 2.0f, 4.0f));
+            float melody = 0.15f * std::sin(6.2831853f * note * t);
+            seed = seed * 1664525u + 1013904223u;
+            float hiss = 0.02f * (static_cast<float>(seed >> 8) / 8388608.0f - 1.0f);
+            samples[2 * i] = 0.6f * kick + drone + melody + hiss;
+            samples[2 * i + 1] = 0.6f * kick + drone - melody + hiss;
+        }
+        return samples;
+    }
+
+    // Largest relative difference between two spectra
+    float SpectrumDifference(const std::vector<float>& re1, const std::vector<float>& im1,
+                             const std::vector<float>& re2, const std::vector<float>& im2) {
+        float peak = 1e-9f, diff = 0.0f;
+        for (size_t i = 0; i < re1.size(); ++i) {
+            peak = std::max(peak, std::hypot(re2[i], im2[i]));
+            diff = std::max(diff, std::hypot(re1[i] - re2[i], im1[i] - im2[i]));
+        }
+        return diff / peak;
+    }
+
+    void RunFft(benchmark::State& state, bool scalar) {
+        size_t n = static_cast<size_t>(state.range(0));
+        AudioFft fft;
+        fft.Configure(n);
+        std::vector<float> input = MakeMix(static_cast<float>(n) / SAMPLE_RATE + 0.01f);
+        std::vector<float> re(n), im(n, 0.0f), refRe(n), refIm(n, 0.0f);
+        for (size_t i = 0; i < n; ++i) re[i] = refRe[i] = input[2 * i];
+
+        // The SIMD path must match the scalar reference to float rounding
+        fft.Forward(re.data(), im.data());
+        fft.ForwardScalar(refRe.data(), refIm.data());
+        if (SpectrumDifference(re, im, refRe, refIm) > 1e-5f) {
+            state.SkipWithError("AudioFft::Forward differs from ForwardScalar");
+            return;
+        }
+
+        AllocationScope allocs;
+        for (auto _ : state) {
+            for (size_t i = 0; i < n; ++i) {
+                re[i] = input[2 * i];
+                im[i] = 0.0f;
+            }
+            if (scalar) {
+                fft.ForwardScalar(re.data(), im.data());
+            } else {
+                fft.Forward(re.data(), im.data());
+            }
+            benchmark::DoNotOptimize(re.data());
+            benchmark::ClobberMemory();
+        }
+        allocs.Report(state);
+    }
+}
+
+// Arg: FFT size (AudioReactive.BlockSize)
+static void BM_AudioFft(benchmark::State& state) { RunFft(state, false); }
+BENCHMARK(BM_AudioFft)->ArgName("size")->Arg(256)->Arg(1024)->Arg(4096);
+
+static void BM_AudioFftScalar(benchmark::State& state) { RunFft(state, true); }
+BENCHMARK(BM_AudioFftScalar)->ArgName("size")->Arg(256)->Arg(1024)->Arg(4096);
+
+// Arg: block size. One second of 48 kHz stereo pushed in 10 ms packets, as the capture thread does.
+static void BM_AudioAnalyzer(benchmark::State& state) {
+    AudioReactiveConfig config;
+    config.block_size = static_cast<int>(state.range(0));
+    std::vector<float> mix = MakeMix(1.0f);
+    size_t frames = mix.size() / 2;
+    AudioBandAnalyzer analyzer;
+    analyzer.Configure(SAMPLE_RATE, config);
+    AllocationScope allocs;
+    int blocks = 0;
+    for (auto _ : state) {
+        for (size_t pos = 0; pos < frames; pos += 480) {
+            blocks += analyzer.Push(mix.data() + 2 * pos, std::min<size_t>(480, frames - pos), 2);
+        }
+        benchmark::DoNotOptimize(analyzer.GetBands());
+    }
+    allocs.Report(state);
+    state.counters["blocks"] = benchmark::Counter(static_cast<double>(blocks), benchmark::Counter::kAvgIterations);
+    state.counters["realtime_x"] = benchmark::Counter(static_cast<double>(state.iterations()),
+                                                      benchmark::Counter::kIsRate);  // Seconds of audio per second
+}
+BENCHMARK(BM_AudioAnalyzer)->ArgName("block")->Arg(512)->Arg(1024)->Arg(2048);
+
+// Arg: lamps. Both layers active (loud bass with a hit).
+static void BM_AudioModulation(benchmark::State& state) {
+    AudioReactiveConfig config;
+    AudioBands bands;
+    bands.level.fill(0.8f);
+    bands.transient.fill(0.5f);
+    std::vector<LightState> base;
+    for (int i = 0; i < state.range(0); ++i) {
+        base.push_back(LightState{"light.audio_" + std::to_string(i), {255, 140, 60}, 60, std::nullopt, std::nullopt,
+                                  false, std::nullopt});
+    }
+    std::vector<LightState> states = base;
+    AllocationScope allocs;
+    for (auto _ : state) {
+        states = base;
+        ApplyAudioModulation(states, bands, config);
+        benchmark::DoNotOptimize(states.data());
+    }
+    allocs.Report(state);
+}
+BENCHMARK(BM_AudioModulation)->ArgName("lamps")->Arg(4)->Arg(16);
+
+// --- WAV files (HAL_AUDIO_WAVS) ---
+
+namespace {
+    void RunWav(benchmark::State& state, const std::filesystem::path& file) {
+        std::vector<float> samples;
+        int sampleRate = 0, channels = 0;
+        if (!LoadWavFile(file, samples, sampleRate, channels)) {
+            state.SkipWithError("not a 16/24-bit PCM or 32-bit float WAV file");
+            return;
+        }
+        size_t frames = samples.size() / static_cast<size_t>(channels);
+        size_t packet = static_cast<size_t>(sampleRate / 100);
+        AudioBandAnalyzer analyzer;
+        AllocationScope allocs;
+        for (auto _ : state) {
+            analyzer.Configure(sampleRate, AudioReactiveConfig{});
+            for (size_t pos = 0; pos < frames; pos += packet) {
+                analyzer.Push(samples.data() + pos * channels, std::min(packet, frames - pos), channels);
+            }
+            benchmark::DoNotOptimize(analyzer.GetBands());
+        }
+        allocs.Report(state);
+        double seconds = static_cast<double>(frames) / sampleRate;
+        state.counters["audio_s"] = seconds;
+        state.counters["realtime_x"] = benchmark::Counter(seconds * static_cast<double>(state.iterations()),
+                                                          benchmark::Counter::kIsRate);
+    }
+
+    const bool g_WavFilesRegistered = [] {
+        const char* folder = std::getenv("HAL_AUDIO_WAVS");
+        std::error_code ec;
+        if (!folder || !std::filesystem::is_directory(folder, ec)) return false;
+        for (const auto& entry : std::filesystem::directory_iterator(folder, ec)) {
+            if (entry.path().extension() != ".wav") continue;
+            std::filesystem::path file = entry.path();
+            benchmark::RegisterBenchmark(("BM_AudioWav/" + file.stem().string()).c_str(),
+                                         [file](benchmark::State& state) { RunWav(state, file); });
+        }
+        return true;
+    }();
+}
@@ -0,0 +1,28 @@
+#pragma once
+#include <benchmark/benchmark.h>
+
+#include <cstdint>
+
+#include "AllocationTracker.h"
+
+// Heap allocations of the benchmark thread, counted by the operator new hook (AllocationHooks.cpp is linked into
+// the benchmark executable)
+
+// Counts allocations between construction and Report(); report once, after the benchmark loop
+class AllocationScope {
+public:
+    AllocationScope() : start(GetThreadAllocations()) {}
+
+    AllocationCounters Total() const { return GetThreadAllocations() - start; }
+
+    void Report(benchmark::State& state) const {
+        AllocationCounters total = Total();
+        state.counters["allocs/iter"] =
+            benchmark::Counter(static_cast<double>(total.count), benchmark::Counter::kAvgIterations);
+        state.counters["bytes/iter"] =
+            benchmark::Counter(static_cast<double>(total.bytes), benchmark::Counter::kAvgIterations);
+    }
+
+private:
+    AllocationCounters start;
+};
@@ -0,0 +1,225 @@
+// Micro-benchmarks for the per-tick lamp pipeline (startup loaders: StartupBenchmarks.cpp).
+// Every benchmark reports allocs/iter and bytes/iter next to the timings: the export thread runs this code five
+// times a second for the whole session, so allocation churn matters as much as raw speed.
+//
+//   HomeAssistantLink_bench --benchmark_filter=Mapping   (any Google Benchmark flag works)
+
+#include <benchmark/benchmark.h>
+
+#include <cmath>
+#include <cstdint>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include "BenchAllocations.h"
+#include "ConfigLoader.h"
+#include "LampMapping.h"
+#include "LightManager.h"
+#include "LightSmoother.h"
+#include "Pipeline.h"
+#include "Profiler.h"
+#include "SceneGenerator.h"
+
+namespace {
+    // --- Deterministic synthetic scenes ---
+
+    // Lamps on a circle around the room center, like a typical 2-8 lamp setup
+    // Lights spread over a 1000 x 1000 area around the player; about half lie inside LIGHT_RADIUS.
+    // Every third one is a fire.
+    std::vector<InGameLight> MakeLights(int count) {
+        std::vector<InGameLight> lights;
+        std::uint32_t seed = 12345;
+        auto next = [&seed]() {
+            seed = seed * 1664525u + 1013904223u;
+            return static_cast<float>(seed >> 8) / static_cast<float>(1u << 24);
+        };
+        for (int i = 0; i < count; ++i) {
+            InGameLight light;
+            light.skyrim_pos = {next() * 1000.0f - 500.0f, next() * 1000.0f - 500.0f, next() * 200.0f - 100.0f};
+            light.type = (i % 3 == 0) ? "fire" : "other";
+            light.color_r = 255;
+            light.color_g = 140 + i % 60;
+            light.color_b = 40;
+            light.intensity = 0.5f + next();
+            lights.push_back(light);
+        }
+        return lights;
+    }
+
+    std::vector<LightState> MakeStates(int count, int seed) {
+        std::vector<LightState> states;
+        for (int i = 0; i < count; ++i) {
+            int v = (seed * 37 + i * 53) % 256;
+            states.push_back(LightState{"light.bench_" + std::to_string(i), {v, 255 - v, (v * 7) % 256},
+                                        10 + v % 90, std::nullopt, std::nullopt, false, std::nullopt});
+        }
+        return states;
+    }
+}
+
+// --- Kernels ---
+
+// Args: lamps, in-game lights
+static void BM_MapInGameLightsToRealLamps(benchmark::State& state) {
+    auto lamps = MakeLampRing(static_cast<int>(state.range(0)), "light.bench_");
+    auto lights = MakeLights(static_cast<int>(state.range(1)));
+    AllocationScope allocs;
+    for (auto _ : state) {
+        auto result = MapInGameLightsToRealLamps(lamps, lights, 0.7f, LIGHT_RADIUS);
+        benchmark::DoNotOptimize(result.data());
+    }
+    allocs.Report(state);
+    state.SetItemsProcessed(state.iterations() * state.range(1));
+}
+BENCHMARK(BM_MapInGameLightsToRealLamps)->ArgsProduct({{1, 4, 8, 16}, {0, 8, 32, 128, 512}});
+
+static void BM_RotateVectorByYaw(benchmark::State& state) {
+    Vec3 v{120.0f, -45.0f, 30.0f};
+    float yaw = 0.0f;
+    AllocationScope allocs;
+    for (auto _ : state) {
+        yaw += 0.001f;
+        Vec3 r = RotateVectorByYaw(v, yaw);
+        benchmark::DoNotOptimize(r);
+    }
+    allocs.Report(state);
+}
+BENCHMARK(BM_RotateVectorByYaw);
+
+static void BM_AmbientStateForHour(benchmark::State& state) {
+    UseSyntheticConfig(1, "light.bench_");
+    const std::string entity = "light.bench_0";
+    float hour = 0.0f;
+    AllocationScope allocs;
+    for (auto _ : state) {
+        hour = std::fmod(hour + 0.37f, 24.0f);
+        LightState s = GetAmbientStateForHour(hour, entity);
+        benchmark::DoNotOptimize(s.brightness_pct);
+    }
+    allocs.Report(state);
+}
+BENCHMARK(BM_AmbientStateForHour);
+
+// Arg: lamps
+static void BM_BlendLampStates(benchmark::State& state) {
+    int lamps = static_cast<int>(state.range(0));
+    auto dynamic = MakeStates(lamps, 1);
+    auto scenario = MakeStates(lamps, 2);
+    AllocationScope allocs;
+    for (auto _ : state) {
+        auto result = BlendLampStates(dynamic, scenario);
+        benchmark::DoNotOptimize(result.data());
+    }
+    allocs.Report(state);
+}
+BENCHMARK(BM_BlendLampStates)->Arg(1)->Arg(4)->Arg(16);
+
+// Arg: lamps. Alternates between two targets so the smoother always has work to do.
+static void BM_SmoothStates(benchmark::State& state) {
+    int lamps = static_cast<int>(state.range(0));
+    auto a = MakeStates(lamps, 1);
+    auto b = MakeStates(lamps, 2);
+    LightSmoother smoother;
+    bool flip = false;
+    AllocationScope allocs;
+    for (auto _ : state) {
+        auto result = smoother.SmoothStates(flip ? a : b, 0.2f);
+        flip = !flip;
+        benchmark::DoNotOptimize(result.data());
+    }
+    allocs.Report(state);
+}
+BENCHMARK(BM_SmoothStates)->Arg(1)->Arg(4)->Arg(16);
+
+static void BM_ApplyFlicker(benchmark::State& state) {
+    std::array<int, 3> rgb{};
+    int brightness = 0;
+    AllocationScope allocs;
+    for (auto _ : state) {
+        ApplyFlicker(rgb, brightness, {255, 140, 40}, 60);
+        benchmark::DoNotOptimize(rgb);
+        benchmark::DoNotOptimize(brightness);
+    }
+    allocs.Report(state);
+}
+BENCHMARK(BM_ApplyFlicker);
+
+static void BM_BuildTurnOnPayload(benchmark::State& state) {
+    const std::string entity = "light.b40_ip_121";
+    const std::optional<std::string> effect = state.range(0) ? std::optional<std::string>("candle") : std::nullopt;
+    AllocationScope allocs;
+    for (auto _ : state) {
+        std::string body = BuildTurnOnPayload(entity, {255, 140, 40}, 73, effect);
+        benchmark::DoNotOptimize(body.data());
+    }
+    allocs.Report(state);
+}
+BENCHMARK(BM_BuildTurnOnPayload)->ArgName("effect")->Arg(0)->Arg(1);
+
+// Args: lamps, in-game lights. One full tick: mapping, scenario/ambient, blend, smoothing.
+static void BM_RunLightPipeline(benchmark::State& state) {
+    UseSyntheticConfig(static_cast<int>(state.range(0)), "light.bench_");
+    FrameInput frame;
+    frame.gameHour = 21.5f;
+    frame.lights = MakeLights(static_cast<int>(state.range(1)));
+    LightSmoother smoother;
+    AllocationScope allocs;
+    for (auto _ : state) {
+        frame.playerYaw += 0.01f;
+        FrameResult result = RunLightPipeline(frame, smoother);
+        benchmark::DoNotOptimize(result.lampStates.data());
+    }
+    allocs.Report(state);
+}
+BENCHMARK(BM_RunLightPipeline)->ArgsProduct({{4, 16}, {8, 128}});
+
+// Steady-state allocation budget of one pipeline tick. Most allocations are per-lamp copies of LightState
+// (entity id strings); the budget fails the benchmark when a change adds per-tick churn beyond that.
+constexpr double PIPELINE_ALLOCS_BASE = 8.0;
+constexpr double PIPELINE_ALLOCS_PER_LAMP = 1.0;
+
+// Args: lamps, in-game lights. Runs with profiling on and reports allocations per stage as counted by the
+// stage timers (the same numbers the stats report shows).
+static void BM_PipelineAllocationBudget(benchmark::State& state) {
+    const int lampCount = static_cast<int>(state.range(0));
+    UseSyntheticConfig(lampCount, "light.bench_");
+    FrameInput frame;
+    frame.gameHour = 21.5f;
+    frame.lights = MakeLights(static_cast<int>(state.range(1)));
+    LightSmoother smoother;
+    RunLightPipeline(frame, smoother);  // First tick fills the smoother state; not part of the steady state
+
+    const PipelineStage stages[] = {PipelineStage::Mapping, PipelineStage::Scenario, PipelineStage::Blend,
+                                    PipelineStage::Smooth};
+    StageAllocations before[std::size(stages)];
+    for (size_t i = 0; i < std::size(stages); ++i) before[i] = GetStageAllocations(stages[i]);
+    bool wasProfiling = g_ProfilingEnabled.exchange(true);
+    AllocationScope allocs;
+    for (auto _ : state) {
+        frame.playerYaw += 0.01f;
+        FrameResult result = RunLightPipeline(frame, smoother);
+        benchmark::DoNotOptimize(result.lampStates.data());
+    }
+    AllocationCounters total = allocs.Total();
+    g_ProfilingEnabled.store(wasProfiling);
+
+    allocs.Report(state);
+    for (size_t i = 0; i < std::size(stages); ++i) {
+        StageAllocations after = GetStageAllocations(stages[i]);
+        state.counters[std::string(GetStageName(stages[i])) + " allocs"] = benchmark::Counter(
+            static_cast<double>(after.count - before[i].count), benchmark::Counter::kAvgIterations);
+    }
+
+    double perTick = static_cast<double>(total.count) / static_cast<double>(state.iterations());
+    double budget = PIPELINE_ALLOCS_BASE + PIPELINE_ALLOCS_PER_LAMP * lampCount;
+    state.counters["budget"] = budget;
+    if (perTick > budget) {
+        std::string message = "allocation budget exceeded: " + std::to_string(perTick) + " allocs/tick > " +
+                              std::to_string(budget);
+        state.SkipWithError(message.c_str());
+    }
+}
+BENCHMARK(BM_PipelineAllocationBudget)->ArgsProduct({{4, 16}, {8, 128}});
+
+BENCHMARK_MAIN();
@@ -0,0 +1,104 @@
+// Plugin startup: LoadConfigurationFromFile and LoadSkyrimLightsDatabaseFromFile on the shipped files, and
+// lights.json scaled up synthetically (load orders with many light mods ship several thousand definitions).
+// Besides the total, each benchmark reports its StartupTiming phases in microseconds per iteration.
+//
+//   HomeAssistantLink_bench --benchmark_filter=Startup
+
+#include <benchmark/benchmark.h>
+
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <initializer_list>
+#include <map>
+#include <nlohmann/json.hpp>
+#include <string>
+
+#include "BenchAllocations.h"
+#include "ConfigLoader.h"
+#include "SkyrimLightsDB.h"
+#include "StartupTiming.h"
+
+namespace {
+    const std::filesystem::path DATA_DIR = HAL_DATA_DIR;
+
+    // Sums the phases over all iterations and reports them as average microseconds per iteration
+    class PhaseAccumulator {
+    public:
+        explicit PhaseAccumulator(std::initializer_list<StartupPhase> phases) {
+            for (StartupPhase phase : phases) totals[phase] = 0.0;
+        }
+
+        void Add() {
+            for (auto& [phase, total] : totals) total += static_cast<double>(GetStartupPhaseDuration(phase).count());
+        }
+
+        void Report(benchmark::State& state) const {
+            for (const auto& [phase, total] : totals) {
+                state.counters[std::string(GetStartupPhaseName(phase)) + " us"] =
+                    benchmark::Counter(total / 1000.0, benchmark::Counter::kAvgIterations);
+            }
+        }
+
+    private:
+        std::map<StartupPhase, double> totals;
+    };
+
+    // The shipped lights.json repeated factor times with fresh form ids, written once per factor to the temp dir
+    std::filesystem::path ScaledLightsFile(int factor) {
+        if (factor == 1) return DATA_DIR / "lights.json";
+        auto path = std::filesystem::temp_directory_path() / ("HomeAssistantLink_bench_lights_x" +
+                                                              std::to_string(factor) + ".json");
+        if (std::filesystem::exists(path)) return path;
+
+        std::ifstream in(DATA_DIR / "lights.json");
+        nlohmann::json shipped = nlohmann::json::parse(in);
+        nlohmann::json scaled = nlohmann::json::array();
+        std::uint32_t nextFormId = 0x05000000;  // Above the shipped ids, like light mods in later load order slots
+        for (int copy = 0; copy < factor; ++copy) {
+            for (nlohmann::json entry : shipped) {
+                char formId[16];
+                std::snprintf(formId, sizeof(formId), "%08X", nextFormId++);
+                entry["formID"] = formId;
+                scaled.push_back(std::move(entry));
+            }
+        }
+        std::ofstream(path) << scaled.dump(2);
+        return path;
+    }
+}
+
+static void BM_StartupConfig(benchmark::State& state) {
+    const std::filesystem::path path = DATA_DIR / "HomeAssistantLink.json";
+    PhaseAccumulator phases({StartupPhase::ConfigRead, StartupPhase::ConfigParse, StartupPhase::ConfigBuild,
+                             StartupPhase::TableBaking});
+    AllocationScope allocs;
+    for (auto _ : state) {
+        if (!LoadConfigurationFromFile(path)) {
+            state.SkipWithError("LoadConfigurationFromFile failed");
+            break;
+        }
+        phases.Add();
+    }
+    allocs.Report(state);
+    phases.Report(state);
+}
+BENCHMARK(BM_StartupConfig)->Unit(benchmark::kMicrosecond);
+
+// Arg: lights.json scale factor (1 = shipped file)
+static void BM_StartupLightsDatabase(benchmark::State& state) {
+    const std::filesystem::path path = ScaledLightsFile(static_cast<int>(state.range(0)));
+    PhaseAccumulator phases({StartupPhase::LightsRead, StartupPhase::LightsParse, StartupPhase::LightsBuild});
+    AllocationScope allocs;
+    for (auto _ : state) {
+        if (!LoadSkyrimLightsDatabaseFromFile(path)) {
+            state.SkipWithError("LoadSkyrimLightsDatabaseFromFile failed");
+            break;
+        }
+        phases.Add();
+    }
+    allocs.Report(state);
+    phases.Report(state);
+    state.counters["definitions"] = static_cast<double>(g_SkyrimLightDefs.size());
+}
+BENCHMARK(BM_StartupLightsDatabase)->ArgName("scale")->Arg(1)->Arg(4)->Arg(16)->Unit(benchmark::kMillisecond);
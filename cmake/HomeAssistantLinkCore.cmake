@@ -0,0 +1,68 @@
+# HomeAssistantLinkCore: everything that does not touch the game (config, lamp pipeline, HA transport, diagnostics).
+# The SKSE plugin links it on Windows; on Linux it is built on its own for the tools and benchmarks.
+# Included by the top-level CMakeLists.txt and by tools/CMakeLists.txt.
+
+set(HAL_SOURCE_DIR "${CMAKE_CURRENT_LIST_DIR}/..")
+
+find_package(nlohmann_json CONFIG REQUIRED)
+find_package(spdlog CONFIG REQUIRED)
+find_package(Threads REQUIRED)
+
+add_library(HomeAssistantLinkCore STATIC
+    "${HAL_SOURCE_DIR}/AllocationTracker.cpp"
+    "${HAL_SOURCE_DIR}/Ambilight.cpp"
+    "${HAL_SOURCE_DIR}/AudioReactive.cpp"
+    "${HAL_SOURCE_DIR}/ConfigLoader.cpp"
+    "${HAL_SOURCE_DIR}/EntityHealth.cpp"
+    "${HAL_SOURCE_DIR}/ExternalIntents.cpp"
+    "${HAL_SOURCE_DIR}/FlightRecorder.cpp"
+    "${HAL_SOURCE_DIR}/FrameRecorder.cpp"
+    "${HAL_SOURCE_DIR}/HttpTransport.cpp"
+    "${HAL_SOURCE_DIR}/LampMapping.cpp"
+    "${HAL_SOURCE_DIR}/LightManager.cpp"
+    "${HAL_SOURCE_DIR}/LightSmoother.cpp"
+    "${HAL_SOURCE_DIR}/Logger.cpp"
+    "${HAL_SOURCE_DIR}/Metrics.cpp"
+    "${HAL_SOURCE_DIR}/MetricsServer.cpp"
+    "${HAL_SOURCE_DIR}/ModEventTriggers.cpp"
+    "${HAL_SOURCE_DIR}/NetSocket.cpp"
+    "${HAL_SOURCE_DIR}/Pipeline.cpp"
+    "${HAL_SOURCE_DIR}/Profiler.cpp"
+    "${HAL_SOURCE_DIR}/SceneGenerator.cpp"
+    "${HAL_SOURCE_DIR}/SkyrimLightsDB.cpp"
+    "${HAL_SOURCE_DIR}/StartupTiming.cpp"
+    "${HAL_SOURCE_DIR}/Stats.cpp"
+    "${HAL_SOURCE_DIR}/TelemetryPublisher.cpp"
+    "${HAL_SOURCE_DIR}/TraceRecorder.cpp"
+    "${HAL_SOURCE_DIR}/TuningServer.cpp")
+target_include_directories(HomeAssistantLinkCore PUBLIC "${HAL_SOURCE_DIR}")
+target_compile_features(HomeAssistantLinkCore PUBLIC cxx_std_23)
+target_link_libraries(HomeAssistantLinkCore PUBLIC nlohmann_json::nlohmann_json spdlog::spdlog Threads::Threads)
+if(WIN32)
+    target_link_libraries(HomeAssistantLinkCore PUBLIC ws2_32)
+endif()
+
+# The real HA transport needs cpr (always present in the vcpkg plugin build)
+find_package(cpr CONFIG QUIET)
+if(cpr_FOUND)
+    target_sources(HomeAssistantLinkCore PRIVATE "${HAL_SOURCE_DIR}/CprTransport.cpp")
+    target_link_libraries(HomeAssistantLinkCore PUBLIC cpr::cpr)
+endif()
+
+# HTTP/2 (multiplexed) and parallel HTTP/1.1 transport on libcurl's multi interface; cpr brings libcurl along
+find_package(CURL QUIET)
+if(CURL_FOUND)
+    target_sources(HomeAssistantLinkCore PRIVATE "${HAL_SOURCE_DIR}/CurlTransport.cpp")
+    target_link_libraries(HomeAssistantLinkCore PUBLIC CURL::libcurl)
+    target_compile_definitions(HomeAssistantLinkCore PUBLIC HAL_CURL_TRANSPORT)
+endif()
+
+# The direct Tuya backend needs OpenSSL for the protocol's AES/HMAC (in the vcpkg plugin build, optional for tools)
+find_package(OpenSSL QUIET)
+if(OpenSSL_FOUND)
+    target_sources(HomeAssistantLinkCore PRIVATE
+        "${HAL_SOURCE_DIR}/TuyaProtocol.cpp"
+        "${HAL_SOURCE_DIR}/TuyaTransport.cpp")
+    target_link_libraries(HomeAssistantLinkCore PUBLIC OpenSSL::Crypto)
+    target_compile_definitions(HomeAssistantLinkCore PUBLIC HAL_TUYA_BACKEND)
+endif()
@@ -2,16 +2,35 @@
 #include "RE/Skyrim.h"
 #include "SKSE/API.h"
 #include "SKSE/SKSE.h"
-#include <spdlog/sinks/basic_file_sink.h> 
+#include <spdlog/async.h>
+#include <spdlog/sinks/basic_file_sink.h>
 #include <spdlog/spdlog.h>
 #include "Logger.h"
 #include "ConfigLoader.h"
+#include "AmbilightCapture.h"
+#include "AudioCapture.h"
+#include "CprTransport.h"
+#include "CurlTransport.h"
+#include "FlightRecorder.h"
+#include "FrameRecorder.h"
 #include "LightManager.h"
+#include "Metrics.h"
+#include "MetricsServer.h"
+#include "PapyrusInterface.h"
+#include "GameEvents.h"
 #include "GameState.h"
+#include "PluginAPI.h"
+#include "Profiler.h"
 #include "SkyrimLightsDB.h"
+#include "StartupTiming.h"
+#include "TraceRecorder.h"
+#include "TuningServer.h"
+#include "TuyaTransport.h"
 
 const std::string PLUGIN_NAME_STR = "HomeAssistantLink";  // Use a string constant for the plugin name
 const std::string LOG_FILE_NAME = PLUGIN_NAME_STR + ".log";  // New dedicated log file name
+const size_t LOG_QUEUE_SIZE = 8192;  // Async log queue length; the oldest lines are dropped when full
+constexpr std::chrono::milliseconds EXPORT_TICK_PERIOD{EXPORT_TICK_MS};  // Export loop period (5 Hz)
 
 // Global atomic flag to track if the data export thread is already running
 std::atomic<bool> g_threadRunning = false;
@@ -24,15 +43,31 @@ void PeriodicGameDataExportThread() {
         return;
     }
 
+    SetTraceThreadName("export");
     LogToFile_Info("Periodic Game Data Export Thread started.");
     LogToConsole("HomeAssistantLink: Periodic Game Data Export Thread started.");  // This one should always appear
     NotifyIngame("HomeAssistantLink: Periodic Game Data Export Thread started.");  // This one should always appear
 
     std::this_thread::sleep_for(std::chrono::seconds(5));  // Initial delay
 
+    // With Sending.Stagger the calls take up most of the tick, so ticks start on a fixed schedule to keep the rate;
+    // a tick that overruns starts the next one right away instead of queueing up missed ones. Otherwise the loop
+    // idles a full period after each tick as it always has.
+    SetSendTickPeriod(EXPORT_TICK_PERIOD);
+    auto nextTick = std::chrono::steady_clock::now();
     while (true) {
         ExportGameData();
-        std::this_thread::sleep_for(std::chrono::milliseconds(200));  // Adjust as needed
+        MaybeDumpStageTimings();
+        SampleWorkerCpuTime();
+        ScopedTrace idleTrace("idle", "pipeline");
+        if (g_Send.stagger) {
+            nextTick += EXPORT_TICK_PERIOD;
+            if (auto now = std::chrono::steady_clock::now(); nextTick < now) nextTick = now;
+            std::this_thread::sleep_until(nextTick);
+        } else {
+            std::this_thread::sleep_for(EXPORT_TICK_PERIOD);
+            nextTick = std::chrono::steady_clock::now();
+        }
     }
     g_threadRunning.store(false);
 }
@@ -41,9 +76,17 @@ void PeriodicGameDataExportThread() {
 SKSEPluginLoad(const SKSE::LoadInterface *skse) {
     // 1. Initialize SKSE API first. This is still necessary for other SKSE services.
     SKSE::Init(skse);
-    //SKSE::GetPapyrusInterface()->Register(HALPapyrus::Register);
+    SKSE::GetPapyrusInterface()->Register(HALPapyrus::Register);
+    SetGameOutput(
+        [](const char *message) {
+            if (auto console = RE::ConsoleLog::GetSingleton()) {
+                console->Print(message);
+            }
+        },
+        [](const char *message) { RE::DebugNotification(message, nullptr); });
 
     // 2. Set up our custom spdlog logger
+    ScopedStartupTimer loggerTimer(StartupPhase::LoggerSetup);
     try {
         auto logsFolder = SKSE::log::log_directory();  // Get default SKSE log directory path
         if (logsFolder) {
@@ -53,14 +96,16 @@ SKSEPluginLoad(const SKSE::LoadInterface *skse) {
             // Create a file sink for our specific log file (true to truncate on start)
             auto file_sink = std::make_shared<spdlog::sinks::basic_file_sink_mt>(logFilePath.string(), true);
 
-            // Create our logger with the file sink. Use PLUGIN_NAME_STR as the logger name.
-            // Set the log level. spdlog::level::trace will show everything.
-            // You can change this to spdlog::level::debug, spdlog::level::info, etc.
-            g_plugin_logger = std::make_shared<spdlog::logger>(PLUGIN_NAME_STR, file_sink);
-            g_plugin_logger->set_level(spdlog::level::trace);
+            // Lines are handed to a background thread through a bounded queue, so logging never blocks the
+            // export loop on disk I/O. When the queue is full the oldest lines are dropped instead of stalling.
+            spdlog::init_thread_pool(LOG_QUEUE_SIZE, 1);
+            g_plugin_logger = std::make_shared<spdlog::async_logger>(PLUGIN_NAME_STR, file_sink, spdlog::thread_pool(),
+                                                                     spdlog::async_overflow_policy::overrun_oldest);
+            g_plugin_logger->set_level(spdlog::level::info);  // Raised to debug by ApplyLogLevel() if DebugMode is on
 
-            // Flush messages immediately for easier debugging. Remove this in release builds for performance.
-            g_plugin_logger->flush_on(spdlog::level::trace);
+            // Warnings and errors are flushed right away, everything else periodically.
+            g_plugin_logger->flush_on(spdlog::level::warn);
+            spdlog::flush_every(std::chrono::seconds(2));
 
             // Optionally register it with spdlog's global registry (not strictly necessary if only you use it)
             spdlog::register_logger(g_plugin_logger);
@@ -85,6 +130,8 @@ SKSEPluginLoad(const SKSE::LoadInterface *skse) {
                 .c_str());
     }
 
+    loggerTimer.Stop();
+
     LogToFile_Info("Plugin loading...");
     LogToFile_Info("SKSE API initialized.");
 
@@ -92,17 +139,46 @@ SKSEPluginLoad(const SKSE::LoadInterface *skse) {
     if (!LoadConfiguration()) {
         LogToFile_Error("Failed to load configuration. Plugin will not function correctly.");
     }
+    ApplyLogLevel();
+    std::unique_ptr<ILightTransport> haTransport;
+    if (g_HA_HTTP2) {
+        haTransport = std::make_unique<CurlTransport>(g_HA_URL, g_HA_TOKEN, true);
+    } else {
+        haTransport = std::make_unique<CprTransport>(g_HA_URL, g_HA_TOKEN);
+    }
+    if (g_Tuya.enabled && !g_Tuya.devices.empty()) {
+        haTransport = std::make_unique<TuyaTransport>(std::move(haTransport), g_Tuya);
+    }
+    SetLightTransport(std::move(haTransport));
+
+    StartMetricsServer(static_cast<std::uint16_t>(g_Diagnostics.metrics_port));
+    StartTuningServer(static_cast<std::uint16_t>(g_Diagnostics.tuning_port));
+    if (auto logsFolder = SKSE::log::log_directory()) {
+        ConfigureFlightRecorder(static_cast<size_t>(g_Diagnostics.flight_recorder_frames), *logsFolder);
+        if (g_Diagnostics.record_frames) {
+            StartFrameRecording(MakeFrameRecordingPath(*logsFolder));
+        }
+    }
 
     std::string lightsJsonPath = "SKSE/Plugins/lights.json";  // Adjust as needed!
     if (!LoadSkyrimLightsDatabase()) {
         LogToFile_Error("Failed to load Skyrim light definitions database. Proximity triggers will not work.");
     }
+    LogToFile_Info(FormatStartupTimings());
 
 
+    // Other SKSE plugins can request our C++ interface to submit light intents
+    RegisterPluginAPI();
+
     LogToFile_Info("Registering messaging listener.");
 
     // Register your data export thread to start when a save game is loaded (kPostLoadGame)
     SKSE::GetMessagingInterface()->RegisterListener([](SKSE::MessagingInterface::Message *message) {
+        if (message->type == SKSE::MessagingInterface::kDataLoaded) {
+            RegisterGameEventSinks();
+            if (g_Ambilight.enabled) InstallAmbilightCapture();
+            if (g_AudioReactive.enabled) StartAudioCapture();
+        }
         if (message->type == SKSE::MessagingInterface::kPostLoadGame) {
             if (!g_threadRunning.load()) {  // Check if thread is NOT already running
                 LogToFile_Info("Game loaded. Starting Home Assistant communication thread.");
@@ -0,0 +1,123 @@
+// Runs a WAV file through the audio-reactive DSP (AudioReactive.h) the way the capture thread does, to check and
+// tune band levels, transients and the resulting layer outputs without the game.
+// Usage: HomeAssistantLink_audio <file.wav> [options]
+//   --config <file>     AudioReactive settings (block size, floor, envelopes, curves) from a HomeAssistantLink.json
+//   --chunk <frames>    Frames per capture packet (default 480 = 10 ms at 48 kHz)
+//   --summary           Only print the summary, not one CSV row per block
+//
+// CSV columns: time of the block end, level and transient per band, brightness added by the intensity layer and
+// the flicker amplitude. The summary (stderr) gives DSP time per block and how much faster than real time it ran.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include "AudioReactive.h"
+#include "ConfigLoader.h"
+
+namespace {
+    struct Options {
+        std::string wav;
+        std::string config;
+        int chunk = 480;
+        bool summary = false;
+    };
+
+    void PrintUsage(const char* exe) {
+        std::fprintf(stderr,
+                     "Usage: %s <file.wav> [--config <HomeAssistantLink.json>] [--chunk <frames>] [--summary]\n", exe);
+    }
+
+    bool ParseOptions(int argc, char** argv, Options& options) {
+        for (int i = 1; i < argc; ++i) {
+            std::string arg = argv[i];
+            bool hasValue = i + 1 < argc;
+            if (arg == "--config" && hasValue) {
+                options.config = argv[++i];
+            } else if (arg == "--chunk" && hasValue) {
+                options.chunk = std::atoi(argv[++i]);
+            } else if (arg == "--summary") {
+                options.summary = true;
+            } else if (options.wav.empty() && arg.rfind("--", 0) != 0) {
+                options.wav = arg;
+            } else {
+                return false;
+            }
+        }
+        return !options.wav.empty() && options.chunk > 0;
+    }
+}
+
+int main(int argc, char** argv) {
+    Options options;
+    if (!ParseOptions(argc, argv, options)) {
+        PrintUsage(argv[0]);
+        return 2;
+    }
+    if (!options.config.empty() && !LoadConfigurationFromFile(options.config)) {
+        std::fprintf(stderr, "Failed to load config %s\n", options.config.c_str());
+        return 1;
+    }
+
+    std::vector<float> samples;
+    int sampleRate = 0, channels = 0;
+    if (!LoadWavFile(options.wav, samples, sampleRate, channels)) {
+        std::fprintf(stderr, "%s: not a 16/24-bit PCM or 32-bit float WAV file\n", options.wav.c_str());
+        return 1;
+    }
+
+    AudioBandAnalyzer analyzer;
+    analyzer.Configure(sampleRate, g_AudioReactive);
+    if (!options.summary) {
+        std::printf("time_ms");
+        for (const char* kind : {"level", "transient"}) {
+            for (size_t b = 0; b < AUDIO_BAND_COUNT; ++b) {
+                std::printf(",%s_%s", kind, GetAudioBandName(static_cast<AudioBand>(b)));
+            }
+        }
+        std::printf(",intensity,flicker\n");
+    }
+
+    size_t frames = samples.size() / static_cast<size_t>(channels);
+    size_t hop = analyzer.GetBlockSize() / 2;
+    size_t blocks = 0, framesPushed = 0;
+    std::chrono::nanoseconds dspTime{0}, maxChunkTime{0};
+    while (framesPushed < frames) {
+        size_t count = std::min(static_cast<size_t>(options.chunk), frames - framesPushed);
+        auto start = std::chrono::steady_clock::now();
+        int analyzed = analyzer.Push(samples.data() + framesPushed * channels, count, channels);
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        dspTime += elapsed;
+        maxChunkTime = std::max(maxChunkTime, std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed));
+        framesPushed += count;
+        if (analyzed == 0) continue;
+
+        // Only the last block of a packet is published, as in the plugin
+        blocks += static_cast<size_t>(analyzed);
+        if (options.summary) continue;
+        const AudioBands& bands = analyzer.GetBands();
+        double timeMs = 1000.0 * static_cast<double>(hop * (blocks + 1)) / sampleRate;
+        std::printf("%.1f", timeMs);
+        for (float v : bands.level) std::printf(",%.3f", v);
+        for (float v : bands.transient) std::printf(",%.3f", v);
+        float intensity = EvaluateAudioCurve(g_AudioReactive.intensity_curve,
+                                             bands.level[static_cast<size_t>(g_AudioReactive.intensity_band)]);
+        float flicker = EvaluateAudioCurve(g_AudioReactive.flicker_curve,
+                                           bands.transient[static_cast<size_t>(g_AudioReactive.flicker_band)]);
+        std::printf(",%.1f,%.1f\n", intensity, flicker);
+    }
+
+    double audioSeconds = static_cast<double>(frames) / sampleRate;
+    double dspSeconds = std::chrono::duration<double>(dspTime).count();
+    std::fprintf(stderr,
+                 "%s: %.1f s, %d Hz, %d channels, %zu blocks of %zu samples\n"
+                 "DSP: %.2f us per block, %.2f us max per packet, %.0fx real time\n",
+                 options.wav.c_str(), audioSeconds, sampleRate, channels, blocks, analyzer.GetBlockSize(),
+                 blocks ? 1e6 * dspSeconds / static_cast<double>(blocks) : 0.0,
+                 std::chrono::duration<double, std::micro>(maxChunkTime).count(),
+                 dspSeconds > 0.0 ? audioSeconds / dspSeconds : 0.0);
+    return 0;
+}
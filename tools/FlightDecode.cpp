@@ -0,0 +1,132 @@
+// Decoder for flight recorder dumps (HomeAssistantLink_flight_*.bin).
+// Usage: HomeAssistantLink_flightdecode <dump.bin> [--csv]
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "FlightRecorderFormat.h"
+
+using namespace FlightRecorder;
+
+namespace {
+    const char* OutcomeName(std::uint8_t outcome) {
+        switch (static_cast<CommandOutcome>(outcome)) {
+            case CommandOutcome::None:
+                return "-";
+            case CommandOutcome::Sent:
+                return "sent";
+            case CommandOutcome::Deduped:
+                return "dedup";
+            case CommandOutcome::Failed:
+                return "FAILED";
+            case CommandOutcome::Quarantined:
+                return "quarantined";
+            case CommandOutcome::Coalesced:
+                return "coalesced";
+        }
+        return "?";
+    }
+
+    std::string DecisionName(std::uint8_t decision) {
+        if (decision & kDecisionInherit) return "inherit";
+        if (decision & kDecisionScene) return "scene";
+        if (decision & kDecisionFlicker) return "flicker";
+        return "static";
+    }
+
+    std::string FlagString(std::uint32_t flags) {
+        std::string out;
+        if (flags & kInCombat) out += "C";
+        if (flags & kInterior) out += "I";
+        if (flags & kTorchEquipped) out += "T";
+        if (flags & kIntentsActive) out += "X";
+        return out.empty() ? "-" : out;
+    }
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        std::fprintf(stderr, "Usage: %s <dump.bin> [--csv]\n", argv[0]);
+        return 2;
+    }
+    bool csv = argc > 2 && std::strcmp(argv[2], "--csv") == 0;
+
+    std::ifstream in(argv[1], std::ios::binary);
+    if (!in) {
+        std::fprintf(stderr, "Cannot open %s\n", argv[1]);
+        return 1;
+    }
+
+    FlightDumpHeader header{};
+    in.read(reinterpret_cast<char*>(&header), sizeof(header));
+    if (!in || header.magic != DUMP_MAGIC) {
+        std::fprintf(stderr, "Not a flight recorder dump\n");
+        return 1;
+    }
+    if (header.version != DUMP_VERSION || header.frameSize < sizeof(FlightFrame)) {
+        std::fprintf(stderr, "Unsupported dump version %u (frame size %u)\n", header.version, header.frameSize);
+        return 1;
+    }
+
+    std::vector<std::string> lamps(header.lampCount);
+    for (auto& name : lamps) {
+        char buffer[ENTITY_ID_SIZE + 1] = {};
+        in.read(buffer, ENTITY_ID_SIZE);
+        name = buffer;
+    }
+
+    header.reason[sizeof(header.reason) - 1] = '\0';
+    if (!csv) {
+        std::printf("Dump reason: %s, %u frames, %u lamps\n", header.reason, header.frameCount, header.lampCount);
+        for (size_t i = 0; i < lamps.size(); ++i) std::printf("  lamp %zu = %s\n", i, lamps[i].c_str());
+        std::printf("flags: C=combat I=interior T=torch X=plugin intents\n\n");
+    } else {
+        std::printf("seq,t_ms,hour,x,y,z,yaw,flags,lights,scenario,tick_us,apply_us,requests");
+        for (size_t i = 0; i < lamps.size(); ++i) {
+            std::printf(",lamp%zu_rgb,lamp%zu_bri,lamp%zu_decision,lamp%zu_outcome,lamp%zu_status,lamp%zu_latency_us", i,
+                        i, i, i, i, i);
+        }
+        std::printf("\n");
+    }
+
+    std::vector<char> raw(header.frameSize);
+    std::uint64_t firstTimestamp = 0;
+    for (std::uint32_t n = 0; n < header.frameCount; ++n) {
+        in.read(raw.data(), header.frameSize);
+        if (!in) {
+            std::fprintf(stderr, "Truncated dump after %u frames\n", n);
+            return 1;
+        }
+        FlightFrame f;
+        std::memcpy(&f, raw.data(), sizeof(f));
+        if (n == 0) firstTimestamp = f.timestamp_us;
+        double t_ms = static_cast<double>(f.timestamp_us - firstTimestamp) / 1000.0;
+
+        if (csv) {
+            std::printf("%u,%.1f,%.2f,%.0f,%.0f,%.0f,%.3f,%s,%u,%d,%u,%u,%u", f.sequence, t_ms, f.gameHour, f.x, f.y,
+                        f.z, f.yaw, FlagString(f.flags).c_str(), f.nearbyLights, f.scenarioIndex, f.tickDuration_us,
+                        f.applyDuration_us, f.requestCount);
+            for (size_t i = 0; i < lamps.size(); ++i) {
+                const FlightLamp& l = f.lamps[i];
+                std::printf(",%02x%02x%02x,%u,%s,%s,%d,%u", l.r, l.g, l.b, l.brightness_pct,
+                            DecisionName(l.decision).c_str(), OutcomeName(l.outcome), l.status, l.latency_us);
+            }
+            std::printf("\n");
+            continue;
+        }
+
+        std::printf("#%-6u +%9.1f ms  hour %5.2f  yaw %5.2f  flags %-4s lights %3u  scenario %3d", f.sequence, t_ms,
+                    f.gameHour, f.yaw, FlagString(f.flags).c_str(), f.nearbyLights, f.scenarioIndex);
+        std::printf("  tick %7u us  apply %7u us\n", f.tickDuration_us, f.applyDuration_us);
+        for (size_t i = 0; i < lamps.size(); ++i) {
+            const FlightLamp& l = f.lamps[i];
+            std::printf("    %-28s #%02x%02x%02x %3u%%  %-8s %-6s status %3d  %7u us\n", lamps[i].c_str(), l.r, l.g,
+                        l.b, l.brightness_pct, DecisionName(l.decision).c_str(), OutcomeName(l.outcome), l.status,
+                        l.latency_us);
+        }
+    }
+    return 0;
+}
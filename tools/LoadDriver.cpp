@@ -0,0 +1,349 @@
+// Load driver for the Home Assistant send path: feeds synthetic frames through RunLightPipeline and
+// ApplyLightStates at a fixed rate against a (mock) Home Assistant and reports what the send path achieved.
+// Usage: HomeAssistantLink_loaddriver [options]
+//   --url <url>         Home Assistant base URL, plain http (default http://127.0.0.1:8123 = HomeAssistantLink_mockha)
+//   --token <token>     Access token (default "mock")
+//   --config <file>     Use lamps, scenarios and day/night cycle from a HomeAssistantLink.json (default: synthetic)
+//   --lamps <n>         Synthetic lamp count when no config is given (default 4)
+//   --lights <n>        In-game lights orbiting the player (default 16)
+//   --rate <hz>         Target frame rate (default 5, the export thread's tick rate)
+//   --duration <s>      Test length in seconds (default 30)
+//   --flicker <n>       Give the first n lamps the animated "flicker" effect, which is sent every frame
+//   --transport <t>     builtin: one HTTP/1.1 keep-alive connection, calls one after another (default);
+//                       http1: libcurl, each frame's calls in parallel over HTTP/1.1 keep-alive connections;
+//                       http2: libcurl, each frame's calls as streams on one HTTP/2 connection (h2c for http://,
+//                       which HomeAssistantLink_mockha speaks when built with nghttp2)
+//   --tuya <v>          Drive the synthetic lamps as Tuya bulbs of protocol 3.3, 3.4 or 3.5 through the direct backend
+//                       (HomeAssistantLink_mocktuya with the same --devices/--version); a config's "Tuya" section is
+//                       used as is
+//   --coalesce <ms>     Sending.CoalesceWindowMs: merge a lamp's changes within the window into one trailing update
+//   --stagger <span>    Sending.Stagger: spread each frame's calls over this fraction (0..1) of the frame period
+//
+// A frame is one export tick: pipeline plus all HA calls. Frames run back to back on one thread like in the
+// plugin, so a slow Home Assistant lowers the achieved rate instead of queueing work.
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "ConfigLoader.h"
+#ifdef HAL_CURL_TRANSPORT
+#include "CurlTransport.h"
+#endif
+#include "EntityHealth.h"
+#include "HttpTransport.h"
+#include "LightManager.h"
+#include "Metrics.h"
+#include "Pipeline.h"
+#include "SceneGenerator.h"
+#include "ToolStats.h"
+#ifdef HAL_TUYA_BACKEND
+#include "TuyaTransport.h"
+#endif
+
+namespace {
+    struct Options {
+        std::string url = "http://127.0.0.1:8123";
+        std::string token = "mock";
+        std::string config;
+        int lamps = 4;
+        int lights = 16;
+        double rate = 5.0;
+        double duration = 30.0;
+        int flicker = 0;
+        std::string transport = "builtin";
+        std::string tuya;
+        int coalesceMs = -1;  // -1 = keep the config's value
+        float staggerSpan = -1.0f;
+    };
+
+    void PrintUsage(const char* exe) {
+        std::fprintf(stderr,
+                     "Usage: %s [--url <http://host:port>] [--token <token>] [--config <HomeAssistantLink.json>] "
+                     "[--lamps <n>] [--lights <n>] [--rate <hz>] [--duration <s>] [--flicker <n>] "
+                     "[--transport builtin|http1|http2] [--tuya 3.3|3.4|3.5] [--coalesce <ms>] [--stagger <span>]\n",
+                     exe);
+    }
+
+    bool ParseOptions(int argc, char** argv, Options& options) {
+        for (int i = 1; i < argc; ++i) {
+            std::string arg = argv[i];
+            bool hasValue = i + 1 < argc;
+            if (arg == "--url" && hasValue) {
+                options.url = argv[++i];
+            } else if (arg == "--token" && hasValue) {
+                options.token = argv[++i];
+            } else if (arg == "--config" && hasValue) {
+                options.config = argv[++i];
+            } else if (arg == "--lamps" && hasValue) {
+                options.lamps = std::atoi(argv[++i]);
+            } else if (arg == "--lights" && hasValue) {
+                options.lights = std::atoi(argv[++i]);
+            } else if (arg == "--rate" && hasValue) {
+                options.rate = std::atof(argv[++i]);
+            } else if (arg == "--duration" && hasValue) {
+                options.duration = std::atof(argv[++i]);
+            } else if (arg == "--flicker" && hasValue) {
+                options.flicker = std::atoi(argv[++i]);
+            } else if (arg == "--transport" && hasValue) {
+                options.transport = argv[++i];
+            } else if (arg == "--tuya" && hasValue) {
+                options.tuya = argv[++i];
+            } else if (arg == "--coalesce" && hasValue) {
+                options.coalesceMs = std::atoi(argv[++i]);
+            } else if (arg == "--stagger" && hasValue) {
+                options.staggerSpan = static_cast<float>(std::atof(argv[++i]));
+            } else {
+                return false;
+            }
+        }
+        bool knownTuya =
+            options.tuya.empty() || options.tuya == "3.3" || options.tuya == "3.4" || options.tuya == "3.5";
+        bool knownTransport =
+            options.transport == "builtin" || options.transport == "http1" || options.transport == "http2";
+        return knownTuya && knownTransport && options.lamps > 0 && options.lights >= 0 && options.rate > 0.0 &&
+               options.duration > 0.0;
+    }
+
+    // Forwards to the real transport and keeps every request's latency and status for the report
+    class RecordingTransport final : public ILightTransport {
+    public:
+        explicit RecordingTransport(std::unique_ptr<ILightTransport> inner) : inner(std::move(inner)) {}
+
+        TransportResponse PostJson(const std::string& path, const std::string& body) override {
+            auto dispatched = std::chrono::steady_clock::now();
+            TransportResponse r = inner->PostJson(path, body);
+            Record(r, dispatched);
+            return r;
+        }
+
+        std::vector<TransportResponse> PostJsonBatch(const std::vector<TransportRequest>& requests) override {
+            auto dispatched = std::chrono::steady_clock::now();
+            std::vector<TransportResponse> responses = inner->PostJsonBatch(requests);
+            for (const TransportResponse& r : responses) Record(r, dispatched);
+            return responses;
+        }
+
+        int TakeFrameRequestCount() {
+            std::lock_guard lock(mutex);
+            return std::exchange(requestsThisFrame, 0);
+        }
+
+        std::mutex mutex;
+        std::vector<double> latenciesMs;
+        std::map<long, std::uint64_t> statusCounts;
+        std::uint64_t connectionsOpened = 0;
+        std::vector<std::chrono::steady_clock::time_point> dispatchTimes;  // Handed to the transport (batch start)
+
+    private:
+        void Record(const TransportResponse& r, std::chrono::steady_clock::time_point dispatched) {
+            std::lock_guard lock(mutex);
+            dispatchTimes.push_back(dispatched);
+            latenciesMs.push_back(r.elapsed * 1000.0);
+            ++statusCounts[r.status_code];
+            if (r.new_connection) ++connectionsOpened;
+            ++requestsThisFrame;
+        }
+
+        std::unique_ptr<ILightTransport> inner;
+        int requestsThisFrame = 0;
+    };
+
+    void PrintDistribution(const char* label, const std::vector<double>& valuesMs) {
+        std::fprintf(stderr, "%-18s p50 %7.2f  p90 %7.2f  p99 %7.2f  max %7.2f ms  (%zu samples)\n", label,
+                     Percentile(valuesMs, 0.50), Percentile(valuesMs, 0.90), Percentile(valuesMs, 0.99),
+                     Percentile(valuesMs, 1.0), valuesMs.size());
+    }
+
+    using TimePoint = std::chrono::steady_clock::time_point;
+
+    // Calls per 10 ms bin over the run: the peak bin against the average shows how bursty the sending is
+    void PrintDispatchBurstiness(const std::vector<TimePoint>& times, TimePoint start, TimePoint end) {
+        constexpr auto BIN = std::chrono::milliseconds(10);
+        size_t binCount = static_cast<size_t>((end - start) / BIN) + 1;
+        std::vector<int> bins(binCount);
+        for (auto t : times) {
+            if (t >= start) ++bins[std::min(static_cast<size_t>((t - start) / BIN), binCount - 1)];
+        }
+        int peak = bins.empty() ? 0 : *std::max_element(bins.begin(), bins.end());
+        double average = static_cast<double>(times.size()) / static_cast<double>(binCount);
+        std::fprintf(stderr, "Dispatch:          peak %d calls per 10 ms, average %.2f, peak/average %.1f\n", peak,
+                     average, average > 0.0 ? peak / average : 0.0);
+    }
+
+    void UseLoadConfig(const Options& options) {
+        UseSyntheticConfig(options.lamps, "light.load_");
+        RegisterEntityHealth(g_RealLamps);
+
+        // Same ids and keys as HomeAssistantLink_mocktuya's synthetic bulbs
+        g_Tuya.devices.clear();
+        g_Tuya.enabled = !options.tuya.empty();
+        if (!g_Tuya.enabled) return;
+        int version = options.tuya == "3.5" ? 35 : options.tuya == "3.4" ? 34 : 33;
+        for (int i = 0; i < options.lamps; ++i) {
+            TuyaDeviceConfig device;
+            device.entity_id = "light.load_" + std::to_string(i);
+            device.address = "127.0.0.1";
+            device.port = 6668 + i;
+            device.device_id = "mock" + std::to_string(i);
+            device.local_key = "0123456789abcdef";
+            device.version = version;
+            g_Tuya.devices.push_back(device);
+        }
+    }
+
+    // Lights circle the player at different radii and speeds, so lamp states change from frame to frame
+    FrameInput MakeFrame(int frameIndex, int lightCount, double rate) {
+        FrameInput frame;
+        float t = static_cast<float>(frameIndex / rate);
+        frame.gameHour = std::fmod(18.0f + t / 10.0f, 24.0f);
+        frame.playerYaw = 0.3f * t;
+        for (int i = 0; i < lightCount; ++i) {
+            float radius = 100.0f + 40.0f * static_cast<float>(i % 8);
+            float angle = t * (0.5f + 0.1f * static_cast<float>(i % 5)) + static_cast<float>(i);
+            InGameLight light;
+            light.skyrim_pos = {radius * std::cos(angle), radius * std::sin(angle), 50.0f};
+            light.type = i % 2 == 0 ? "fire" : "other";
+            light.color_r = 255;
+            light.color_g = 120 + (i * 17) % 100;
+            light.color_b = 40;
+            light.intensity = 1.0f;
+            frame.lights.push_back(light);
+        }
+        return frame;
+    }
+}
+
+int main(int argc, char** argv) {
+    Options options;
+    if (!ParseOptions(argc, argv, options)) {
+        PrintUsage(argv[0]);
+        return 2;
+    }
+
+    if (!options.config.empty()) {
+        if (!LoadConfigurationFromFile(options.config)) {
+            std::fprintf(stderr, "Failed to load config %s\n", options.config.c_str());
+            return 1;
+        }
+    } else {
+        UseLoadConfig(options);
+    }
+    g_HA_URL = options.url;
+    g_HA_TOKEN = options.token;
+    if (options.coalesceMs >= 0) g_Send.coalesce_window_ms = options.coalesceMs;
+    if (options.staggerSpan >= 0.0f) {
+        g_Send.stagger = options.staggerSpan > 0.0f;
+        g_Send.stagger_span = std::min(options.staggerSpan, 1.0f);
+    }
+
+    std::unique_ptr<ILightTransport> http;
+    if (options.transport == "builtin") {
+        http = std::make_unique<HttpTransport>(options.url, options.token);
+    } else {
+#ifdef HAL_CURL_TRANSPORT
+        http = std::make_unique<CurlTransport>(options.url, options.token, options.transport == "http2");
+#else
+        std::fprintf(stderr, "Built without libcurl: only --transport builtin\n");
+        return 1;
+#endif
+    }
+    if (g_Tuya.enabled && !g_Tuya.devices.empty()) {
+#ifdef HAL_TUYA_BACKEND
+        http = std::make_unique<TuyaTransport>(std::move(http), g_Tuya);
+#else
+        std::fprintf(stderr, "Built without OpenSSL: no direct Tuya backend\n");
+        return 1;
+#endif
+    }
+    auto transport = std::make_unique<RecordingTransport>(std::move(http));
+    RecordingTransport* recorder = transport.get();
+    SetLightTransport(std::move(transport));
+
+    const auto period = std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+        std::chrono::duration<double>(1.0 / options.rate));
+    SetSendTickPeriod(period);
+    const int frameTarget = static_cast<int>(options.duration * options.rate);
+    std::vector<double> frameTimesMs;
+    std::vector<int> requestsPerFrame;
+    int overruns = 0;
+
+    std::fprintf(stderr, "Driving %s (%s): %zu lamps, %d lights, %.1f Hz for %.0f s\n", options.url.c_str(),
+                 options.transport.c_str(), g_RealLamps.size(), options.lights, options.rate, options.duration);
+
+    LightSmoother smoother;
+    auto start = std::chrono::steady_clock::now();
+    auto nextFrame = start;
+    for (int i = 0; i < frameTarget; ++i) {
+        std::this_thread::sleep_until(nextFrame);
+        auto frameStart = std::chrono::steady_clock::now();
+
+        FrameResult result = RunLightPipeline(MakeFrame(i, options.lights, options.rate), smoother);
+        for (int lamp = 0; lamp < options.flicker && lamp < static_cast<int>(result.lampStates.size()); ++lamp)
+            result.lampStates[lamp].effect = "flicker";
+        ApplyLightStates(result.lampStates);
+
+        auto frameEnd = std::chrono::steady_clock::now();
+        frameTimesMs.push_back(std::chrono::duration<double, std::milli>(frameEnd - frameStart).count());
+        requestsPerFrame.push_back(recorder->TakeFrameRequestCount());
+
+        nextFrame += period;
+        if (frameEnd > nextFrame) {
+            // Behind schedule: start the next frame right away, like the export thread would
+            ++overruns;
+            nextFrame = frameEnd;
+        }
+    }
+    // The last frame owns its whole period unless it overran
+    auto end = std::max(std::chrono::steady_clock::now(), nextFrame);
+    double seconds = std::chrono::duration<double>(end - start).count();
+
+    std::vector<double> requestsAsDouble(requestsPerFrame.begin(), requestsPerFrame.end());
+    double totalRequests = 0.0;
+    for (double r : requestsAsDouble) totalRequests += r;
+
+    std::fprintf(stderr, "Frames:            %d in %.2f s = %.2f Hz achieved (target %.2f Hz), %d overran the period\n",
+                 frameTarget, seconds, seconds > 0.0 ? frameTarget / seconds : 0.0, options.rate, overruns);
+    std::fprintf(stderr, "Requests:          %.0f total, %.2f per frame (max %.0f), %.1f req/s\n", totalRequests,
+                 frameTarget > 0 ? totalRequests / frameTarget : 0.0, Percentile(requestsAsDouble, 1.0),
+                 seconds > 0.0 ? totalRequests / seconds : 0.0);
+    PrintDistribution("Frame (end-to-end)", frameTimesMs);
+    std::lock_guard lock(recorder->mutex);
+    PrintDistribution("Request", recorder->latenciesMs);
+    std::string statuses;
+    for (const auto& [status, count] : recorder->statusCounts) {
+        statuses += " " + (status == 0 ? std::string("transport-error") : std::to_string(status)) + "=" +
+                    std::to_string(count);
+    }
+    std::fprintf(stderr, "Status:           %s\n", statuses.empty() ? " (none)" : statuses.c_str());
+    std::fprintf(stderr, "Connections:       %llu opened\n",
+                 static_cast<unsigned long long>(recorder->connectionsOpened));
+    std::fprintf(stderr, "Held back:         %llu deduped, %llu coalesced (window %d ms)\n",
+                 static_cast<unsigned long long>(g_Metrics.dedup_suppressed.load()),
+                 static_cast<unsigned long long>(g_Metrics.coalesced.load()), g_Send.coalesce_window_ms);
+    PrintDispatchBurstiness(recorder->dispatchTimes, start, end);
+    if (std::uint64_t gaps = g_Metrics.send_gaps.load(); gaps != 0) {
+        std::fprintf(stderr, "Stagger spacing:   %.2f ms between slots (planned %.2f ms), %llu gaps\n",
+                     static_cast<double>(g_Metrics.send_gap_us.load()) / gaps / 1000.0,
+                     static_cast<double>(g_Metrics.send_gap_planned_us.load()) / gaps / 1000.0,
+                     static_cast<unsigned long long>(gaps));
+    }
+    for (const EntityHealth& h : GetEntityHealth()) {
+        std::uint64_t quarantines = h.quarantines.load(std::memory_order_relaxed);
+        if (quarantines == 0) continue;
+        std::fprintf(stderr, "Quarantined:       %s %llu time(s), %llu commands skipped%s\n", h.entity_id.c_str(),
+                     static_cast<unsigned long long>(quarantines),
+                     static_cast<unsigned long long>(h.skipped.load(std::memory_order_relaxed)),
+                     h.IsQuarantined() ? " (still quarantined)" : "");
+    }
+    return 0;
+}
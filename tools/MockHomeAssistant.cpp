@@ -0,0 +1,617 @@
+// Stand-in Home Assistant REST server for load tests: accepts the service calls HomeAssistantLink sends, delays
+// and fails them on purpose, and reports what it saw. Never point the load driver at a real house.
+// Usage: HomeAssistantLink_mockha [options]
+//   --port <n>                   Listen port (default 8123, like Home Assistant)
+//   --bind <address>             Listen address (default 127.0.0.1)
+//   --token <token>              Require "Authorization: Bearer <token>" (default: accept anything)
+//   --latency <endpoint>=<dist>  Response delay per endpoint, e.g. light/turn_on=lognormal:40:0.6. Distributions:
+//                                fixed:<ms>, uniform:<min>:<max>, normal:<mean>:<stddev>, lognormal:<median>:<sigma>
+//   --error-rate <endpoint>=<p>  Answer this fraction of calls with HTTP 500
+//   --max-connections <n>        Concurrent connections beyond n get 503 and are closed (default 0 = unlimited)
+//   --log <file>                 Request log as CSV (time_ms,connection,method,path,entity_id,status,delay_ms)
+//   --report <seconds>           Print the summary periodically (default 0 = only at exit)
+//   --duration <seconds>         Exit after this long (default 0 = run until Ctrl+C)
+//   --seed <n>                   Random seed for delays and errors
+//
+// <endpoint> is the service path below /api/services/ (light/turn_on, select/select_option, ...) or * for all.
+// When built with nghttp2, connections that open with the HTTP/2 preface are served as h2c (prior knowledge), with
+// the delays of concurrent streams running in parallel like behind an HTTP/2 reverse proxy.
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <cmath>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <nlohmann/json.hpp>
+#include <optional>
+#include <random>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "NetSocket.h"
+#include "ToolStats.h"
+
+#ifdef HAL_MOCK_HTTP2
+#ifdef _MSC_VER
+#include <BaseTsd.h>
+typedef SSIZE_T ssize_t;  // nghttp2.h expects it
+#endif
+#include <nghttp2/nghttp2.h>
+#endif
+
+namespace {
+    struct DelayDistribution {
+        enum class Kind { Fixed, Uniform, Normal, LogNormal } kind = Kind::Fixed;
+        double a = 0.0;
+        double b = 0.0;
+
+        double Sample(std::mt19937& rng) const {
+            switch (kind) {
+                case Kind::Uniform:
+                    return std::uniform_real_distribution<double>(a, b)(rng);
+                case Kind::Normal:
+                    return std::max(0.0, std::normal_distribution<double>(a, b)(rng));
+                case Kind::LogNormal:
+                    return std::lognormal_distribution<double>(std::log(std::max(a, 0.001)), b)(rng);
+                default:
+                    return a;
+            }
+        }
+    };
+
+    // Unset fields fall back to the "*" entry, then to no delay and no errors
+    struct EndpointBehavior {
+        std::optional<DelayDistribution> delay;
+        std::optional<double> errorRate;
+    };
+
+    struct Options {
+        std::string bind = "127.0.0.1";
+        std::uint16_t port = 8123;
+        std::string token;
+        std::map<std::string, EndpointBehavior> endpoints;  // "*" = default
+        int maxConnections = 0;
+        std::string logFile;
+        int reportSeconds = 0;
+        int durationSeconds = 0;
+        unsigned seed = 1;
+    };
+
+    // What the server saw for one endpoint
+    struct EndpointStats {
+        std::uint64_t requests = 0;
+        std::uint64_t injectedErrors = 0;
+        std::uint64_t unauthorized = 0;
+        std::vector<double> delaysMs;
+    };
+
+    Options g_Options;
+    std::atomic<bool> g_StopRequested{false};
+    std::atomic<int> g_ActiveConnections{0};
+    std::atomic<int> g_PeakConnections{0};
+    std::atomic<std::uint64_t> g_RejectedConnections{0};
+    std::atomic<std::uint64_t> g_AcceptedConnections{0};
+    std::atomic<std::uint64_t> g_Http2Connections{0};
+    std::mutex g_StatsMutex;
+    std::map<std::string, EndpointStats> g_Stats;
+    std::mutex g_LogMutex;
+    FILE* g_Log = nullptr;
+    const auto g_StartTime = std::chrono::steady_clock::now();
+
+    void PrintUsage(const char* exe) {
+        std::fprintf(stderr,
+                     "Usage: %s [--port <n>] [--bind <address>] [--token <token>] [--latency <endpoint>=<dist>]... "
+                     "[--error-rate <endpoint>=<p>]... [--max-connections <n>] [--log <file>] [--report <s>] "
+                     "[--duration <s>] [--seed <n>]\n",
+                     exe);
+    }
+
+    bool ParseDistribution(const std::string& text, DelayDistribution& out) {
+        std::vector<double> values;
+        size_t colon = text.find(':');
+        std::string kind = text.substr(0, colon);
+        while (colon != std::string::npos) {
+            size_t next = text.find(':', colon + 1);
+            values.push_back(std::atof(text.substr(colon + 1, next - colon - 1).c_str()));
+            colon = next;
+        }
+        if (kind == "fixed" && values.size() == 1) {
+            out = {DelayDistribution::Kind::Fixed, values[0], 0.0};
+        } else if (kind == "uniform" && values.size() == 2) {
+            out = {DelayDistribution::Kind::Uniform, values[0], std::max(values[0], values[1])};
+        } else if (kind == "normal" && values.size() == 2) {
+            out = {DelayDistribution::Kind::Normal, values[0], values[1]};
+        } else if (kind == "lognormal" && values.size() == 2) {
+            out = {DelayDistribution::Kind::LogNormal, values[0], values[1]};
+        } else {
+            return false;
+        }
+        return true;
+    }
+
+    // Splits "<endpoint>=<value>"
+    bool SplitEndpointArg(const std::string& arg, std::string& endpoint, std::string& value) {
+        size_t eq = arg.find('=');
+        if (eq == std::string::npos || eq == 0) return false;
+        endpoint = arg.substr(0, eq);
+        value = arg.substr(eq + 1);
+        return true;
+    }
+
+    bool ParseOptions(int argc, char** argv, Options& options) {
+        for (int i = 1; i < argc; ++i) {
+            std::string arg = argv[i];
+            bool hasValue = i + 1 < argc;
+            std::string endpoint, value;
+            if (arg == "--port" && hasValue) {
+                options.port = static_cast<std::uint16_t>(std::atoi(argv[++i]));
+            } else if (arg == "--bind" && hasValue) {
+                options.bind = argv[++i];
+            } else if (arg == "--token" && hasValue) {
+                options.token = argv[++i];
+            } else if (arg == "--latency" && hasValue && SplitEndpointArg(argv[++i], endpoint, value)) {
+                DelayDistribution delay;
+                if (!ParseDistribution(value, delay)) return false;
+                options.endpoints[endpoint].delay = delay;
+            } else if (arg == "--error-rate" && hasValue && SplitEndpointArg(argv[++i], endpoint, value)) {
+                options.endpoints[endpoint].errorRate = std::clamp(std::atof(value.c_str()), 0.0, 1.0);
+            } else if (arg == "--max-connections" && hasValue) {
+                options.maxConnections = std::atoi(argv[++i]);
+            } else if (arg == "--log" && hasValue) {
+                options.logFile = argv[++i];
+            } else if (arg == "--report" && hasValue) {
+                options.reportSeconds = std::atoi(argv[++i]);
+            } else if (arg == "--duration" && hasValue) {
+                options.durationSeconds = std::atoi(argv[++i]);
+            } else if (arg == "--seed" && hasValue) {
+                options.seed = static_cast<unsigned>(std::atoi(argv[++i]));
+            } else {
+                return false;
+            }
+        }
+        return options.port != 0;
+    }
+
+    EndpointBehavior BehaviorFor(const std::string& endpoint) {
+        EndpointBehavior behavior;
+        for (const char* key : {endpoint.c_str(), "*"}) {
+            auto it = g_Options.endpoints.find(key);
+            if (it == g_Options.endpoints.end()) continue;
+            if (!behavior.delay) behavior.delay = it->second.delay;
+            if (!behavior.errorRate) behavior.errorRate = it->second.errorRate;
+        }
+        return behavior;
+    }
+
+    double MillisecondsSinceStart() {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - g_StartTime).count();
+    }
+
+    void SendResponse(SocketHandle client, int status, const char* reason, const std::string& body, bool close) {
+        std::string response = "HTTP/1.1 " + std::to_string(status) + " " + reason +
+                               "\r\nContent-Type: application/json\r\nContent-Length: " +
+                               std::to_string(body.size()) + (close ? "\r\nConnection: close" : "") + "\r\n\r\n" +
+                               body;
+        SendAll(client, response.data(), response.size());
+    }
+
+    struct ParsedRequest {
+        std::string method;
+        std::string path;
+        std::string authorization;
+        std::string body;
+        bool close = false;
+    };
+
+    // Reads one request from a keep-alive connection; leftover bytes stay in buffer. False once the client is gone.
+    bool ReadRequest(SocketHandle client, std::string& buffer, ParsedRequest& request) {
+        auto receiveMore = [&]() {
+            char chunk[4096];
+            long received = ReceiveSome(client, chunk, sizeof(chunk), 30000);
+            if (received <= 0) return false;
+            buffer.append(chunk, static_cast<size_t>(received));
+            return buffer.size() < (1 << 20);
+        };
+        size_t headerEnd;
+        while ((headerEnd = buffer.find("\r\n\r\n")) == std::string::npos) {
+            if (!receiveMore()) return false;
+        }
+
+        std::string head = buffer.substr(0, headerEnd);
+        size_t lineEnd = head.find("\r\n");
+        std::string requestLine = head.substr(0, lineEnd);
+        size_t s1 = requestLine.find(' ');
+        size_t s2 = requestLine.find(' ', s1 + 1);
+        if (s1 == std::string::npos || s2 == std::string::npos) return false;
+        request.method = requestLine.substr(0, s1);
+        request.path = requestLine.substr(s1 + 1, s2 - s1 - 1);
+
+        size_t contentLength = 0;
+        while (lineEnd != std::string::npos && lineEnd < head.size()) {
+            size_t next = head.find("\r\n", lineEnd + 2);
+            std::string line = head.substr(lineEnd + 2, next == std::string::npos ? next : next - lineEnd - 2);
+            lineEnd = next;
+            size_t colon = line.find(':');
+            if (colon == std::string::npos) continue;
+            std::string name = line.substr(0, colon);
+            std::string value = line.substr(std::min(line.size(), colon + 2));
+            std::transform(name.begin(), name.end(), name.begin(), [](unsigned char c) { return std::tolower(c); });
+            if (name == "content-length") contentLength = static_cast<size_t>(std::atoll(value.c_str()));
+            if (name == "authorization") request.authorization = value;
+            if (name == "connection" && (value == "close" || value == "Close")) request.close = true;
+        }
+
+        size_t bodyStart = headerEnd + 4;
+        while (buffer.size() < bodyStart + contentLength) {
+            if (!receiveMore()) return false;
+        }
+        request.body = buffer.substr(bodyStart, contentLength);
+        buffer.erase(0, bodyStart + contentLength);
+        return true;
+    }
+
+    void LogRequest(int connectionId, const ParsedRequest& request, const std::string& entityId, int status,
+                    double delayMs) {
+        if (!g_Log) return;
+        std::lock_guard lock(g_LogMutex);
+        std::fprintf(g_Log, "%.1f,%d,%s,%s,%s,%d,%.1f\n", MillisecondsSinceStart(), connectionId,
+                     request.method.c_str(), request.path.c_str(), entityId.c_str(), status, delayMs);
+    }
+
+    // What to answer to one request, decided when it is complete
+    struct Reply {
+        std::string endpoint;
+        std::string entityId;
+        int status = 200;
+        const char* reason = "OK";
+        std::string body = "[]";
+        double delayMs = 0.0;
+        bool injectedError = false;
+        bool authorized = true;
+    };
+
+    Reply DecideReply(const ParsedRequest& request, std::mt19937& rng) {
+        static const std::string servicePrefix = "/api/services/";
+        std::uniform_real_distribution<double> unit(0.0, 1.0);
+        Reply reply;
+        bool isService = request.method == "POST" && request.path.starts_with(servicePrefix);
+        reply.endpoint = isService ? request.path.substr(servicePrefix.size()) : request.path;
+        if (isService) {
+            auto body = nlohmann::json::parse(request.body, nullptr, false);
+            if (body.is_object() && body.contains("entity_id") && body["entity_id"].is_string())
+                reply.entityId = body["entity_id"].get<std::string>();
+        }
+
+        EndpointBehavior behavior = BehaviorFor(reply.endpoint);
+        reply.delayMs = behavior.delay ? behavior.delay->Sample(rng) : 0.0;
+        reply.authorized = g_Options.token.empty() || request.authorization == "Bearer " + g_Options.token;
+        reply.injectedError = reply.authorized && isService && unit(rng) < behavior.errorRate.value_or(0.0);
+
+        if (!reply.authorized) {
+            reply.status = 401;
+            reply.reason = "Unauthorized";
+            reply.body = "{\"message\":\"Unauthorized\"}";
+        } else if (request.method == "GET" && request.path == "/api/") {
+            reply.body = "{\"message\":\"API running.\"}";
+        } else if (!isService) {
+            reply.status = 404;
+            reply.reason = "Not Found";
+            reply.body = "{\"message\":\"Not found\"}";
+        } else if (reply.injectedError) {
+            reply.status = 500;
+            reply.reason = "Internal Server Error";
+            reply.body = "{\"message\":\"Injected error\"}";
+        }
+        return reply;
+    }
+
+    void RecordReply(int connectionId, const ParsedRequest& request, const Reply& reply) {
+        {
+            std::lock_guard lock(g_StatsMutex);
+            EndpointStats& stats = g_Stats[reply.endpoint];
+            ++stats.requests;
+            if (reply.injectedError) ++stats.injectedErrors;
+            if (!reply.authorized) ++stats.unauthorized;
+            stats.delaysMs.push_back(reply.delayMs);
+        }
+        LogRequest(connectionId, request, reply.entityId, reply.status, reply.delayMs);
+    }
+
+#ifdef HAL_MOCK_HTTP2
+    // --- HTTP/2 (h2c) ---
+
+    constexpr std::string_view H2_PREFACE = "PRI * HTTP/2.0\r\n\r\nSM\r\n\r\n";
+
+    // A reply waiting out its delay; other streams of the connection go on meanwhile
+    struct H2PendingReply {
+        std::chrono::steady_clock::time_point due;
+        std::int32_t streamId;
+        ParsedRequest request;
+        Reply reply;
+    };
+
+    struct H2Connection {
+        SocketHandle client;
+        int connectionId;
+        std::mt19937 rng;
+        std::map<std::int32_t, ParsedRequest> requests;  // Streams still receiving
+        std::map<std::int32_t, std::pair<std::string, size_t>> bodies;  // Response body and bytes sent, per stream
+        std::vector<H2PendingReply> pending;
+    };
+
+    int OnH2BeginHeaders(nghttp2_session*, const nghttp2_frame* frame, void* user) {
+        if (frame->hd.type == NGHTTP2_HEADERS && frame->headers.cat == NGHTTP2_HCAT_REQUEST)
+            static_cast<H2Connection*>(user)->requests[frame->hd.stream_id] = {};
+        return 0;
+    }
+
+    int OnH2Header(nghttp2_session*, const nghttp2_frame* frame, const std::uint8_t* name, size_t nameLength,
+                   const std::uint8_t* value, size_t valueLength, std::uint8_t, void* user) {
+        auto& requests = static_cast<H2Connection*>(user)->requests;
+        auto it = requests.find(frame->hd.stream_id);
+        if (it == requests.end()) return 0;
+        std::string_view key(reinterpret_cast<const char*>(name), nameLength);
+        std::string text(reinterpret_cast<const char*>(value), valueLength);
+        if (key == ":method") it->second.method = std::move(text);
+        if (key == ":path") it->second.path = std::move(text);
+        if (key == "authorization") it->second.authorization = std::move(text);
+        return 0;
+    }
+
+    int OnH2Data(nghttp2_session*, std::uint8_t, std::int32_t streamId, const std::uint8_t* data, size_t length,
+                 void* user) {
+        auto& requests = static_cast<H2Connection*>(user)->requests;
+        auto it = requests.find(streamId);
+        if (it != requests.end()) it->second.body.append(reinterpret_cast<const char*>(data), length);
+        return 0;
+    }
+
+    int OnH2Frame(nghttp2_session*, const nghttp2_frame* frame, void* user) {
+        auto* connection = static_cast<H2Connection*>(user);
+        bool requestDone = (frame->hd.type == NGHTTP2_HEADERS || frame->hd.type == NGHTTP2_DATA) &&
+                           (frame->hd.flags & NGHTTP2_FLAG_END_STREAM);
+        auto it = connection->requests.find(frame->hd.stream_id);
+        if (!requestDone || it == connection->requests.end()) return 0;
+        Reply reply = DecideReply(it->second, connection->rng);
+        auto due = std::chrono::steady_clock::now() +
+                   std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                       std::chrono::duration<double, std::milli>(reply.delayMs));
+        connection->pending.push_back({due, frame->hd.stream_id, std::move(it->second), std::move(reply)});
+        connection->requests.erase(it);
+        return 0;
+    }
+
+    int OnH2StreamClose(nghttp2_session*, std::int32_t streamId, std::uint32_t, void* user) {
+        auto* connection = static_cast<H2Connection*>(user);
+        connection->requests.erase(streamId);
+        connection->bodies.erase(streamId);
+        return 0;
+    }
+
+    ssize_t ReadH2Body(nghttp2_session*, std::int32_t streamId, std::uint8_t* out, size_t length,
+                       std::uint32_t* flags, nghttp2_data_source*, void* user) {
+        auto& bodies = static_cast<H2Connection*>(user)->bodies;
+        auto it = bodies.find(streamId);
+        if (it == bodies.end()) return NGHTTP2_ERR_TEMPORAL_CALLBACK_FAILURE;
+        auto& [body, sent] = it->second;
+        size_t n = std::min(length, body.size() - sent);
+        std::memcpy(out, body.data() + sent, n);
+        sent += n;
+        if (sent == body.size()) *flags |= NGHTTP2_DATA_FLAG_EOF;
+        return static_cast<ssize_t>(n);
+    }
+
+    // One send for all pending frames: separate small writes of HEADERS and DATA would wait on Nagle
+    bool FlushH2(nghttp2_session* session, SocketHandle client) {
+        std::string out;
+        const std::uint8_t* data = nullptr;
+        ssize_t length;
+        while ((length = nghttp2_session_mem_send(session, &data)) > 0) {
+            out.append(reinterpret_cast<const char*>(data), static_cast<size_t>(length));
+        }
+        return length == 0 && (out.empty() || SendAll(client, out.data(), out.size()));
+    }
+
+    // buffer holds what was read so far, starting with the client preface
+    void ServeHttp2(SocketHandle client, int connectionId, const std::string& buffer) {
+        g_Http2Connections.fetch_add(1);
+        H2Connection connection{client, connectionId,
+                                std::mt19937(g_Options.seed * 7919u + static_cast<unsigned>(connectionId)), {}, {}, {}};
+        nghttp2_session_callbacks* callbacks = nullptr;
+        nghttp2_session_callbacks_new(&callbacks);
+        nghttp2_session_callbacks_set_on_begin_headers_callback(callbacks, OnH2BeginHeaders);
+        nghttp2_session_callbacks_set_on_header_callback(callbacks, OnH2Header);
+        nghttp2_session_callbacks_set_on_data_chunk_recv_callback(callbacks, OnH2Data);
+        nghttp2_session_callbacks_set_on_frame_recv_callback(callbacks, OnH2Frame);
+        nghttp2_session_callbacks_set_on_stream_close_callback(callbacks, OnH2StreamClose);
+        nghttp2_session* session = nullptr;
+        nghttp2_session_server_new(&session, callbacks, &connection);
+        nghttp2_session_callbacks_del(callbacks);
+
+        nghttp2_settings_entry settings[] = {{NGHTTP2_SETTINGS_MAX_CONCURRENT_STREAMS, 128}};
+        nghttp2_submit_settings(session, NGHTTP2_FLAG_NONE, settings, 1);
+        bool ok = nghttp2_session_mem_recv(session, reinterpret_cast<const std::uint8_t*>(buffer.data()),
+                                           buffer.size()) >= 0;
+        auto lastActivity = std::chrono::steady_clock::now();
+        while (ok && !g_StopRequested.load() &&
+               (nghttp2_session_want_read(session) || nghttp2_session_want_write(session))) {
+            // Answer every stream whose delay is over
+            auto now = std::chrono::steady_clock::now();
+            for (size_t i = 0; i < connection.pending.size();) {
+                H2PendingReply& pending = connection.pending[i];
+                if (pending.due > now) {
+                    ++i;
+                    continue;
+                }
+                std::string status = std::to_string(pending.reply.status);
+                auto header = [](std::string_view name, std::string_view value) {
+                    return nghttp2_nv{reinterpret_cast<std::uint8_t*>(const_cast<char*>(name.data())),
+                                      reinterpret_cast<std::uint8_t*>(const_cast<char*>(value.data())), name.size(),
+                                      value.size(), NGHTTP2_NV_FLAG_NONE};
+                };
+                const nghttp2_nv headers[] = {header(":status", status), header("content-type", "application/json")};
+                connection.bodies[pending.streamId] = {pending.reply.body, 0};
+                nghttp2_data_provider provider{};
+                provider.read_callback = ReadH2Body;
+                nghttp2_submit_response(session, pending.streamId, headers, 2, &provider);
+                RecordReply(connectionId, pending.request, pending.reply);
+                connection.pending.erase(connection.pending.begin() + static_cast<std::ptrdiff_t>(i));
+            }
+            if (!FlushH2(session, client)) break;
+
+            // Sleep until data arrives or the next reply is due; drop the connection after 30 s of silence
+            int waitMs = 100;
+            for (const H2PendingReply& pending : connection.pending) {
+                auto left = std::chrono::duration_cast<std::chrono::milliseconds>(pending.due - now).count();
+                waitMs = std::clamp(static_cast<int>(left), 0, waitMs);
+            }
+            int ready = PollReadable(client, waitMs);
+            if (ready < 0) break;
+            if (ready == 0) {
+                if (connection.pending.empty() && now - lastActivity > std::chrono::seconds(30)) break;
+                continue;
+            }
+            char chunk[4096];
+            long received = ReceiveSome(client, chunk, sizeof(chunk), 0);
+            if (received <= 0) break;
+            lastActivity = std::chrono::steady_clock::now();
+            ok = nghttp2_session_mem_recv(session, reinterpret_cast<const std::uint8_t*>(chunk),
+                                          static_cast<size_t>(received)) >= 0;
+        }
+        nghttp2_session_del(session);
+    }
+#endif
+
+    void ServeConnection(SocketHandle client, int connectionId) {
+        std::mt19937 rng(g_Options.seed * 7919u + static_cast<unsigned>(connectionId));
+        std::string buffer;
+
+#ifdef HAL_MOCK_HTTP2
+        // HTTP/2 clients with prior knowledge open with the connection preface instead of a request line
+        while (buffer.size() < H2_PREFACE.size() && H2_PREFACE.starts_with(buffer)) {
+            char chunk[4096];
+            long received = ReceiveSome(client, chunk, sizeof(chunk), 30000);
+            if (received <= 0) break;
+            buffer.append(chunk, static_cast<size_t>(received));
+        }
+        if (buffer.starts_with(H2_PREFACE)) {
+            ServeHttp2(client, connectionId, buffer);
+            CloseSocket(client);
+            g_ActiveConnections.fetch_sub(1);
+            return;
+        }
+#endif
+
+        while (!g_StopRequested.load()) {
+            ParsedRequest request;
+            if (!ReadRequest(client, buffer, request)) break;
+            Reply reply = DecideReply(request, rng);
+            if (reply.delayMs > 0.0) {
+                std::this_thread::sleep_for(std::chrono::duration<double, std::milli>(reply.delayMs));
+            }
+            SendResponse(client, reply.status, reply.reason, reply.body, request.close);
+            RecordReply(connectionId, request, reply);
+            if (request.close) break;
+        }
+        CloseSocket(client);
+        g_ActiveConnections.fetch_sub(1);
+    }
+
+    void PrintSummary() {
+        std::lock_guard lock(g_StatsMutex);
+        double seconds = MillisecondsSinceStart() / 1000.0;
+        std::fprintf(stderr,
+                     "--- Mock HA after %.1f s: %llu connections (%llu HTTP/2, peak %d concurrent, %llu rejected) "
+                     "---\n",
+                     seconds, static_cast<unsigned long long>(g_AcceptedConnections.load()),
+                     static_cast<unsigned long long>(g_Http2Connections.load()), g_PeakConnections.load(),
+                     static_cast<unsigned long long>(g_RejectedConnections.load()));
+        for (const auto& [endpoint, stats] : g_Stats) {
+            std::fprintf(stderr,
+                         "%-28s %8llu req %8.1f req/s  errors %llu  unauthorized %llu  delay p50 %.1f p99 %.1f "
+                         "max %.1f ms\n",
+                         endpoint.c_str(), static_cast<unsigned long long>(stats.requests),
+                         seconds > 0.0 ? static_cast<double>(stats.requests) / seconds : 0.0,
+                         static_cast<unsigned long long>(stats.injectedErrors),
+                         static_cast<unsigned long long>(stats.unauthorized), Percentile(stats.delaysMs, 0.50),
+                         Percentile(stats.delaysMs, 0.99), Percentile(stats.delaysMs, 1.0));
+        }
+    }
+
+    void AcceptLoop(TcpListener& listener) {
+        int nextConnectionId = 0;
+        while (listener.IsOpen() && !g_StopRequested.load()) {
+            SocketHandle client = listener.Accept();
+            if (client == INVALID_SOCKET_HANDLE) continue;
+            int active = g_ActiveConnections.load();
+            if (g_Options.maxConnections > 0 && active >= g_Options.maxConnections) {
+                g_RejectedConnections.fetch_add(1);
+                SendResponse(client, 503, "Service Unavailable", "{\"message\":\"Too many connections\"}", true);
+                CloseSocket(client);
+                continue;
+            }
+            active = g_ActiveConnections.fetch_add(1) + 1;
+            int peak = g_PeakConnections.load();
+            while (active > peak && !g_PeakConnections.compare_exchange_weak(peak, active)) {
+            }
+            g_AcceptedConnections.fetch_add(1);
+            std::thread(ServeConnection, client, nextConnectionId++).detach();
+        }
+    }
+}
+
+int main(int argc, char** argv) {
+    if (!ParseOptions(argc, argv, g_Options)) {
+        PrintUsage(argv[0]);
+        return 2;
+    }
+    if (!g_Options.logFile.empty()) {
+        g_Log = std::fopen(g_Options.logFile.c_str(), "w");
+        if (!g_Log) {
+            std::fprintf(stderr, "Cannot write %s\n", g_Options.logFile.c_str());
+            return 1;
+        }
+        std::fprintf(g_Log, "time_ms,connection,method,path,entity_id,status,delay_ms\n");
+    }
+
+    static TcpListener listener;
+    if (!listener.Listen(g_Options.bind, g_Options.port, 64)) {
+        std::fprintf(stderr, "Cannot listen on %s:%u (%s)\n", g_Options.bind.c_str(), g_Options.port,
+                     LastSocketError().c_str());
+        return 1;
+    }
+    std::fprintf(stderr, "Mock Home Assistant listening on http://%s:%u\n", g_Options.bind.c_str(), g_Options.port);
+
+    std::signal(SIGINT, [](int) { g_StopRequested.store(true); });
+    std::thread(AcceptLoop, std::ref(listener)).detach();
+
+    auto lastReport = std::chrono::steady_clock::now();
+    while (!g_StopRequested.load()) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        auto now = std::chrono::steady_clock::now();
+        if (g_Options.durationSeconds > 0 && now - g_StartTime >= std::chrono::seconds(g_Options.durationSeconds))
+            break;
+        if (g_Options.reportSeconds > 0 && now - lastReport >= std::chrono::seconds(g_Options.reportSeconds)) {
+            lastReport = now;
+            PrintSummary();
+        }
+    }
+
+    PrintSummary();
+    if (g_Log) {
+        std::lock_guard lock(g_LogMutex);
+        std::fclose(g_Log);
+        g_Log = nullptr;
+    }
+    // Connection threads may still be sleeping in a delay; don't run static destructors under them
+    std::fflush(stderr);
+    std::quick_exit(0);
+}
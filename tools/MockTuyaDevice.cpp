@@ -0,0 +1,311 @@
+// Stand-in Tuya bulbs for testing the direct Tuya backend (TuyaTransport) without hardware: speaks the local
+// protocol 3.3/3.4/3.5 (session key negotiation, control, heartbeat, status query), acknowledges commands after an
+// optional delay and reports the DPS each bulb ended up with.
+// Usage: HomeAssistantLink_mocktuya [options]
+//   --config <file>     Serve the "Tuya" devices of a HomeAssistantLink.json, each on 127.0.0.1:<Port>
+//   --devices <n>       Without --config: n bulbs on consecutive ports, device id mock<i>, local key
+//                       0123456789abcdef (what HomeAssistantLink_loaddriver --tuya expects; default 4)
+//   --version <v>       Protocol of those bulbs: 3.3, 3.4 or 3.5 (default 3.3)
+//   --port <n>          First port (default 6668)
+//   --latency <ms>      Delay before every acknowledgement (default 0; real bulbs take 10-40 ms)
+//   --status            Follow every command with an unsolicited status report, like real bulbs do
+//   --verbose           Print every command
+//   --duration <s>      Exit after this long (default 0 = run until Ctrl+C)
+
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <nlohmann/json.hpp>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "ConfigLoader.h"
+#include "NetSocket.h"
+#include "TuyaProtocol.h"
+
+using json = nlohmann::json;
+
+namespace {
+    struct Options {
+        std::string config;
+        int devices = 4;
+        std::string version = "3.3";
+        int port = 6668;
+        int latencyMs = 0;
+        bool status = false;
+        bool verbose = false;
+        double duration = 0.0;
+    };
+
+    std::atomic<bool> g_Stop = false;
+
+    void PrintUsage(const char* exe) {
+        std::fprintf(stderr,
+                     "Usage: %s [--config <HomeAssistantLink.json>] [--devices <n>] [--version 3.3|3.4|3.5] "
+                     "[--port <n>] [--latency <ms>] [--status] [--verbose] [--duration <s>]\n",
+                     exe);
+    }
+
+    bool ParseOptions(int argc, char** argv, Options& options) {
+        for (int i = 1; i < argc; ++i) {
+            std::string arg = argv[i];
+            bool hasValue = i + 1 < argc;
+            if (arg == "--config" && hasValue) {
+                options.config = argv[++i];
+            } else if (arg == "--devices" && hasValue) {
+                options.devices = std::atoi(argv[++i]);
+            } else if (arg == "--version" && hasValue) {
+                options.version = argv[++i];
+            } else if (arg == "--port" && hasValue) {
+                options.port = std::atoi(argv[++i]);
+            } else if (arg == "--latency" && hasValue) {
+                options.latencyMs = std::atoi(argv[++i]);
+            } else if (arg == "--status") {
+                options.status = true;
+            } else if (arg == "--verbose") {
+                options.verbose = true;
+            } else if (arg == "--duration" && hasValue) {
+                options.duration = std::atof(argv[++i]);
+            } else {
+                return false;
+            }
+        }
+        bool knownVersion = options.version == "3.3" || options.version == "3.4" || options.version == "3.5";
+        return knownVersion && options.devices > 0 && options.port > 0 && options.latencyMs >= 0;
+    }
+
+    struct Bulb {
+        TuyaDeviceConfig config;
+        TuyaVersion version = TuyaVersion::V33;
+        TuyaKey localKey{};
+        TcpListener listener;
+
+        std::mutex mutex;  // Guards the counters and dps against the report
+        json dps = json::object();
+        std::uint64_t commands = 0;
+        std::uint64_t connections = 0;
+        std::uint64_t rejected = 0;  // Connections dropped on an undecodable frame (wrong key or version)
+    };
+
+    std::string AsPayload(const std::uint8_t* data, size_t size) {
+        return std::string(reinterpret_cast<const char*>(data), size);
+    }
+
+    // Control payload -> dps object: 3.3 {"devId", "dps"}, 3.4/3.5 {"protocol": 5, "data": {"dps"}}
+    bool ExtractDps(const Bulb& bulb, const std::string& payload, json& dps) {
+        json message = json::parse(payload, nullptr, false);
+        if (!message.is_object()) return false;
+        if (bulb.version == TuyaVersion::V33) {
+            if (message.value("devId", "") != bulb.config.device_id || !message.contains("dps")) return false;
+            dps = message["dps"];
+        } else {
+            if (!message.contains("data") || !message["data"].contains("dps")) return false;
+            dps = message["data"]["dps"];
+        }
+        return dps.is_object();
+    }
+
+    std::string StatusPayload(const Bulb& bulb, const json& dps) {
+        auto t = std::chrono::duration_cast<std::chrono::seconds>(
+                     std::chrono::system_clock::now().time_since_epoch())
+                     .count();
+        if (bulb.version == TuyaVersion::V33) {
+            return json{{"devId", bulb.config.device_id}, {"dps", dps}, {"t", t}}.dump();
+        }
+        return json{{"protocol", 4}, {"t", t}, {"data", {{"dps", dps}}}}.dump();
+    }
+
+    // One client connection, until it closes or sends something that does not decode
+    void ServeConnection(Bulb& bulb, SocketHandle client, const Options& options) {
+        TuyaCodec codec;
+        codec.Configure(bulb.version, bulb.localKey);
+        TuyaNonce clientNonce{}, deviceNonce{};
+        std::uint32_t seq = 0;
+        std::string buffer;
+        char chunk[2048];
+
+        auto reply = [&](std::uint32_t cmd, std::string_view payload) {
+            std::string frame = codec.Encode(++seq, cmd, payload, true, 0);
+            return SendAll(client, frame.data(), frame.size());
+        };
+
+        while (!g_Stop) {
+            int ready = PollReadable(client, 200);
+            if (ready < 0) return;
+            if (ready == 0) continue;
+            long received = ReceiveSome(client, chunk, sizeof(chunk), 0);
+            if (received <= 0) return;
+            buffer.append(chunk, static_cast<size_t>(received));
+
+            TuyaMessage message;
+            long used = 0;
+            while ((used = codec.Decode(buffer, message, false)) > 0) {
+                buffer.erase(0, static_cast<size_t>(used));
+                switch (message.cmd) {
+                    case TuyaCommand::kSessKeyNegStart: {
+                        if (message.payload.size() != TUYA_NONCE_SIZE) return;
+                        std::memcpy(clientNonce.data(), message.payload.data(), TUYA_NONCE_SIZE);
+                        RandomTuyaBytes(deviceNonce.data(), deviceNonce.size());
+                        TuyaHmacDigest proof = TuyaHmac(bulb.localKey, clientNonce.data(), clientNonce.size());
+                        if (!reply(TuyaCommand::kSessKeyNegResp, AsPayload(deviceNonce.data(), deviceNonce.size()) +
+                                                                     AsPayload(proof.data(), proof.size()))) {
+                            return;
+                        }
+                        break;
+                    }
+                    case TuyaCommand::kSessKeyNegFinish: {
+                        TuyaHmacDigest expected = TuyaHmac(bulb.localKey, deviceNonce.data(), deviceNonce.size());
+                        if (message.payload != AsPayload(expected.data(), expected.size())) {
+                            std::fprintf(stderr, "%s: session key negotiation failed\n", bulb.config.entity_id.c_str());
+                            return;
+                        }
+                        codec.SetKey(DeriveTuyaSessionKey(bulb.version, bulb.localKey, clientNonce, deviceNonce));
+                        break;
+                    }
+                    case TuyaCommand::kControl:
+                    case TuyaCommand::kControlNew: {
+                        json dps;
+                        if (!ExtractDps(bulb, message.payload, dps)) {
+                            std::fprintf(stderr, "%s: malformed control payload %s\n", bulb.config.entity_id.c_str(),
+                                         message.payload.c_str());
+                            return;
+                        }
+                        if (options.latencyMs > 0) {
+                            std::this_thread::sleep_for(std::chrono::milliseconds(options.latencyMs));
+                        }
+                        json state;
+                        {
+                            std::lock_guard lock(bulb.mutex);
+                            bulb.dps.update(dps);
+                            ++bulb.commands;
+                            state = bulb.dps;
+                        }
+                        if (options.verbose) {
+                            std::printf("%s %s\n", bulb.config.entity_id.c_str(), dps.dump().c_str());
+                        }
+                        if (!reply(message.cmd, {})) return;
+                        if (options.status && !reply(TuyaCommand::kStatus, StatusPayload(bulb, state))) return;
+                        break;
+                    }
+                    case TuyaCommand::kHeartbeat:
+                        if (!reply(TuyaCommand::kHeartbeat, {})) return;
+                        break;
+                    case TuyaCommand::kDpQuery: {
+                        json state;
+                        {
+                            std::lock_guard lock(bulb.mutex);
+                            state = bulb.dps;
+                        }
+                        if (!reply(TuyaCommand::kDpQuery, StatusPayload(bulb, state))) return;
+                        break;
+                    }
+                    default:
+                        break;  // Real bulbs ignore commands they do not know
+                }
+            }
+            if (used < 0) {
+                std::lock_guard lock(bulb.mutex);
+                ++bulb.rejected;
+                return;
+            }
+        }
+    }
+
+    // Like a real bulb: one client at a time
+    void BulbThread(Bulb& bulb, const Options& options) {
+        while (!g_Stop) {
+            SocketHandle client = bulb.listener.Accept();
+            if (client == INVALID_SOCKET_HANDLE) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(100));
+                continue;
+            }
+            {
+                std::lock_guard lock(bulb.mutex);
+                ++bulb.connections;
+            }
+            ServeConnection(bulb, client, options);
+            CloseSocket(client);
+        }
+    }
+
+    void PrintReport(std::vector<std::unique_ptr<Bulb>>& bulbs) {
+        for (auto& bulb : bulbs) {
+            std::lock_guard lock(bulb->mutex);
+            std::fprintf(stderr, "%-24s %s  port %5d  %6llu commands  %3llu connections  %3llu rejected  dps %s\n",
+                         bulb->config.entity_id.c_str(), GetTuyaVersionName(bulb->version), bulb->config.port,
+                         static_cast<unsigned long long>(bulb->commands),
+                         static_cast<unsigned long long>(bulb->connections),
+                         static_cast<unsigned long long>(bulb->rejected), bulb->dps.dump().c_str());
+        }
+    }
+}
+
+int main(int argc, char** argv) {
+    Options options;
+    if (!ParseOptions(argc, argv, options)) {
+        PrintUsage(argv[0]);
+        return 2;
+    }
+
+    std::vector<TuyaDeviceConfig> devices;
+    if (!options.config.empty()) {
+        if (!LoadConfigurationFromFile(options.config)) {
+            std::fprintf(stderr, "Failed to load config %s\n", options.config.c_str());
+            return 1;
+        }
+        devices = g_Tuya.devices;
+    } else {
+        int version = options.version == "3.5" ? 35 : options.version == "3.4" ? 34 : 33;
+        for (int i = 0; i < options.devices; ++i) {
+            TuyaDeviceConfig device;
+            device.entity_id = "light.load_" + std::to_string(i);
+            device.address = "127.0.0.1";
+            device.port = options.port + i;
+            device.device_id = "mock" + std::to_string(i);
+            device.local_key = "0123456789abcdef";
+            device.version = version;
+            devices.push_back(device);
+        }
+    }
+    if (devices.empty()) {
+        std::fprintf(stderr, "No Tuya devices to serve\n");
+        return 1;
+    }
+
+    std::vector<std::unique_ptr<Bulb>> bulbs;
+    for (const TuyaDeviceConfig& device : devices) {
+        auto bulb = std::make_unique<Bulb>();
+        bulb->config = device;
+        bulb->version = static_cast<TuyaVersion>(device.version);
+        std::memcpy(bulb->localKey.data(), device.local_key.data(), bulb->localKey.size());
+        if (!bulb->listener.Listen("127.0.0.1", static_cast<std::uint16_t>(device.port))) {
+            std::fprintf(stderr, "Cannot listen on 127.0.0.1:%d (%s)\n", device.port, LastSocketError().c_str());
+            return 1;
+        }
+        std::fprintf(stderr, "%s (%s, id %s) on 127.0.0.1:%d\n", device.entity_id.c_str(),
+                     GetTuyaVersionName(bulb->version), device.device_id.c_str(), device.port);
+        bulbs.push_back(std::move(bulb));
+    }
+
+    std::signal(SIGINT, [](int) { g_Stop = true; });
+    for (auto& bulb : bulbs) std::thread(BulbThread, std::ref(*bulb), std::cref(options)).detach();
+
+    auto start = std::chrono::steady_clock::now();
+    while (!g_Stop) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        if (options.duration > 0.0 &&
+            std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() >= options.duration) {
+            break;
+        }
+    }
+    PrintReport(bulbs);
+    // Accepting threads are detached and blocked in accept(); exiting the process ends them
+    std::fflush(stderr);
+    std::_Exit(0);
+}
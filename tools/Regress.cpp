@@ -0,0 +1,496 @@
+// Golden-output and performance regression check for the lamp pipeline. Record a baseline with the current code,
+// change mapping/blend/smoothing (SIMD, new algorithms, ...), then check: lamp outputs must stay within a
+// perceptual tolerance of the golden files and, with --perf, time/allocations per frame within thresholds of the
+// baseline. tools/regress holds the goldens of the synthetic traces; ctest runs the output check against them.
+// Usage:
+//   HomeAssistantLink_regress record <baseline dir> [--config <file>] [recording.halrec...] [options]
+//   HomeAssistantLink_regress check <baseline dir> [options]
+// Options:
+//   --config <file>              Lamps, scenarios and day/night cycle (record only; default: 4 synthetic lamps)
+//   --runs <n>                   Timed runs per trace, the fastest counts (default 5)
+//   --color-tolerance <dE>       Max CIE76 color difference per lamp and frame (default 2.3 = just noticeable)
+//   --brightness-tolerance <pct> Max brightness difference in percentage points (default 1)
+//   --time-tolerance <fraction>  Max slowdown of ns/frame against the baseline (default 0.15)
+//   --alloc-tolerance <n>        Max extra allocations per frame (default 0)
+//   --perf                       Also compare time and allocations per frame (check; off by default)
+//
+// Traces are the built-in synthetic scenes (SceneGenerator, fixed seeds) plus any frame recordings given to
+// record; check replays the same set. A baseline directory holds baseline.json (config, traces, performance)
+// and one <trace>.golden.csv per trace with every lamp state of every frame. Performance numbers only compare
+// on the machine and build type they were recorded with, so --perf needs a baseline recorded locally and a quiet
+// machine; the output check passes anywhere. Exit code: 0 pass, 1 regression, 2 usage error.
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <nlohmann/json.hpp>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "AllocationTracker.h"
+#include "ConfigLoader.h"
+#include "FrameRecorder.h"
+#include "Pipeline.h"
+#include "SceneGenerator.h"
+
+namespace {
+    enum class Mode { Record, Check };
+
+    struct Options {
+        Mode mode = Mode::Check;
+        std::filesystem::path baselineDir;
+        std::string config;
+        std::vector<std::string> recordings;
+        int runs = 5;
+        double colorTolerance = 2.3;
+        int brightnessTolerance = 1;
+        double timeTolerance = 0.15;
+        double allocTolerance = 0.0;
+        bool perf = false;
+    };
+
+    void PrintUsage(const char* exe) {
+        std::fprintf(stderr,
+                     "Usage: %s record|check <baseline dir> [--config <HomeAssistantLink.json>] [recording.halrec...] "
+                     "[--runs <n>] [--color-tolerance <dE>] [--brightness-tolerance <pct>] "
+                     "[--time-tolerance <fraction>] [--alloc-tolerance <n>] [--perf]\n",
+                     exe);
+    }
+
+    bool ParseOptions(int argc, char** argv, Options& options) {
+        if (argc < 3) return false;
+        std::string mode = argv[1];
+        if (mode == "record") {
+            options.mode = Mode::Record;
+        } else if (mode != "check") {
+            return false;
+        }
+        options.baselineDir = argv[2];
+        for (int i = 3; i < argc; ++i) {
+            std::string arg = argv[i];
+            bool hasValue = i + 1 < argc;
+            if (arg == "--config" && hasValue && options.mode == Mode::Record) {
+                options.config = argv[++i];
+            } else if (arg == "--runs" && hasValue) {
+                options.runs = std::atoi(argv[++i]);
+            } else if (arg == "--color-tolerance" && hasValue) {
+                options.colorTolerance = std::atof(argv[++i]);
+            } else if (arg == "--brightness-tolerance" && hasValue) {
+                options.brightnessTolerance = std::atoi(argv[++i]);
+            } else if (arg == "--time-tolerance" && hasValue) {
+                options.timeTolerance = std::atof(argv[++i]);
+            } else if (arg == "--alloc-tolerance" && hasValue) {
+                options.allocTolerance = std::atof(argv[++i]);
+            } else if (arg == "--perf") {
+                options.perf = true;
+            } else if (!arg.empty() && arg[0] != '-' && options.mode == Mode::Record) {
+                options.recordings.push_back(arg);
+            } else {
+                return false;
+            }
+        }
+        return options.runs > 0 && options.colorTolerance >= 0.0 && options.brightnessTolerance >= 0;
+    }
+
+    // FNV-1a of the config file, so check can tell when the goldens were recorded with a different config
+    std::uint64_t HashFile(const std::string& path) {
+        std::string text;
+        if (path.empty() || !ReadTextFile(path, text)) return 0;
+        std::uint64_t hash = 14695981039346656037ull;
+        for (unsigned char c : text) hash = (hash ^ c) * 1099511628211ull;
+        return hash;
+    }
+
+    // --- Traces ---
+
+    struct Trace {
+        std::string name;
+        std::string source;  // "synthetic" or the recording path
+        std::vector<FrameInput> frames;
+    };
+
+    struct SyntheticScene {
+        const char* name;
+        SceneConfig config;
+        int frames;
+        int combatFrom, combatTo;  // Frames with inCombat set (scenario switches); -1 = none
+    };
+
+    std::vector<SyntheticScene> SyntheticScenes() {
+        std::vector<SyntheticScene> scenes;
+        SceneConfig town;  // Evening town: clustered braziers, guards with torches, walking in a circle
+        town.staticLights = 300;
+        town.clusters = 8;
+        town.torchBearers = 6;
+        town.startHour = 19.0f;
+        town.seed = 11;
+        scenes.push_back({"town_evening", town, 300, -1, -1});
+
+        SceneConfig dungeon;  // Candle-lit corridors walked end to end, with a fight halfway
+        dungeon.staticLights = 150;
+        dungeon.areaRadius = 1200.0f;
+        dungeon.clusters = 12;
+        dungeon.clusterSpread = 120.0f;
+        dungeon.playerPath = PlayerPath::Line;
+        dungeon.startHour = 2.0f;
+        dungeon.seed = 23;
+        scenes.push_back({"dungeon_fight", dungeon, 300, 120, 200});
+
+        SceneConfig wilderness;  // Few lights, daylight to dusk with a fast time scale: exercises the ambient cycle
+        wilderness.staticLights = 40;
+        wilderness.areaRadius = 3000.0f;
+        wilderness.playerPath = PlayerPath::RandomWalk;
+        wilderness.startHour = 14.0f;
+        wilderness.timeScale = 600.0f;
+        wilderness.seed = 37;
+        scenes.push_back({"wilderness_dusk", wilderness, 300, -1, -1});
+
+        SceneConfig crowd;  // Worst case: dense market with many torch bearers, mostly cool magic lights
+        crowd.staticLights = 1200;
+        crowd.areaRadius = 1500.0f;
+        crowd.torchBearers = 24;
+        crowd.warmFraction = 0.4f;
+        crowd.playerPath = PlayerPath::Static;
+        crowd.startHour = 22.0f;
+        crowd.seed = 41;
+        scenes.push_back({"crowd_worst_case", crowd, 150, -1, -1});
+        return scenes;
+    }
+
+    Trace MakeSyntheticTrace(const SyntheticScene& scene) {
+        Trace trace{scene.name, "synthetic", {}};
+        SceneGenerator generator(scene.config);
+        for (int i = 0; i < scene.frames; ++i) {
+            FrameInput frame = generator.NextFrame();
+            frame.inCombat = i >= scene.combatFrom && i < scene.combatTo;
+            trace.frames.push_back(std::move(frame));
+        }
+        return trace;
+    }
+
+    bool LoadRecordingTrace(const std::string& path, Trace& trace) {
+        std::vector<RecordedFrame> recorded;
+        std::string error;
+        if (!LoadFrameRecording(path, recorded, error)) {
+            std::fprintf(stderr, "%s: %s\n", path.c_str(), error.c_str());
+            return false;
+        }
+        trace.name = std::filesystem::path(path).stem().string();
+        trace.source = path;
+        for (RecordedFrame& frame : recorded) trace.frames.push_back(std::move(frame.input));
+        return true;
+    }
+
+    // --- Running ---
+
+    struct LampRow {
+        size_t frame = 0;
+        std::string entity;
+        std::array<int, 3> rgb{};
+        int brightness = 0;
+        std::string effect;
+        bool inherit = false;
+        std::string scenario;
+    };
+
+    struct RunResult {
+        std::vector<LampRow> rows;
+        double nsPerFrame = 0.0;
+        double allocsPerFrame = 0.0;
+        double bytesPerFrame = 0.0;
+    };
+
+    // Outputs come from the first run; time is the fastest run. Only RunLightPipeline itself is timed and counted.
+    RunResult RunTrace(const Trace& trace, int runs) {
+        RunResult result;
+        double bestNs = std::numeric_limits<double>::max();
+        for (int run = 0; run < runs; ++run) {
+            LightSmoother smoother;
+            std::chrono::steady_clock::duration elapsed{};
+            AllocationCounters allocations;
+            for (size_t i = 0; i < trace.frames.size(); ++i) {
+                AllocationCounters allocStart = GetThreadAllocations();
+                auto start = std::chrono::steady_clock::now();
+                FrameResult out = RunLightPipeline(trace.frames[i], smoother);
+                elapsed += std::chrono::steady_clock::now() - start;
+                AllocationCounters delta = GetThreadAllocations() - allocStart;
+                allocations.count += delta.count;
+                allocations.bytes += delta.bytes;
+
+                if (run != 0) continue;
+                for (const LightState& state : out.lampStates) {
+                    result.rows.push_back({i, state.entity_id, state.rgb_color, state.brightness_pct,
+                                           state.effect.value_or(""), state.inherit,
+                                           out.activeScenario ? out.activeScenario->name : "ambient"});
+                }
+            }
+            double frames = static_cast<double>(std::max<size_t>(trace.frames.size(), 1));
+            bestNs = std::min(bestNs, static_cast<double>(
+                                          std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()) /
+                                          frames);
+            result.allocsPerFrame = static_cast<double>(allocations.count) / frames;
+            result.bytesPerFrame = static_cast<double>(allocations.bytes) / frames;
+        }
+        result.nsPerFrame = bestNs;
+        return result;
+    }
+
+    // --- Golden files ---
+
+    bool WriteGolden(const std::filesystem::path& path, const std::vector<LampRow>& rows) {
+        std::ofstream out(path);
+        if (!out) return false;
+        out << "frame,entity_id,r,g,b,brightness_pct,effect,inherit,scenario\n";
+        for (const LampRow& row : rows) {
+            out << row.frame << ',' << row.entity << ',' << row.rgb[0] << ',' << row.rgb[1] << ',' << row.rgb[2]
+                << ',' << row.brightness << ',' << row.effect << ',' << (row.inherit ? 1 : 0) << ',' << row.scenario
+                << '\n';
+        }
+        return static_cast<bool>(out);
+    }
+
+    bool ReadGolden(const std::filesystem::path& path, std::vector<LampRow>& rows) {
+        std::ifstream in(path);
+        std::string line;
+        if (!std::getline(in, line)) return false;  // Header
+        while (std::getline(in, line)) {
+            std::vector<std::string> fields;
+            std::stringstream stream(line);
+            for (std::string field; std::getline(stream, field, ',');) fields.push_back(field);
+            if (!line.empty() && line.back() == ',') fields.emplace_back();
+            if (fields.size() != 9) return false;
+            LampRow row;
+            row.frame = std::strtoull(fields[0].c_str(), nullptr, 10);
+            row.entity = fields[1];
+            for (int c = 0; c < 3; ++c) row.rgb[c] = std::atoi(fields[2 + c].c_str());
+            row.brightness = std::atoi(fields[5].c_str());
+            row.effect = fields[6];
+            row.inherit = fields[7] == "1";
+            row.scenario = fields[8];
+            rows.push_back(std::move(row));
+        }
+        return true;
+    }
+
+    // --- Perceptual comparison ---
+
+    struct Lab {
+        double l, a, b;
+    };
+
+    // sRGB (D65) to CIELAB
+    Lab ToLab(const std::array<int, 3>& rgb) {
+        auto linear = [](int channel) {
+            double c = static_cast<double>(channel) / 255.0;
+            return c <= 0.04045 ? c / 12.92 : std::pow((c + 0.055) / 1.055, 2.4);
+        };
+        double r = linear(rgb[0]), g = linear(rgb[1]), b = linear(rgb[2]);
+        double x = (0.4124 * r + 0.3576 * g + 0.1805 * b) / 0.95047;
+        double y = 0.2126 * r + 0.7152 * g + 0.0722 * b;
+        double z = (0.0193 * r + 0.1192 * g + 0.9505 * b) / 1.08883;
+        auto f = [](double t) { return t > 216.0 / 24389.0 ? std::cbrt(t) : (24389.0 / 27.0 * t + 16.0) / 116.0; };
+        return {116.0 * f(y) - 16.0, 500.0 * (f(x) - f(y)), 200.0 * (f(y) - f(z))};
+    }
+
+    double DeltaE(const std::array<int, 3>& a, const std::array<int, 3>& b) {
+        if (a == b) return 0.0;
+        Lab la = ToLab(a), lb = ToLab(b);
+        return std::sqrt((la.l - lb.l) * (la.l - lb.l) + (la.a - lb.a) * (la.a - lb.a) + (la.b - lb.b) * (la.b - lb.b));
+    }
+
+    struct Comparison {
+        size_t outOfTolerance = 0;
+        double maxDeltaE = 0.0;
+        int maxBrightnessDelta = 0;
+        std::string firstFailure;
+    };
+
+    // Rows must line up one to one (same frames, lamps, effects, inherit and scenario); colors and brightness may
+    // drift within tolerance
+    Comparison CompareRows(const std::vector<LampRow>& golden, const std::vector<LampRow>& actual,
+                           const Options& options) {
+        Comparison c;
+        auto fail = [&c](const std::string& message) {
+            ++c.outOfTolerance;
+            if (c.firstFailure.empty()) c.firstFailure = message;
+        };
+        if (golden.size() != actual.size()) {
+            fail(std::to_string(actual.size()) + " lamp states instead of " + std::to_string(golden.size()));
+        }
+        for (size_t i = 0; i < std::min(golden.size(), actual.size()); ++i) {
+            const LampRow& g = golden[i];
+            const LampRow& a = actual[i];
+            std::string where = "frame " + std::to_string(g.frame) + " " + g.entity + ": ";
+            if (g.frame != a.frame || g.entity != a.entity) {
+                fail(where + "row order differs (" + a.entity + " in frame " + std::to_string(a.frame) + ")");
+                continue;
+            }
+            if (g.effect != a.effect || g.inherit != a.inherit || g.scenario != a.scenario) {
+                fail(where + "effect/inherit/scenario '" + a.effect + "'/" + std::to_string(a.inherit) + "/" +
+                     a.scenario + " instead of '" + g.effect + "'/" + std::to_string(g.inherit) + "/" + g.scenario);
+                continue;
+            }
+            if (g.inherit) continue;  // The lamp keeps its own state; color and brightness are not sent
+            double deltaE = DeltaE(g.rgb, a.rgb);
+            int brightnessDelta = std::abs(g.brightness - a.brightness);
+            c.maxDeltaE = std::max(c.maxDeltaE, deltaE);
+            c.maxBrightnessDelta = std::max(c.maxBrightnessDelta, brightnessDelta);
+            if (deltaE > options.colorTolerance || brightnessDelta > options.brightnessTolerance) {
+                char buffer[160];
+                std::snprintf(buffer, sizeof(buffer), "rgb %d,%d,%d @%d%% instead of %d,%d,%d @%d%% (dE %.2f)",
+                              a.rgb[0], a.rgb[1], a.rgb[2], a.brightness, g.rgb[0], g.rgb[1], g.rgb[2], g.brightness,
+                              deltaE);
+                fail(where + buffer);
+            }
+        }
+        return c;
+    }
+
+    // --- Modes ---
+
+    std::vector<Trace> BuildTraces(const std::vector<std::string>& recordings, bool& ok) {
+        std::vector<Trace> traces;
+        for (const SyntheticScene& scene : SyntheticScenes()) traces.push_back(MakeSyntheticTrace(scene));
+        ok = true;
+        for (const std::string& path : recordings) {
+            Trace trace;
+            if (!LoadRecordingTrace(path, trace)) {
+                ok = false;
+                continue;
+            }
+            traces.push_back(std::move(trace));
+        }
+        return traces;
+    }
+
+    int Record(const Options& options) {
+        if (!options.config.empty()) {
+            if (!LoadConfigurationFromFile(options.config)) {
+                std::fprintf(stderr, "Failed to load config %s\n", options.config.c_str());
+                return 1;
+            }
+        } else {
+            UseSyntheticConfig(4, "light.regress_");
+        }
+        bool ok = false;
+        std::vector<Trace> traces = BuildTraces(options.recordings, ok);
+        if (!ok) return 1;
+
+        std::error_code ec;
+        std::filesystem::create_directories(options.baselineDir, ec);
+        nlohmann::json baseline = {
+            {"config", options.config.empty() ? "" : std::filesystem::absolute(options.config).string()},
+            {"configHash", HashFile(options.config)},
+            {"allocationsCounted", AllocationHooksInstalled()},
+            {"traces", nlohmann::json::array()}};
+        for (const Trace& trace : traces) {
+            RunResult result = RunTrace(trace, options.runs);
+            if (!WriteGolden(options.baselineDir / (trace.name + ".golden.csv"), result.rows)) {
+                std::fprintf(stderr, "Cannot write golden file for %s to %s\n", trace.name.c_str(),
+                             options.baselineDir.string().c_str());
+                return 1;
+            }
+            baseline["traces"].push_back({{"name", trace.name},
+                                          {"source", trace.source == "synthetic"
+                                                         ? trace.source
+                                                         : std::filesystem::absolute(trace.source).string()},
+                                          {"frames", trace.frames.size()},
+                                          {"nsPerFrame", result.nsPerFrame},
+                                          {"allocsPerFrame", result.allocsPerFrame},
+                                          {"bytesPerFrame", result.bytesPerFrame}});
+            std::printf("%-20s %5zu frames %8zu lamp states %10.0f ns/frame %7.2f allocs/frame\n", trace.name.c_str(),
+                        trace.frames.size(), result.rows.size(), result.nsPerFrame, result.allocsPerFrame);
+        }
+        std::ofstream(options.baselineDir / "baseline.json") << baseline.dump(2);
+        std::printf("Baseline written to %s\n", options.baselineDir.string().c_str());
+        return 0;
+    }
+
+    int Check(const Options& options) {
+        std::string text;
+        nlohmann::json baseline;
+        if (!ReadTextFile(options.baselineDir / "baseline.json", text)) {
+            std::fprintf(stderr, "No baseline.json in %s (run record first)\n", options.baselineDir.string().c_str());
+            return 2;
+        }
+        try {
+            baseline = nlohmann::json::parse(text);
+        } catch (const std::exception& e) {
+            std::fprintf(stderr, "baseline.json: %s\n", e.what());
+            return 2;
+        }
+
+        std::string config = baseline.value("config", "");
+        if (!config.empty()) {
+            if (!LoadConfigurationFromFile(config)) {
+                std::fprintf(stderr, "Failed to load config %s\n", config.c_str());
+                return 1;
+            }
+            if (HashFile(config) != baseline.value("configHash", std::uint64_t{0})) {
+                std::fprintf(stderr, "Warning: %s changed since the baseline was recorded\n", config.c_str());
+            }
+        } else {
+            UseSyntheticConfig(4, "light.regress_");
+        }
+        bool compareAllocs = options.perf && baseline.value("allocationsCounted", false) && AllocationHooksInstalled();
+
+        std::vector<std::string> recordings;
+        for (const auto& entry : baseline["traces"]) {
+            if (entry.value("source", "") != "synthetic") recordings.push_back(entry.value("source", ""));
+        }
+        bool ok = false;
+        std::vector<Trace> traces = BuildTraces(recordings, ok);
+        if (!ok) return 1;
+
+        int failures = 0;
+        std::printf("%-20s %8s %6s %6s | %10s %10s %7s | %8s %8s | %s\n", "trace", "bad", "maxdE", "maxBri",
+                    "ns/frame", "baseline", "change", "allocs", "baseline", "result");
+        for (const auto& entry : baseline["traces"]) {
+            std::string name = entry.value("name", "");
+            auto trace = std::find_if(traces.begin(), traces.end(), [&](const Trace& t) { return t.name == name; });
+            std::vector<LampRow> golden;
+            if (trace == traces.end() || !ReadGolden(options.baselineDir / (name + ".golden.csv"), golden)) {
+                std::printf("%-20s missing trace or golden file\n", name.c_str());
+                ++failures;
+                continue;
+            }
+
+            RunResult result = RunTrace(*trace, options.perf ? options.runs : 1);
+            Comparison c = CompareRows(golden, result.rows, options);
+            double baseNs = entry.value("nsPerFrame", 0.0);
+            double baseAllocs = entry.value("allocsPerFrame", 0.0);
+            double change = baseNs > 0.0 ? result.nsPerFrame / baseNs - 1.0 : 0.0;
+            bool slower = options.perf && change > options.timeTolerance;
+            bool moreAllocs = compareAllocs && result.allocsPerFrame > baseAllocs + options.allocTolerance;
+            bool pass = c.outOfTolerance == 0 && !slower && !moreAllocs;
+            if (!pass) ++failures;
+
+            std::string verdict = pass ? "ok" : "FAIL";
+            if (c.outOfTolerance) verdict += " output";
+            if (slower) verdict += " time";
+            if (moreAllocs) verdict += " allocs";
+            std::printf("%-20s %8zu %6.2f %6d | %10.0f %10.0f %+6.1f%% | %8.2f %8.2f | %s\n", name.c_str(),
+                        c.outOfTolerance, c.maxDeltaE, c.maxBrightnessDelta, result.nsPerFrame, baseNs,
+                        100.0 * change, result.allocsPerFrame, baseAllocs, verdict.c_str());
+            if (!c.firstFailure.empty()) std::printf("    first difference: %s\n", c.firstFailure.c_str());
+        }
+        std::printf("%s\n", failures ? "REGRESSION" : "All traces within tolerance");
+        return failures ? 1 : 0;
+    }
+}
+
+int main(int argc, char** argv) {
+    Options options;
+    if (!ParseOptions(argc, argv, options)) {
+        PrintUsage(argv[0]);
+        return 2;
+    }
+    return options.mode == Mode::Record ? Record(options) : Check(options);
+}
@@ -0,0 +1,159 @@
+// Offline replay of frame recordings (HomeAssistantLink_frames_*.halrec) through the lamp pipeline.
+// Usage: HomeAssistantLink_replay <recording.halrec> --config <HomeAssistantLink.json> [options]
+//   --realtime         Pace frames by their recorded timestamps (default: as fast as possible)
+//   --speed <factor>   Realtime playback speed, e.g. 4 = four times faster (implies --realtime)
+//   --repeat <n>       Run the recording n times (fresh smoother each run) for steadier timings
+//   --commands <file>  Write the command stream as CSV to a file instead of stdout
+//   --no-commands      Only print the timing summary
+//
+// The command stream lists what ApplyLightStates would send: one row per lamp whose state changed since its last
+// command (flicker lamps every tick, inherit lamps never). Output is deterministic for a given recording and
+// config, so two runs can be diffed to spot behavior changes.
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "ConfigLoader.h"
+#include "FrameRecorder.h"
+#include "Pipeline.h"
+#include "Profiler.h"
+
+namespace {
+    struct Options {
+        std::string recording;
+        std::string config;
+        std::string commandsFile;
+        bool realtime = false;
+        double speed = 1.0;
+        int repeat = 1;
+        bool commands = true;
+    };
+
+    void PrintUsage(const char* exe) {
+        std::fprintf(stderr,
+                     "Usage: %s <recording.halrec> --config <HomeAssistantLink.json> [--realtime] [--speed <x>] "
+                     "[--repeat <n>] [--commands <file>] [--no-commands]\n",
+                     exe);
+    }
+
+    bool ParseOptions(int argc, char** argv, Options& options) {
+        for (int i = 1; i < argc; ++i) {
+            std::string arg = argv[i];
+            bool hasValue = i + 1 < argc;
+            if (arg == "--config" && hasValue) {
+                options.config = argv[++i];
+            } else if (arg == "--realtime") {
+                options.realtime = true;
+            } else if (arg == "--speed" && hasValue) {
+                options.speed = std::atof(argv[++i]);
+                options.realtime = true;
+            } else if (arg == "--repeat" && hasValue) {
+                options.repeat = std::atoi(argv[++i]);
+            } else if (arg == "--commands" && hasValue) {
+                options.commandsFile = argv[++i];
+            } else if (arg == "--no-commands") {
+                options.commands = false;
+            } else if (!arg.empty() && arg[0] != '-' && options.recording.empty()) {
+                options.recording = arg;
+            } else {
+                return false;
+            }
+        }
+        return !options.recording.empty() && !options.config.empty() && options.speed > 0.0 && options.repeat > 0;
+    }
+
+    // Same dedup rule as ApplyLightStates: scene lamps and flickering lamps go out every tick
+    bool WouldSend(const LightState& state, std::map<std::string, LightState>& lastCommanded) {
+        if (state.inherit) return false;
+        bool scene = state.effect.has_value() && state.effect.value() == "scene" && state.scene.has_value();
+        if (scene) {
+            lastCommanded[state.entity_id] = state;
+            return true;
+        }
+        bool animated = state.effect.has_value() && state.effect.value() == "flicker";
+        auto it = lastCommanded.find(state.entity_id);
+        if (!animated && it != lastCommanded.end() && it->second == state) return false;
+        lastCommanded[state.entity_id] = state;
+        return true;
+    }
+}
+
+int main(int argc, char** argv) {
+    Options options;
+    if (!ParseOptions(argc, argv, options)) {
+        PrintUsage(argv[0]);
+        return 2;
+    }
+
+    if (!LoadConfigurationFromFile(options.config)) {
+        std::fprintf(stderr, "Failed to load config %s\n", options.config.c_str());
+        return 1;
+    }
+    std::vector<RecordedFrame> frames;
+    std::string error;
+    if (!LoadFrameRecording(options.recording, frames, error)) {
+        std::fprintf(stderr, "%s: %s\n", options.recording.c_str(), error.c_str());
+        return 1;
+    }
+
+    FILE* out = nullptr;
+    if (options.commands) {
+        out = options.commandsFile.empty() ? stdout : std::fopen(options.commandsFile.c_str(), "w");
+        if (!out) {
+            std::fprintf(stderr, "Cannot write %s\n", options.commandsFile.c_str());
+            return 1;
+        }
+        std::fprintf(out, "time_ms,entity_id,r,g,b,brightness_pct,effect,scenario\n");
+    }
+
+    g_ProfilingEnabled.store(true);
+    size_t commandCount = 0, dedupCount = 0;
+    auto wallStart = std::chrono::steady_clock::now();
+    for (int run = 0; run < options.repeat; ++run) {
+        LightSmoother smoother;
+        std::map<std::string, LightState> lastCommanded;
+        bool emit = out && run == 0;
+        auto runStart = std::chrono::steady_clock::now();
+
+        for (const RecordedFrame& frame : frames) {
+            if (options.realtime) {
+                std::this_thread::sleep_until(
+                    runStart + std::chrono::microseconds(static_cast<std::int64_t>(frame.time_us / options.speed)));
+            }
+            ScopedStageTimer tickTimer(PipelineStage::Tick);
+            FrameResult result = RunLightPipeline(frame.input, smoother);
+            tickTimer.Stop();
+
+            for (const LightState& state : result.lampStates) {
+                if (!WouldSend(state, lastCommanded)) {
+                    if (!state.inherit) ++dedupCount;
+                    continue;
+                }
+                ++commandCount;
+                if (emit) {
+                    std::fprintf(out, "%.1f,%s,%d,%d,%d,%d,%s,%s\n", static_cast<double>(frame.time_us) / 1000.0,
+                                 state.entity_id.c_str(), state.rgb_color[0], state.rgb_color[1], state.rgb_color[2],
+                                 state.brightness_pct, state.effect.value_or("").c_str(),
+                                 result.activeScenario ? result.activeScenario->name.c_str() : "ambient");
+                }
+            }
+        }
+    }
+    double wallSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - wallStart).count();
+    if (out && out != stdout) std::fclose(out);
+
+    size_t totalFrames = frames.size() * static_cast<size_t>(options.repeat);
+    double recordedSeconds = frames.empty() ? 0.0 : static_cast<double>(frames.back().time_us) / 1e6;
+    std::fprintf(stderr, "Replayed %zu frames (%d x %zu, %.1f s recorded) in %.3f s: %.0f frames/s\n", totalFrames,
+                 options.repeat, frames.size(), recordedSeconds, wallSeconds,
+                 wallSeconds > 0.0 ? static_cast<double>(totalFrames) / wallSeconds : 0.0);
+    std::fprintf(stderr, "Commands: %zu sent, %zu deduplicated\n", commandCount, dedupCount);
+    std::fprintf(stderr, "%s\n", FormatStageTimings().c_str());
+    return 0;
+}
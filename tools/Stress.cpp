@@ -0,0 +1,282 @@
+// Worst-case stress report: runs synthetic scenes (SceneGenerator) of growing density through the lamp pipeline
+// and shows how per-stage cost, memory and output stability scale.
+// Usage: HomeAssistantLink_stress [options]
+//   --config <file>         Lamps, scenarios and day/night cycle from a HomeAssistantLink.json (default: synthetic)
+//   --lamps <n>             Synthetic lamp count when no config is given (default 4)
+//   --scales <a,b,...>      Average static lights within LIGHT_RADIUS per step (default 8,32,128,256,512,1024)
+//   --frames <n>            Ticks per step (default 300 = one minute of play)
+//   --torch-bearers <n>     Moving torch lights (default 24)
+//   --clusters <n>          Gather static lights around n centers (default 0 = uniform)
+//   --area <radius>         Radius of the generated town in game units (default 1200)
+//   --path <kind>           Player path: static, line, circle (default), random
+//   --seed <n>              Scene seed (default 1)
+//   --csv                   Machine-readable output
+//
+// Stage times come from the pipeline's own stage histograms (microsecond resolution); tick time is measured
+// around RunLightPipeline with nanosecond resolution. Output stability is measured on the smoothed lamp states:
+// average brightness and color change per tick, lit/inherit flips, and how many lamps would be sent per tick.
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "ConfigLoader.h"
+#include "Pipeline.h"
+#include "Profiler.h"
+#include "SceneGenerator.h"
+
+#ifdef __linux__
+    #include <fstream>
+#endif
+
+namespace {
+    struct Options {
+        std::string config;
+        int lamps = 4;
+        std::vector<int> scales = {8, 32, 128, 256, 512, 1024};
+        int frames = 300;
+        int torchBearers = 24;
+        int clusters = 0;
+        float area = 1200.0f;
+        PlayerPath path = PlayerPath::Circle;
+        std::uint32_t seed = 1;
+        bool csv = false;
+    };
+
+    void PrintUsage(const char* exe) {
+        std::fprintf(stderr,
+                     "Usage: %s [--config <HomeAssistantLink.json>] [--lamps <n>] [--scales <a,b,...>] [--frames <n>] "
+                     "[--torch-bearers <n>] [--clusters <n>] [--area <radius>] [--path static|line|circle|random] "
+                     "[--seed <n>] [--csv]\n",
+                     exe);
+    }
+
+    bool ParsePath(const std::string& text, PlayerPath& path) {
+        static const std::map<std::string, PlayerPath> names = {{"static", PlayerPath::Static},
+                                                                {"line", PlayerPath::Line},
+                                                                {"circle", PlayerPath::Circle},
+                                                                {"random", PlayerPath::RandomWalk}};
+        auto it = names.find(text);
+        if (it == names.end()) return false;
+        path = it->second;
+        return true;
+    }
+
+    bool ParseOptions(int argc, char** argv, Options& options) {
+        for (int i = 1; i < argc; ++i) {
+            std::string arg = argv[i];
+            bool hasValue = i + 1 < argc;
+            if (arg == "--config" && hasValue) {
+                options.config = argv[++i];
+            } else if (arg == "--lamps" && hasValue) {
+                options.lamps = std::atoi(argv[++i]);
+            } else if (arg == "--scales" && hasValue) {
+                options.scales.clear();
+                std::string list = argv[++i];
+                for (size_t pos = 0; pos != std::string::npos;) {
+                    size_t comma = list.find(',', pos);
+                    int value = std::atoi(list.substr(pos, comma - pos).c_str());
+                    if (value > 0) options.scales.push_back(value);
+                    pos = comma == std::string::npos ? comma : comma + 1;
+                }
+            } else if (arg == "--frames" && hasValue) {
+                options.frames = std::atoi(argv[++i]);
+            } else if (arg == "--torch-bearers" && hasValue) {
+                options.torchBearers = std::atoi(argv[++i]);
+            } else if (arg == "--clusters" && hasValue) {
+                options.clusters = std::atoi(argv[++i]);
+            } else if (arg == "--area" && hasValue) {
+                options.area = static_cast<float>(std::atof(argv[++i]));
+            } else if (arg == "--path" && hasValue) {
+                if (!ParsePath(argv[++i], options.path)) return false;
+            } else if (arg == "--seed" && hasValue) {
+                options.seed = static_cast<std::uint32_t>(std::atoi(argv[++i]));
+            } else if (arg == "--csv") {
+                options.csv = true;
+            } else {
+                return false;
+            }
+        }
+        return options.lamps > 0 && options.frames > 1 && !options.scales.empty() && options.area > 0.0f;
+    }
+
+    // Histogram samples recorded between two snapshots
+    LatencyHistogram::Snapshot Difference(const LatencyHistogram::Snapshot& after,
+                                          const LatencyHistogram::Snapshot& before) {
+        LatencyHistogram::Snapshot diff;
+        for (size_t i = 0; i < diff.buckets.size(); ++i) diff.buckets[i] = after.buckets[i] - before.buckets[i];
+        diff.count = after.count - before.count;
+        diff.sum_us = after.sum_us - before.sum_us;
+        diff.max_us = after.max_us;  // Not recoverable per step; only used as an upper bound
+        return diff;
+    }
+
+    // Peak resident set of this process in KiB (0 where not available)
+    std::uint64_t PeakResidentKiB() {
+#ifdef __linux__
+        std::ifstream status("/proc/self/status");
+        std::string line;
+        while (std::getline(status, line)) {
+            if (line.rfind("VmHWM:", 0) == 0) return std::strtoull(line.c_str() + 6, nullptr, 10);
+        }
+#endif
+        return 0;
+    }
+
+    constexpr PipelineStage STAGES[] = {PipelineStage::Mapping, PipelineStage::Scenario, PipelineStage::Blend,
+                                        PipelineStage::Smooth};
+
+    struct StepResult {
+        int scale = 0;
+        double avgLights = 0.0;
+        int maxLights = 0;
+        double tickMeanUs = 0.0;
+        double tickP99Us = 0.0;
+        LatencyHistogram::Snapshot stages[std::size(STAGES)];
+        double frameKiB = 0.0;         // Average in-game light payload per tick
+        std::uint64_t peakResidentKiB = 0;
+        double brightnessDelta = 0.0;  // Mean |change| per lamp per tick, percentage points
+        double colorDelta = 0.0;       // Mean |change| per channel per lamp per tick
+        double flipsPerLampMinute = 0.0;
+        double sendsPerTick = 0.0;     // By ApplyLightStates' dedup rule
+    };
+
+    StepResult RunStep(const Options& options, int scale) {
+        float coverage = (options.area * options.area) / (LIGHT_RADIUS * LIGHT_RADIUS);
+        SceneConfig scene;
+        scene.staticLights = static_cast<int>(static_cast<float>(scale) * coverage);
+        scene.areaRadius = options.area;
+        scene.clusters = options.clusters;
+        scene.torchBearers = options.torchBearers;
+        scene.playerPath = options.path;
+        scene.seed = options.seed;
+        SceneGenerator generator(scene);
+
+        LatencyHistogram::Snapshot before[std::size(STAGES)];
+        for (size_t s = 0; s < std::size(STAGES); ++s) before[s] = GetStageHistogram(STAGES[s]).TakeSnapshot();
+
+        StepResult result;
+        result.scale = scale;
+        LightSmoother smoother;
+        std::vector<LightState> previous;
+        std::map<std::string, LightState> lastSent;
+        std::vector<double> tickUs;
+        double lightSum = 0.0, frameBytes = 0.0, brightnessSum = 0.0, colorSum = 0.0;
+        std::uint64_t flips = 0, sends = 0, comparisons = 0;
+
+        for (int i = 0; i < options.frames; ++i) {
+            FrameInput frame = generator.NextFrame();
+            lightSum += static_cast<double>(frame.lights.size());
+            result.maxLights = std::max(result.maxLights, static_cast<int>(frame.lights.size()));
+            frameBytes += static_cast<double>(frame.lights.capacity() * sizeof(InGameLight));
+
+            auto start = std::chrono::steady_clock::now();
+            FrameResult out = RunLightPipeline(frame, smoother);
+            tickUs.push_back(
+                std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count());
+
+            for (size_t lamp = 0; lamp < out.lampStates.size(); ++lamp) {
+                const LightState& state = out.lampStates[lamp];
+                if (lamp < previous.size()) {
+                    const LightState& last = previous[lamp];
+                    if (state.inherit != last.inherit) ++flips;
+                    if (!state.inherit && !last.inherit) {
+                        brightnessSum += std::abs(state.brightness_pct - last.brightness_pct);
+                        for (int c = 0; c < 3; ++c)
+                            colorSum += std::abs(state.rgb_color[c] - last.rgb_color[c]) / 3.0;
+                        ++comparisons;
+                    }
+                }
+                // Same rule as ApplyLightStates: animated lamps every tick, others on change, inherit never
+                if (state.inherit) continue;
+                bool animated = state.effect.has_value() && state.effect.value() == "flicker";
+                auto it = lastSent.find(state.entity_id);
+                if (animated || it == lastSent.end() || !(it->second == state)) {
+                    ++sends;
+                    lastSent[state.entity_id] = state;
+                }
+            }
+            previous = std::move(out.lampStates);
+        }
+
+        double frames = static_cast<double>(options.frames);
+        result.avgLights = lightSum / frames;
+        result.frameKiB = frameBytes / frames / 1024.0;
+        double tickSum = 0.0;
+        for (double us : tickUs) tickSum += us;
+        result.tickMeanUs = tickSum / frames;
+        std::sort(tickUs.begin(), tickUs.end());
+        result.tickP99Us = tickUs[static_cast<size_t>(0.99 * static_cast<double>(tickUs.size() - 1))];
+        for (size_t s = 0; s < std::size(STAGES); ++s)
+            result.stages[s] = Difference(GetStageHistogram(STAGES[s]).TakeSnapshot(), before[s]);
+        result.peakResidentKiB = PeakResidentKiB();
+        result.brightnessDelta = comparisons ? brightnessSum / static_cast<double>(comparisons) : 0.0;
+        result.colorDelta = comparisons ? colorSum / static_cast<double>(comparisons) : 0.0;
+        double lampMinutes = static_cast<double>(g_RealLamps.size()) * frames * scene.tickSeconds / 60.0;
+        result.flipsPerLampMinute = lampMinutes > 0.0 ? static_cast<double>(flips) / lampMinutes : 0.0;
+        result.sendsPerTick = static_cast<double>(sends) / frames;
+        return result;
+    }
+
+    double MeanUs(const LatencyHistogram::Snapshot& snap) {
+        return snap.count ? static_cast<double>(snap.sum_us) / static_cast<double>(snap.count) : 0.0;
+    }
+}
+
+int main(int argc, char** argv) {
+    Options options;
+    if (!ParseOptions(argc, argv, options)) {
+        PrintUsage(argv[0]);
+        return 2;
+    }
+    if (!options.config.empty()) {
+        if (!LoadConfigurationFromFile(options.config)) {
+            std::fprintf(stderr, "Failed to load config %s\n", options.config.c_str());
+            return 1;
+        }
+    } else {
+        UseSyntheticConfig(options.lamps, "light.stress_");
+    }
+    g_ProfilingEnabled.store(true);
+
+    if (options.csv) {
+        std::printf("scale,avg_lights,max_lights,tick_mean_us,tick_p99_us");
+        for (PipelineStage stage : STAGES)
+            std::printf(",%s_mean_us,%s_p99_us", GetStageName(stage), GetStageName(stage));
+        std::printf(",frame_kib,peak_rss_kib,brightness_delta,color_delta,flips_per_lamp_min,sends_per_tick\n");
+    } else {
+        std::printf("%zu lamps, %d torch bearers, %d frames per step, area radius %.0f, %s\n", g_RealLamps.size(),
+                    options.torchBearers, options.frames, options.area,
+                    options.clusters ? (std::to_string(options.clusters) + " clusters").c_str() : "uniform");
+        std::printf("Stage columns are mean microseconds per tick\n");
+        std::printf("%6s %7s %6s | %9s %9s | %8s %8s %8s %8s | %8s %9s | %6s %6s %6s %6s\n", "scale", "lights",
+                    "max", "tick us", "p99 us", "mapping", "scenario", "blend", "smooth", "frameKiB", "peakKiB",
+                    "dBri", "dRGB", "flip/m", "send/t");
+    }
+
+    for (int scale : options.scales) {
+        StepResult r = RunStep(options, scale);
+        if (options.csv) {
+            std::printf("%d,%.1f,%d,%.2f,%.2f", r.scale, r.avgLights, r.maxLights, r.tickMeanUs, r.tickP99Us);
+            for (const auto& snap : r.stages)
+                std::printf(",%.2f,%llu", MeanUs(snap), static_cast<unsigned long long>(snap.Percentile(99.0)));
+            std::printf(",%.2f,%llu,%.3f,%.3f,%.3f,%.3f\n", r.frameKiB,
+                        static_cast<unsigned long long>(r.peakResidentKiB), r.brightnessDelta, r.colorDelta,
+                        r.flipsPerLampMinute, r.sendsPerTick);
+        } else {
+            std::printf("%6d %7.1f %6d | %9.2f %9.2f | %8.2f %8.2f %8.2f %8.2f | %8.1f %9llu | %6.2f %6.2f %6.2f "
+                        "%6.2f\n",
+                        r.scale, r.avgLights, r.maxLights, r.tickMeanUs, r.tickP99Us, MeanUs(r.stages[0]),
+                        MeanUs(r.stages[1]), MeanUs(r.stages[2]), MeanUs(r.stages[3]), r.frameKiB,
+                        static_cast<unsigned long long>(r.peakResidentKiB), r.brightnessDelta, r.colorDelta,
+                        r.flipsPerLampMinute, r.sendsPerTick);
+        }
+        std::fflush(stdout);
+    }
+    return 0;
+}
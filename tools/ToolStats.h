@@ -0,0 +1,14 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+// Summary statistics shared by the load-test tools (mockha, loaddriver)
+
+// Nearest-rank percentile, p in 0..1 (1 = max); 0 for no samples. Takes a copy, the caller's order is kept.
+inline double Percentile(std::vector<double> values, double p) {
+    if (values.empty()) return 0.0;
+    size_t index = static_cast<size_t>(p * static_cast<double>(values.size() - 1) + 0.5);
+    std::nth_element(values.begin(), values.begin() + static_cast<std::ptrdiff_t>(index), values.end());
+    return values[index];
+}